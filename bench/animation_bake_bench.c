@@ -0,0 +1,126 @@
+#include "window.h"
+
+#include "animation.h"
+#include "animation_bake.h"
+#include "arena.h"
+#include "model.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CROWD_SIZE 5000
+#define CROWD_FRAMES 100
+#define CROWD_DELTA_TIME (1.0f / 60)
+
+void benchModel(const char *modelFilename, float frameRate);
+double playCrowd(Animation *animation, float *times, AnimationCursor *cursors,
+                 mat4s *poses, int poseStride);
+
+// plays every animation of each model on `CROWD_SIZE` copies from their keys
+// and then baked, and prints the memory the frames take, the time per channel
+// and how far the baked pose strays. pass a frame rate and then model names
+// (relative to `MODELS_PATH`), or leave them out for the defaults
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"AnimatedCube.gltf", "RiggedFigure.glb",
+                                   "InterpolationTest.gltf"};
+    const char **models = defaultModels;
+    int modelCount = 3;
+    float frameRate = ANIMATION_BAKE_FRAME_RATE;
+    if (argc > 1)
+        frameRate = atof(argv[1]);
+    if (argc > 2) {
+        models = (const char **)&argv[2];
+        modelCount = argc - 2;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+
+    printf("\n%g fps, %d copies\n%-24s %-24s %10s %12s %12s %10s\n",
+           frameRate, CROWD_SIZE, "model", "animation", "bytes",
+           "keyed (ns)", "baked (ns)", "max error");
+    for (int i = 0; i < modelCount; i++) {
+        benchModel(models[i], frameRate);
+    }
+
+    windowClose();
+    return 0;
+}
+
+void benchModel(const char *modelFilename, float frameRate) {
+    // baked here instead, so the keys can be played too
+    AnimationBakeEnabled = false;
+    Model *model = modelLoad(modelFilename);
+    int poseStride = model->NodeCount;
+    mat4s *keyedPoses = malloc(CROWD_SIZE * poseStride * sizeof(mat4s));
+    mat4s *bakedPoses = malloc(CROWD_SIZE * poseStride * sizeof(mat4s));
+    float *times = malloc(CROWD_SIZE * sizeof(float));
+    struct Arena *arena = arenaCreate(MODEL_ARENA_SIZE);
+
+    for (int i = 0; i < model->AnimationCount; i++) {
+        Animation *animation = model->Animations[i];
+        AnimationCursor *cursors = calloc(
+            (size_t)CROWD_SIZE * animation->NodeCount, sizeof(AnimationCursor));
+
+        double keyedTime =
+            playCrowd(animation, times, cursors, keyedPoses, poseStride);
+        if (!animationBake(arena, animation, frameRate, SIZE_MAX,
+                           AnimationBakeBlend)) {
+            free(cursors);
+            continue;
+        }
+        double bakedTime =
+            playCrowd(animation, times, NULL, bakedPoses, poseStride);
+
+        // both end on the same times
+        float maxError = 0;
+        for (int j = 0; j < CROWD_SIZE; j++) {
+            for (int k = 0; k < animation->NodeCount; k++) {
+                struct Node *node = animation->Nodes[k].Node;
+                if (node == NULL)
+                    continue;
+                mat4s keyed = keyedPoses[j * poseStride + node->Index];
+                mat4s baked = bakedPoses[j * poseStride + node->Index];
+                for (int l = 0; l < 16; l++) {
+                    maxError = fmaxf(maxError, fabsf(keyed.raw[l / 4][l % 4] -
+                                                     baked.raw[l / 4][l % 4]));
+                }
+            }
+        }
+
+        double samples =
+            (double)CROWD_FRAMES * CROWD_SIZE * animation->NodeCount;
+        printf("%-24s %-24s %10zu %12.1f %12.1f %10.2g\n", modelFilename,
+               animation->Name, animationBakeSize(animation, frameRate),
+               keyedTime * 1e9 / samples, bakedTime * 1e9 / samples, maxError);
+        animation->Bake = NULL;
+        free(cursors);
+    }
+
+    arenaFree(arena);
+    free(times);
+    free(bakedPoses);
+    free(keyedPoses);
+    modelFree(model);
+}
+
+// plays `CROWD_FRAMES` frames with each copy starting somewhere else
+double playCrowd(Animation *animation, float *times, AnimationCursor *cursors,
+                 mat4s *poses, int poseStride) {
+    for (int i = 0; i < CROWD_SIZE; i++) {
+        times[i] = fmodf(i * 7.3f, animation->Duration);
+    }
+    double start = glfwGetTime();
+    for (int frame = 0; frame < CROWD_FRAMES; frame++) {
+        for (int i = 0; i < CROWD_SIZE; i++) {
+            times[i] = animationAdvance(animation, times[i], CROWD_DELTA_TIME);
+            animationSample(
+                animation, times[i], &poses[i * poseStride],
+                cursors != NULL ? &cursors[i * animation->NodeCount] : NULL);
+        }
+    }
+    return glfwGetTime() - start;
+}
@@ -0,0 +1,105 @@
+#include "window.h"
+
+#include "animation.h"
+#include "model.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CROWD_SIZE 5000
+#define CROWD_FRAMES 100
+
+void benchModel(const char *modelFilename);
+
+// plays the first animation of each model on `CROWD_SIZE` copies, each at
+// its own time, once with `animationSample` per copy and once with
+// `animationSampleBatch`. pass model names (relative to `MODELS_PATH`) or
+// leave empty for the default set
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"AnimatedCube.gltf", "RiggedFigure.glb",
+                                   "InterpolationTest.gltf"};
+    const char **models = defaultModels;
+    int modelCount = 3;
+    if (argc > 1) {
+        models = (const char **)&argv[1];
+        modelCount = argc - 1;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+
+    printf("\n%-24s %8s %14s %14s %10s\n", "model", "channels",
+           "per copy (ms)", "batched (ms)", "max error");
+    for (int i = 0; i < modelCount; i++) {
+        benchModel(models[i]);
+    }
+
+    windowClose();
+    return 0;
+}
+
+void benchModel(const char *modelFilename) {
+    Model *model = modelLoad(modelFilename);
+    if (model->AnimationCount == 0) {
+        printf("%-24s has no animations\n", modelFilename);
+        modelFree(model);
+        return;
+    }
+    Animation *animation = model->Animations[0];
+    int poseStride = model->NodeCount;
+    mat4s *poses = calloc(CROWD_SIZE * poseStride, sizeof(mat4s));
+    mat4s *batchPoses = calloc(CROWD_SIZE * poseStride, sizeof(mat4s));
+    AnimationCursor *cursors =
+        calloc(CROWD_SIZE * animation->NodeCount, sizeof(AnimationCursor));
+    AnimationCursor *batchCursors =
+        calloc(CROWD_SIZE * animation->NodeCount, sizeof(AnimationCursor));
+    float *times = malloc(CROWD_SIZE * sizeof(float));
+    for (int i = 0; i < CROWD_SIZE; i++) {
+        times[i] = (float)i / CROWD_SIZE * animation->Duration;
+    }
+
+    double perCopyTime = 0, batchTime = 0;
+    for (int frame = 0; frame < CROWD_FRAMES; frame++) {
+        for (int i = 0; i < CROWD_SIZE; i++) {
+            times[i] = animationAdvance(animation, times[i], 1.0f / 60);
+        }
+
+        double start = glfwGetTime();
+        for (int i = 0; i < CROWD_SIZE; i++) {
+            animationSample(animation, times[i], &poses[i * poseStride],
+                            &cursors[i * animation->NodeCount]);
+        }
+        perCopyTime += glfwGetTime() - start;
+
+        start = glfwGetTime();
+        animationSampleBatch(animation, CROWD_SIZE, times, batchCursors,
+                             batchPoses, poseStride);
+        batchTime += glfwGetTime() - start;
+    }
+
+    float maxError = 0;
+    for (int i = 0; i < CROWD_SIZE; i++) {
+        for (int j = 0; j < animation->NodeCount; j++) {
+            if (animation->Nodes[j].Node == NULL)
+                continue;
+            int pose = i * poseStride + animation->Nodes[j].Node->Index;
+            for (int k = 0; k < 16; k++) {
+                float error = fabsf(poses[pose].raw[k / 4][k % 4] -
+                                    batchPoses[pose].raw[k / 4][k % 4]);
+                maxError = fmaxf(maxError, error);
+            }
+        }
+    }
+    printf("%-24s %8d %14.3f %14.3f %10.2e\n", modelFilename,
+           animation->NodeCount, perCopyTime * 1000 / CROWD_FRAMES,
+           batchTime * 1000 / CROWD_FRAMES, maxError);
+
+    free(times);
+    free(batchCursors);
+    free(cursors);
+    free(batchPoses);
+    free(poses);
+    modelFree(model);
+}
@@ -0,0 +1,85 @@
+#include "window.h"
+
+#include "animation.h"
+#include "animation_compress.h"
+#include "arena.h"
+#include "model.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLE_FRAMES 20000
+#define SAMPLE_DELTA_TIME (1.0f / 60)
+
+void benchModel(const char *modelFilename, float tolerance);
+double playbackTime(Animation *animation, mat4s *pose);
+
+// compresses every animation of each model, prints the ratio and error the
+// loaders report and what playing it back costs before and after. pass a
+// tolerance and then model names (relative to `MODELS_PATH`), or leave them
+// out for the defaults
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"AnimatedCube.gltf", "RiggedFigure.glb",
+                                   "InterpolationTest.gltf"};
+    const char **models = defaultModels;
+    int modelCount = 3;
+    float tolerance = ANIMATION_COMPRESS_TOLERANCE;
+    if (argc > 1)
+        tolerance = atof(argv[1]);
+    if (argc > 2) {
+        models = (const char **)&argv[2];
+        modelCount = argc - 2;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+
+    printf("\ntolerance %g\n", tolerance);
+    for (int i = 0; i < modelCount; i++) {
+        benchModel(models[i], tolerance);
+    }
+
+    windowClose();
+    return 0;
+}
+
+void benchModel(const char *modelFilename, float tolerance) {
+    // the original keys are needed to compare against
+    AnimationCompressEnabled = false;
+    Model *model = modelLoad(modelFilename);
+    mat4s *pose = malloc(model->NodeCount * sizeof(mat4s));
+    struct Arena *arena = arenaCreate(MODEL_ARENA_SIZE);
+
+    for (int i = 0; i < model->AnimationCount; i++) {
+        Animation *animation = model->Animations[i];
+        struct AnimationCompressStats stats;
+        Animation *compressed =
+            animationCompress(arena, animation, tolerance, &stats);
+        printf("%s: ", modelFilename);
+        animationCompressPrintStats(compressed, &stats);
+
+        double samples = (double)SAMPLE_FRAMES * animation->NodeCount;
+        printf("    playback %.1f -> %.1f ns per channel\n",
+               playbackTime(animation, pose) * 1e9 / samples,
+               playbackTime(compressed, pose) * 1e9 / samples);
+    }
+
+    arenaFree(arena);
+    free(pose);
+    modelFree(model);
+}
+
+double playbackTime(Animation *animation, mat4s *pose) {
+    AnimationCursor *cursors =
+        calloc(animation->NodeCount, sizeof(AnimationCursor));
+    float time = 0;
+    double start = glfwGetTime();
+    for (int frame = 0; frame < SAMPLE_FRAMES; frame++) {
+        time = animationAdvance(animation, time, SAMPLE_DELTA_TIME);
+        animationSample(animation, time, pose, cursors);
+    }
+    double result = glfwGetTime() - start;
+    free(cursors);
+    return result;
+}
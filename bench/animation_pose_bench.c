@@ -0,0 +1,102 @@
+#include "window.h"
+
+#include "animation.h"
+#include "animation_pose.h"
+#include "model.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CROWD_SIZE 2000
+#define CROWD_FRAMES 100
+#define CROWD_DELTA_TIME (1.0f / 60)
+// two clips fading into each other and an additive layer
+#define POSES_PER_COPY 3
+
+// plays a crossfade between the first two animations of a model with the
+// third added on top of the first half of its nodes, for `CROWD_SIZE` copies,
+// and prints the time per copy of each stage. pass a model name (relative to
+// `MODELS_PATH`), or leave it out for the default
+int main(int argc, char **argv) {
+    const char *modelFilename = "InterpolationTest.gltf";
+    if (argc > 1)
+        modelFilename = argv[1];
+
+    // the context is needed for uploads
+    windowCreate();
+
+    Model *model = modelLoad(modelFilename);
+    if (model->AnimationCount == 0) {
+        printf("%s has no animations\n", modelFilename);
+        exit(EXIT_FAILURE);
+    }
+    Animation *from = model->Animations[0];
+    Animation *to = model->Animations[1 % model->AnimationCount];
+    Animation *layer = model->Animations[2 % model->AnimationCount];
+
+    // everything is set up here, the frames themselves don't allocate
+    AnimationPosePool *pool = animationPosePoolCreate(model, POSES_PER_COPY);
+    float *mask = animationPoseMaskCreate(pool);
+    for (int i = 0; i < model->NodeCount / 2 + 1; i++) {
+        mask[i] = 1;
+    }
+    mat4s *parentFromLocal = malloc(CROWD_SIZE * model->NodeCount *
+                                    sizeof(mat4s));
+    float *times = malloc(CROWD_SIZE * sizeof(float));
+    for (int i = 0; i < CROWD_SIZE; i++) {
+        times[i] = fmodf(i * 7.3f, from->Duration);
+    }
+
+    double sampleTime = 0, blendTime = 0, composeTime = 0;
+    for (int frame = 0; frame < CROWD_FRAMES; frame++) {
+        float weight = (float)frame / CROWD_FRAMES;
+        for (int i = 0; i < CROWD_SIZE; i++) {
+            double start = glfwGetTime();
+            AnimationPose *fromPose = animationPoseAcquire(pool);
+            AnimationPose *toPose = animationPoseAcquire(pool);
+            AnimationPose *layerPose = animationPoseAcquire(pool);
+            times[i] = animationAdvance(from, times[i], CROWD_DELTA_TIME);
+            animationPoseReset(pool, fromPose);
+            animationPoseSample(from, times[i], fromPose, NULL);
+            animationPoseReset(pool, toPose);
+            animationPoseSample(to, fmodf(times[i], to->Duration), toPose,
+                                NULL);
+            animationPoseReset(pool, layerPose);
+            animationPoseSample(layer, fmodf(times[i], layer->Duration),
+                                layerPose, NULL);
+            double sampled = glfwGetTime();
+
+            animationPoseMakeAdditive(pool, layerPose, &pool->Rest);
+            animationPoseBlend(pool, fromPose, fromPose, toPose, weight, NULL);
+            animationPoseAdd(pool, fromPose, fromPose, layerPose, 1, mask);
+            double blended = glfwGetTime();
+
+            animationPoseToMatrices(pool, fromPose,
+                                    &parentFromLocal[i * model->NodeCount]);
+            animationPoseRelease(pool, layerPose);
+            animationPoseRelease(pool, toPose);
+            animationPoseRelease(pool, fromPose);
+            double composed = glfwGetTime();
+
+            sampleTime += sampled - start;
+            blendTime += blended - sampled;
+            composeTime += composed - blended;
+        }
+    }
+
+    double copies = (double)CROWD_FRAMES * CROWD_SIZE;
+    printf("\n%s, %d nodes, %d copies\n%12s %12s %12s\n", modelFilename,
+           model->NodeCount, CROWD_SIZE, "sample (ns)", "blend (ns)",
+           "compose (ns)");
+    printf("%12.1f %12.1f %12.1f\n", sampleTime * 1e9 / copies,
+           blendTime * 1e9 / copies, composeTime * 1e9 / copies);
+
+    free(times);
+    free(parentFromLocal);
+    animationPosePoolFree(pool);
+    modelFree(model);
+    windowClose();
+    return 0;
+}
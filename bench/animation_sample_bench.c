@@ -0,0 +1,87 @@
+#include "window.h"
+
+#include "animation.h"
+#include "model.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLE_FRAMES 20000
+#define SAMPLE_DELTA_TIME (1.0f / 60)
+
+void benchModel(const char *modelFilename);
+
+// samples every animation of each model frame by frame with cursors and at
+// random times with binary search only, and prints what one channel costs
+// each way. pass model names (relative to `MODELS_PATH`) or leave empty for
+// the default set
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"RiggedFigure.glb",
+                                   "InterpolationTest.gltf"};
+    const char **models = defaultModels;
+    int modelCount = 2;
+    if (argc > 1) {
+        models = (const char **)&argv[1];
+        modelCount = argc - 1;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+
+    printf("\n%-24s %-24s %8s %6s %14s %14s\n", "model", "animation",
+           "channels", "keys", "playback (ns)", "seek (ns)");
+    for (int i = 0; i < modelCount; i++) {
+        benchModel(models[i]);
+    }
+
+    windowClose();
+    return 0;
+}
+
+void benchModel(const char *modelFilename) {
+    Model *model = modelLoad(modelFilename);
+    mat4s *pose = malloc(model->NodeCount * sizeof(mat4s));
+    srand(1);
+
+    for (int i = 0; i < model->AnimationCount; i++) {
+        Animation *animation = model->Animations[i];
+        int channelCount = animation->NodeCount;
+        int keyCount = 0;
+        for (int j = 0; j < channelCount; j++) {
+            AnimationNode *animNode = &animation->Nodes[j];
+            keyCount += animNode->PositionKeyCount +
+                        animNode->RotationKeyCount + animNode->ScalingKeyCount;
+        }
+        AnimationCursor *cursors =
+            calloc(channelCount, sizeof(AnimationCursor));
+
+        float time = 0;
+        double start = glfwGetTime();
+        for (int frame = 0; frame < SAMPLE_FRAMES; frame++) {
+            time = animationAdvance(animation, time, SAMPLE_DELTA_TIME);
+            animationSample(animation, time, pose, cursors);
+        }
+        double playbackTime = glfwGetTime() - start;
+
+        float *times = malloc(SAMPLE_FRAMES * sizeof(float));
+        for (int frame = 0; frame < SAMPLE_FRAMES; frame++) {
+            times[frame] = (float)rand() / RAND_MAX * animation->Duration;
+        }
+        start = glfwGetTime();
+        for (int frame = 0; frame < SAMPLE_FRAMES; frame++) {
+            animationSample(animation, times[frame], pose, NULL);
+        }
+        double seekTime = glfwGetTime() - start;
+
+        double samples = (double)SAMPLE_FRAMES * channelCount;
+        printf("%-24s %-24s %8d %6d %14.1f %14.1f\n", modelFilename,
+               animation->Name, channelCount, keyCount,
+               playbackTime * 1e9 / samples, seekTime * 1e9 / samples);
+        free(times);
+        free(cursors);
+    }
+
+    free(pose);
+    modelFree(model);
+}
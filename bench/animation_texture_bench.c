@@ -0,0 +1,165 @@
+#include "window.h"
+
+#include "animation.h"
+#include "animation_texture.h"
+#include "material.h"
+#include "model.h"
+#include "model_instance.h"
+#include "shader.h"
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <cglm/struct/affine.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INSTANCE_COUNT 5000
+#define FRAME_COUNT 50
+#define FRAME_RATE 30.0f
+// times checked against the CPU over the length of the animation
+#define CHECK_COUNT 97
+
+// largest difference between the texels the texture gives at `time` and the
+// ones written from the model posed with `animationSample`
+float checkTime(AnimationTexture *texture, Animation *animation, float time,
+                mat4s *pose, mat4s *modelFromLocal, vec4s *expected);
+// bakes the first animation of a model both ways and checks the frames
+// against the CPU, on and between frames. then draws `INSTANCE_COUNT` copies
+// from the texture and the same number animated on the CPU with
+// `ModelInstance`, and prints the time per frame of both. pass a model name
+// (relative to `MODELS_PATH`) or leave empty for AnimatedCube, skinned meshes
+// like RiggedFigure.glb go through the bone matrices
+int main(int argc, char **argv) {
+    const char *modelFilename = argc > 1 ? argv[1] : "AnimatedCube.gltf";
+
+    // the context is needed for uploads
+    windowCreate();
+
+    Model *model = modelLoad(modelFilename);
+    if (model->AnimationCount == 0) {
+        printf("%s has no animations\n", modelFilename);
+        exit(EXIT_FAILURE);
+    }
+    Animation *animation = model->Animations[0];
+    uint32_t vatShader = shaderCreate("vat_vert.glsl", "fragment_shader.glsl");
+    Material *vatMaterial = materialCreate(vatShader, 0);
+    uint32_t shader =
+        shaderCreate("vertex_shader.glsl", "fragment_shader.glsl");
+    Material *material = materialCreate(shader, 0);
+    modelSetDefaultMaterial(model, material);
+
+    mat4s *pose = malloc(model->NodeCount * sizeof(mat4s));
+    mat4s *modelFromLocal = malloc(model->NodeCount * sizeof(mat4s));
+    AnimationTextureInstance *vatInstances =
+        malloc(INSTANCE_COUNT * sizeof(AnimationTextureInstance));
+    ModelInstance **instances = malloc(INSTANCE_COUNT * sizeof(void *));
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        mat4s worldFromModel = glms_translate(
+            GLMS_MAT4_IDENTITY,
+            (vec3s){{(i % 100) * 3.0f, 0, -(i / 100) * 3.0f}});
+        vatInstances[i] = (AnimationTextureInstance){
+            .WorldFromModel = worldFromModel,
+            .TimeOffset = i * 0.013f,
+        };
+        instances[i] = modelInstanceCreate(model);
+        instances[i]->WorldFromModel = worldFromModel;
+    }
+
+    enum AnimationTextureMode modes[] = {ANIMATIONTEXTURE_MATRICES,
+                                         ANIMATIONTEXTURE_VERTICES};
+    for (int m = 0; m < 2; m++) {
+        AnimationTexture *texture =
+            animationTextureBake(model, 0, FRAME_RATE, modes[m]);
+        if (texture == NULL)
+            continue;
+        if (texture->Mode != modes[m]) {
+            animationTextureFree(texture);
+            continue;
+        }
+        vec4s *expected = malloc(texture->FrameTexels * sizeof(vec4s));
+        float frameError = 0, betweenError = 0;
+        for (int i = 0; i < CHECK_COUNT; i++) {
+            float time = texture->Duration * i / CHECK_COUNT;
+            float frameTime = texture->Duration *
+                              (i % texture->FrameCount) /
+                              texture->FrameCount;
+            frameError = fmaxf(frameError,
+                               checkTime(texture, animation, frameTime, pose,
+                                         modelFromLocal, expected));
+            betweenError = fmaxf(betweenError,
+                                 checkTime(texture, animation, time, pose,
+                                           modelFromLocal, expected));
+        }
+        free(expected);
+
+        double start = glfwGetTime();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            animationTextureRender(texture, vatInstances, INSTANCE_COUNT,
+                                   frame / 60.0f, vatMaterial);
+            glFinish();
+        }
+        double drawTime = (glfwGetTime() - start) / FRAME_COUNT;
+
+        printf("\n%s, %s texture: largest error %g on frames, %g between\n",
+               modelFilename,
+               texture->Mode == ANIMATIONTEXTURE_VERTICES ? "vertex"
+                                                          : "matrix",
+               frameError, betweenError);
+        printf("%d copies from the texture:  %10.3f ms per frame\n",
+               INSTANCE_COUNT, drawTime * 1000);
+        animationTextureFree(texture);
+    }
+
+    double start = glfwGetTime();
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int i = 0; i < INSTANCE_COUNT; i++) {
+            float deltaTime = frame == 0 ? i * 0.013f : 1.0f / 60;
+            modelInstanceAnimate(instances[i], 0, deltaTime);
+            modelInstanceRender(instances[i]);
+        }
+        glFinish();
+    }
+    double cpuTime = (glfwGetTime() - start) / FRAME_COUNT;
+    printf("%d copies animated on the CPU: %9.3f ms per frame\n",
+           INSTANCE_COUNT, cpuTime * 1000);
+
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        modelInstanceFree(instances[i]);
+    }
+    free(instances);
+    free(vatInstances);
+    free(modelFromLocal);
+    free(pose);
+    modelFree(model);
+    materialFree(vatMaterial);
+    materialFree(material);
+    windowClose();
+    return 0;
+}
+
+float checkTime(AnimationTexture *texture, Animation *animation, float time,
+                mat4s *pose, mat4s *modelFromLocal, vec4s *expected) {
+    Model *model = texture->Asset;
+    for (int i = 0; i < model->NodeCount; i++) {
+        pose[i] = nodeGetParentFromLocal(model->NodeEntries[i].Node);
+    }
+    animationSample(animation, time * animation->TicksPerSec, pose, NULL);
+    for (int i = 0; i < model->NodeCount; i++) {
+        int parent = model->NodeEntries[i].ParentIndex;
+        modelFromLocal[i] =
+            i == 0 ? pose[i] : glms_mat4_mul(modelFromLocal[parent], pose[i]);
+    }
+    animationTextureWriteFrame(texture, modelFromLocal, expected);
+
+    float error = 0;
+    for (int i = 0; i < texture->FrameTexels; i++) {
+        vec4s texel = animationTextureSample(texture, time, i);
+        for (int j = 0; j < 4; j++) {
+            error = fmaxf(error, fabsf(texel.raw[j] - expected[i].raw[j]));
+        }
+    }
+    return error;
+}
@@ -0,0 +1,37 @@
+#include "window.h"
+
+#include "gltf.h"
+#include "mesh_optimize.h"
+#include "model.h"
+#include "model_cache.h"
+
+#include <stdio.h>
+
+// imports models through assimp, which prints the ACMR/ATVR of every mesh
+// before and after optimizing it. pass model names (relative to
+// `MODELS_PATH`) or leave empty for the default set
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"home.glb", "nodes_test.glb"};
+    const char **models = defaultModels;
+    int modelCount = 2;
+    if (argc > 1) {
+        models = (const char **)&argv[1];
+        modelCount = argc - 1;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+    // the cache skips the import stage entirely, and the stats should come
+    // from assimp's meshes
+    ModelNativeGltfEnabled = false;
+    ModelCacheEnabled = false;
+    MeshOptimizeEnabled = true;
+    printf("simulated FIFO cache of %d vertices\n", MESH_OPTIMIZE_FIFO_SIZE);
+    for (int i = 0; i < modelCount; i++) {
+        printf("\n%s\n", models[i]);
+        modelFree(modelLoad(models[i]));
+    }
+
+    windowClose();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "window.h"
+
+#include "model.h"
+#include "model_instance.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INSTANCE_COUNT 10000
+#define FRAME_COUNT 100
+
+// spawns `INSTANCE_COUNT` instances of one animated model, each at its own
+// point in the animation, and reports what they take and how long animating
+// all of them does. pass a model name (relative to `MODELS_PATH`) or leave
+// empty for AnimatedCube
+int main(int argc, char **argv) {
+    const char *modelFilename = argc > 1 ? argv[1] : "AnimatedCube.gltf";
+
+    // the context is needed for uploads
+    windowCreate();
+
+    double start = glfwGetTime();
+    Model *model = modelLoad(modelFilename);
+    double loadTime = glfwGetTime() - start;
+
+    ModelInstance **instances = malloc(INSTANCE_COUNT * sizeof(void *));
+    start = glfwGetTime();
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        instances[i] = modelInstanceCreate(model);
+    }
+    double spawnTime = glfwGetTime() - start;
+    // the model itself is held by the instances from here on
+    modelFree(model);
+
+    double animateTime = 0;
+    if (model->AnimationCount > 0) {
+        start = glfwGetTime();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            for (int i = 0; i < INSTANCE_COUNT; i++) {
+                // offset each instance so they don't all sample the same key
+                float deltaTime = frame == 0 ? i * 0.001f : 1.0f / 60;
+                modelInstanceAnimate(instances[i], 0, deltaTime);
+            }
+        }
+        animateTime = (glfwGetTime() - start) / FRAME_COUNT;
+    }
+
+    size_t instanceSize = modelInstanceSize(model);
+    size_t modelSize = 0;
+    for (struct Arena *block = model->Arena; block; block = block->Next) {
+        modelSize += block->Size;
+    }
+    printf("\n%s: %d nodes, %d animations\n", modelFilename, model->NodeCount,
+           model->AnimationCount);
+    printf("model load:          %10.3f ms, %zu bytes in its arena\n",
+           loadTime * 1000, modelSize);
+    printf("%d instances:     %10.3f ms, %zu bytes each\n", INSTANCE_COUNT,
+           spawnTime * 1000, instanceSize);
+    printf("animate all:         %10.3f ms per frame\n", animateTime * 1000);
+
+    for (int i = 0; i < INSTANCE_COUNT; i++) {
+        modelInstanceFree(instances[i]);
+    }
+    free(instances);
+
+    windowClose();
+    return 0;
+}
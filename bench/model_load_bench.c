@@ -0,0 +1,105 @@
+#include "window.h"
+
+#include "gltf.h"
+#include "model.h"
+#include "model_cache.h"
+#include "upload_queue.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOAD_REPEATS 10
+#define MAX_MODEL_FILES 64
+
+struct LoadResult {
+    char *Name;
+    double AssimpTime;
+    double NativeTime; // negative if the native loader falls back to assimp
+};
+
+double timeModelLoad(const char *modelPath, bool native);
+int compareNames(const void *a, const void *b);
+
+// loads every .gltf/.glb file in `MODELS_PATH` with assimp and with the native
+// glTF loader, and prints the average time of each
+int main(void) {
+    // the context is needed for uploads
+    windowCreate();
+    // the cache would hide both importers
+    ModelCacheEnabled = false;
+
+    DIR *directory = opendir(MODELS_PATH);
+    if (directory == NULL) {
+        fprintf(stderr, "couldn't open \"%s\", run from the repo root\n",
+                MODELS_PATH);
+        return EXIT_FAILURE;
+    }
+    char *names[MAX_MODEL_FILES];
+    int nameCount = 0;
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL &&
+           nameCount < MAX_MODEL_FILES) {
+        if (!gltfIsGltfFile(entry->d_name))
+            continue;
+        names[nameCount] = malloc(strlen(entry->d_name) + 1);
+        strcpy(names[nameCount++], entry->d_name);
+    }
+    closedir(directory);
+    qsort(names, nameCount, sizeof(char *), compareNames);
+
+    struct LoadResult *results = malloc(nameCount * sizeof(struct LoadResult));
+    for (int i = 0; i < nameCount; i++) {
+        results[i].Name = names[i];
+        results[i].AssimpTime = timeModelLoad(names[i], false);
+
+        char *modelFile = malloc(strlen(names[i]) + sizeof(MODELS_PATH));
+        strcpy(modelFile, MODELS_PATH);
+        strcat(modelFile, names[i]);
+        Model *nativeModel = gltfLoad(modelFile);
+        uploadQueueFlush();
+        free(modelFile);
+        if (nativeModel == NULL) {
+            results[i].NativeTime = -1;
+            continue;
+        }
+        modelFree(nativeModel);
+        results[i].NativeTime = timeModelLoad(names[i], true);
+    }
+
+    printf("\n%-40s %12s %12s %8s\n", "model", "assimp (ms)", "native (ms)",
+           "speedup");
+    for (int i = 0; i < nameCount; i++) {
+        struct LoadResult *result = &results[i];
+        if (result->NativeTime < 0)
+            printf("%-40s %12.3f %12s %8s\n", result->Name,
+                   result->AssimpTime, "fallback", "-");
+        else
+            printf("%-40s %12.3f %12.3f %7.1fx\n", result->Name,
+                   result->AssimpTime, result->NativeTime,
+                   result->AssimpTime / result->NativeTime);
+        free(result->Name);
+    }
+    free(results);
+
+    windowClose();
+    return 0;
+}
+
+// average over `LOAD_REPEATS` loads in milliseconds, including the upload
+double timeModelLoad(const char *modelPath, bool native) {
+    ModelNativeGltfEnabled = native;
+    double total = 0;
+    for (int i = 0; i < LOAD_REPEATS; i++) {
+        double start = glfwGetTime();
+        Model *model = modelLoad(modelPath);
+        glFinish();
+        total += glfwGetTime() - start;
+        modelFree(model);
+    }
+    return total / LOAD_REPEATS * 1000.0;
+}
+int compareNames(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
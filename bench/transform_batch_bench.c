@@ -0,0 +1,246 @@
+#include "arena.h"
+#include "transform.h"
+#include "transform_batch.h"
+
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/quat.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ELEMENT_COUNT 4096
+#define REPEAT_COUNT 500
+
+/// everything the kernels read and write, `ELEMENT_COUNT` of each
+struct BenchData {
+    mat4s *Left, *Right, *Results, *Expected;
+    const mat4s **LeftPointers, **RightPointers;
+    vec3s *Positions, *Scalings;
+    versors *Rotations;
+    TransformAffine *Affines, *ExpectedAffines;
+    TransformHierarchy Hierarchy;
+    int *Nodes;
+    vec4s Planes[6];
+    vec4s *Spheres;
+    bool *Visible, *ExpectedVisible;
+};
+
+double benchTime(void);
+float randomFloat(float min, float max);
+void fillData(struct Arena *arena, struct BenchData *data);
+float matrixError(const mat4s *a, const mat4s *b, int count);
+float affineError(const TransformAffine *a, const TransformAffine *b,
+                  int count);
+void printRow(const char *name, double time, double baseTime, float error);
+
+// times multiplying, composing, applying and culling `ELEMENT_COUNT` elements
+// one at a time with cglm and `transform.h`, then with the batch functions on
+// each path the CPU supports, with the largest difference from one at a time
+int main(void) {
+    struct Arena *arena = arenaCreate(ELEMENT_COUNT * 512);
+    struct BenchData data;
+    fillData(arena, &data);
+    enum TransformBatchPath widest = transformBatchGetPath();
+    printf("\n%d elements, widest path %s\n", ELEMENT_COUNT,
+           transformBatchPathName(widest));
+    printf("%-24s %12s %10s %12s\n", "", "ns each", "speedup", "max error");
+
+    double start = benchTime();
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            data.Expected[i] = glms_mat4_mul(data.Left[i], data.Right[i]);
+        }
+    }
+    double baseTime = benchTime() - start;
+    printRow("mul, glms_mat4_mul", baseTime, baseTime, 0);
+    for (int path = 0; path <= widest; path++) {
+        TransformBatchPath = path;
+        start = benchTime();
+        for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+            transformBatchMul(data.LeftPointers, data.RightPointers,
+                              data.Results, ELEMENT_COUNT);
+        }
+        printRow(transformBatchPathName(path), benchTime() - start, baseTime,
+                 matrixError(data.Results, data.Expected, ELEMENT_COUNT));
+    }
+
+    start = benchTime();
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            data.ExpectedAffines[i] = transformCompose((TransformLocal){
+                data.Rotations[i], data.Positions[i], data.Scalings[i]});
+        }
+    }
+    baseTime = benchTime() - start;
+    printRow("compose, transformCompose", baseTime, baseTime, 0);
+    for (int path = 0; path <= widest; path++) {
+        TransformBatchPath = path;
+        start = benchTime();
+        for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+            transformBatchCompose(data.Positions, data.Rotations,
+                                  data.Scalings, NULL, ELEMENT_COUNT,
+                                  data.Affines);
+        }
+        printRow(transformBatchPathName(path), benchTime() - start, baseTime,
+                 affineError(data.Affines, data.ExpectedAffines,
+                             ELEMENT_COUNT));
+    }
+
+    // every node hangs off the root, so none of them wait on another
+    TransformHierarchy *hierarchy = &data.Hierarchy;
+    start = benchTime();
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            data.Expected[i] = transformApply(hierarchy->WorldFromRoot,
+                                              data.ExpectedAffines[i]);
+        }
+    }
+    baseTime = benchTime() - start;
+    printRow("apply, transformApply", baseTime, baseTime, 0);
+    for (int path = 0; path <= widest; path++) {
+        TransformBatchPath = path;
+        start = benchTime();
+        for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+            transformBatchApply(hierarchy, data.Nodes, data.ExpectedAffines,
+                                ELEMENT_COUNT);
+        }
+        printRow(transformBatchPathName(path), benchTime() - start, baseTime,
+                 matrixError(&hierarchy->WorldFromLocal[1], data.Expected,
+                             ELEMENT_COUNT));
+    }
+
+    start = benchTime();
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            vec4s sphere = data.Spheres[i];
+            bool visible = true;
+            for (int j = 0; j < 6 && visible; j++) {
+                visible = glms_vec3_dot(glms_vec3(data.Planes[j]),
+                                        glms_vec3(sphere)) +
+                              data.Planes[j].w >=
+                          -sphere.w;
+            }
+            data.ExpectedVisible[i] = visible;
+        }
+    }
+    baseTime = benchTime() - start;
+    printRow("cull, glms_vec3_dot", baseTime, baseTime, 0);
+    for (int path = 0; path <= widest; path++) {
+        TransformBatchPath = path;
+        start = benchTime();
+        for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+            transformBatchCullSpheres(data.Planes, data.Spheres[0].raw,
+                                      sizeof(vec4s), ELEMENT_COUNT,
+                                      data.Visible);
+        }
+        int mismatches = 0;
+        for (int i = 0; i < ELEMENT_COUNT; i++) {
+            mismatches += data.Visible[i] != data.ExpectedVisible[i];
+        }
+        printRow(transformBatchPathName(path), benchTime() - start, baseTime,
+                 mismatches);
+    }
+
+    arenaFree(arena);
+    return 0;
+}
+
+double benchTime(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+float randomFloat(float min, float max) {
+    return min + (max - min) * rand() / (float)RAND_MAX;
+}
+void fillData(struct Arena *arena, struct BenchData *data) {
+    srand(1);
+    data->Left = arenaAlloc(arena, ELEMENT_COUNT * sizeof(mat4s));
+    data->Right = arenaAlloc(arena, ELEMENT_COUNT * sizeof(mat4s));
+    data->Results = arenaAlloc(arena, ELEMENT_COUNT * sizeof(mat4s));
+    data->Expected = arenaAlloc(arena, ELEMENT_COUNT * sizeof(mat4s));
+    data->LeftPointers = arenaAlloc(arena, ELEMENT_COUNT * sizeof(void *));
+    data->RightPointers = arenaAlloc(arena, ELEMENT_COUNT * sizeof(void *));
+    data->Positions = arenaAlloc(arena, ELEMENT_COUNT * sizeof(vec3s));
+    data->Rotations = arenaAlloc(arena, ELEMENT_COUNT * sizeof(versors));
+    data->Scalings = arenaAlloc(arena, ELEMENT_COUNT * sizeof(vec3s));
+    data->Affines =
+        arenaAlloc(arena, ELEMENT_COUNT * sizeof(TransformAffine));
+    data->ExpectedAffines =
+        arenaAlloc(arena, ELEMENT_COUNT * sizeof(TransformAffine));
+    data->Nodes = arenaAlloc(arena, ELEMENT_COUNT * sizeof(int));
+    data->Spheres = arenaAlloc(arena, ELEMENT_COUNT * sizeof(vec4s));
+    data->Visible = arenaAlloc(arena, ELEMENT_COUNT * sizeof(bool));
+    data->ExpectedVisible = arenaAlloc(arena, ELEMENT_COUNT * sizeof(bool));
+
+    for (int i = 0; i < ELEMENT_COUNT; i++) {
+        data->Positions[i] = (vec3s){{randomFloat(-10, 10),
+                                      randomFloat(-10, 10),
+                                      randomFloat(-10, 10)}};
+        data->Rotations[i] = glms_quat_normalize((versors){{
+            randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1),
+            randomFloat(-1, 1)}});
+        data->Scalings[i] = (vec3s){{randomFloat(0.5f, 2),
+                                     randomFloat(0.5f, 2),
+                                     randomFloat(0.5f, 2)}};
+        TransformLocal local = {data->Rotations[i], data->Positions[i],
+                                data->Scalings[i]};
+        data->Left[i] = transformToMat4(transformCompose(local));
+        data->Right[(i + 1) % ELEMENT_COUNT] = data->Left[i];
+        data->LeftPointers[i] = &data->Left[i];
+        data->RightPointers[i] = &data->Right[i];
+        data->Nodes[i] = i + 1;
+        data->Spheres[i] = (vec4s){{data->Positions[i].x * 3,
+                                    data->Positions[i].y * 3,
+                                    data->Positions[i].z * 3 - 30,
+                                    randomFloat(0.1f, 5)}};
+    }
+
+    int *parents = arenaAlloc(arena, (ELEMENT_COUNT + 1) * sizeof(int));
+    parents[0] = -1;
+    for (int i = 1; i <= ELEMENT_COUNT; i++) {
+        parents[i] = 0;
+    }
+    transformCreate(arena, &data->Hierarchy, ELEMENT_COUNT + 1, parents);
+    transformUpdate(&data->Hierarchy,
+                    transformToMat4(transformCompose((TransformLocal){
+                        data->Rotations[0], data->Positions[0],
+                        data->Scalings[0]})));
+
+    // a 90 degree frustum down -z, from 1 to 50
+    vec3s normals[6] = {{{1, 0, -1}},  {{-1, 0, -1}}, {{0, 1, -1}},
+                        {{0, -1, -1}}, {{0, 0, -1}},  {{0, 0, 1}}};
+    float distances[6] = {0, 0, 0, 0, -1, 50};
+    for (int i = 0; i < 6; i++) {
+        vec3s normal = glms_vec3_normalize(normals[i]);
+        data->Planes[i] =
+            (vec4s){{normal.x, normal.y, normal.z, distances[i]}};
+    }
+}
+float matrixError(const mat4s *a, const mat4s *b, int count) {
+    float error = 0;
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < 16; j++) {
+            error = fmaxf(error, fabsf(a[i].raw[j / 4][j % 4] -
+                                       b[i].raw[j / 4][j % 4]));
+        }
+    }
+    return error;
+}
+float affineError(const TransformAffine *a, const TransformAffine *b,
+                  int count) {
+    float error = 0;
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < 12; j++) {
+            error = fmaxf(error, fabsf(a[i].Rows[j / 4].raw[j % 4] -
+                                       b[i].Rows[j / 4].raw[j % 4]));
+        }
+    }
+    return error;
+}
+void printRow(const char *name, double time, double baseTime, float error) {
+    printf("%-24s %12.2f %9.2fx %12g\n", name,
+           time * 1e9 / REPEAT_COUNT / ELEMENT_COUNT, baseTime / time, error);
+}
@@ -0,0 +1,146 @@
+#include "arena.h"
+#include "thread_pool.h"
+#include "transform.h"
+#include "transform_scene.h"
+
+#include <cglm/struct/affine.h>
+#include <cglm/struct/quat.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NODE_COUNT 100000
+#define NODES_PER_HIERARCHY 100
+#define FRAME_COUNT 100
+
+// world transforms of every hierarchy, one after another
+mat4s *expected;
+
+double benchTime(void);
+// moves every root, so every node is worked out again each frame
+void moveRoots(mat4s *worldFromRoots, int count, int frame);
+void fillScene(struct Arena *arena, TransformHierarchy *hierarchies,
+               int count);
+float maxError(TransformHierarchy *hierarchies, int count);
+
+// builds a scene of `NODE_COUNT` nodes split into models of
+// `NODES_PER_HIERARCHY`, each a random tree, and moves every model each
+// frame. times `transformUpdate` on each model one after another, then
+// `transformSceneUpdate` from 1 to N threads. pass the largest thread count
+// or leave empty for one per core
+int main(int argc, char **argv) {
+    int maxThreads = argc > 1 ? atoi(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxThreads < 1)
+        maxThreads = 1;
+    int hierarchyCount = NODE_COUNT / NODES_PER_HIERARCHY;
+
+    struct Arena *arena =
+        arenaCreate(hierarchyCount *
+                    (transformArenaSize(NODES_PER_HIERARCHY) +
+                     ARENA_SIZE(NODES_PER_HIERARCHY * sizeof(int))));
+    TransformHierarchy *hierarchies =
+        malloc(hierarchyCount * sizeof(TransformHierarchy));
+    mat4s *worldFromRoots = malloc(hierarchyCount * sizeof(mat4s));
+    expected = malloc(NODE_COUNT * sizeof(mat4s));
+    fillScene(arena, hierarchies, hierarchyCount);
+
+    double start = benchTime();
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        moveRoots(worldFromRoots, hierarchyCount, frame);
+        for (int i = 0; i < hierarchyCount; i++) {
+            transformUpdate(&hierarchies[i], worldFromRoots[i]);
+        }
+    }
+    double serialTime = (benchTime() - start) / FRAME_COUNT;
+    for (int i = 0; i < hierarchyCount; i++) {
+        memcpy(&expected[i * NODES_PER_HIERARCHY],
+               hierarchies[i].WorldFromLocal,
+               NODES_PER_HIERARCHY * sizeof(mat4s));
+    }
+
+    TransformScene *scene = transformSceneCreate();
+    for (int i = 0; i < hierarchyCount; i++) {
+        transformSceneAdd(scene, &hierarchies[i], &worldFromRoots[i]);
+    }
+    // the first update sorts the nodes
+    transformSceneUpdate(scene);
+    printf("\n%d nodes in %d models, %d depths\n", NODE_COUNT, hierarchyCount,
+           scene->LevelCount);
+    printf("%-10s %14s %10s %12s\n", "threads", "ms per frame", "speedup",
+           "max error");
+    printf("%-10s %14.3f %10s %12s\n", "serial", serialTime * 1000, "", "");
+
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        // the calling thread works on the depths too
+        if (threads > 1)
+            threadPoolInit(threads - 1);
+        start = benchTime();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            moveRoots(worldFromRoots, hierarchyCount, frame);
+            transformSceneUpdate(scene);
+        }
+        double sceneTime = (benchTime() - start) / FRAME_COUNT;
+        printf("%-10d %14.3f %9.2fx %12g\n", threads, sceneTime * 1000,
+               serialTime / sceneTime, maxError(hierarchies, hierarchyCount));
+        threadPoolShutdown();
+    }
+
+    transformSceneFree(scene);
+    free(expected);
+    free(worldFromRoots);
+    free(hierarchies);
+    arenaFree(arena);
+    return 0;
+}
+
+double benchTime(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+void moveRoots(mat4s *worldFromRoots, int count, int frame) {
+    for (int i = 0; i < count; i++) {
+        worldFromRoots[i] = glms_translate(
+            GLMS_MAT4_IDENTITY,
+            (vec3s){{(i % 100) * 3.0f, frame * 0.01f, -(i / 100) * 3.0f}});
+    }
+}
+// each node hangs off a random node before it, like `processNodeArray` lays
+// them out
+void fillScene(struct Arena *arena, TransformHierarchy *hierarchies,
+               int count) {
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        int *parents = arenaAlloc(arena, NODES_PER_HIERARCHY * sizeof(int));
+        parents[0] = -1;
+        for (int node = 1; node < NODES_PER_HIERARCHY; node++) {
+            parents[node] = rand() % node;
+        }
+        transformCreate(arena, &hierarchies[i], NODES_PER_HIERARCHY, parents);
+        for (int node = 0; node < NODES_PER_HIERARCHY; node++) {
+            TransformLocal local = transformIdentity();
+            local.Position = (vec3s){{rand() % 100 * 0.01f, 0.5f, 0}};
+            local.Rotation = glms_quatv(rand() % 100 * 0.0628f,
+                                        (vec3s){{0, 1, 0}});
+            transformSetLocal(&hierarchies[i], node, local);
+        }
+    }
+}
+float maxError(TransformHierarchy *hierarchies, int count) {
+    float error = 0;
+    for (int i = 0; i < count; i++) {
+        for (int node = 0; node < NODES_PER_HIERARCHY; node++) {
+            mat4s a = hierarchies[i].WorldFromLocal[node];
+            mat4s b = expected[i * NODES_PER_HIERARCHY + node];
+            for (int j = 0; j < 16; j++) {
+                error = fmaxf(error,
+                              fabsf(a.col[j / 4].raw[j % 4] -
+                                    b.col[j / 4].raw[j % 4]));
+            }
+        }
+    }
+    return error;
+}
@@ -0,0 +1,57 @@
+#include "window.h"
+
+#include "gltf.h"
+#include "mesh.h"
+#include "model.h"
+#include "model_cache.h"
+
+#include <stdio.h>
+
+size_t modelGpuSize(const char *modelFilename, bool packed);
+
+// compares how much vertex and index memory models take on the GPU with
+// float vertices and with packed ones. pass model names (relative to
+// `MODELS_PATH`) or leave empty for the default set
+int main(int argc, char **argv) {
+    const char *defaultModels[] = {"home.glb", "nodes_test.glb", "suzanne.glb",
+                                   "SM_Deccer_Cubes.glb"};
+    const char **models = defaultModels;
+    int modelCount = 4;
+    if (argc > 1) {
+        models = (const char **)&argv[1];
+        modelCount = argc - 1;
+    }
+
+    // the context is needed for uploads
+    windowCreate();
+    // only meshes that go through `meshSendData` can be packed
+    ModelNativeGltfEnabled = false;
+    ModelCacheEnabled = false;
+
+    size_t floatSizes[modelCount], packedSizes[modelCount];
+    for (int i = 0; i < modelCount; i++) {
+        floatSizes[i] = modelGpuSize(models[i], false);
+        packedSizes[i] = modelGpuSize(models[i], true);
+    }
+
+    printf("\n%-30s %14s %14s %8s\n", "model", "float (bytes)",
+           "packed (bytes)", "ratio");
+    for (int i = 0; i < modelCount; i++) {
+        printf("%-30s %14zu %14zu %7.2fx\n", models[i], floatSizes[i],
+               packedSizes[i], (double)floatSizes[i] / packedSizes[i]);
+    }
+
+    windowClose();
+    return 0;
+}
+
+size_t modelGpuSize(const char *modelFilename, bool packed) {
+    MeshPackingEnabled = packed;
+    Model *model = modelLoad(modelFilename);
+    size_t size = 0;
+    for (int i = 0; i < model->MeshCount; i++) {
+        size += model->Meshes[i]->GpuSize;
+    }
+    modelFree(model);
+    return size;
+}
@@ -1,29 +1,66 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
+#include "arena.h"
 #include "node.h"
 #include <assimp/scene.h>
 #include <cglm/types-struct.h>
+#include <stdint.h>
 
+struct Mesh;
+
+enum AnimationInterpolation {
+    ANIMATIONINTERP_STEP,
+    ANIMATIONINTERP_LINEAR,
+    ANIMATIONINTERP_SMOOTHSTEP,
+};
+/// the key each of a channel's tracks was last sampled at, so playing
+/// forwards only has to look at the one after it
 typedef struct {
-    int Time;
-    vec3s Value;
-} AnimationVectorKey;
+    int Position, Rotation, Scaling;
+} AnimationCursor;
+
+/// values of a track stored by `animationCompress`. positions and scales are
+/// 16 bit fractions of `Extent` above `Min`, rotations are smallest three:
+/// the index of the largest component in 2 bits and the other three in 15
+/// bits each
 typedef struct {
-    int Time;
-    versors Value;
-} AnimationQuaternionKey;
+    uint16_t (*Keys)[3];
+    vec3s Min, Extent;
+} AnimationPackedTrack;
 
 typedef struct {
     int PositionKeyCount, RotationKeyCount, ScalingKeyCount;
-    AnimationVectorKey *PositionKeys;
-    AnimationQuaternionKey *RotationKeys;
-    AnimationVectorKey *ScalingKeys;
+    /// key times in ticks, ascending. the value of each key is at the same
+    /// index in the matching `Values` array
+    float *PositionTimes, *RotationTimes, *ScalingTimes;
+    vec3s *PositionValues;
+    versors *RotationValues;
+    vec3s *ScalingValues;
+    /// used when the matching `Values` array is NULL
+    AnimationPackedTrack PackedPositions, PackedRotations, PackedScalings;
     struct Node *Node;
-    /// interpolation function to use for this animation node; set with
-    /// `animationCreate`
-    float (*InterpFunction)(float);
+    /// set with `animationCreate`, one per track since a file can sample
+    /// each of them differently
+    enum AnimationInterpolation PositionInterpolation, RotationInterpolation,
+        ScalingInterpolation;
+    /// used by `animationStep`
+    AnimationCursor Cursor;
 } AnimationNode;
+/// weights of the morph targets of the meshes on one node, every key has
+/// one for each target
+typedef struct {
+    struct Node *Node;
+    int KeyCount;
+    /// key times in ticks, ascending
+    float *Times;
+    /// `TargetCount` weights per key, targets a key leaves out are 0
+    int TargetCount;
+    float *Weights;
+    enum AnimationInterpolation Interpolation;
+    /// used by `animationSampleMorphs`
+    int Cursor;
+} AnimationMorphChannel;
 typedef struct {
     int Duration; // in ticks
     float Time;
@@ -31,18 +68,86 @@ typedef struct {
     int NodeCount;
     AnimationNode *Nodes;
     char *Name;
+    /// frames sampled by `animationBake`, played instead of the keys. NULL
+    /// when it isn't baked
+    struct AnimationBake *Bake;
+    /// morph target weight tracks, 0 and NULL for animations without any
+    int MorphChannelCount;
+    AnimationMorphChannel *MorphChannels;
+    /// the model's meshes, which `Node::Meshes` index into
+    struct Mesh **Meshes;
 } Animation;
 
-// interpolation functions
-float StepInterp(float x);
-float LinearInterp(float x);
-float SmoothStepInterp(float x);
-
-/// free with `animationFree`
-Animation *animationCreate(const struct aiScene *scene, char *name,
-                           struct Node *rootNode);
-/// step animation using `InterpFunction` defined by each node
+/// allocates the animation and its keys from `arena`. `meshes` are the
+/// model's, for the morph target channels
+Animation *animationCreate(struct Arena *arena, const struct aiScene *scene,
+                           char *name, struct Node *rootNode,
+                           struct Mesh **meshes);
+/// how much `animationCreate` takes from an arena for the morph channels of
+/// `animation`
+size_t animationMorphArenaSize(const struct aiAnimation *animation);
+/// copies the morph channels of `from` into `to`, allocated from `arena`
+void animationCopyMorphChannels(struct Arena *arena, Animation *to,
+                                const Animation *from);
+/// step animation using the interpolations of each node. writes to the nodes
+/// and meshes themselves, so every user of the model sees the same pose
 void animationStep(Animation *animation, float deltaTime);
-void animationFree(Animation *animation);
+/// sets the morph weights of the meshes the morph channels animate to the
+/// ones at `time` (in ticks)
+void animationSampleMorphs(Animation *animation, float time);
+/// returns `time` moved on by `deltaTime` seconds, wrapped to `Duration`
+float animationAdvance(Animation *animation, float time, float deltaTime);
+/// writes the pose at `time` (in ticks) to `pose`, indexed by `Node::Index`.
+/// nodes the animation doesn't touch are left alone. `cursors` has one entry
+/// per node of the animation and makes playing forwards O(1) per track, it
+/// can be NULL to binary search every key instead
+void animationSample(Animation *animation, float time, mat4s *pose,
+                     AnimationCursor *cursors);
+/// like `animationSample`, into the local transforms of `transforms`, and
+/// marks the nodes it sets for `transformUpdate`
+void animationSampleTransforms(Animation *animation, float time,
+                               TransformHierarchy *transforms,
+                               AnimationCursor *cursors);
+/// local matrix of `Nodes[channel]` at `time`, `cursor` can be NULL
+mat4s animationSampleChannel(Animation *animation, int channel, float time,
+                             AnimationCursor *cursor);
+/// `animationSampleChannel` before it's made into a matrix
+TransformLocal animationSampleChannelLocal(Animation *animation, int channel,
+                                           float time,
+                                           AnimationCursor *cursor);
+/// samples `count` copies of the animation at once, copy `i` at `times[i]`
+/// into `poses + i * poseStride` (indexed by `Node::Index`). `cursors` has
+/// `NodeCount` entries per copy, or is NULL. rotations use nlerp, corrected
+/// to stay within about 1e-3 radians of `animationSample`'s slerp
+void animationSampleBatch(Animation *animation, int count, const float *times,
+                          AnimationCursor *cursors, mat4s *poses,
+                          int poseStride);
+/// value of a position or scaling track at `time`, `packed` is used when
+/// `values` is NULL. `cursor` works like in `animationFindKey`
+vec3s animationSampleVec(const float *times, const vec3s *values,
+                         const AnimationPackedTrack *packed, int keyCount,
+                         float time, int *cursor,
+                         enum AnimationInterpolation interpolation);
+versors animationSampleQuat(const float *times, const versors *values,
+                            const AnimationPackedTrack *packed, int keyCount,
+                            float time, int *cursor,
+                            enum AnimationInterpolation interpolation);
+vec3s animationDecodeVec(const AnimationPackedTrack *packed, int key);
+versors animationDecodeQuat(const AnimationPackedTrack *packed, int key);
+/// translation * rotation * scale
+mat4s animationCompose(vec3s position, versors rotation, vec3s scale);
+/// cubic ease in and out, stands in for cubic spline keys
+float animationSmoothStep(float x);
+/// allocates the time and value arrays of `animNode` from `arena`
+void animationNodeAlloc(struct Arena *arena, AnimationNode *animNode,
+                        int positionKeyCount, int rotationKeyCount,
+                        int scalingKeyCount);
+/// how much `animationNodeAlloc` takes from an arena
+size_t animationNodeArenaSize(int positionKeyCount, int rotationKeyCount,
+                              int scalingKeyCount);
+/// index of the last key at or before `time`, 0 when `time` comes before all
+/// of them. `cursor` is where to start looking and gets the result
+int animationFindKey(const float *times, int keyCount, float time,
+                     int *cursor);
 
 #endif // !ANIMATION_H
@@ -0,0 +1,59 @@
+#ifndef ANIMATION_BAKE_H
+#define ANIMATION_BAKE_H
+
+#include "animation.h"
+#include "arena.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// default for `AnimationBakeFrameRate`
+#define ANIMATION_BAKE_FRAME_RATE 30.0f
+/// default for `AnimationBakeBudget`
+#define ANIMATION_BAKE_BUDGET (1 << 20)
+
+/// set to true to have models bake their animations when they're loaded
+extern bool AnimationBakeEnabled;
+/// frames per second of baked animations
+extern float AnimationBakeFrameRate;
+/// most bytes one animation's frames may take, animations that need more
+/// keep sampling their keys
+extern size_t AnimationBakeBudget;
+/// blend between the two frames around the time, or snap to the closest one
+extern bool AnimationBakeBlend;
+
+/// one channel of one frame
+typedef struct {
+    versors Rotation;
+    vec3s Position;
+    vec3s Scaling;
+} AnimationBakedKey;
+/// an animation sampled at a fixed rate, set as `Animation::Bake`. it belongs
+/// to the animation, so every instance of a model plays from the same frames
+struct AnimationBake {
+    int FrameCount;
+    /// frames are spread evenly from 0 to `Duration`, both included
+    float FramesPerTick;
+    bool Blend;
+    /// `FrameCount` frames of `NodeCount` keys each
+    AnimationBakedKey *Frames;
+};
+
+/// samples `animation` at `frameRate` frames per second into `arena` and
+/// sets `Bake`. leaves it alone and returns false when the frames would take
+/// more than `budget` bytes. prints what it took either way
+bool animationBake(struct Arena *arena, Animation *animation, float frameRate,
+                   size_t budget, bool blend);
+/// bytes `animationBake` takes for `animation` at `frameRate`
+size_t animationBakeSize(const Animation *animation, float frameRate);
+/// `animationSample` for baked animations. step channels aren't blended, so
+/// their keys can show up to a frame off
+void animationBakeSample(const Animation *animation, float time, mat4s *pose);
+/// local matrix of one channel of a baked animation
+mat4s animationBakeSampleChannel(const Animation *animation, int channel,
+                                 float time);
+/// the parts of one channel of a baked animation, before they're composed
+AnimationBakedKey animationBakeSampleKey(const Animation *animation,
+                                         int channel, float time);
+
+#endif // !ANIMATION_BAKE_H
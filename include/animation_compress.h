@@ -0,0 +1,40 @@
+#ifndef ANIMATION_COMPRESS_H
+#define ANIMATION_COMPRESS_H
+
+#include "animation.h"
+#include "arena.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// default for `AnimationCompressTolerance`
+#define ANIMATION_COMPRESS_TOLERANCE 1e-3f
+
+/// set to true to have loaders keep animations compressed
+extern bool AnimationCompressEnabled;
+/// how far a dropped key may be from what its neighbours interpolate to:
+/// distance for positions and scales, radians for rotations
+extern float AnimationCompressTolerance;
+
+struct AnimationCompressStats {
+    /// bytes of key times and values
+    size_t SizeBefore, SizeAfter;
+    int KeyCountBefore, KeyCountAfter;
+    /// largest difference from the original, sampled at and halfway between
+    /// its keys
+    float PositionError, RotationError, ScalingError;
+};
+
+/// copies `animation` into `arena` without the keys its neighbours can
+/// interpolate to within `tolerance`, and with the rest quantized (see
+/// `AnimationPackedTrack`). rotations with keys about half a turn apart aren't
+/// quantized. `animation` is left as it is, so it can be built in a temporary
+/// arena
+Animation *animationCompress(struct Arena *arena, const Animation *animation,
+                             float tolerance,
+                             struct AnimationCompressStats *stats);
+/// prints `stats` the way loaders report compressed animations
+void animationCompressPrintStats(const Animation *animation,
+                                 const struct AnimationCompressStats *stats);
+
+#endif // !ANIMATION_COMPRESS_H
@@ -0,0 +1,71 @@
+#ifndef ANIMATION_LOD_H
+#define ANIMATION_LOD_H
+
+#include "animation.h"
+
+#include <cglm/types-struct.h>
+#include <stdbool.h>
+
+#define ANIMATION_LOD_COUNT 4
+
+/// set to false to sample every animation fully every frame, visible or not
+extern bool AnimationLodEnabled;
+/// part of the screen height a model has to cover to get each LOD, the last
+/// LOD gets the rest
+extern float AnimationLodScreenSizes[ANIMATION_LOD_COUNT - 1];
+/// times a second animations are sampled at each LOD, 0 for every frame
+extern float AnimationLodUpdateRates[ANIMATION_LOD_COUNT];
+/// channels of nodes deeper than this in the hierarchy keep their last pose
+/// at each LOD, -1 samples all of them
+extern int AnimationLodMaxDepths[ANIMATION_LOD_COUNT];
+
+/// channel evaluations of the frame since `animationLodBeginFrame`
+struct AnimationLodCounters {
+    int Evaluated;
+    /// the model was outside the frustum
+    int SkippedHidden;
+    /// the model wasn't due for an update at its LOD
+    int SkippedThrottled;
+    /// the channel's node was too deep for the LOD
+    int SkippedMinor;
+};
+extern struct AnimationLodCounters AnimationLodCounters;
+
+/// one playing animation of a model or instance
+typedef struct {
+    Animation *Animation;
+    /// indexed by `Node::Index` like in `animationSample`, or NULL to write
+    /// to the nodes like `animationStep`
+    mat4s *Pose;
+    /// one per channel, or NULL
+    AnimationCursor *Cursors;
+    /// in ticks. keeps running while the animation isn't sampled, so it's in
+    /// sync again when it is
+    float Time;
+    /// seconds since it was last sampled
+    float SinceUpdate;
+    /// bounding sphere in model space, see `modelBounds`
+    vec3s BoundsCenter;
+    float BoundsRadius;
+    /// picked by the last `animationLodUpdate`, `ANIMATION_LOD_COUNT` when
+    /// it wasn't visible
+    int Lod;
+} AnimationLodState;
+
+/// starts the animation at time 0, sampled on the first update
+AnimationLodState animationLodCreate(Animation *animation, mat4s *pose,
+                                     AnimationCursor *cursors,
+                                     vec3s boundsCenter, float boundsRadius);
+/// resets `AnimationLodCounters`
+void animationLodBeginFrame(void);
+/// moves the clock on and samples the animation if it's visible and due at
+/// its LOD. the LOD comes from the bounds under `worldFromModel` and the view
+/// and projection in `rendering.h`
+void animationLodUpdate(AnimationLodState *state, mat4s worldFromModel,
+                        float deltaTime);
+/// LOD of the bounds from the current camera, `ANIMATION_LOD_COUNT` when
+/// they're outside the frustum
+int animationLodPick(vec3s boundsCenter, float boundsRadius,
+                     mat4s worldFromModel);
+
+#endif // !ANIMATION_LOD_H
@@ -0,0 +1,75 @@
+#ifndef ANIMATION_POSE_H
+#define ANIMATION_POSE_H
+
+#include "animation.h"
+#include "arena.h"
+#include "model.h"
+
+#include <cglm/types-struct.h>
+
+/// local transform of every node of a model, split into one array per part
+/// so blending runs down each of them. indexed by `Node::Index`
+typedef struct AnimationPose {
+    vec3s *Positions;
+    versors *Rotations;
+    vec3s *Scalings;
+    /// next pose on the free list while it's in the pool
+    struct AnimationPose *NextFree;
+} AnimationPose;
+
+/// a fixed number of poses for one model, all allocated up front so sampling
+/// and blending every frame doesn't allocate
+typedef struct {
+    /// the pool, its poses and masks come from here
+    struct Arena *Arena;
+    int NodeCount;
+    int Capacity;
+    AnimationPose *Poses;
+    AnimationPose *FirstFree;
+    /// the pose the nodes were in when the pool was made, nodes no clip
+    /// touches keep it
+    AnimationPose Rest;
+} AnimationPosePool;
+
+/// `capacity` poses for `model`, free with `animationPosePoolFree`
+AnimationPosePool *animationPosePoolCreate(Model *model, int capacity);
+void animationPosePoolFree(AnimationPosePool *pool);
+/// takes a pose out of the pool, its contents are whatever the last user
+/// left. exits when they're all in use
+AnimationPose *animationPoseAcquire(AnimationPosePool *pool);
+void animationPoseRelease(AnimationPosePool *pool, AnimationPose *pose);
+/// one weight per node for the blend functions, all 0. lives as long as the
+/// pool
+float *animationPoseMaskCreate(AnimationPosePool *pool);
+/// sets the weight of `node` and everything below it
+void animationPoseMaskSet(float *mask, struct Node *node, float weight);
+
+/// copies the rest pose into `pose`
+void animationPoseReset(AnimationPosePool *pool, AnimationPose *pose);
+/// writes the channels of `animation` at `time` (in ticks) to `pose`, nodes it
+/// doesn't touch are left alone. `cursors` works like in `animationSample`
+void animationPoseSample(Animation *animation, float time, AnimationPose *pose,
+                         AnimationCursor *cursors);
+/// crossfade: `out` gets `from` moved `weight` of the way to `to`, scaled per
+/// node by `mask` when it isn't NULL. `out` can be either of them
+void animationPoseBlend(AnimationPosePool *pool, AnimationPose *out,
+                        const AnimationPose *from, const AnimationPose *to,
+                        float weight, const float *mask);
+/// turns `pose` into how far it is from `reference`, for `animationPoseAdd`
+void animationPoseMakeAdditive(AnimationPosePool *pool, AnimationPose *pose,
+                               const AnimationPose *reference);
+/// puts `weight` of the difference made by `animationPoseMakeAdditive` on top
+/// of `base`, scaled per node by `mask` when it isn't NULL. `out` can be
+/// `base`
+void animationPoseAdd(AnimationPosePool *pool, AnimationPose *out,
+                      const AnimationPose *base, const AnimationPose *additive,
+                      float weight, const float *mask);
+/// the final step, composes the matrix of every node into `parentFromLocal`
+/// (indexed by `Node::Index`, like the pose of `animationSample`)
+void animationPoseToMatrices(AnimationPosePool *pool, const AnimationPose *pose,
+                             mat4s *parentFromLocal);
+/// same as `animationPoseToMatrices`, straight into the nodes of `model`
+void animationPoseApply(AnimationPosePool *pool, const AnimationPose *pose,
+                        Model *model);
+
+#endif // !ANIMATION_POSE_H
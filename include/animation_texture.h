@@ -0,0 +1,100 @@
+#ifndef ANIMATION_TEXTURE_H
+#define ANIMATION_TEXTURE_H
+
+#include "arena.h"
+#include "material.h"
+#include "model.h"
+
+#include <cglm/types-struct.h>
+#include <stdint.h>
+
+/// most texels in a row of the frame texture, frames carry on into the next
+/// row
+#define ANIMATION_TEXTURE_WIDTH 4096
+/// texture unit `vat_vert.glsl` reads the frames from, above the ones
+/// materials use
+#define ANIMATION_TEXTURE_UNIT 7
+/// shader storage binding of the instances
+#define ANIMATION_TEXTURE_INSTANCE_BINDING 3
+
+enum AnimationTextureMode {
+    /// model space matrix of every node, then of every bone, three texels
+    /// (the rows) each. skinned meshes are skinned in the vertex shader
+    ANIMATIONTEXTURE_MATRICES,
+    /// model space position and normal of every vertex of every draw, two
+    /// texels each. needs `Mesh::Vertices`, which meshes loaded by the cache
+    /// and the ones `gltfLoad` uploads straight from the file don't have
+    ANIMATIONTEXTURE_VERTICES,
+};
+
+/// one mesh of one node, drawn once for all instances
+struct AnimationTextureDraw {
+    /// position in `Model::NodeEntries`
+    int NodeIndex;
+    /// index in `Model::Meshes`
+    int Mesh;
+    /// its first vertex in a frame, for `ANIMATIONTEXTURE_VERTICES`
+    int VertexBase;
+};
+/// a looping animation played ahead of time into a float texture, so copies
+/// of the model are animated entirely on the GPU
+typedef struct {
+    /// the texture and its arrays come from here
+    struct Arena *Arena;
+    /// holds a reference to it until `animationTextureFree`
+    Model *Asset;
+    enum AnimationTextureMode Mode;
+
+    /// frames are spread evenly from 0 to just before `Duration`, the last
+    /// one blends into the first
+    int FrameCount;
+    /// length of the animation in seconds
+    float Duration;
+    /// texels each frame takes
+    int FrameTexels;
+    int Width, Height;
+    /// the contents of the texture, kept for `animationTextureSample`
+    vec4s *Texels;
+
+    int DrawCount;
+    struct AnimationTextureDraw *Draws;
+
+    uint32_t Texture;
+    /// GL buffer the instances are uploaded to on every render
+    uint32_t InstanceBuffer;
+} AnimationTexture;
+
+/// laid out like `Instance` in `vat_vert.glsl`
+typedef struct {
+    mat4s WorldFromModel;
+    /// seconds the instance is ahead of the clock passed to
+    /// `animationTextureRender`
+    float TimeOffset;
+    float _padding[3];
+} AnimationTextureInstance;
+
+/// plays `model->Animations[animation]` with `animationStep` at `frameRate`
+/// frames per second and uploads the frames. the nodes, morph weights, time
+/// and cursors of the animation are put back afterwards.
+/// `ANIMATIONTEXTURE_VERTICES` falls back to matrices when the vertices aren't
+/// there or the frames don't fit in `GL_MAX_TEXTURE_SIZE` rows. NULL when
+/// the matrices don't fit either
+AnimationTexture *animationTextureBake(Model *model, int animation,
+                                       float frameRate,
+                                       enum AnimationTextureMode mode);
+/// writes one frame from the model space transform of every node
+/// (indexed by `Node::Index`) to `texels`, `FrameTexels` of them
+void animationTextureWriteFrame(const AnimationTexture *texture,
+                                const mat4s *modelFromLocal, vec4s *texels);
+/// what `vat_vert.glsl` reads for `texel` of a frame at `time` seconds
+vec4s animationTextureSample(const AnimationTexture *texture, float time,
+                             int texel);
+/// draws `count` copies of the model, each at `time` plus its own offset, in
+/// one instanced draw per mesh. `material` has to use `vat_vert.glsl`
+void animationTextureRender(AnimationTexture *texture,
+                            const AnimationTextureInstance *instances,
+                            int count, float time, Material *material);
+/// drops the reference to `Asset`
+void animationTextureFree(AnimationTexture *texture);
+
+#endif // !ANIMATION_TEXTURE_H
@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/// every allocation starts on this boundary, enough for `mat4s`
+#define ARENA_ALIGNMENT 16
+/// what an allocation of `size` bytes takes up in the arena, for sizing one
+/// up front
+#define ARENA_SIZE(size)                                                      \
+    (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/// a block of memory that allocations are cut from and that is freed all at
+/// once. when it runs out another block is chained on, so a size that is too
+/// small only costs an extra `malloc`
+struct Arena {
+    size_t Size, Used;
+    struct Arena *Next;
+    char *Data;
+};
+
+/// free with `arenaFree`
+struct Arena *arenaCreate(size_t size);
+/// the memory is not cleared
+void *arenaAlloc(struct Arena *arena, size_t size);
+void *arenaCalloc(struct Arena *arena, size_t size);
+/// NULL stays NULL
+char *arenaCopyString(struct Arena *arena, const char *string);
+/// frees the arena and everything allocated from it
+void arenaFree(struct Arena *arena);
+
+#endif // !ARENA_H
@@ -0,0 +1,52 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum AssetType {
+    ASSETTYPE_MODEL,
+    ASSETTYPE_MESH,
+    ASSETTYPE_TEXTURE,
+    ASSETTYPE_MATERIAL,
+    ASSETTYPE_SHADER,
+};
+
+/// refers to a registered asset. the generation changes when the slot is
+/// reused, so a handle to an asset that was freed stays invalid. generation 0
+/// is never handed out, a zeroed handle is always invalid
+typedef struct {
+    uint32_t Index;
+    uint32_t Generation;
+} AssetHandle;
+
+#define ASSET_HANDLE_NULL ((AssetHandle){0, 0})
+
+/// registers `data` with a reference count of 1. `path` is normalized and
+/// used to find the asset again with `assetFind`; NULL registers an asset
+/// that can only be reached through its handle. `onRelease` is called with
+/// `data` when the last reference is released, and may be NULL. can be called
+/// from any thread
+AssetHandle assetRegister(enum AssetType type, const char *path, void *data,
+                          void (*onRelease)(void *data));
+/// looks up an asset by path and adds a reference to it. returns
+/// `ASSET_HANDLE_NULL` if there is none
+AssetHandle assetFind(enum AssetType type, const char *path);
+/// adds a reference, returns `handle` for convenience
+AssetHandle assetAcquire(AssetHandle handle);
+/// drops a reference, freeing the asset if it was the last one. returns
+/// true if it was freed. invalid handles are ignored
+bool assetRelease(AssetHandle handle);
+/// NULL if the handle is invalid or refers to another type of asset
+void *assetGet(AssetHandle handle, enum AssetType type);
+/// 0 for invalid handles
+int assetRefCount(AssetHandle handle);
+/// frees every asset of `type` regardless of references
+void assetReleaseAll(enum AssetType type);
+/// returns a copy of `path` with `\` turned into `/`, repeated slashes, `.`
+/// and `dir/..` removed. free with `free`
+char *assetNormalizePath(const char *path);
+/// frees the registry itself, warning about assets that were never released
+void assetRegistryFree();
+
+#endif // !ASSET_H
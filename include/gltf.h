@@ -0,0 +1,22 @@
+#ifndef GLTF_H
+#define GLTF_H
+
+#include "model.h"
+
+#include <stdbool.h>
+
+/// set to false to load .gltf/.glb files through assimp as well
+extern bool ModelNativeGltfEnabled;
+
+/// returns true if `modelFile` has a .gltf or .glb extension
+bool gltfIsGltfFile(const char *modelFile);
+/// loads a glTF 2.0 file (path including `MODELS_PATH`) without assimp.
+/// primitives nothing re-encodes share one buffer, uploaded to the GPU
+/// straight from the vertex and index buffer views of the mapped file. the
+/// rest are decoded into `Mesh::Vertices` so they can be optimized and cached
+/// like the ones from assimp. returns NULL if the file uses something this
+/// loader doesn't handle (skins, morph targets, missing normals, ...) so the
+/// caller can fall back to assimp
+Model *gltfLoad(const char *modelFile);
+
+#endif // !GLTF_H
@@ -0,0 +1,53 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum JsonType {
+    JSONTYPE_NULL,
+    JSONTYPE_BOOL,
+    JSONTYPE_NUMBER,
+    JSONTYPE_STRING,
+    JSONTYPE_ARRAY,
+    JSONTYPE_OBJECT,
+};
+
+/// a value in the source text; nothing is decoded until it is asked for
+struct JsonToken {
+    enum JsonType Type;
+    /// range in the source. strings don't include the quotes
+    int Start, Length;
+    /// number of elements for arrays, number of key/value pairs for objects
+    int ChildCount;
+    /// index of the first token after this value and all of its children
+    int Next;
+};
+/// tokens are stored depth first, so the children of a token directly follow
+/// it. an object's children alternate between key and value
+typedef struct {
+    const char *Source;
+    int TokenCount;
+    struct JsonToken *Tokens;
+} Json;
+
+/// tokenizes `source` without copying it, so it needs to outlive the result.
+/// returns NULL if the text isn't valid json. free with `jsonFree`
+Json *jsonParse(const char *source, size_t length);
+/// returns the token index of the value under `key`, -1 if it isn't there
+int jsonObjectGet(Json *json, int object, const char *key);
+/// returns the token index of the element, -1 if out of range
+int jsonArrayGet(Json *json, int array, int index);
+/// returns number of elements/pairs, 0 for missing tokens (-1)
+int jsonCount(Json *json, int token);
+/// returns `fallback` for missing tokens (-1)
+double jsonNumber(Json *json, int token, double fallback);
+int jsonInt(Json *json, int token, int fallback);
+bool jsonBool(Json *json, int token, bool fallback);
+bool jsonStringEquals(Json *json, int token, const char *string);
+/// returns a decoded copy of a string token, NULL for missing tokens. free
+/// with `free`
+char *jsonStringCopy(Json *json, int token);
+void jsonFree(Json *json);
+
+#endif // !JSON_H
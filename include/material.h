@@ -1,6 +1,7 @@
 #ifndef MATERIAL_H
 #define MATERIAL_H
 
+#include "asset.h"
 #include "texture.h"
 
 /// all types that can be defined as uniforms in shaders. if you want to add
@@ -45,6 +46,8 @@ typedef struct {
 
     int PropertyCount;
     MaterialProperty **Properties;
+
+    AssetHandle Handle;
 } Material;
 
 /// returns material for use with models
@@ -55,6 +58,9 @@ void materialApplyProperties(Material *material);
 Material *materialCopy(Material *source);
 void materialChangeProperty(Material *material, const char *propertyName,
                             void *newData);
+/// adds a reference for another user of the material, returns `material`
+Material *materialAcquire(Material *material);
+/// drops a reference, the material is freed with the last one
 void materialFree(Material *material);
 
 #endif // !MATERIAL_H
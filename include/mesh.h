@@ -1,14 +1,56 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include "arena.h"
+#include "asset.h"
+
 #include <cglm/types-struct.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/// most bones one mesh can have, `Vertex::Joints` are 8 bit
+#define MESH_MAX_BONES 256
+/// smallest change a morph target makes to a vertex for it to be kept
+#define MESH_MORPH_EPSILON 1e-6f
+
 struct Vertex {
     vec3s Position;
     vec3s Normal;
     vec2s TexCoords;
     vec3s Color;
+    /// up to four bones, counted from the mesh's `BoneOffset`. the weights
+    /// add up to 1, or are all 0 for meshes that aren't skinned
+    uint8_t Joints[4];
+    float Weights[4];
+};
+/// what `meshSendData` uploads `struct Vertex` as when `MeshPackingEnabled`
+/// is set, 28 bytes instead of 64
+struct PackedVertex {
+    /// snorm16 inside the mesh bounds, see `Mesh::PositionOffset`. the last
+    /// one is padding
+    int16_t Position[4];
+    /// octahedral encoded, snorm16
+    int16_t Normal[2];
+    /// half floats
+    uint16_t TexCoords[2];
+    /// unorm8, alpha is always 255
+    uint8_t Color[4];
+    uint8_t Joints[4];
+    /// unorm8
+    uint8_t Weights[4];
+};
+/// one vertex a morph target moves, laid out like `MorphDelta` in
+/// `morph_comp.glsl`
+struct MorphDelta {
+    uint32_t Vertex;
+    vec3s Position;
+    vec3s Normal;
+    uint32_t _padding;
+};
+enum MeshVertexFormat {
+    MESHFORMAT_FLOAT,
+    MESHFORMAT_PACKED,
 };
 struct Mesh {
     int VertexCount;
@@ -16,17 +58,80 @@ struct Mesh {
 
     int IndexCount;
     uint32_t *Indices;
+    /// GL type of the uploaded indices and where they start in the element
+    /// buffer. `meshSendData` uses 16 bit indices when they fit, the offset
+    /// is 0 unless the mesh came from `gltfLoad`
+    uint32_t IndexType;
+    uint64_t IndexOffset;
+
+    /// format of the uploaded vertices, set by `meshSendData`
+    enum MeshVertexFormat VertexFormat;
+    /// shaders get positions back with `offset + stored * scale`; zero and
+    /// one unless packed
+    vec3s PositionOffset, PositionScale;
+    /// bytes of vertex and index data uploaded by `meshSendData`
+    size_t GpuSize;
+
+    /// sphere around all the vertices, in model space
+    vec3s BoundsCenter;
+    float BoundsRadius;
+
+    /// bones of `Model::Bones` the vertices' `Joints` refer to, `BoneCount`
+    /// of them from `BoneOffset`. 0 for meshes that aren't skinned, which is
+    /// what `meshLoad` leaves them at
+    int BoneOffset, BoneCount;
+    /// blend shapes, stored as only the vertices each one moves: target `i`
+    /// is `MorphDeltas` from `MorphTargetOffsets[i]` up to
+    /// `MorphTargetOffsets[i + 1]`. 0 and NULL for meshes without any
+    int MorphTargetCount, MorphDeltaCount;
+    int *MorphTargetOffsets;
+    struct MorphDelta *MorphDeltas;
+    /// how much of each target is applied, set with `meshSetMorphWeight`
+    float *MorphWeights;
+    /// GL buffer `MorphDeltas` are uploaded to by `skinningUpdate`
+    uint32_t MorphBuffer;
+    /// vertices written by `skinningUpdate` for meshes that are skinned or
+    /// have morph targets, 0 until it first runs on the mesh. world space
+    /// when skinned, the mesh's own otherwise
+    uint32_t SkinnedVAO, SkinnedVBO;
+    /// set when the bones the mesh uses have moved or its morph weights
+    /// changed since it was last skinned
+    bool SkinnedDirty;
+
+    /// set by `meshletBuild`, NULL for meshes that are always drawn whole
+    struct Meshlet *Meshlets;
+    int MeshletCount;
 
     uint32_t VAO, VBO, EBO;
     int MaterialIndex;
+
+    /// registered as "<model file>#<index>" by `modelLoad`, the model owns
+    /// the mesh so this only lets it be looked up
+    AssetHandle Handle;
 };
 
-/// creates OpenGL buffers with supplied vertices and indices. free with
-/// `meshFree`
-struct Mesh *meshLoad(struct Vertex *vertices, uint32_t *indices,
-                      int vertexCount, int indexCount);
+/// set to false to upload `struct Vertex` as it is. indices are 16 bit
+/// whenever they fit either way
+extern bool MeshPackingEnabled;
+
+/// allocates the mesh from `arena`. the vertices and indices aren't copied
+/// and stay owned by the caller. `meshFree` deletes the GL objects. the
+/// bounds are worked out from `vertices`, loaders that don't have them set
+/// the bounds with `meshSetBounds`
+struct Mesh *meshLoad(struct Arena *arena, struct Vertex *vertices,
+                      uint32_t *indices, int vertexCount, int indexCount);
+/// sets the bounding sphere to the one around the box from `min` to `max`
+void meshSetBounds(struct Mesh *mesh, vec3s min, vec3s max);
 void meshSendData(struct Mesh *mesh);
+/// same as `meshSendData`, but through the upload queue so it can be called
+/// from any thread. `Vertices` and `Indices` need to stay valid until then
+void meshQueueSendData(struct Mesh *mesh);
+/// skinned meshes are moved to world space by the bone palette bound by
+/// `modelRender`, `worldFromModel` should be the identity for them
 void meshRender(struct Mesh *mesh, mat4s worldFromModel, uint32_t shader);
+/// marks the mesh to be morphed again when `weight` is new. the weights
+/// belong to the mesh, so every user of the model sees the same ones
+void meshSetMorphWeight(struct Mesh *mesh, int target, float weight);
 void meshFree(struct Mesh *mesh);
 
 #endif // !MESH_H
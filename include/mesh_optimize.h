@@ -0,0 +1,54 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include "mesh.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// size of the simulated FIFO cache used for the ACMR/ATVR numbers
+#define MESH_OPTIMIZE_FIFO_SIZE 16
+/// how much worse (as a factor of ACMR) the overdraw pass may make the vertex
+/// cache before it is undone
+#define MESH_OPTIMIZE_OVERDRAW_THRESHOLD 1.05f
+
+/// set to false to import meshes as they are in the file
+extern bool MeshOptimizeEnabled;
+
+/// ACMR is the average number of vertex shader runs per triangle, ATVR the
+/// same per unique vertex (1.0 is the best possible)
+struct MeshOptimizeStats {
+    int VertexCountBefore, VertexCountAfter;
+    float AcmrBefore, AcmrAfter;
+    float AtvrBefore, AtvrAfter;
+};
+
+/// runs every stage below in order on the arrays, in place. returns the new
+/// vertex count, which is never more than `vertexCount`
+int meshOptimize(struct Vertex *vertices, int vertexCount, uint32_t *indices,
+                 int indexCount, struct MeshOptimizeStats *stats);
+/// prints `stats` the way loaders report optimized meshes
+void meshOptimizePrintStats(const char *meshName,
+                            const struct MeshOptimizeStats *stats);
+/// merges vertices that are exactly the same. returns the new vertex count
+int meshOptimizeWeld(struct Vertex *vertices, int vertexCount,
+                     uint32_t *indices, int indexCount);
+/// reorders triangles for the post-transform vertex cache (Tom Forsyth's
+/// linear-speed algorithm)
+void meshOptimizeVertexCache(uint32_t *indices, int indexCount,
+                             int vertexCount);
+/// splits the cache-ordered triangles into clusters where the cache starts
+/// over, and draws clusters that face outwards from the middle of the mesh
+/// first so they occlude the rest
+void meshOptimizeOverdraw(const struct Vertex *vertices, int vertexCount,
+                          uint32_t *indices, int indexCount, float threshold);
+/// reorders vertices by first use so fetches are sequential, dropping unused
+/// vertices. returns the new vertex count
+int meshOptimizeVertexFetch(struct Vertex *vertices, int vertexCount,
+                            uint32_t *indices, int indexCount);
+float meshOptimizeAcmr(const uint32_t *indices, int indexCount,
+                       int vertexCount, int cacheSize);
+float meshOptimizeAtvr(const uint32_t *indices, int indexCount,
+                       int vertexCount, int cacheSize);
+
+#endif // !MESH_OPTIMIZE_H
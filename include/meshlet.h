@@ -0,0 +1,54 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include "mesh.h"
+
+#include <cglm/types-struct.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+/// meshes with fewer triangles than this are always drawn whole
+#define MESHLET_MIN_MESH_TRIANGLES 1024
+/// the most meshlets `meshletBuild` can make out of `triangleCount`
+/// triangles. a meshlet is only cut short by the vertex limit, and every
+/// triangle adds at most 3 vertices
+#define MESHLET_MAX_COUNT(triangleCount)                                      \
+    ((triangleCount) / ((MESHLET_MAX_VERTICES - 2) / 3) + 1)
+
+/// set to false to import meshes without meshlets
+extern bool MeshletsEnabled;
+/// set to false to draw every meshlet, even the ones that can't be seen
+extern bool MeshletCullingEnabled;
+
+/// a run of consecutive triangles in the mesh's index buffer, with what is
+/// needed to tell if it can be skipped. everything is in model space
+struct Meshlet {
+    uint32_t FirstIndex;
+    uint32_t TriangleCount;
+    uint32_t VertexCount;
+
+    vec3s Center;
+    float Radius;
+    /// every triangle's normal is within the cone around `ConeAxis`. the
+    /// meshlet faces away from a camera at `c` when
+    /// `dot(Center - c, ConeAxis) >= ConeCutoff * length(Center - c) + Radius`,
+    /// a cutoff of 1 never passes
+    vec3s ConeAxis;
+    float ConeCutoff;
+};
+
+/// splits the mesh's triangles into meshlets of at most `MESHLET_MAX_VERTICES`
+/// vertices and `MESHLET_MAX_TRIANGLES` triangles, keeping the triangle order
+/// (so run `meshOptimize` first for tighter meshlets). does nothing for meshes
+/// with fewer than `MESHLET_MIN_MESH_TRIANGLES` triangles. the meshlets are
+/// allocated from `arena`
+void meshletBuild(struct Arena *arena, struct Mesh *mesh);
+/// the index ranges of the meshlets that are inside the frustum and not
+/// facing away from the camera. neighbouring ranges are merged. the arrays
+/// stay valid until the next call. returns the number of ranges
+int meshletCull(struct Mesh *mesh, mat4s worldFromModel, int32_t **counts,
+                const void ***offsets);
+
+#endif // !MESHLET_H
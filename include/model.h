@@ -2,23 +2,45 @@
 #define MODEL_H
 
 #define MODELS_PATH "models/"
+/// first block size for loaders that don't size the arena up front
+#define MODEL_ARENA_SIZE (64 << 10)
+/// shader storage binding the bone palette of skinned meshes is bound to
+#define MODEL_BONE_BINDING 0
 
 #include "animation.h"
+#include "arena.h"
+#include "asset.h"
 #include "mesh.h"
 #include "node.h"
 #include "texture.h"
+#include "transform.h"
 
 #include <assimp/cimport.h>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <cglm/struct/mat4.h>
 
+/// set to false to keep every node of imported models, instead of folding
+/// static ones that only move their children into those children
+extern bool ModelFlattenEnabled;
+
 struct NodeEntry {
     struct Node *Node;
     int ParentIndex;
-    mat4s WorldFromLocal;
+};
+/// a node that skinned vertices follow
+struct ModelBone {
+    /// position in `Model::NodeEntries`
+    int NodeIndex;
+    /// the inverse bind matrix, from the space the mesh is modeled in to the
+    /// node's in the bind pose
+    mat4s BoneFromMesh;
 };
 typedef struct {
+    /// the model itself, its nodes, meshes, animations and the arrays
+    /// pointing to them all come from here
+    struct Arena *Arena;
+
     mat4s WorldFromModel;
 
     int MeshCount;
@@ -32,25 +54,81 @@ typedef struct {
 
     int NodeCount;
     struct NodeEntry *NodeEntries;
+    /// local and world transforms of the nodes, in `NodeEntries` order.
+    /// `modelRender` only works out the world transforms that changed
+    TransformHierarchy Transforms;
 
     int AnimationCount;
     Animation **Animations;
 
+    /// GL buffer shared by all meshes when loaded with `gltfLoad`, 0 otherwise
+    uint32_t SharedBuffer;
+
+    /// bones of all skinned meshes, see `Mesh::BoneOffset`
+    int BoneCount;
+    struct ModelBone *Bones;
+    /// `WorldFromLocal * BoneFromMesh` of each bone, filled while rendering
+    mat4s *BonePalette;
+    /// GL buffer `BonePalette` is uploaded to once per render, made the first
+    /// time it's needed
+    uint32_t BoneBuffer;
+
     void (*OnDelete)(void *model);
+    /// set when loaded through `modelLoad` or `modelLoadAsync`
+    AssetHandle Handle;
 } Model;
 
-/// manages rendering a 3d file. free with `modelFree`
+/// manages rendering a 3d file. free with `modelFree`. blocks until the model
+/// is on the GPU; this runs everything on the upload queue, including uploads
+/// of other models that are loading asynchronously.
+///
+/// a file that is already loaded isn't loaded again, the same model is
+/// returned with another reference. everything in it is shared, including
+/// `WorldFromModel` and `Materials`; use a `ModelInstance` for copies that
+/// need their own transform, pose or materials
 Model *modelLoad(const char *modelFilename);
+/// loads the model on the thread pool. `onLoaded` is called on the GL thread
+/// from `uploadQueueDrain` once all of the model's data is on the GPU. shares
+/// already loaded files like `modelLoad`, and a file that is still loading is
+/// imported once for all of its requests
+void modelLoadAsync(const char *modelFilename,
+                    void (*onLoaded)(Model *model, void *data), void *data);
 /// @param Material *...: materials to set, needs to be `model->MaterialCount`
 /// number of them
 void modelSetMaterials(Model *model, int materialCount, ...);
 void modelSetDefaultMaterial(Model *model, Material *material);
 void modelRender(Model *model);
-/// calls `model->OnDelete`
+/// sphere around the meshes of the model in the pose its nodes are in now,
+/// in model space
+void modelBounds(Model *model, vec3s *center, float *radius);
+/// drops a reference, `model->OnDelete` is called with the last one
 void modelFree(Model *model);
 
 /// not to be used directly, but by presets and such
 void _modelDelete(void *_model);
 void _modelFreeMaterials(void *_model);
+/// not to be used directly, but by loaders. creates the model as the first
+/// allocation in a new arena of `arenaSize` bytes
+Model *_modelCreate(size_t arenaSize);
+/// not to be used directly, but by loaders before `_modelSetNodes`. folds
+/// nodes without meshes into the `Local` of their children, except the root,
+/// leaves and the nodes in `keepNames`, whose names animations and bones find
+/// them by. prints the node count before and after. does nothing when
+/// `ModelFlattenEnabled` is off
+void _modelFlattenNodes(struct Arena *arena, struct Node *rootNode,
+                        const char *const *keepNames, int keepCount);
+/// not to be used directly, but by loaders. fills `NodeEntries` from the tree
+/// and sets up `Transforms` from it
+void _modelSetNodes(Model *model, struct Node *rootNode);
+/// not to be used directly, but by loaders that fill `NodeEntries`
+/// themselves. creates `Transforms` from the nodes' `Local`
+void _modelSetTransforms(Model *model);
+/// not to be used directly, but by renderers. fills `BonePalette` from the
+/// world transform of each node (in `NodeEntries` order), uploads it and binds
+/// it to `MODEL_BONE_BINDING`. does nothing without bones. meshes whose bones
+/// moved are marked `Mesh::SkinnedDirty`; instances of one model share the
+/// skinned vertices, so each of them in a different pose skins again
+void _modelUploadBones(Model *model, const mat4s *worldFromLocal,
+                       size_t stride);
 
 #endif // !MODEL_H
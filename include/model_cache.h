@@ -0,0 +1,24 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include "model.h"
+
+#include <stdbool.h>
+
+/// appended to the model path to get the path of its cooked cache
+#define MODEL_CACHE_EXTENSION ".cooked"
+
+/// set to false to always import models from their source files
+extern bool ModelCacheEnabled;
+
+/// loads the cooked version of `modelFile` (path including `MODELS_PATH`).
+/// returns NULL if there is no cache or it is stale, in which case the model
+/// should be imported normally
+Model *modelCacheLoad(const char *modelFile);
+/// writes the final vertex/index arrays, nodes and animation keys of a model
+/// that was just imported next to `modelFile`. `textureNames` are what each
+/// of `Model::Textures` was loaded as
+void modelCacheWrite(const char *modelFile, Model *model,
+                     const char *const *textureNames);
+
+#endif // !MODEL_CACHE_H
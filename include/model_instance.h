@@ -0,0 +1,49 @@
+#ifndef MODEL_INSTANCE_H
+#define MODEL_INSTANCE_H
+
+#include "arena.h"
+#include "material.h"
+#include "model.h"
+
+#include <cglm/types-struct.h>
+
+/// one placement of a loaded model. the meshes, nodes, textures and
+/// animation keys all stay in the shared model, the instance only has what
+/// can differ between copies of it
+typedef struct {
+    /// the instance and its arrays come from here, one allocation in total
+    struct Arena *Arena;
+    /// holds a reference to it until `modelInstanceFree`
+    Model *Asset;
+
+    mat4s WorldFromModel;
+
+    /// the instance's pose, in `Asset->NodeEntries` order and sharing the
+    /// model's `Parents`. starts out as the model's rest pose, world
+    /// transforms are worked out by `modelInstanceRender` where it changed
+    TransformHierarchy Transforms;
+
+    /// `MaterialCount` of them, NULL uses the one in `Asset->Materials`. the
+    /// instance doesn't own any of them
+    Material **MaterialOverrides;
+
+    /// clock of each of `Asset->Animations`, in ticks
+    float *AnimationTimes;
+    /// key cursors of each animation, one per `Animation::Nodes`
+    AnimationCursor **AnimationCursors;
+} ModelInstance;
+
+/// models that weren't loaded with `modelLoad` or `modelLoadAsync` aren't
+/// reference counted and need to outlive their instances
+ModelInstance *modelInstanceCreate(Model *model);
+/// bytes a `modelInstanceCreate` of `model` takes
+size_t modelInstanceSize(Model *model);
+/// moves the clock of `Asset->Animations[animation]` on and poses the
+/// instance with it
+void modelInstanceAnimate(ModelInstance *instance, int animation,
+                          float deltaTime);
+void modelInstanceRender(ModelInstance *instance);
+/// drops the instance's reference to `Asset`
+void modelInstanceFree(ModelInstance *instance);
+
+#endif // !MODEL_INSTANCE_H
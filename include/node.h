@@ -1,13 +1,17 @@
 #ifndef NODE_H
 #define NODE_H
 
+#include "arena.h"
 #include "material.h"
 #include "mesh.h"
+#include "transform.h"
 #include <cglm/types-struct.h>
 
 /// to be used with the model class
 struct Node {
-    mat4s ParentFromLocal;
+    /// transform from the node's space to its parent's. set with
+    /// `nodeSetLocal` once the node is in a model
+    TransformLocal Local;
     Material Material;
 
     int MeshCount;
@@ -19,18 +23,32 @@ struct Node {
     struct Node **Children;
 
     char *Name;
+    /// position in `Model::NodeEntries`, -1 until `_modelSetNodes`
+    int Index;
+    /// the model's, NULL until `_modelSetTransforms`
+    struct TransformHierarchy *Transforms;
 };
 
-/// free with `nodeFree`
-struct Node *nodeCreate(struct Node *parent, int childCount);
+/// allocates the node and its `Children` from `arena`
+struct Node *nodeCreate(struct Arena *arena, struct Node *parent,
+                        int childCount);
 /// only renders this specific node
 void nodeRender(mat4s worldFromParent, struct Node *node,
                 struct Mesh **meshArray, Material **materialArray);
-/// gets world transform of parent node
+/// same as `nodeRender`, with the node's world transform already worked out
+void nodeRenderAt(mat4s worldFromLocal, struct Node *node,
+                  struct Mesh **meshArray, Material **materialArray);
+/// also marks the node for `transformUpdate`, so its world transform and
+/// the ones below it are worked out again
+void nodeSetLocal(struct Node *node, TransformLocal local);
+/// `Local` as a matrix
+mat4s nodeGetParentFromLocal(struct Node *node);
+/// world transform of the node as of the last `modelRender`. walks up the
+/// parents for nodes that aren't in a model
 mat4s nodeGetWorldFromLocal(struct Node *node);
 int nodeChildCount(struct Node *node);
+/// number of parents above the node, 0 for the root
+int nodeDepth(struct Node *node);
 void nodePrintInfo(struct Node *node);
-/// recursively frees node and children
-void nodeFree(struct Node *node);
 
 #endif // !NODE_H
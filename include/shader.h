@@ -5,9 +5,15 @@
 
 #include <stdint.h>
 
+/// compiles and links the pair, or adds a reference to the program if the
+/// pair is already loaded. release each one with `shaderFree`
 uint32_t shaderCreate(const char *vertexShaderPath,
                       const char *fragmentShaderPath);
+/// same as `shaderCreate` for a compute shader on its own
+uint32_t shaderCreateCompute(const char *computeShaderPath);
+/// drops a reference, the program is deleted with the last one
 void shaderFree(uint32_t shader);
+/// deletes every program, whether or not it's still referenced
 void shaderFreeCache();
 
 #endif // !SHADER_H
@@ -0,0 +1,29 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include "mesh.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// compute shader work group size, has to match `skinning_comp.glsl`
+#define SKINNING_GROUP_SIZE 64
+
+/// set to false to skin in the vertex shader on every draw instead. meshes
+/// with morph targets always go through the compute pass
+extern bool SkinningComputeEnabled;
+/// vertices skinned by compute dispatches since the last
+/// `skinningResetCounters`, and draws that reused them instead
+extern int SkinningVerticesSkinned, SkinningDrawsReused;
+/// morph targets added to meshes since the last `skinningResetCounters`, and
+/// ones left out for having no weight
+extern int SkinningMorphTargetsApplied, SkinningMorphTargetsSkipped;
+
+/// morphs `mesh` with its `MorphWeights` and skins it with the bone palette
+/// bound to `MODEL_BONE_BINDING` into its `SkinnedVBO`, unless it's already
+/// in that pose. returns the VAO to draw, which has float positions and
+/// normals, in world space when the mesh is skinned
+uint32_t skinningUpdate(struct Mesh *mesh);
+void skinningResetCounters(void);
+
+#endif // !SKINNING_H
@@ -1,6 +1,8 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include "asset.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -12,14 +14,30 @@ enum TEXTURETYPE {
     TEXTURETYPE_RGBA = 1,
 };
 
+struct TextureUpload;
 typedef struct {
     uint32_t id;
+    /// set while `textureLoadAsync` is still working on it
+    struct TextureUpload *Pending;
+    AssetHandle Handle;
 } Texture;
 
+/// a path that is already loaded (by either function) returns the same
+/// texture with another reference, release each one with `textureFree`
 /// @param const char *texturePath: path to texture; prepended with
 /// `TEXTURES_PATH`
 Texture *textureCreate(const char *texturePath, enum TEXTURETYPE type,
                        bool optional);
+/// returns right away with the placeholder's id, decoding and mipmapping
+/// happen on the thread pool. `id` is swapped to the real texture from
+/// `uploadQueueDrain` once every level is uploaded. if the image can't be
+/// loaded the placeholder stays. can be called from any thread
+Texture *textureLoadAsync(const char *texturePath);
+/// loads default.jpg as the placeholder for `textureLoadAsync`; without it
+/// textures are 0 until they're loaded. GL thread only
+void textureInitPlaceholder();
+void textureFreePlaceholder();
+/// drops a reference, the texture is deleted with the last one
 void textureFree(Texture *texture);
 
 #endif // !TEXTURE_H
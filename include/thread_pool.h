@@ -0,0 +1,25 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/// starts the worker threads. `threadCount` of 0 uses one thread per core
+/// minus the main thread. shut down with `threadPoolShutdown`
+void threadPoolInit(int threadCount);
+/// returns 0 if the pool isn't running
+int threadPoolThreadCount();
+/// runs `function(data)` on a worker thread. if the pool isn't running the
+/// function runs right away on the calling thread
+void threadPoolSubmit(void (*function)(void *data), void *data);
+/// blocks until every submitted job is done, including jobs submitted by
+/// other jobs. must not be called from a job
+void threadPoolWait();
+/// splits `[0, count)` into ranges of at most `chunkSize` and runs
+/// `function(data, start, end)` on each, spread over the workers and the
+/// calling thread. returns once every range is done; it only waits on its own
+/// ranges, so other jobs can keep running and it can be called from a job
+void threadPoolFor(int count, int chunkSize,
+                   void (*function)(void *data, int start, int end),
+                   void *data);
+/// waits for all jobs and stops the workers
+void threadPoolShutdown();
+
+#endif // !THREAD_POOL_H
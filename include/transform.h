@@ -0,0 +1,94 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "arena.h"
+
+#include <cglm/types-struct.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/// a local transform as translation, rotation and scale, only made into a
+/// matrix with `transformCompose` when it's needed
+typedef struct {
+    versors Rotation;
+    vec3s Position;
+    vec3s Scaling;
+} TransformLocal;
+/// the top three rows of an affine matrix, the last one is always
+/// (0, 0, 0, 1)
+typedef struct {
+    vec4s Rows[3];
+} TransformAffine;
+
+/// a node tree flattened with every parent before its children, as parallel
+/// arrays. world transforms are only worked out again below the nodes whose
+/// local transform changed, and not at all when nothing did
+typedef struct TransformHierarchy {
+    int Count;
+    /// index of each node's parent, always lower than the node's own, -1 for
+    /// the root. can be shared between hierarchies of the same tree
+    const int *Parents;
+    /// the local transforms, 40 bytes a node. change them with
+    /// `transformSetLocal`, or mark the node with `transformMarkDirty` after
+    /// writing them directly
+    vec3s *Positions;
+    versors *Rotations;
+    vec3s *Scalings;
+    /// filled by `transformUpdate`
+    mat4s *WorldFromLocal;
+    /// nodes whose local transform changed since the last `transformUpdate`
+    bool *Dirty;
+    /// lowest node in `Dirty`, `Count` when there are none
+    int FirstDirty;
+    /// what the root was placed with last time
+    mat4s WorldFromRoot;
+} TransformHierarchy;
+
+/// world transforms worked out by `transformUpdate` since the last
+/// `transformResetCounters`
+extern int TransformNodesUpdated;
+
+/// no translation or rotation and a scale of 1
+TransformLocal transformIdentity(void);
+/// translation * rotation * scale, straight from the quaternion
+TransformAffine transformCompose(TransformLocal local);
+/// `worldFromParent * parentFromLocal`, with `worldFromParent` affine too
+mat4s transformApply(mat4s worldFromParent, TransformAffine parentFromLocal);
+mat4s transformToMat4(TransformAffine affine);
+/// the other way round from `transformCompose`, for matrices without shear
+TransformLocal transformDecompose(mat4s parentFromLocal);
+/// whether `parentFromMiddle * middleFromLocal` has no shear, so it can be
+/// a `TransformLocal`. it does when the first scales evenly or the second
+/// doesn't rotate
+bool transformCanCombine(TransformLocal parentFromMiddle,
+                         TransformLocal middleFromLocal);
+/// `parentFromMiddle * middleFromLocal`, see `transformCanCombine`
+TransformLocal transformCombine(TransformLocal parentFromMiddle,
+                                TransformLocal middleFromLocal);
+/// what normals are transformed by for an affine `worldFromLocal`, up to a
+/// positive scale. the upper 3x3 itself when it only rotates and scales
+/// evenly, its cofactors otherwise
+mat3s transformNormalMatrix(mat4s worldFromLocal);
+
+/// bytes `transformCreate` takes from an arena for `count` nodes
+size_t transformArenaSize(int count);
+/// allocates the arrays from `arena`, with every local transform the identity
+/// and every node dirty
+void transformCreate(struct Arena *arena, TransformHierarchy *hierarchy,
+                     int count, const int *parents);
+TransformLocal transformGetLocal(const TransformHierarchy *hierarchy,
+                                 int node);
+void transformSetLocal(TransformHierarchy *hierarchy, int node,
+                       TransformLocal local);
+void transformMarkDirty(TransformHierarchy *hierarchy, int node);
+/// works out `WorldFromLocal` for the dirty nodes and everything below them,
+/// with the root placed at `worldFromRoot`, and clears `Dirty`. returns how
+/// many nodes it updated
+int transformUpdate(TransformHierarchy *hierarchy, mat4s worldFromRoot);
+/// works out `WorldFromLocal` of just `nodes`, in order, from their parents'
+/// and `WorldFromRoot`. leaves `Dirty` alone
+void transformUpdateNodes(TransformHierarchy *hierarchy, const int *nodes,
+                          int count);
+void transformResetCounters(void);
+
+#endif // !TRANSFORM_H
@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include "transform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// the kernels the batch functions have, narrowest first
+enum TransformBatchPath {
+    TRANSFORMBATCH_AUTO = -1,
+    TRANSFORMBATCH_SCALAR,
+    TRANSFORMBATCH_SSE4,
+    TRANSFORMBATCH_AVX2,
+    TRANSFORMBATCH_AVX512,
+    TRANSFORMBATCH_PATH_COUNT,
+};
+
+/// which kernels to use. `TRANSFORMBATCH_AUTO` picks the widest the CPU
+/// supports, and so does asking for one it doesn't
+extern enum TransformBatchPath TransformBatchPath;
+
+/// the kernels the batch functions run with `TransformBatchPath` as it is
+enum TransformBatchPath transformBatchGetPath(void);
+const char *transformBatchPathName(enum TransformBatchPath path);
+
+/// `results[i] = *left[i] * *right[i]`. `results` can't overlap the inputs
+void transformBatchMul(const mat4s *const *left, const mat4s *const *right,
+                       mat4s *results, int count);
+/// `transformCompose` of the transform at `nodes[i]` in the arrays, or at `i`
+/// when `nodes` is NULL
+void transformBatchCompose(const vec3s *positions, const versors *rotations,
+                           const vec3s *scalings, const int *nodes, int count,
+                           TransformAffine *results);
+/// `transformApply` of `parentFromLocals[i]` to the world transform of the
+/// parent of `nodes[i]`, or `WorldFromRoot` for a root, into the node's
+/// `WorldFromLocal`. goes in order, so a parent can come earlier in `nodes`
+void transformBatchApply(TransformHierarchy *hierarchy, const int *nodes,
+                         const TransformAffine *parentFromLocals, int count);
+/// sets `visible[i]` for each sphere that is at least partly on the inner
+/// side of all 6 `planes`, which have a normalized xyz and are inside where
+/// `dot(xyz, p) + w >= 0`. the spheres are a center followed by a radius,
+/// `stride` bytes apart. returns how many are visible
+int transformBatchCullSpheres(const vec4s *planes, const float *spheres,
+                              size_t stride, int count, bool *visible);
+
+#endif // !TRANSFORM_BATCH_H
@@ -0,0 +1,52 @@
+#ifndef TRANSFORM_SCENE_H
+#define TRANSFORM_SCENE_H
+
+#include "transform.h"
+
+/// a node of one of the hierarchies in a scene
+typedef struct {
+    int Hierarchy;
+    int Node;
+} TransformSceneNode;
+
+/// the hierarchies of many models and instances, updated together one depth
+/// at a time instead of one tree at a time. the nodes of a depth only depend
+/// on the depth above, so each of them is split over the thread pool
+typedef struct {
+    int HierarchyCount, HierarchyCapacity;
+    TransformHierarchy **Hierarchies;
+    /// where each hierarchy's root is placed, read on every update so moving
+    /// a model doesn't need a call
+    const mat4s **WorldFromRoots;
+
+    /// every node of every hierarchy, grouped by depth and by hierarchy
+    /// within a depth. worked out again on the next update after hierarchies
+    /// are added or removed
+    int NodeCount;
+    TransformSceneNode *Nodes;
+    /// where each depth starts in `Nodes`, with `NodeCount` after the last
+    int LevelCount;
+    int *LevelStarts;
+    bool LevelsStale;
+} TransformScene;
+
+/// nodes of a depth one thread works on at a time; depths with fewer nodes
+/// are done on the calling thread
+extern int TransformSceneChunkSize;
+
+/// free with `transformSceneFree`
+TransformScene *transformSceneCreate(void);
+/// `hierarchy` and `worldFromRoot` have to stay valid until they're removed,
+/// e.g. a model's `Transforms` and `WorldFromModel`
+void transformSceneAdd(TransformScene *scene, TransformHierarchy *hierarchy,
+                       const mat4s *worldFromRoot);
+void transformSceneRemove(TransformScene *scene,
+                          TransformHierarchy *hierarchy);
+/// `transformUpdate` for every hierarchy, with the depths spread over the
+/// thread pool. afterwards the hierarchies are clean, so `modelRender` and
+/// `modelInstanceRender` don't work anything out again. returns how many
+/// nodes it updated
+int transformSceneUpdate(TransformScene *scene);
+void transformSceneFree(TransformScene *scene);
+
+#endif // !TRANSFORM_SCENE_H
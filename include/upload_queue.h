@@ -0,0 +1,18 @@
+#ifndef UPLOAD_QUEUE_H
+#define UPLOAD_QUEUE_H
+
+#include <stddef.h>
+
+/// queues `upload(data)` to run on the GL thread. can be called from any
+/// thread without locking. `bytes` is roughly how much the upload sends to
+/// the GPU and counts against the budget of `uploadQueueDrain`
+void uploadQueuePush(void (*upload)(void *data), void *data, size_t bytes);
+/// runs queued uploads in the order they were pushed until either budget is
+/// used up; at least one upload runs if any are queued, so one that is bigger
+/// than the budget still gets through. call once per frame from the GL
+/// thread. returns the number of bytes uploaded
+size_t uploadQueueDrain(size_t byteBudget, double msBudget);
+/// runs everything that is queued, ignoring any budget. GL thread only
+void uploadQueueFlush();
+
+#endif // !UPLOAD_QUEUE_H
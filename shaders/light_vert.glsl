@@ -9,8 +9,13 @@ out vec3 vColor;
 
 uniform mat4 projectionFromModel;
 
+// undoes the packing done by `meshSendData`, identity for float meshes
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+
 void main() {
     vColor = vertColor;
 
-    gl_Position = projectionFromModel * vec4(vertPos, 1.0f);
+    vec3 position = positionOffset + vertPos * positionScale;
+    gl_Position = projectionFromModel * vec4(position, 1.0f);
 }
@@ -0,0 +1,82 @@
+#version 460 core
+
+// has to match `SKINNING_GROUP_SIZE`
+layout(local_size_x = 64) in;
+
+// the mesh's own vertex buffer, read like in `skinning_comp.glsl`
+layout(std430, binding = 1) readonly buffer VertexData {
+    uint vertexData[];
+};
+// position and normal of each vertex in the mesh's space, skinned after this
+// or drawn as they are
+layout(std430, binding = 2) buffer MorphedVertices {
+    float morphedVertices[];
+};
+// laid out like `struct MorphDelta`
+struct MorphDelta {
+    uint vertex;
+    float position[3];
+    float normal[3];
+    uint padding;
+};
+layout(std430, binding = 3) readonly buffer MorphDeltas {
+    MorphDelta deltas[];
+};
+
+uniform uint vertexCount;
+uniform bool packedVertices = false;
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+
+// copies every vertex to the output when false, adds `weight` of the deltas
+// of one target when true
+uniform bool addDeltas = false;
+uniform int firstDelta = 0;
+uniform uint deltaCount = 0;
+uniform float weight = 0.0;
+
+// sizes of `PackedVertex` and `Vertex` in words
+const uint packedStride = 7;
+const uint floatStride = 16;
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0)
+        normal.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy));
+    return normalize(normal);
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (addDeltas) {
+        if (index >= deltaCount)
+            return;
+        MorphDelta delta = deltas[firstDelta + index];
+        uint outBase = delta.vertex * 6;
+        for (int i = 0; i < 3; i++) {
+            morphedVertices[outBase + i] += weight * delta.position[i];
+            morphedVertices[outBase + 3 + i] += weight * delta.normal[i];
+        }
+        return;
+    }
+
+    if (index >= vertexCount)
+        return;
+    vec3 position, normal;
+    if (packedVertices) {
+        uint base = index * packedStride;
+        vec2 xy = unpackSnorm2x16(vertexData[base]);
+        vec2 z = unpackSnorm2x16(vertexData[base + 1]);
+        position = positionOffset + vec3(xy, z.x) * positionScale;
+        normal = octahedral_decode(unpackSnorm2x16(vertexData[base + 2]));
+    } else {
+        uint base = index * floatStride;
+        position = uintBitsToFloat(uvec3(vertexData[base], vertexData[base + 1], vertexData[base + 2]));
+        normal = uintBitsToFloat(uvec3(vertexData[base + 3], vertexData[base + 4], vertexData[base + 5]));
+    }
+    uint outBase = index * 6;
+    for (int i = 0; i < 3; i++) {
+        morphedVertices[outBase + i] = position[i];
+        morphedVertices[outBase + 3 + i] = normal[i];
+    }
+}
@@ -0,0 +1,85 @@
+#version 460 core
+
+// has to match `SKINNING_GROUP_SIZE`
+layout(local_size_x = 64) in;
+
+// world transform of each bone, uploaded by `modelRender`
+layout(std430, binding = 0) readonly buffer BonePalette {
+    mat4 worldFromMeshes[];
+};
+// the mesh's own vertex buffer, read a word at a time since it's either a
+// `Vertex` or a `PackedVertex` per vertex
+layout(std430, binding = 1) readonly buffer VertexData {
+    uint vertexData[];
+};
+// world space position and normal of each vertex, drawn by `meshRender`.
+// holds the morphed vertices in their own space beforehand when `morphed`
+layout(std430, binding = 2) buffer SkinnedVertices {
+    float skinnedVertices[];
+};
+
+uniform uint vertexCount;
+uniform int boneOffset = 0;
+// undoes the packing done by `meshSendData`, like in the vertex shader
+uniform bool packedVertices = false;
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+// positions and normals come from `morph_comp.glsl`, in the output
+uniform bool morphed = false;
+
+// sizes of `PackedVertex` and `Vertex` in words
+const uint packedStride = 7;
+const uint floatStride = 16;
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0)
+        normal.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy));
+    return normalize(normal);
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= vertexCount)
+        return;
+
+    vec3 position, normal;
+    uvec4 joints;
+    vec4 weights;
+    if (packedVertices) {
+        uint base = index * packedStride;
+        vec2 xy = unpackSnorm2x16(vertexData[base]);
+        vec2 z = unpackSnorm2x16(vertexData[base + 1]);
+        position = positionOffset + vec3(xy, z.x) * positionScale;
+        normal = octahedral_decode(unpackSnorm2x16(vertexData[base + 2]));
+        uint packedJoints = vertexData[base + 5];
+        joints = uvec4(packedJoints, packedJoints >> 8, packedJoints >> 16, packedJoints >> 24) & 0xFFu;
+        weights = unpackUnorm4x8(vertexData[base + 6]);
+    } else {
+        uint base = index * floatStride;
+        position = uintBitsToFloat(uvec3(vertexData[base], vertexData[base + 1], vertexData[base + 2]));
+        normal = uintBitsToFloat(uvec3(vertexData[base + 3], vertexData[base + 4], vertexData[base + 5]));
+        uint packedJoints = vertexData[base + 11];
+        joints = uvec4(packedJoints, packedJoints >> 8, packedJoints >> 16, packedJoints >> 24) & 0xFFu;
+        weights = uintBitsToFloat(uvec4(vertexData[base + 12], vertexData[base + 13], vertexData[base + 14], vertexData[base + 15]));
+    }
+
+    uint outBase = index * 6;
+    if (morphed) {
+        position = vec3(skinnedVertices[outBase], skinnedVertices[outBase + 1], skinnedVertices[outBase + 2]);
+        normal = vec3(skinnedVertices[outBase + 3], skinnedVertices[outBase + 4], skinnedVertices[outBase + 5]);
+    }
+
+    // packed weights are rounded on their own and may not add up to 1
+    weights /= max(dot(weights, vec4(1.0)), 1e-6);
+    mat4 worldFromMesh = mat4(0.0);
+    for (int i = 0; i < 4; i++)
+        worldFromMesh += weights[i] * worldFromMeshes[boneOffset + int(joints[i])];
+    position = vec3(worldFromMesh * vec4(position, 1.0));
+    normal = normalize(mat3(worldFromMesh) * normal);
+
+    for (int i = 0; i < 3; i++) {
+        skinnedVertices[outBase + i] = position[i];
+        skinnedVertices[outBase + 3 + i] = normal[i];
+    }
+}
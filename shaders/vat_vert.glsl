@@ -0,0 +1,115 @@
+#version 460 core
+
+layout(location = 0) in vec3 vertPos;
+layout(location = 1) in vec3 vertNormal;
+layout(location = 2) in vec2 vertTexCoord;
+layout(location = 3) in vec3 vertColor;
+layout(location = 4) in uvec4 vertJoints;
+layout(location = 5) in vec4 vertWeights;
+
+out vec3 vColor;
+out vec2 vTexCoord;
+out vec3 vNormal;
+out vec3 vPos;
+
+// laid out like `AnimationTextureInstance`
+struct Instance {
+    mat4 worldFromModel;
+    float timeOffset;
+};
+layout(std430, binding = 3) readonly buffer Instances {
+    Instance instances[];
+};
+
+// frames baked by `animationTextureBake`, each `frameTexels` long and
+// carrying on across rows
+uniform sampler2D animationFrames;
+uniform int frameTexels;
+uniform int frameCount;
+uniform float duration;
+uniform float time;
+// position and normal per vertex instead of matrices per node and bone
+uniform bool vertexFrames = false;
+
+uniform mat4 projectionFromWorld;
+// the mesh being drawn
+uniform int nodeIndex = 0;
+uniform int vertexBase = 0;
+uniform bool skinned = false;
+// where the mesh's bones start among the matrices
+uniform int boneOffset = 0;
+
+// undoes the packing done by `meshSendData`, identity for float meshes
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+uniform bool octahedralNormals = false;
+
+const float strength = 5;
+vec4 vertex_warp(vec4 pos) {
+    pos.xy = (pos.xy + vec2(1.0)) * vec2(320.0 / strength, 240.0 / strength) * 0.5;
+    pos.xy = round(pos.xy);
+    pos.xy = pos.xy * 2 / vec2(320.0 / strength, 240.0 / strength) - vec2(1.0, 1.0);
+    return pos;
+}
+
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0)
+        normal.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy));
+    return normalize(normal);
+}
+
+int frame, nextFrame;
+float frameBlend;
+
+vec4 fetch(int frameIndex, int texel) {
+    int index = frameIndex * frameTexels + texel;
+    int width = textureSize(animationFrames, 0).x;
+    return texelFetch(animationFrames, ivec2(index % width, index / width), 0);
+}
+vec4 frame_texel(int texel) {
+    return mix(fetch(frame, texel), fetch(nextFrame, texel), frameBlend);
+}
+// the texels are the first three rows
+mat4 frame_matrix(int matrix) {
+    int texel = matrix * 3;
+    return transpose(mat4(frame_texel(texel), frame_texel(texel + 1), frame_texel(texel + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+void main() {
+    Instance instance = instances[gl_InstanceID];
+    // same as `animationTextureSample`
+    float position = duration > 0 ? mod(time + instance.timeOffset, duration) / duration * frameCount : 0.0;
+    frame = int(position) % frameCount;
+    nextFrame = (frame + 1) % frameCount;
+    frameBlend = fract(position);
+
+    vec3 modelPosition, modelNormal;
+    if (vertexFrames) {
+        int texel = (vertexBase + gl_VertexID) * 2;
+        modelPosition = frame_texel(texel).xyz;
+        modelNormal = frame_texel(texel + 1).xyz;
+    } else {
+        vec3 meshPosition = positionOffset + vertPos * positionScale;
+        vec3 meshNormal = octahedralNormals ? octahedral_decode(vertNormal.xy) : vertNormal;
+        mat4 modelFromMesh;
+        if (skinned) {
+            // packed weights are rounded on their own and may not add up to 1
+            vec4 weights = vertWeights / max(dot(vertWeights, vec4(1.0)), 1e-6);
+            modelFromMesh = mat4(0.0);
+            for (int i = 0; i < 4; i++)
+                modelFromMesh += weights[i] * frame_matrix(boneOffset + int(vertJoints[i]));
+        } else
+            modelFromMesh = frame_matrix(nodeIndex);
+        modelPosition = vec3(modelFromMesh * vec4(meshPosition, 1.0));
+        modelNormal = mat3(modelFromMesh) * meshNormal;
+    }
+
+    vec4 worldPosition = instance.worldFromModel * vec4(modelPosition, 1.0);
+    vColor = vertColor;
+    vTexCoord = vertTexCoord;
+    vNormal = normalize(mat3(instance.worldFromModel) * modelNormal);
+    vPos = worldPosition.xyz;
+
+    gl_Position = vertex_warp(projectionFromWorld * worldPosition);
+}
@@ -4,6 +4,8 @@ layout(location = 0) in vec3 vertPos;
 layout(location = 1) in vec3 vertNormal;
 layout(location = 2) in vec2 vertTexCoord;
 layout(location = 3) in vec3 vertColor;
+layout(location = 4) in uvec4 vertJoints;
+layout(location = 5) in vec4 vertWeights;
 
 out vec3 vColor;
 out vec2 vTexCoord;
@@ -14,6 +16,19 @@ uniform mat4 projectionFromModel;
 uniform mat4 worldFromModel;
 uniform mat3 worldNormalFromModel;
 
+// undoes the packing done by `meshSendData`, identity for float meshes
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+uniform bool octahedralNormals = false;
+
+// world transform of each bone, uploaded by `modelRender`. skinned meshes
+// are drawn with the identity as `worldFromModel`
+layout(std430, binding = 0) readonly buffer BonePalette {
+    mat4 worldFromMeshes[];
+};
+uniform bool skinned = false;
+uniform int boneOffset = 0;
+
 const float strength = 5;
 vec4 vertex_warp(vec4 pos) {
     pos.xy = (pos.xy + vec2(1.0)) * vec2(320.0 / strength, 240.0 / strength) * 0.5;
@@ -22,11 +37,30 @@ vec4 vertex_warp(vec4 pos) {
     return pos;
 }
 
+vec3 octahedral_decode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0)
+        normal.xy = (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy));
+    return normalize(normal);
+}
+
 void main() {
+    vec3 position = positionOffset + vertPos * positionScale;
+    vec3 normal = octahedralNormals ? octahedral_decode(vertNormal.xy) : vertNormal;
+    if (skinned) {
+        // packed weights are rounded on their own and may not add up to 1
+        vec4 weights = vertWeights / max(dot(vertWeights, vec4(1.0)), 1e-6);
+        mat4 worldFromMesh = mat4(0.0);
+        for (int i = 0; i < 4; i++)
+            worldFromMesh += weights[i] * worldFromMeshes[boneOffset + int(vertJoints[i])];
+        position = vec3(worldFromMesh * vec4(position, 1.0));
+        normal = mat3(worldFromMesh) * normal;
+    }
+
     vColor = vertColor;
     vTexCoord = vertTexCoord;
-    vNormal = normalize(worldNormalFromModel * vertNormal);
-    vPos = vec3(worldFromModel * vec4(vertPos, 1.0f));
+    vNormal = normalize(worldNormalFromModel * normal);
+    vPos = vec3(worldFromModel * vec4(position, 1.0f));
 
-    gl_Position = vertex_warp(projectionFromModel * vec4(vertPos, 1.0f));
+    gl_Position = vertex_warp(projectionFromModel * vec4(position, 1.0f));
 }
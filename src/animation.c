@@ -1,22 +1,21 @@
 #include "animation.h"
+#include "animation_bake.h"
+#include "mesh.h"
 
 #include <assimp/anim.h>
 #include <assimp/quaternion.h>
-#include <cglm/struct/affine-pre.h>
-#include <cglm/struct/affine.h>
 #include <cglm/struct/mat4.h>
 #include <cglm/struct/quat.h>
+#include <cglm/struct/vec3.h>
+#include <cglm/struct/vec4.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// interpolation functions
-float StepInterp(float x) { return 0; }
-float LinearInterp(float x) { return x; }
-float SmoothStepInterp(float x) {
-    return x < 0.5 ? 4 * x * x * x : 1 - pow(-2 * x + 2, 3) / 2;
-}
+/// how many keys a cursor walks forwards before it gives up and binary
+/// searches instead
+#define ANIMATION_CURSOR_MAX_STEPS 4
 
 vec3s aiVecToVec3s(struct aiVector3D vec) {
     return (vec3s){
@@ -34,8 +33,12 @@ versors aiQuatToVersors(struct aiQuaternion quat) {
     };
 }
 struct Node *getAnimationNode(char *nodeName, struct Node *rootNode);
-Animation *animationCreate(const struct aiScene *scene, char *name,
-                           struct Node *rootNode) {
+int morphTargetCount(const struct aiMeshMorphAnim *channel);
+void morphChannelAlloc(struct Arena *arena, AnimationMorphChannel *channel,
+                       int keyCount, int targetCount);
+Animation *animationCreate(struct Arena *arena, const struct aiScene *scene,
+                           char *name, struct Node *rootNode,
+                           struct Mesh **meshes) {
     int animIndex = 0;
     for (; animIndex < scene->mNumAnimations; animIndex++) {
         if (strcmp(name, scene->mAnimations[animIndex]->mName.data) == 0)
@@ -47,158 +50,404 @@ Animation *animationCreate(const struct aiScene *scene, char *name,
     }
 
     struct aiAnimation *animation = scene->mAnimations[animIndex];
-    Animation *resultAnimation = malloc(sizeof(Animation));
+    Animation *resultAnimation = arenaAlloc(arena, sizeof(Animation));
 
-    resultAnimation->Name = malloc(strlen(name) + 1);
-    strcpy(resultAnimation->Name, name);
+    resultAnimation->Name = arenaCopyString(arena, name);
 
     resultAnimation->Duration = animation->mDuration;
     resultAnimation->TicksPerSec = animation->mTicksPerSecond;
     resultAnimation->Time = 0;
+    resultAnimation->Bake = NULL;
     printf("found animation \"%s\"\n    duration: %d, ticks per sec: %d\n",
            name, resultAnimation->Duration, resultAnimation->TicksPerSec);
 
-    float (*interpFunction)(float);
+    enum AnimationInterpolation interpolation;
     if (!strncmp(resultAnimation->Name, "Step", 4))
-        interpFunction = StepInterp;
+        interpolation = ANIMATIONINTERP_STEP;
     else if (!strncmp(resultAnimation->Name, "Linear", 6))
-        interpFunction = LinearInterp;
+        interpolation = ANIMATIONINTERP_LINEAR;
     else if (!strncmp(resultAnimation->Name, "CubicSpline", 11))
-        interpFunction = SmoothStepInterp;
+        interpolation = ANIMATIONINTERP_SMOOTHSTEP;
     else
-        interpFunction = LinearInterp;
+        interpolation = ANIMATIONINTERP_LINEAR;
 
     resultAnimation->NodeCount = animation->mNumChannels;
     resultAnimation->Nodes =
-        malloc(animation->mNumChannels * sizeof(AnimationNode));
+        arenaAlloc(arena, animation->mNumChannels * sizeof(AnimationNode));
 
     for (int i = 0; i < resultAnimation->NodeCount; i++) {
         AnimationNode *animNode = &resultAnimation->Nodes[i];
         struct aiNodeAnim *channel = animation->mChannels[i];
         animNode->Node = getAnimationNode(channel->mNodeName.data, rootNode);
+        animNode->PositionInterpolation = interpolation;
+        animNode->RotationInterpolation = interpolation;
+        animNode->ScalingInterpolation = interpolation;
+        animNode->Cursor = (AnimationCursor){0};
 
-        animNode->InterpFunction = interpFunction;
-
-        animNode->PositionKeyCount = channel->mNumPositionKeys;
-        animNode->RotationKeyCount = channel->mNumRotationKeys;
-        animNode->ScalingKeyCount = channel->mNumScalingKeys;
-
-        animNode->ScalingKeys =
-            malloc(animNode->ScalingKeyCount * sizeof(AnimationVectorKey));
-        animNode->RotationKeys =
-            malloc(animNode->RotationKeyCount * sizeof(AnimationQuaternionKey));
-        animNode->PositionKeys =
-            malloc(animNode->PositionKeyCount * sizeof(AnimationVectorKey));
-
+        animationNodeAlloc(arena, animNode, channel->mNumPositionKeys,
+                           channel->mNumRotationKeys,
+                           channel->mNumScalingKeys);
         for (int j = 0; j < animNode->ScalingKeyCount; j++) {
-            animNode->ScalingKeys[j].Time = channel->mScalingKeys[j].mTime;
-            animNode->ScalingKeys[j].Value =
+            animNode->ScalingTimes[j] = channel->mScalingKeys[j].mTime;
+            animNode->ScalingValues[j] =
                 aiVecToVec3s(channel->mScalingKeys[j].mValue);
         }
         for (int j = 0; j < animNode->RotationKeyCount; j++) {
-            animNode->RotationKeys[j].Time = channel->mRotationKeys[j].mTime;
-            animNode->RotationKeys[j].Value =
+            animNode->RotationTimes[j] = channel->mRotationKeys[j].mTime;
+            animNode->RotationValues[j] =
                 aiQuatToVersors(channel->mRotationKeys[j].mValue);
         }
         for (int j = 0; j < animNode->PositionKeyCount; j++) {
-            animNode->PositionKeys[j].Time = channel->mPositionKeys[j].mTime;
-            animNode->PositionKeys[j].Value =
+            animNode->PositionTimes[j] = channel->mPositionKeys[j].mTime;
+            animNode->PositionValues[j] =
                 aiVecToVec3s(channel->mPositionKeys[j].mValue);
         }
     }
 
+    // named after the node whose meshes they morph
+    resultAnimation->Meshes = meshes;
+    resultAnimation->MorphChannelCount = animation->mNumMorphMeshChannels;
+    resultAnimation->MorphChannels =
+        arenaAlloc(arena, animation->mNumMorphMeshChannels *
+                              sizeof(AnimationMorphChannel));
+    for (int i = 0; i < resultAnimation->MorphChannelCount; i++) {
+        AnimationMorphChannel *morphChannel =
+            &resultAnimation->MorphChannels[i];
+        struct aiMeshMorphAnim *channel = animation->mMorphMeshChannels[i];
+        morphChannel->Node = getAnimationNode(channel->mName.data, rootNode);
+        morphChannel->Interpolation = interpolation;
+        morphChannel->Cursor = 0;
+        morphChannelAlloc(arena, morphChannel, channel->mNumKeys,
+                          morphTargetCount(channel));
+        for (int j = 0; j < channel->mNumKeys; j++) {
+            struct aiMeshMorphKey *key = &channel->mKeys[j];
+            float *weights =
+                &morphChannel->Weights[j * morphChannel->TargetCount];
+            morphChannel->Times[j] = key->mTime;
+            for (int k = 0; k < key->mNumValuesAndWeights; k++) {
+                weights[key->mValues[k]] = key->mWeights[k];
+            }
+        }
+    }
+
     return resultAnimation;
 }
-int getNextIndexVec(float targetTime, AnimationVectorKey *keyArray,
-                    int keyCount);
-int getNextIndexQuat(float targetTime, AnimationQuaternionKey *keyArray,
-                     int keyCount);
+size_t animationMorphArenaSize(const struct aiAnimation *animation) {
+    size_t size = ARENA_SIZE(animation->mNumMorphMeshChannels *
+                             sizeof(AnimationMorphChannel));
+    for (int i = 0; i < animation->mNumMorphMeshChannels; i++) {
+        const struct aiMeshMorphAnim *channel =
+            animation->mMorphMeshChannels[i];
+        size += ARENA_SIZE(channel->mNumKeys * sizeof(float));
+        size += ARENA_SIZE((size_t)channel->mNumKeys *
+                           morphTargetCount(channel) * sizeof(float));
+    }
+    return size;
+}
+void animationCopyMorphChannels(struct Arena *arena, Animation *to,
+                                const Animation *from) {
+    to->Meshes = from->Meshes;
+    to->MorphChannelCount = from->MorphChannelCount;
+    to->MorphChannels = arenaAlloc(
+        arena, from->MorphChannelCount * sizeof(AnimationMorphChannel));
+    for (int i = 0; i < from->MorphChannelCount; i++) {
+        const AnimationMorphChannel *source = &from->MorphChannels[i];
+        AnimationMorphChannel *channel = &to->MorphChannels[i];
+        *channel = *source;
+        morphChannelAlloc(arena, channel, source->KeyCount,
+                          source->TargetCount);
+        memcpy(channel->Times, source->Times,
+               source->KeyCount * sizeof(float));
+        memcpy(channel->Weights, source->Weights,
+               (size_t)source->KeyCount * source->TargetCount *
+                   sizeof(float));
+    }
+}
+void animationNodeAlloc(struct Arena *arena, AnimationNode *animNode,
+                        int positionKeyCount, int rotationKeyCount,
+                        int scalingKeyCount) {
+    animNode->PositionKeyCount = positionKeyCount;
+    animNode->RotationKeyCount = rotationKeyCount;
+    animNode->ScalingKeyCount = scalingKeyCount;
+    animNode->PositionTimes =
+        arenaAlloc(arena, positionKeyCount * sizeof(float));
+    animNode->RotationTimes =
+        arenaAlloc(arena, rotationKeyCount * sizeof(float));
+    animNode->ScalingTimes = arenaAlloc(arena, scalingKeyCount * sizeof(float));
+    animNode->PositionValues =
+        arenaAlloc(arena, positionKeyCount * sizeof(vec3s));
+    animNode->RotationValues =
+        arenaAlloc(arena, rotationKeyCount * sizeof(versors));
+    animNode->ScalingValues =
+        arenaAlloc(arena, scalingKeyCount * sizeof(vec3s));
+}
+size_t animationNodeArenaSize(int positionKeyCount, int rotationKeyCount,
+                              int scalingKeyCount) {
+    return ARENA_SIZE(positionKeyCount * sizeof(float)) +
+           ARENA_SIZE(rotationKeyCount * sizeof(float)) +
+           ARENA_SIZE(scalingKeyCount * sizeof(float)) +
+           ARENA_SIZE(positionKeyCount * sizeof(vec3s)) +
+           ARENA_SIZE(rotationKeyCount * sizeof(versors)) +
+           ARENA_SIZE(scalingKeyCount * sizeof(vec3s));
+}
+mat4s animationNodeSample(AnimationNode *animNode, float time,
+                          AnimationCursor *cursor);
+TransformLocal animationNodeSampleLocal(AnimationNode *animNode, float time,
+                                        AnimationCursor *cursor);
+vec3s trackVec(const vec3s *values, const AnimationPackedTrack *packed,
+               int key);
+versors trackQuat(const versors *values, const AnimationPackedTrack *packed,
+                  int key);
+int findKeyBinary(const float *times, int keyCount, float time);
 void animationStep(Animation *animation, float deltaTime) {
-    animation->Time += deltaTime * animation->TicksPerSec;
-    while (animation->Time >= animation->Duration)
-        animation->Time -= animation->Duration;
+    animation->Time = animationAdvance(animation, animation->Time, deltaTime);
 
     // now here's the licker
     for (int i = 0; i < animation->NodeCount; i++) {
         AnimationNode *animNode = &animation->Nodes[i];
-        mat4s newTransform = GLMS_MAT4_IDENTITY;
-
-        if (animNode->PositionKeyCount > 1) {
-            int nextPosKeyIdx =
-                getNextIndexVec(animation->Time, animNode->PositionKeys,
-                                animNode->PositionKeyCount);
-            int prevPosKeyIdx =
-                (nextPosKeyIdx + animNode->PositionKeyCount - 1) %
-                animNode->PositionKeyCount;
-            AnimationVectorKey nextPosKey =
-                animNode->PositionKeys[nextPosKeyIdx];
-            AnimationVectorKey prevPosKey =
-                animNode->PositionKeys[prevPosKeyIdx];
-            float t = (animation->Time - prevPosKey.Time) /
-                      (nextPosKey.Time - prevPosKey.Time);
-            newTransform = glms_translate(
-                newTransform, glms_vec3_lerp(prevPosKey.Value, nextPosKey.Value,
-                                             animNode->InterpFunction(t)));
-        } else
-            newTransform =
-                glms_translate(newTransform, animNode->PositionKeys[0].Value);
-
-        if (animNode->RotationKeyCount > 1) {
-            int nextRotKeyIdx =
-                getNextIndexQuat(animation->Time, animNode->RotationKeys,
-                                 animNode->RotationKeyCount);
-            int prevRotKeyIdx =
-                (nextRotKeyIdx + animNode->RotationKeyCount - 1) %
-                animNode->RotationKeyCount;
-            AnimationQuaternionKey nextRotKey =
-                animNode->RotationKeys[nextRotKeyIdx];
-            AnimationQuaternionKey prevRotKey =
-                animNode->RotationKeys[prevRotKeyIdx];
-            float t = (animation->Time - prevRotKey.Time) /
-                      (nextRotKey.Time - prevRotKey.Time);
-            newTransform = glms_quat_rotate(
-                newTransform,
-                glms_quat_slerp(prevRotKey.Value, nextRotKey.Value,
-                                animNode->InterpFunction(t)));
-        } else
-            newTransform =
-                glms_quat_rotate(newTransform, animNode->RotationKeys[0].Value);
-
-        if (animNode->ScalingKeyCount > 1) {
-            int nextScaleKeyIdx =
-                getNextIndexVec(animation->Time, animNode->ScalingKeys,
-                                animNode->ScalingKeyCount);
-            int prevScaleKeyIdx =
-                (nextScaleKeyIdx + animNode->ScalingKeyCount - 1) %
-                animNode->ScalingKeyCount;
-            AnimationVectorKey nextScaleKey =
-                animNode->ScalingKeys[nextScaleKeyIdx];
-            AnimationVectorKey prevScaleKey =
-                animNode->ScalingKeys[prevScaleKeyIdx];
-            float t = (animation->Time - prevScaleKey.Time) /
-                      (nextScaleKey.Time - prevScaleKey.Time);
-            newTransform = glms_scale(
-                newTransform,
-                glms_vec3_lerp(prevScaleKey.Value, nextScaleKey.Value,
-                               animNode->InterpFunction(t)));
-        } else
-            newTransform =
-                glms_scale(newTransform, animNode->ScalingKeys[0].Value);
+        nodeSetLocal(animNode->Node,
+                     animationSampleChannelLocal(animation, i, animation->Time,
+                                                 &animNode->Cursor));
+    }
+    animationSampleMorphs(animation, animation->Time);
+}
+void animationSampleMorphs(Animation *animation, float time) {
+    for (int i = 0; i < animation->MorphChannelCount; i++) {
+        AnimationMorphChannel *channel = &animation->MorphChannels[i];
+        if (channel->Node == NULL || channel->KeyCount == 0)
+            continue;
+        int key = 0;
+        if (channel->KeyCount > 1)
+            key = animationFindKey(channel->Times, channel->KeyCount, time,
+                                   &channel->Cursor);
+        float t = 0;
+        if (key < channel->KeyCount - 1 && time > channel->Times[key] &&
+            channel->Interpolation != ANIMATIONINTERP_STEP) {
+            t = (time - channel->Times[key]) /
+                (channel->Times[key + 1] - channel->Times[key]);
+            if (channel->Interpolation == ANIMATIONINTERP_SMOOTHSTEP)
+                t = animationSmoothStep(t);
+        }
+        const float *from = &channel->Weights[key * channel->TargetCount];
+        const float *to = t > 0 ? from + channel->TargetCount : from;
 
-        animNode->Node->ParentFromLocal = newTransform;
+        struct Node *node = channel->Node;
+        for (int j = 0; j < node->MeshCount; j++) {
+            struct Mesh *mesh = animation->Meshes[node->Meshes[j]];
+            for (int k = 0; k < channel->TargetCount; k++) {
+                meshSetMorphWeight(mesh, k, from[k] + (to[k] - from[k]) * t);
+            }
+        }
     }
 }
-void animationFree(Animation *animation) {
+float animationAdvance(Animation *animation, float time, float deltaTime) {
+    time += deltaTime * animation->TicksPerSec;
+    while (time >= animation->Duration)
+        time -= animation->Duration;
+    return time;
+}
+void animationSample(Animation *animation, float time, mat4s *pose,
+                     AnimationCursor *cursors) {
+    if (animation->Bake != NULL) {
+        animationBakeSample(animation, time, pose);
+        return;
+    }
     for (int i = 0; i < animation->NodeCount; i++) {
-        free(animation->Nodes[i].PositionKeys);
-        free(animation->Nodes[i].RotationKeys);
-        free(animation->Nodes[i].ScalingKeys);
+        AnimationNode *animNode = &animation->Nodes[i];
+        if (animNode->Node == NULL)
+            continue;
+        AnimationCursor cursor = {-1, -1, -1};
+        pose[animNode->Node->Index] = animationNodeSample(
+            animNode, time, cursors != NULL ? &cursors[i] : &cursor);
+    }
+}
+void animationSampleTransforms(Animation *animation, float time,
+                               TransformHierarchy *transforms,
+                               AnimationCursor *cursors) {
+    for (int i = 0; i < animation->NodeCount; i++) {
+        AnimationNode *animNode = &animation->Nodes[i];
+        if (animNode->Node == NULL)
+            continue;
+        transformSetLocal(transforms, animNode->Node->Index,
+                          animationSampleChannelLocal(
+                              animation, i, time,
+                              cursors != NULL ? &cursors[i] : NULL));
+    }
+}
+mat4s animationSampleChannel(Animation *animation, int channel, float time,
+                             AnimationCursor *cursor) {
+    if (animation->Bake != NULL)
+        return animationBakeSampleChannel(animation, channel, time);
+    AnimationCursor binarySearch = {-1, -1, -1};
+    return animationNodeSample(&animation->Nodes[channel], time,
+                               cursor != NULL ? cursor : &binarySearch);
+}
+TransformLocal animationSampleChannelLocal(Animation *animation, int channel,
+                                           float time,
+                                           AnimationCursor *cursor) {
+    if (animation->Bake != NULL) {
+        AnimationBakedKey key =
+            animationBakeSampleKey(animation, channel, time);
+        return (TransformLocal){key.Rotation, key.Position, key.Scaling};
     }
-    free(animation->Nodes);
-    free(animation->Name);
-    free(animation);
+    AnimationCursor binarySearch = {-1, -1, -1};
+    return animationNodeSampleLocal(&animation->Nodes[channel], time,
+                                    cursor != NULL ? cursor : &binarySearch);
+}
+mat4s animationNodeSample(AnimationNode *animNode, float time,
+                          AnimationCursor *cursor) {
+    return transformToMat4(
+        transformCompose(animationNodeSampleLocal(animNode, time, cursor)));
+}
+TransformLocal animationNodeSampleLocal(AnimationNode *animNode, float time,
+                                        AnimationCursor *cursor) {
+    vec3s position = animationSampleVec(
+        animNode->PositionTimes, animNode->PositionValues,
+        &animNode->PackedPositions, animNode->PositionKeyCount, time,
+        &cursor->Position, animNode->PositionInterpolation);
+    versors rotation = animationSampleQuat(
+        animNode->RotationTimes, animNode->RotationValues,
+        &animNode->PackedRotations, animNode->RotationKeyCount, time,
+        &cursor->Rotation, animNode->RotationInterpolation);
+    vec3s scale = animationSampleVec(
+        animNode->ScalingTimes, animNode->ScalingValues,
+        &animNode->PackedScalings, animNode->ScalingKeyCount, time,
+        &cursor->Scaling, animNode->ScalingInterpolation);
+    return (TransformLocal){rotation, position, scale};
+}
+mat4s animationCompose(vec3s position, versors rotation, vec3s scale) {
+    return transformToMat4(
+        transformCompose((TransformLocal){rotation, position, scale}));
+}
+vec3s animationSampleVec(const float *times, const vec3s *values,
+                         const AnimationPackedTrack *packed, int keyCount,
+                         float time, int *cursor,
+                         enum AnimationInterpolation interpolation) {
+    int key = 0;
+    if (keyCount > 1)
+        key = animationFindKey(times, keyCount, time, cursor);
+    vec3s from = trackVec(values, packed, key);
+    if (key == keyCount - 1 || time <= times[key] ||
+        interpolation == ANIMATIONINTERP_STEP)
+        return from;
+    float t = (time - times[key]) / (times[key + 1] - times[key]);
+    if (interpolation == ANIMATIONINTERP_SMOOTHSTEP)
+        t = animationSmoothStep(t);
+    return glms_vec3_lerp(from, trackVec(values, packed, key + 1), t);
+}
+versors animationSampleQuat(const float *times, const versors *values,
+                            const AnimationPackedTrack *packed, int keyCount,
+                            float time, int *cursor,
+                            enum AnimationInterpolation interpolation) {
+    int key = 0;
+    if (keyCount > 1)
+        key = animationFindKey(times, keyCount, time, cursor);
+    versors from = trackQuat(values, packed, key);
+    if (key == keyCount - 1 || time <= times[key] ||
+        interpolation == ANIMATIONINTERP_STEP)
+        return from;
+    float t = (time - times[key]) / (times[key + 1] - times[key]);
+    if (interpolation == ANIMATIONINTERP_SMOOTHSTEP)
+        t = animationSmoothStep(t);
+    return glms_quat_slerp(from, trackQuat(values, packed, key + 1), t);
+}
+vec3s trackVec(const vec3s *values, const AnimationPackedTrack *packed,
+               int key) {
+    if (values != NULL)
+        return values[key];
+    return animationDecodeVec(packed, key);
+}
+versors trackQuat(const versors *values, const AnimationPackedTrack *packed,
+                  int key) {
+    if (values != NULL)
+        return values[key];
+    return animationDecodeQuat(packed, key);
+}
+vec3s animationDecodeVec(const AnimationPackedTrack *packed, int key) {
+    const uint16_t *keyData = packed->Keys[key];
+    vec3s result;
+    for (int i = 0; i < 3; i++) {
+        result.raw[i] = packed->Min.raw[i] +
+                        keyData[i] * (packed->Extent.raw[i] / UINT16_MAX);
+    }
+    return result;
+}
+versors animationDecodeQuat(const AnimationPackedTrack *packed, int key) {
+    const uint16_t *keyData = packed->Keys[key];
+    uint64_t bits = keyData[0] | (uint64_t)keyData[1] << 16 |
+                    (uint64_t)keyData[2] << 32;
+    int largest = bits & 3;
+    versors result;
+    float sum = 0;
+    int shift = 2;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float value = ((bits >> shift) & 0x7fff) / 32767.0f * 2 - 1;
+        result.raw[i] = value * (float)M_SQRT1_2;
+        sum += result.raw[i] * result.raw[i];
+        shift += 15;
+    }
+    result.raw[largest] = sqrtf(fmaxf(1 - sum, 0));
+    return result;
+}
+float animationSmoothStep(float x) {
+    if (x < 0.5f)
+        return 4 * x * x * x;
+    float y = 2 - 2 * x;
+    return 1 - y * y * y / 2;
+}
+int animationFindKey(const float *times, int keyCount, float time,
+                     int *cursor) {
+    int key = *cursor;
+    if (key < 0 || key >= keyCount || times[key] > time) {
+        // started over or seeked backwards
+        key = findKeyBinary(times, keyCount, time);
+    } else {
+        int steps = 0;
+        while (key + 1 < keyCount && times[key + 1] <= time) {
+            if (++steps > ANIMATION_CURSOR_MAX_STEPS) {
+                key = findKeyBinary(times, keyCount, time);
+                break;
+            }
+            key++;
+        }
+    }
+    *cursor = key;
+    return key;
+}
+int findKeyBinary(const float *times, int keyCount, float time) {
+    int low = 0, high = keyCount - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (times[middle] <= time)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
 }
 
+// highest target any key sets, plus one
+int morphTargetCount(const struct aiMeshMorphAnim *channel) {
+    int count = 0;
+    for (int i = 0; i < channel->mNumKeys; i++) {
+        const struct aiMeshMorphKey *key = &channel->mKeys[i];
+        for (int j = 0; j < key->mNumValuesAndWeights; j++) {
+            if ((int)key->mValues[j] >= count)
+                count = key->mValues[j] + 1;
+        }
+    }
+    return count;
+}
+void morphChannelAlloc(struct Arena *arena, AnimationMorphChannel *channel,
+                       int keyCount, int targetCount) {
+    channel->KeyCount = keyCount;
+    channel->TargetCount = targetCount;
+    channel->Times = arenaAlloc(arena, keyCount * sizeof(float));
+    channel->Weights =
+        arenaCalloc(arena, (size_t)keyCount * targetCount * sizeof(float));
+}
 struct Node *getAnimationNode(char *nodeName, struct Node *rootNode) {
     if (!strcmp(rootNode->Name, nodeName))
         return rootNode;
@@ -210,23 +459,3 @@ struct Node *getAnimationNode(char *nodeName, struct Node *rootNode) {
     }
     return NULL;
 }
-// these two are exactly the same function but because the vector key array is
-// more tightly packed it would be problematic to cast the quat array
-int getNextIndexVec(float targetTime, AnimationVectorKey *keyArray,
-                    int keyCount) {
-    int result = 0;
-    while (keyArray[result].Time < targetTime) {
-        result += 1;
-        result %= keyCount;
-    }
-    return result;
-}
-int getNextIndexQuat(float targetTime, AnimationQuaternionKey *keyArray,
-                     int keyCount) {
-    int result = 0;
-    while (keyArray[result].Time < targetTime) {
-        result += 1;
-        result %= keyCount;
-    }
-    return result;
-}
@@ -0,0 +1,175 @@
+#include "animation_bake.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool AnimationBakeEnabled = false;
+float AnimationBakeFrameRate = ANIMATION_BAKE_FRAME_RATE;
+size_t AnimationBakeBudget = ANIMATION_BAKE_BUDGET;
+bool AnimationBakeBlend = true;
+
+int bakeFrameCount(const Animation *animation, float frameRate);
+int bakeFrame(const struct AnimationBake *bake, float time, float *t);
+mat4s bakeChannel(const Animation *animation, int channel, int frame,
+                  float t);
+AnimationBakedKey bakeKey(const Animation *animation, int channel, int frame,
+                          float t);
+AnimationBakedKey bakeBlend(const AnimationBakedKey *from,
+                            const AnimationBakedKey *to, float t);
+
+bool animationBake(struct Arena *arena, Animation *animation, float frameRate,
+                   size_t budget, bool blend) {
+    size_t size = animationBakeSize(animation, frameRate);
+    if (size > budget) {
+        printf("not baking animation \"%s\", it needs %zu bytes and the "
+               "budget is %zu\n",
+               animation->Name, size, budget);
+        return false;
+    }
+
+    struct AnimationBake *bake =
+        arenaAlloc(arena, sizeof(struct AnimationBake));
+    bake->FrameCount = bakeFrameCount(animation, frameRate);
+    bake->FramesPerTick = 0;
+    if (animation->Duration > 0)
+        bake->FramesPerTick =
+            (bake->FrameCount - 1) / (float)animation->Duration;
+    bake->Blend = blend;
+    bake->Frames = arenaAlloc(arena, (size_t)bake->FrameCount *
+                                         animation->NodeCount *
+                                         sizeof(AnimationBakedKey));
+
+    AnimationCursor *cursors =
+        calloc(animation->NodeCount, sizeof(AnimationCursor));
+    for (int frame = 0; frame < bake->FrameCount; frame++) {
+        float time = animation->Duration;
+        if (frame < bake->FrameCount - 1)
+            time = frame / bake->FramesPerTick;
+        AnimationBakedKey *keys = &bake->Frames[frame * animation->NodeCount];
+        for (int i = 0; i < animation->NodeCount; i++) {
+            AnimationNode *animNode = &animation->Nodes[i];
+            AnimationCursor *cursor = &cursors[i];
+            keys[i].Position = animationSampleVec(
+                animNode->PositionTimes, animNode->PositionValues,
+                &animNode->PackedPositions, animNode->PositionKeyCount, time,
+                &cursor->Position, animNode->PositionInterpolation);
+            keys[i].Rotation = animationSampleQuat(
+                animNode->RotationTimes, animNode->RotationValues,
+                &animNode->PackedRotations, animNode->RotationKeyCount, time,
+                &cursor->Rotation, animNode->RotationInterpolation);
+            keys[i].Scaling = animationSampleVec(
+                animNode->ScalingTimes, animNode->ScalingValues,
+                &animNode->PackedScalings, animNode->ScalingKeyCount, time,
+                &cursor->Scaling, animNode->ScalingInterpolation);
+        }
+    }
+    free(cursors);
+
+    animation->Bake = bake;
+    printf("baked animation \"%s\": %d frames of %d channels at %g fps, %zu "
+           "bytes\n",
+           animation->Name, bake->FrameCount, animation->NodeCount, frameRate,
+           size);
+    return true;
+}
+size_t animationBakeSize(const Animation *animation, float frameRate) {
+    return ARENA_SIZE(sizeof(struct AnimationBake)) +
+           ARENA_SIZE((size_t)bakeFrameCount(animation, frameRate) *
+                      animation->NodeCount * sizeof(AnimationBakedKey));
+}
+void animationBakeSample(const Animation *animation, float time, mat4s *pose) {
+    float t;
+    int frame = bakeFrame(animation->Bake, time, &t);
+    for (int i = 0; i < animation->NodeCount; i++) {
+        struct Node *node = animation->Nodes[i].Node;
+        if (node != NULL)
+            pose[node->Index] = bakeChannel(animation, i, frame, t);
+    }
+}
+mat4s animationBakeSampleChannel(const Animation *animation, int channel,
+                                 float time) {
+    float t;
+    int frame = bakeFrame(animation->Bake, time, &t);
+    return bakeChannel(animation, channel, frame, t);
+}
+AnimationBakedKey animationBakeSampleKey(const Animation *animation,
+                                         int channel, float time) {
+    float t;
+    int frame = bakeFrame(animation->Bake, time, &t);
+    return bakeKey(animation, channel, frame, t);
+}
+
+// the frame at or before `time`, `t` gets how far it is to the next one
+int bakeFrame(const struct AnimationBake *bake, float time, float *t) {
+    float position = time * bake->FramesPerTick;
+    int frame = (int)position;
+    if (frame > bake->FrameCount - 2)
+        frame = bake->FrameCount - 2;
+    if (frame < 0)
+        frame = 0;
+    *t = bake->FrameCount > 1 ? position - frame : 0;
+    return frame;
+}
+mat4s bakeChannel(const Animation *animation, int channel, int frame,
+                  float t) {
+    AnimationBakedKey key = bakeKey(animation, channel, frame, t);
+    return animationCompose(key.Position, key.Rotation, key.Scaling);
+}
+AnimationBakedKey bakeKey(const Animation *animation, int channel, int frame,
+                          float t) {
+    const struct AnimationBake *bake = animation->Bake;
+    const AnimationBakedKey *from =
+        &bake->Frames[frame * animation->NodeCount + channel];
+    const AnimationBakedKey *to = from + animation->NodeCount;
+    const AnimationNode *animNode = &animation->Nodes[channel];
+    AnimationBakedKey key = *from;
+    if (bake->Blend && t > 0)
+        key = bakeBlend(from, to, t);
+    else if (!bake->Blend && t >= 0.5f)
+        key = *to;
+    // step tracks hold until the next frame
+    if (animNode->PositionInterpolation == ANIMATIONINTERP_STEP)
+        key.Position = from->Position;
+    if (animNode->RotationInterpolation == ANIMATIONINTERP_STEP)
+        key.Rotation = from->Rotation;
+    if (animNode->ScalingInterpolation == ANIMATIONINTERP_STEP)
+        key.Scaling = from->Scaling;
+    return key;
+}
+// enough frames to keep the rate, at least one
+int bakeFrameCount(const Animation *animation, float frameRate) {
+    float seconds = (float)animation->Duration / animation->TicksPerSec;
+    return (int)ceilf(seconds * frameRate) + 1;
+}
+// nlerp, frames are close enough together for it. written out so the
+// compiler can keep it all in registers
+AnimationBakedKey bakeBlend(const AnimationBakedKey *from,
+                            const AnimationBakedKey *to, float t) {
+    AnimationBakedKey result;
+    float dot = 0;
+    for (int i = 0; i < 4; i++) {
+        dot += from->Rotation.raw[i] * to->Rotation.raw[i];
+    }
+    // the short way round
+    float toWeight = dot < 0 ? -t : t;
+    float length = 0;
+    for (int i = 0; i < 4; i++) {
+        result.Rotation.raw[i] = from->Rotation.raw[i] * (1 - t) +
+                                 to->Rotation.raw[i] * toWeight;
+        length += result.Rotation.raw[i] * result.Rotation.raw[i];
+    }
+    float inverseLength = 1 / sqrtf(length);
+    for (int i = 0; i < 4; i++) {
+        result.Rotation.raw[i] *= inverseLength;
+    }
+    for (int i = 0; i < 3; i++) {
+        float fromPosition = from->Position.raw[i];
+        float fromScaling = from->Scaling.raw[i];
+        result.Position.raw[i] =
+            fromPosition + (to->Position.raw[i] - fromPosition) * t;
+        result.Scaling.raw[i] =
+            fromScaling + (to->Scaling.raw[i] - fromScaling) * t;
+    }
+    return result;
+}
@@ -0,0 +1,242 @@
+#include "animation.h"
+#include "animation_bake.h"
+#include "transform_batch.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// copies are sampled a lane each, one AVX2 register or two SSE ones
+#define ANIMATION_LANES 8
+
+typedef float AnimationFloats
+    __attribute__((vector_size(ANIMATION_LANES * sizeof(float))));
+typedef int32_t AnimationInts
+    __attribute__((vector_size(ANIMATION_LANES * sizeof(int32_t))));
+
+/// the components of the three tracks one after another in `From` and `To`
+enum AnimationLaneTrack {
+    ANIMATIONLANE_POSITION = 0,
+    ANIMATIONLANE_ROTATION = 3,
+    ANIMATIONLANE_SCALING = 7,
+};
+
+/// one group of copies, one value per lane in each
+struct AnimationLanes {
+    AnimationFloats From[10];
+    AnimationFloats To[10];
+    /// position, rotation and scaling
+    AnimationFloats T[3];
+    /// upper 3x4 of the local matrix, column major
+    AnimationFloats Matrix[12];
+};
+
+void gatherTrack(struct AnimationLanes *lanes, int lane, int track,
+                 const float *times, const float *values,
+                 const AnimationPackedTrack *packed, int components,
+                 int keyCount, enum AnimationInterpolation interpolation,
+                 float time, int *cursor);
+void trackKey(const float *values, const AnimationPackedTrack *packed,
+              int components, int key, float *result);
+void lanesComposeDefault(struct AnimationLanes *lanes);
+#if defined(__x86_64__) || defined(__i386__)
+void lanesComposeAvx2(struct AnimationLanes *lanes);
+#endif
+
+void animationSampleBatch(Animation *animation, int count, const float *times,
+                          AnimationCursor *cursors, mat4s *poses,
+                          int poseStride) {
+    if (animation->Bake != NULL) {
+        // no keys to search, a copy is a couple of frames to blend
+        for (int i = 0; i < count; i++) {
+            animationBakeSample(animation, times[i], &poses[i * poseStride]);
+        }
+        return;
+    }
+    // the kernel is picked at run time, so a build without `-march=native`
+    // still gets AVX2 where the CPU has it
+    void (*lanesCompose)(struct AnimationLanes *) = lanesComposeDefault;
+#if defined(__x86_64__) || defined(__i386__)
+    if (transformBatchGetPath() >= TRANSFORMBATCH_AVX2)
+        lanesCompose = lanesComposeAvx2;
+#endif
+    struct AnimationLanes lanes;
+    for (int i = 0; i < animation->NodeCount; i++) {
+        AnimationNode *animNode = &animation->Nodes[i];
+        if (animNode->Node == NULL)
+            continue;
+        int nodeIndex = animNode->Node->Index;
+
+        for (int first = 0; first < count; first += ANIMATION_LANES) {
+            int laneCount = count - first < ANIMATION_LANES ? count - first
+                                                            : ANIMATION_LANES;
+            // the lanes past `count` repeat the last copy
+            for (int lane = 0; lane < ANIMATION_LANES; lane++) {
+                int copy = first + (lane < laneCount ? lane : laneCount - 1);
+                AnimationCursor noCursor = {-1, -1, -1};
+                AnimationCursor *cursor =
+                    cursors != NULL ? &cursors[copy * animation->NodeCount + i]
+                                    : &noCursor;
+                gatherTrack(&lanes, lane, ANIMATIONLANE_POSITION,
+                            animNode->PositionTimes,
+                            (const float *)animNode->PositionValues,
+                            &animNode->PackedPositions, 3,
+                            animNode->PositionKeyCount,
+                            animNode->PositionInterpolation, times[copy],
+                            &cursor->Position);
+                gatherTrack(&lanes, lane, ANIMATIONLANE_ROTATION,
+                            animNode->RotationTimes,
+                            (const float *)animNode->RotationValues,
+                            &animNode->PackedRotations, 4,
+                            animNode->RotationKeyCount,
+                            animNode->RotationInterpolation, times[copy],
+                            &cursor->Rotation);
+                gatherTrack(&lanes, lane, ANIMATIONLANE_SCALING,
+                            animNode->ScalingTimes,
+                            (const float *)animNode->ScalingValues,
+                            &animNode->PackedScalings, 3,
+                            animNode->ScalingKeyCount,
+                            animNode->ScalingInterpolation, times[copy],
+                            &cursor->Scaling);
+            }
+
+            lanesCompose(&lanes);
+            for (int lane = 0; lane < laneCount; lane++) {
+                mat4s *pose = &poses[(first + lane) * poseStride + nodeIndex];
+                for (int column = 0; column < 4; column++) {
+                    for (int row = 0; row < 3; row++) {
+                        pose->raw[column][row] =
+                            lanes.Matrix[column * 3 + row][lane];
+                    }
+                    pose->raw[column][3] = column == 3 ? 1 : 0;
+                }
+            }
+        }
+    }
+}
+
+// finds the two keys around `time` and how far between them it is, the
+// rest of the work happens across all lanes at once
+void gatherTrack(struct AnimationLanes *lanes, int lane, int track,
+                 const float *times, const float *values,
+                 const AnimationPackedTrack *packed, int components,
+                 int keyCount, enum AnimationInterpolation interpolation,
+                 float time, int *cursor) {
+    int key = 0;
+    float t = 0;
+    if (keyCount > 1) {
+        key = animationFindKey(times, keyCount, time, cursor);
+        if (key < keyCount - 1 && time > times[key] &&
+            interpolation != ANIMATIONINTERP_STEP) {
+            t = (time - times[key]) / (times[key + 1] - times[key]);
+            if (interpolation == ANIMATIONINTERP_SMOOTHSTEP)
+                t = animationSmoothStep(t);
+        }
+    }
+    float from[4], to[4];
+    trackKey(values, packed, components, key, from);
+    trackKey(values, packed, components, t > 0 ? key + 1 : key, to);
+    for (int c = 0; c < components; c++) {
+        lanes->From[track + c][lane] = from[c];
+        lanes->To[track + c][lane] = to[c];
+    }
+    lanes->T[track == ANIMATIONLANE_POSITION   ? 0
+             : track == ANIMATIONLANE_ROTATION ? 1
+                                               : 2][lane] = t;
+}
+void trackKey(const float *values, const AnimationPackedTrack *packed,
+              int components, int key, float *result) {
+    if (values != NULL) {
+        memcpy(result, &values[key * components], components * sizeof(float));
+    } else if (components == 4) {
+        versors rotation = animationDecodeQuat(packed, key);
+        memcpy(result, rotation.raw, sizeof(rotation.raw));
+    } else {
+        vec3s value = animationDecodeVec(packed, key);
+        memcpy(result, value.raw, sizeof(value.raw));
+    }
+}
+
+// the lane math is written once with vector extensions and inlined into a
+// function per instruction set, like the kernels in transform_batch.c
+__attribute__((always_inline)) static inline void
+lanesLerp(const struct AnimationLanes *lanes, int track, int t,
+          AnimationFloats *result, int components) {
+    for (int c = 0; c < components; c++) {
+        AnimationFloats from = lanes->From[track + c];
+        result[c] = from + (lanes->To[track + c] - from) * lanes->T[t];
+    }
+}
+// nlerp with `t` adjusted so it follows slerp to within about 1e-3 radians,
+// see "Approximating slerp" by Arseny Kapoulkine
+__attribute__((always_inline)) static inline void
+lanesNlerp(const struct AnimationLanes *lanes, AnimationFloats *rotation) {
+    const AnimationFloats *from = &lanes->From[ANIMATIONLANE_ROTATION];
+    const AnimationFloats *to = &lanes->To[ANIMATIONLANE_ROTATION];
+    AnimationFloats dot = from[0] * to[0] + from[1] * to[1] +
+                          from[2] * to[2] + from[3] * to[3];
+    AnimationInts signBit = (AnimationInts)dot & INT32_MIN;
+
+    AnimationFloats t = lanes->T[1];
+    AnimationFloats d = (AnimationFloats)((AnimationInts)dot & INT32_MAX);
+    // a = 1.0904 - 3.2452d + 3.55645d^2 - 1.43519d^3
+    AnimationFloats a =
+        1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+    // b = 0.848013 - 1.06021d + 0.215638d^2
+    AnimationFloats b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+    // t + t(t - 0.5)(t - 1)(a(t - 0.5)^2 + b)
+    AnimationFloats centered = t - 0.5f;
+    t = t + t * centered * (t - 1) * (a * centered * centered + b);
+
+    AnimationFloats length = {0};
+    for (int c = 0; c < 4; c++) {
+        // `to` with the sign of `dot` flipped in, to take the short way round
+        AnimationFloats other =
+            (AnimationFloats)((AnimationInts)to[c] ^ signBit);
+        rotation[c] = from[c] + (other - from[c]) * t;
+        length += rotation[c] * rotation[c];
+    }
+    AnimationFloats scale;
+    for (int lane = 0; lane < ANIMATION_LANES; lane++) {
+        scale[lane] = 1 / sqrtf(length[lane]);
+    }
+    for (int c = 0; c < 4; c++) {
+        rotation[c] *= scale;
+    }
+}
+// translation * rotation * scale, same as `animationSample`
+__attribute__((always_inline)) static inline void
+lanesComposeBody(struct AnimationLanes *lanes) {
+    AnimationFloats position[3], rotation[4], scale[3];
+    lanesLerp(lanes, ANIMATIONLANE_POSITION, 0, position, 3);
+    lanesNlerp(lanes, rotation);
+    lanesLerp(lanes, ANIMATIONLANE_SCALING, 2, scale, 3);
+
+    AnimationFloats x = rotation[0], y = rotation[1], z = rotation[2],
+                    w = rotation[3];
+    AnimationFloats xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+    AnimationFloats xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+    AnimationFloats wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+    AnimationFloats *m = lanes->Matrix;
+    m[0] = (1 - (yy + zz)) * scale[0];
+    m[1] = (xy + wz) * scale[0];
+    m[2] = (xz - wy) * scale[0];
+    m[3] = (xy - wz) * scale[1];
+    m[4] = (1 - (xx + zz)) * scale[1];
+    m[5] = (yz + wx) * scale[1];
+    m[6] = (xz + wy) * scale[2];
+    m[7] = (yz - wx) * scale[2];
+    m[8] = (1 - (xx + yy)) * scale[2];
+    m[9] = position[0];
+    m[10] = position[1];
+    m[11] = position[2];
+}
+void lanesComposeDefault(struct AnimationLanes *lanes) {
+    lanesComposeBody(lanes);
+}
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2,fma"))) void
+lanesComposeAvx2(struct AnimationLanes *lanes) {
+    lanesComposeBody(lanes);
+}
+#endif
@@ -0,0 +1,391 @@
+#include "animation_compress.h"
+
+#include <cglm/struct/quat.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// slerp takes the short way round, so which way a rotation goes between keys
+// half a turn apart is down to rounding, which packing could change. spans
+// never get this wide and tracks with keys this far apart keep their floats
+#define HALF_TURN (float)(M_PI - 0.05)
+
+bool AnimationCompressEnabled = false;
+float AnimationCompressTolerance = ANIMATION_COMPRESS_TOLERANCE;
+
+int reduceTrack(const float *times, const float *values, int components,
+                int keyCount, enum AnimationInterpolation interpolation,
+                float tolerance, int *kept);
+bool spanFits(const float *times, const float *values, int components,
+              int first, int last, enum AnimationInterpolation interpolation,
+              float tolerance);
+void interpolateKey(const float *from, const float *to, int components,
+                    float t, float *result);
+float keyError(const float *a, const float *b, int components);
+float *copyTimes(struct Arena *arena, const float *times, const int *kept,
+                 int keptCount);
+void packVecTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                  const vec3s *values, const int *kept, int keptCount);
+void packQuatTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                   const versors *values, const int *kept, int keptCount);
+bool hasHalfTurn(const versors *values, const int *kept, int keptCount);
+versors *copyRotations(struct Arena *arena, const versors *values,
+                       const int *kept, int keptCount);
+float vecTrackError(const AnimationNode *original,
+                    const AnimationNode *compressed, bool scaling);
+float quatTrackError(const AnimationNode *original,
+                     const AnimationNode *compressed);
+
+Animation *animationCompress(struct Arena *arena, const Animation *animation,
+                             float tolerance,
+                             struct AnimationCompressStats *stats) {
+    Animation *result = arenaAlloc(arena, sizeof(Animation));
+    *result = *animation;
+    result->Name = arenaCopyString(arena, animation->Name);
+    result->Time = 0;
+    result->Bake = NULL;
+    animationCopyMorphChannels(arena, result, animation);
+    result->Nodes =
+        arenaCalloc(arena, animation->NodeCount * sizeof(AnimationNode));
+    *stats = (struct AnimationCompressStats){0};
+
+    int maxKeyCount = 1;
+    for (int i = 0; i < animation->NodeCount; i++) {
+        const AnimationNode *source = &animation->Nodes[i];
+        int keyCounts[3] = {source->PositionKeyCount, source->RotationKeyCount,
+                            source->ScalingKeyCount};
+        for (int j = 0; j < 3; j++) {
+            if (keyCounts[j] > maxKeyCount)
+                maxKeyCount = keyCounts[j];
+        }
+    }
+    int *kept = malloc(maxKeyCount * sizeof(int));
+
+    for (int i = 0; i < animation->NodeCount; i++) {
+        const AnimationNode *source = &animation->Nodes[i];
+        AnimationNode *animNode = &result->Nodes[i];
+        animNode->Node = source->Node;
+        animNode->PositionInterpolation = source->PositionInterpolation;
+        animNode->RotationInterpolation = source->RotationInterpolation;
+        animNode->ScalingInterpolation = source->ScalingInterpolation;
+
+        int count = reduceTrack(
+            source->PositionTimes, (const float *)source->PositionValues, 3,
+            source->PositionKeyCount, source->PositionInterpolation, tolerance,
+            kept);
+        animNode->PositionKeyCount = count;
+        animNode->PositionTimes =
+            copyTimes(arena, source->PositionTimes, kept, count);
+        packVecTrack(arena, &animNode->PackedPositions,
+                     source->PositionValues, kept, count);
+
+        count = reduceTrack(
+            source->RotationTimes, (const float *)source->RotationValues, 4,
+            source->RotationKeyCount, source->RotationInterpolation, tolerance,
+            kept);
+        animNode->RotationKeyCount = count;
+        animNode->RotationTimes =
+            copyTimes(arena, source->RotationTimes, kept, count);
+        if (hasHalfTurn(source->RotationValues, kept, count))
+            animNode->RotationValues =
+                copyRotations(arena, source->RotationValues, kept, count);
+        else
+            packQuatTrack(arena, &animNode->PackedRotations,
+                          source->RotationValues, kept, count);
+
+        count = reduceTrack(
+            source->ScalingTimes, (const float *)source->ScalingValues, 3,
+            source->ScalingKeyCount, source->ScalingInterpolation, tolerance,
+            kept);
+        animNode->ScalingKeyCount = count;
+        animNode->ScalingTimes =
+            copyTimes(arena, source->ScalingTimes, kept, count);
+        packVecTrack(arena, &animNode->PackedScalings, source->ScalingValues,
+                     kept, count);
+
+        stats->KeyCountBefore += source->PositionKeyCount +
+                                 source->RotationKeyCount +
+                                 source->ScalingKeyCount;
+        stats->KeyCountAfter += animNode->PositionKeyCount +
+                                animNode->RotationKeyCount +
+                                animNode->ScalingKeyCount;
+        stats->SizeBefore +=
+            source->PositionKeyCount * (sizeof(float) + sizeof(vec3s)) +
+            source->RotationKeyCount * (sizeof(float) + sizeof(versors)) +
+            source->ScalingKeyCount * (sizeof(float) + sizeof(vec3s));
+        // the ranges of the position and scaling tracks, then the keys
+        stats->SizeAfter += 4 * sizeof(vec3s);
+        stats->SizeAfter += (animNode->PositionKeyCount +
+                             animNode->RotationKeyCount +
+                             animNode->ScalingKeyCount) *
+                            (sizeof(float) + 3 * sizeof(uint16_t));
+        if (animNode->RotationValues != NULL)
+            stats->SizeAfter += animNode->RotationKeyCount *
+                                (sizeof(versors) - 3 * sizeof(uint16_t));
+
+        stats->PositionError = fmaxf(stats->PositionError,
+                                     vecTrackError(source, animNode, false));
+        stats->RotationError =
+            fmaxf(stats->RotationError, quatTrackError(source, animNode));
+        stats->ScalingError = fmaxf(stats->ScalingError,
+                                    vecTrackError(source, animNode, true));
+    }
+
+    free(kept);
+    return result;
+}
+void animationCompressPrintStats(const Animation *animation,
+                                 const struct AnimationCompressStats *stats) {
+    printf("compressed animation \"%s\": %d -> %d keys, %zu -> %zu bytes "
+           "(%.2fx), max error %.2g (position) %.2g rad (rotation) %.2g "
+           "(scale)\n",
+           animation->Name, stats->KeyCountBefore, stats->KeyCountAfter,
+           stats->SizeBefore, stats->SizeAfter,
+           (double)stats->SizeBefore / stats->SizeAfter, stats->PositionError,
+           stats->RotationError, stats->ScalingError);
+}
+
+// fills `kept` with the keys that can't be interpolated from the ones kept
+// around them, returns how many there are
+int reduceTrack(const float *times, const float *values, int components,
+                int keyCount, enum AnimationInterpolation interpolation,
+                float tolerance, int *kept) {
+    if (keyCount <= 1) {
+        kept[0] = 0;
+        return keyCount;
+    }
+
+    // a track that doesn't change is one key
+    bool constant = true;
+    for (int i = 1; i < keyCount && constant; i++) {
+        constant = keyError(&values[i * components], values, components) <=
+                   tolerance;
+    }
+    if (constant) {
+        kept[0] = 0;
+        return 1;
+    }
+
+    int keptCount = 0;
+    int first = 0;
+    kept[keptCount++] = first;
+    for (int last = 2; last < keyCount; last++) {
+        if (!spanFits(times, values, components, first, last, interpolation,
+                      tolerance)) {
+            first = last - 1;
+            kept[keptCount++] = first;
+        }
+    }
+    kept[keptCount++] = keyCount - 1;
+    return keptCount;
+}
+// whether every key between `first` and `last` is within `tolerance` of what
+// interpolating between the two gives
+bool spanFits(const float *times, const float *values, int components,
+              int first, int last, enum AnimationInterpolation interpolation,
+              float tolerance) {
+    float duration = times[last] - times[first];
+    if (duration <= 0)
+        return false;
+    if (components == 4 && keyError(&values[first * components],
+                                    &values[last * components],
+                                    components) > HALF_TURN)
+        return false;
+    for (int i = first + 1; i < last; i++) {
+        const float *value = &values[i * components];
+        // easing comes to a stop at every key, so only keys that hold still
+        // can go without changing the curve
+        if (interpolation == ANIMATIONINTERP_SMOOTHSTEP) {
+            if (keyError(value, &values[first * components], components) >
+                    tolerance ||
+                keyError(value, &values[last * components], components) >
+                    tolerance)
+                return false;
+            continue;
+        }
+        float t = interpolation == ANIMATIONINTERP_STEP
+                      ? 0
+                      : (times[i] - times[first]) / duration;
+        float expected[4];
+        interpolateKey(&values[first * components],
+                       &values[last * components], components, t, expected);
+        if (keyError(expected, value, components) > tolerance)
+            return false;
+    }
+    return true;
+}
+void interpolateKey(const float *from, const float *to, int components,
+                    float t, float *result) {
+    if (components == 4) {
+        versors a, b;
+        memcpy(a.raw, from, sizeof(a.raw));
+        memcpy(b.raw, to, sizeof(b.raw));
+        versors rotation = glms_quat_slerp(a, b, t);
+        memcpy(result, rotation.raw, sizeof(rotation.raw));
+        return;
+    }
+    for (int i = 0; i < components; i++) {
+        result[i] = from[i] + (to[i] - from[i]) * t;
+    }
+}
+// distance for vectors, the angle between them for quaternions
+float keyError(const float *a, const float *b, int components) {
+    if (components == 4) {
+        // acos of the dot product loses small angles to rounding, this
+        // doesn't. q and -q are the same rotation
+        float dot = 0;
+        for (int i = 0; i < 4; i++) {
+            dot += a[i] * b[i];
+        }
+        float sign = dot < 0 ? -1 : 1;
+        float difference = 0, sum = 0;
+        for (int i = 0; i < 4; i++) {
+            difference += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+            sum += (a[i] + sign * b[i]) * (a[i] + sign * b[i]);
+        }
+        return 4 * atan2f(sqrtf(difference), sqrtf(sum));
+    }
+    float error = 0;
+    for (int i = 0; i < components; i++) {
+        error += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return sqrtf(error);
+}
+float *copyTimes(struct Arena *arena, const float *times, const int *kept,
+                 int keptCount) {
+    float *result = arenaAlloc(arena, keptCount * sizeof(float));
+    for (int i = 0; i < keptCount; i++) {
+        result[i] = times[kept[i]];
+    }
+    return result;
+}
+void packVecTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                  const vec3s *values, const int *kept, int keptCount) {
+    packed->Keys = arenaAlloc(arena, keptCount * sizeof(uint16_t[3]));
+    if (keptCount == 0) {
+        packed->Min = packed->Extent = (vec3s){0};
+        return;
+    }
+    vec3s min = values[kept[0]], max = values[kept[0]];
+    for (int i = 1; i < keptCount; i++) {
+        min = glms_vec3_minv(min, values[kept[i]]);
+        max = glms_vec3_maxv(max, values[kept[i]]);
+    }
+    packed->Min = min;
+    packed->Extent = glms_vec3_sub(max, min);
+    for (int i = 0; i < keptCount; i++) {
+        for (int j = 0; j < 3; j++) {
+            float extent = packed->Extent.raw[j];
+            float value = values[kept[i]].raw[j] - min.raw[j];
+            packed->Keys[i][j] =
+                extent > 0 ? lroundf(value / extent * UINT16_MAX) : 0;
+        }
+    }
+}
+void packQuatTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                   const versors *values, const int *kept, int keptCount) {
+    packed->Min = packed->Extent = (vec3s){0};
+    packed->Keys = arenaAlloc(arena, keptCount * sizeof(uint16_t[3]));
+    for (int i = 0; i < keptCount; i++) {
+        versors rotation = glms_quat_normalize(values[kept[i]]);
+        int largest = 0;
+        for (int j = 1; j < 4; j++) {
+            if (fabsf(rotation.raw[j]) > fabsf(rotation.raw[largest]))
+                largest = j;
+        }
+        // q and -q are the same rotation, so the largest can be positive
+        float sign = rotation.raw[largest] < 0 ? -1 : 1;
+
+        uint64_t bits = largest;
+        int shift = 2;
+        for (int j = 0; j < 4; j++) {
+            if (j == largest)
+                continue;
+            // the others can't be bigger than 1/sqrt(2)
+            float value = rotation.raw[j] * sign * (float)M_SQRT2;
+            long quantized = lroundf((value * 0.5f + 0.5f) * 32767);
+            if (quantized < 0)
+                quantized = 0;
+            else if (quantized > 32767)
+                quantized = 32767;
+            bits |= (uint64_t)quantized << shift;
+            shift += 15;
+        }
+        packed->Keys[i][0] = bits;
+        packed->Keys[i][1] = bits >> 16;
+        packed->Keys[i][2] = bits >> 32;
+    }
+}
+bool hasHalfTurn(const versors *values, const int *kept, int keptCount) {
+    for (int i = 1; i < keptCount; i++) {
+        if (keyError(values[kept[i - 1]].raw, values[kept[i]].raw, 4) >
+            HALF_TURN)
+            return true;
+    }
+    return false;
+}
+versors *copyRotations(struct Arena *arena, const versors *values,
+                       const int *kept, int keptCount) {
+    versors *result = arenaAlloc(arena, keptCount * sizeof(versors));
+    for (int i = 0; i < keptCount; i++) {
+        result[i] = values[kept[i]];
+    }
+    return result;
+}
+float vecTrackError(const AnimationNode *original,
+                    const AnimationNode *compressed, bool scaling) {
+    const float *times =
+        scaling ? original->ScalingTimes : original->PositionTimes;
+    int keyCount =
+        scaling ? original->ScalingKeyCount : original->PositionKeyCount;
+    int originalCursor = -1, compressedCursor = -1;
+    float error = 0;
+    for (int i = 0; i < keyCount * 2 - 1; i++) {
+        // every key and halfway to the next one
+        float time = i % 2 == 0 ? times[i / 2]
+                                : (times[i / 2] + times[i / 2 + 1]) / 2;
+        vec3s expected, actual;
+        if (scaling) {
+            expected = animationSampleVec(
+                times, original->ScalingValues, NULL, keyCount, time,
+                &originalCursor, original->ScalingInterpolation);
+            actual = animationSampleVec(
+                compressed->ScalingTimes, NULL, &compressed->PackedScalings,
+                compressed->ScalingKeyCount, time, &compressedCursor,
+                compressed->ScalingInterpolation);
+        } else {
+            expected = animationSampleVec(
+                times, original->PositionValues, NULL, keyCount, time,
+                &originalCursor, original->PositionInterpolation);
+            actual = animationSampleVec(
+                compressed->PositionTimes, NULL, &compressed->PackedPositions,
+                compressed->PositionKeyCount, time, &compressedCursor,
+                compressed->PositionInterpolation);
+        }
+        error = fmaxf(error, keyError(expected.raw, actual.raw, 3));
+    }
+    return error;
+}
+float quatTrackError(const AnimationNode *original,
+                     const AnimationNode *compressed) {
+    const float *times = original->RotationTimes;
+    int keyCount = original->RotationKeyCount;
+    int originalCursor = -1, compressedCursor = -1;
+    float error = 0;
+    for (int i = 0; i < keyCount * 2 - 1; i++) {
+        float time = i % 2 == 0 ? times[i / 2]
+                                : (times[i / 2] + times[i / 2 + 1]) / 2;
+        versors expected = animationSampleQuat(
+            times, original->RotationValues, NULL, keyCount, time,
+            &originalCursor, original->RotationInterpolation);
+        versors actual = animationSampleQuat(
+            compressed->RotationTimes, compressed->RotationValues,
+            &compressed->PackedRotations,
+            compressed->RotationKeyCount, time, &compressedCursor,
+            compressed->RotationInterpolation);
+        error = fmaxf(error, keyError(expected.raw, actual.raw, 4));
+    }
+    return error;
+}
@@ -0,0 +1,127 @@
+#include "animation_lod.h"
+
+#include "rendering.h"
+
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
+
+bool AnimationLodEnabled = true;
+float AnimationLodScreenSizes[ANIMATION_LOD_COUNT - 1] = {0.25f, 0.1f, 0.03f};
+float AnimationLodUpdateRates[ANIMATION_LOD_COUNT] = {0, 30, 15, 5};
+int AnimationLodMaxDepths[ANIMATION_LOD_COUNT] = {-1, -1, 8, 4};
+
+struct AnimationLodCounters AnimationLodCounters;
+
+void lodSample(AnimationLodState *state, int maxDepth);
+
+AnimationLodState animationLodCreate(Animation *animation, mat4s *pose,
+                                     AnimationCursor *cursors,
+                                     vec3s boundsCenter, float boundsRadius) {
+    return (AnimationLodState){
+        .Animation = animation,
+        .Pose = pose,
+        .Cursors = cursors,
+        .Time = 0,
+        .SinceUpdate = 0,
+        .BoundsCenter = boundsCenter,
+        .BoundsRadius = boundsRadius,
+        // counts as coming into view, so the first update samples it
+        .Lod = ANIMATION_LOD_COUNT,
+    };
+}
+void animationLodBeginFrame(void) {
+    AnimationLodCounters = (struct AnimationLodCounters){0};
+}
+void animationLodUpdate(AnimationLodState *state, mat4s worldFromModel,
+                        float deltaTime) {
+    Animation *animation = state->Animation;
+    state->Time = animationAdvance(animation, state->Time, deltaTime);
+    state->SinceUpdate += deltaTime;
+    if (!AnimationLodEnabled) {
+        state->Lod = 0;
+        state->SinceUpdate = 0;
+        lodSample(state, -1);
+        return;
+    }
+
+    bool wasHidden = state->Lod == ANIMATION_LOD_COUNT;
+    state->Lod = animationLodPick(state->BoundsCenter, state->BoundsRadius,
+                                  worldFromModel);
+    if (state->Lod == ANIMATION_LOD_COUNT) {
+        AnimationLodCounters.SkippedHidden += animation->NodeCount;
+        return;
+    }
+    // just came into view, the pose it has is from whenever it left
+    float rate = AnimationLodUpdateRates[state->Lod];
+    if (!wasHidden && rate > 0 && state->SinceUpdate < 1 / rate) {
+        AnimationLodCounters.SkippedThrottled += animation->NodeCount;
+        return;
+    }
+    state->SinceUpdate = 0;
+    lodSample(state, AnimationLodMaxDepths[state->Lod]);
+}
+int animationLodPick(vec3s boundsCenter, float boundsRadius,
+                     mat4s worldFromModel) {
+    mat4s viewFromModel = glms_mat4_mul(ViewFromWorldMatrix, worldFromModel);
+    mat4s projectionFromModel =
+        glms_mat4_mul(ProjectionFromViewMatrix, viewFromModel);
+
+    // frustum planes in model space, like `meshletCull`
+    for (int i = 0; i < 6; i++) {
+        vec4s plane;
+        for (int j = 0; j < 4; j++) {
+            float row = projectionFromModel.raw[j][i / 2];
+            float w = projectionFromModel.raw[j][3];
+            plane.raw[j] = i % 2 == 0 ? w + row : w - row;
+        }
+        float length = glms_vec3_norm(glms_vec3(plane));
+        if (glms_vec3_dot(glms_vec3(plane), boundsCenter) + plane.w <
+            -boundsRadius * length)
+            return ANIMATION_LOD_COUNT;
+    }
+
+    float scale = 0;
+    for (int i = 0; i < 3; i++) {
+        scale = fmaxf(scale, glms_vec3_norm(glms_vec3(viewFromModel.col[i])));
+    }
+    float radius = boundsRadius * scale;
+    vec3s center = glms_mat4_mulv3(viewFromModel, boundsCenter, 1);
+    float distance = glms_vec3_norm(center);
+    if (distance <= radius)
+        return 0;
+    // the projection scales y by 1 / tan(fov / 2), an orthographic one
+    // doesn't divide by distance
+    float screenSize = radius * fabsf(ProjectionFromViewMatrix.raw[1][1]);
+    if (ProjectionFromViewMatrix.raw[3][3] == 0)
+        screenSize /= distance;
+
+    int lod = 0;
+    while (lod < ANIMATION_LOD_COUNT - 1 &&
+           screenSize < AnimationLodScreenSizes[lod])
+        lod++;
+    return lod;
+}
+
+// samples the channels no deeper than `maxDepth`, all of them when it's -1
+void lodSample(AnimationLodState *state, int maxDepth) {
+    Animation *animation = state->Animation;
+    for (int i = 0; i < animation->NodeCount; i++) {
+        struct Node *node = animation->Nodes[i].Node;
+        if (node == NULL)
+            continue;
+        if (maxDepth >= 0 && nodeDepth(node) > maxDepth) {
+            AnimationLodCounters.SkippedMinor++;
+            continue;
+        }
+        AnimationCursor *cursor =
+            state->Cursors != NULL ? &state->Cursors[i] : NULL;
+        if (state->Pose != NULL)
+            state->Pose[node->Index] =
+                animationSampleChannel(animation, i, state->Time, cursor);
+        else
+            nodeSetLocal(node, animationSampleChannelLocal(
+                                   animation, i, state->Time, cursor));
+        AnimationLodCounters.Evaluated++;
+    }
+}
@@ -0,0 +1,213 @@
+#include "animation_pose.h"
+
+#include "animation_bake.h"
+#include "transform_batch.h"
+
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/quat.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// nodes `animationPoseToMatrices` composes at a time
+#define ANIMATION_POSE_BLOCK 64
+
+void poseAlloc(struct Arena *arena, AnimationPose *pose, int nodeCount);
+size_t poseSize(int nodeCount);
+versors poseNlerp(versors from, versors to, float t);
+
+AnimationPosePool *animationPosePoolCreate(Model *model, int capacity) {
+    int nodeCount = model->NodeCount;
+    size_t size = ARENA_SIZE(sizeof(AnimationPosePool)) +
+                  ARENA_SIZE(capacity * sizeof(AnimationPose)) +
+                  (capacity + 1) * poseSize(nodeCount);
+    struct Arena *arena = arenaCreate(size);
+    AnimationPosePool *pool = arenaAlloc(arena, sizeof(AnimationPosePool));
+    pool->Arena = arena;
+    pool->NodeCount = nodeCount;
+    pool->Capacity = capacity;
+    pool->Poses = arenaAlloc(arena, capacity * sizeof(AnimationPose));
+    pool->FirstFree = NULL;
+    for (int i = capacity - 1; i >= 0; i--) {
+        poseAlloc(arena, &pool->Poses[i], nodeCount);
+        pool->Poses[i].NextFree = pool->FirstFree;
+        pool->FirstFree = &pool->Poses[i];
+    }
+
+    poseAlloc(arena, &pool->Rest, nodeCount);
+    for (int i = 0; i < nodeCount; i++) {
+        TransformLocal local = model->NodeEntries[i].Node->Local;
+        pool->Rest.Positions[i] = local.Position;
+        pool->Rest.Rotations[i] = local.Rotation;
+        pool->Rest.Scalings[i] = local.Scaling;
+    }
+    return pool;
+}
+void animationPosePoolFree(AnimationPosePool *pool) {
+    arenaFree(pool->Arena);
+}
+AnimationPose *animationPoseAcquire(AnimationPosePool *pool) {
+    AnimationPose *pose = pool->FirstFree;
+    if (pose == NULL) {
+        printf("all %d poses of the pool are in use\n", pool->Capacity);
+        exit(EXIT_FAILURE);
+    }
+    pool->FirstFree = pose->NextFree;
+    pose->NextFree = NULL;
+    return pose;
+}
+void animationPoseRelease(AnimationPosePool *pool, AnimationPose *pose) {
+    pose->NextFree = pool->FirstFree;
+    pool->FirstFree = pose;
+}
+float *animationPoseMaskCreate(AnimationPosePool *pool) {
+    return arenaCalloc(pool->Arena, pool->NodeCount * sizeof(float));
+}
+void animationPoseMaskSet(float *mask, struct Node *node, float weight) {
+    mask[node->Index] = weight;
+    for (int i = 0; i < node->ChildCount; i++) {
+        animationPoseMaskSet(mask, node->Children[i], weight);
+    }
+}
+
+void animationPoseReset(AnimationPosePool *pool, AnimationPose *pose) {
+    memcpy(pose->Positions, pool->Rest.Positions,
+           pool->NodeCount * sizeof(vec3s));
+    memcpy(pose->Rotations, pool->Rest.Rotations,
+           pool->NodeCount * sizeof(versors));
+    memcpy(pose->Scalings, pool->Rest.Scalings,
+           pool->NodeCount * sizeof(vec3s));
+}
+void animationPoseSample(Animation *animation, float time, AnimationPose *pose,
+                         AnimationCursor *cursors) {
+    for (int i = 0; i < animation->NodeCount; i++) {
+        AnimationNode *animNode = &animation->Nodes[i];
+        if (animNode->Node == NULL)
+            continue;
+        int index = animNode->Node->Index;
+        if (animation->Bake != NULL) {
+            AnimationBakedKey key = animationBakeSampleKey(animation, i, time);
+            pose->Positions[index] = key.Position;
+            pose->Rotations[index] = key.Rotation;
+            pose->Scalings[index] = key.Scaling;
+            continue;
+        }
+        AnimationCursor binarySearch = {-1, -1, -1};
+        AnimationCursor *cursor = cursors != NULL ? &cursors[i] : &binarySearch;
+        pose->Positions[index] = animationSampleVec(
+            animNode->PositionTimes, animNode->PositionValues,
+            &animNode->PackedPositions, animNode->PositionKeyCount, time,
+            &cursor->Position, animNode->PositionInterpolation);
+        pose->Rotations[index] = animationSampleQuat(
+            animNode->RotationTimes, animNode->RotationValues,
+            &animNode->PackedRotations, animNode->RotationKeyCount, time,
+            &cursor->Rotation, animNode->RotationInterpolation);
+        pose->Scalings[index] = animationSampleVec(
+            animNode->ScalingTimes, animNode->ScalingValues,
+            &animNode->PackedScalings, animNode->ScalingKeyCount, time,
+            &cursor->Scaling, animNode->ScalingInterpolation);
+    }
+}
+void animationPoseBlend(AnimationPosePool *pool, AnimationPose *out,
+                        const AnimationPose *from, const AnimationPose *to,
+                        float weight, const float *mask) {
+    for (int i = 0; i < pool->NodeCount; i++) {
+        float t = mask != NULL ? weight * mask[i] : weight;
+        out->Positions[i] =
+            glms_vec3_lerp(from->Positions[i], to->Positions[i], t);
+        out->Rotations[i] = poseNlerp(from->Rotations[i], to->Rotations[i], t);
+        out->Scalings[i] =
+            glms_vec3_lerp(from->Scalings[i], to->Scalings[i], t);
+    }
+}
+void animationPoseMakeAdditive(AnimationPosePool *pool, AnimationPose *pose,
+                               const AnimationPose *reference) {
+    for (int i = 0; i < pool->NodeCount; i++) {
+        pose->Positions[i] =
+            glms_vec3_sub(pose->Positions[i], reference->Positions[i]);
+        pose->Rotations[i] = glms_quat_mul(
+            glms_quat_inv(reference->Rotations[i]), pose->Rotations[i]);
+        for (int j = 0; j < 3; j++) {
+            float referenceScale = reference->Scalings[i].raw[j];
+            pose->Scalings[i].raw[j] =
+                referenceScale != 0
+                    ? pose->Scalings[i].raw[j] / referenceScale
+                    : 1;
+        }
+    }
+}
+void animationPoseAdd(AnimationPosePool *pool, AnimationPose *out,
+                      const AnimationPose *base, const AnimationPose *additive,
+                      float weight, const float *mask) {
+    for (int i = 0; i < pool->NodeCount; i++) {
+        float t = mask != NULL ? weight * mask[i] : weight;
+        out->Positions[i] = glms_vec3_add(
+            base->Positions[i], glms_vec3_scale(additive->Positions[i], t));
+        out->Rotations[i] = glms_quat_mul(
+            base->Rotations[i],
+            poseNlerp(GLMS_QUAT_IDENTITY, additive->Rotations[i], t));
+        for (int j = 0; j < 3; j++) {
+            out->Scalings[i].raw[j] =
+                base->Scalings[i].raw[j] *
+                (1 + (additive->Scalings[i].raw[j] - 1) * t);
+        }
+    }
+}
+void animationPoseToMatrices(AnimationPosePool *pool, const AnimationPose *pose,
+                             mat4s *parentFromLocal) {
+    TransformAffine affines[ANIMATION_POSE_BLOCK];
+    for (int first = 0; first < pool->NodeCount;
+         first += ANIMATION_POSE_BLOCK) {
+        int blockCount = pool->NodeCount - first < ANIMATION_POSE_BLOCK
+                             ? pool->NodeCount - first
+                             : ANIMATION_POSE_BLOCK;
+        transformBatchCompose(&pose->Positions[first], &pose->Rotations[first],
+                              &pose->Scalings[first], NULL, blockCount,
+                              affines);
+        for (int i = 0; i < blockCount; i++) {
+            parentFromLocal[first + i] = transformToMat4(affines[i]);
+        }
+    }
+}
+void animationPoseApply(AnimationPosePool *pool, const AnimationPose *pose,
+                        Model *model) {
+    for (int i = 0; i < pool->NodeCount; i++) {
+        nodeSetLocal(model->NodeEntries[i].Node,
+                     (TransformLocal){pose->Rotations[i], pose->Positions[i],
+                                      pose->Scalings[i]});
+    }
+}
+
+void poseAlloc(struct Arena *arena, AnimationPose *pose, int nodeCount) {
+    pose->Positions = arenaAlloc(arena, nodeCount * sizeof(vec3s));
+    pose->Rotations = arenaAlloc(arena, nodeCount * sizeof(versors));
+    pose->Scalings = arenaAlloc(arena, nodeCount * sizeof(vec3s));
+    pose->NextFree = NULL;
+}
+size_t poseSize(int nodeCount) {
+    return 2 * ARENA_SIZE(nodeCount * sizeof(vec3s)) +
+           ARENA_SIZE(nodeCount * sizeof(versors));
+}
+// the short way round, like `bakeBlend`
+versors poseNlerp(versors from, versors to, float t) {
+    if (t == 0)
+        return from;
+    float dot = 0;
+    for (int i = 0; i < 4; i++) {
+        dot += from.raw[i] * to.raw[i];
+    }
+    float toWeight = dot < 0 ? -t : t;
+    versors result;
+    float length = 0;
+    for (int i = 0; i < 4; i++) {
+        result.raw[i] = from.raw[i] * (1 - t) + to.raw[i] * toWeight;
+        length += result.raw[i] * result.raw[i];
+    }
+    float inverseLength = 1 / sqrtf(length);
+    for (int i = 0; i < 4; i++) {
+        result.raw[i] *= inverseLength;
+    }
+    return result;
+}
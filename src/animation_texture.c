@@ -0,0 +1,370 @@
+#include "animation_texture.h"
+
+#include "rendering.h"
+
+#include "glad/glad.h"
+#include <cglm/struct/mat3.h>
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/vec3.h>
+#include <cglm/struct/vec4.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int textureDrawCount(Model *model);
+int textureFrameTexels(Model *model, enum AnimationTextureMode mode);
+size_t textureHeight(size_t texelCount);
+void textureModelFromLocal(Model *model, mat4s *modelFromLocal);
+void textureWriteMatrix(vec4s *texels, mat4s matrix);
+mat4s textureModelFromMesh(const Model *model, const struct Mesh *mesh,
+                           const struct Vertex *vertex,
+                           const mat4s *modelFromLocal);
+
+AnimationTexture *animationTextureBake(Model *model, int animation,
+                                       float frameRate,
+                                       enum AnimationTextureMode mode) {
+    Animation *clip = model->Animations[animation];
+    int drawCount = textureDrawCount(model);
+    // the vertices are gone once the meshes are on the GPU, except for
+    // meshes assimp loaded
+    if (mode == ANIMATIONTEXTURE_VERTICES) {
+        for (int i = 0; i < model->MeshCount; i++) {
+            if (model->Meshes[i]->Vertices != NULL)
+                continue;
+            printf("animation texture of \"%s\": mesh %d has no vertices on "
+                   "the CPU, baking matrices instead\n",
+                   clip->Name, i);
+            mode = ANIMATIONTEXTURE_MATRICES;
+            break;
+        }
+    }
+
+    float duration = (float)clip->Duration / clip->TicksPerSec;
+    int frameCount = fmaxf(ceilf(duration * frameRate), 1);
+    // the frames go down the texture, so the height is what runs out first
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    int frameTexels = textureFrameTexels(model, mode);
+    size_t texelCount = (size_t)frameCount * frameTexels;
+    if (mode == ANIMATIONTEXTURE_VERTICES &&
+        textureHeight(texelCount) > (size_t)maxSize) {
+        printf("animation texture of \"%s\": %zu rows of vertices is over "
+               "the limit of %d, baking matrices instead\n",
+               clip->Name, textureHeight(texelCount), maxSize);
+        mode = ANIMATIONTEXTURE_MATRICES;
+        frameTexels = textureFrameTexels(model, mode);
+        texelCount = (size_t)frameCount * frameTexels;
+    }
+    if (textureHeight(texelCount) > (size_t)maxSize) {
+        printf("animation texture of \"%s\": %zu rows is over the limit of "
+               "%d, lower the frame rate\n",
+               clip->Name, textureHeight(texelCount), maxSize);
+        return NULL;
+    }
+    int width = texelCount < ANIMATION_TEXTURE_WIDTH ? texelCount
+                                                     : ANIMATION_TEXTURE_WIDTH;
+    if (width == 0)
+        width = 1;
+    int height = textureHeight(texelCount);
+
+    size_t size = ARENA_SIZE(sizeof(AnimationTexture)) +
+                  ARENA_SIZE(drawCount * sizeof(struct AnimationTextureDraw)) +
+                  ARENA_SIZE((size_t)width * height * sizeof(vec4s));
+    struct Arena *arena = arenaCreate(size);
+    AnimationTexture *texture = arenaAlloc(arena, sizeof(AnimationTexture));
+    texture->Arena = arena;
+    texture->Asset = model;
+    if (model->Handle.Generation != 0)
+        assetAcquire(model->Handle);
+    texture->Mode = mode;
+    texture->FrameCount = frameCount;
+    texture->Duration = duration;
+    texture->FrameTexels = frameTexels;
+    texture->Width = width;
+    texture->Height = height;
+    texture->Texels =
+        arenaCalloc(arena, (size_t)width * height * sizeof(vec4s));
+    texture->DrawCount = drawCount;
+    texture->Draws =
+        arenaAlloc(arena, drawCount * sizeof(struct AnimationTextureDraw));
+    int draw = 0, vertexBase = 0;
+    for (int i = 0; i < model->NodeCount; i++) {
+        struct Node *node = model->NodeEntries[i].Node;
+        for (int j = 0; j < node->MeshCount; j++) {
+            texture->Draws[draw++] = (struct AnimationTextureDraw){
+                .NodeIndex = i,
+                .Mesh = node->Meshes[j],
+                .VertexBase = vertexBase,
+            };
+            vertexBase += model->Meshes[node->Meshes[j]]->VertexCount;
+        }
+    }
+
+    // `animationStep` poses the model itself, so everything it touches is
+    // put back at the end
+    TransformLocal *restPose =
+        malloc(model->NodeCount * sizeof(TransformLocal));
+    mat4s *modelFromLocal = malloc(model->NodeCount * sizeof(mat4s));
+    AnimationCursor *cursors =
+        malloc(clip->NodeCount * sizeof(AnimationCursor));
+    for (int i = 0; i < model->NodeCount; i++) {
+        restPose[i] = model->NodeEntries[i].Node->Local;
+    }
+    for (int i = 0; i < clip->NodeCount; i++) {
+        cursors[i] = clip->Nodes[i].Cursor;
+    }
+    float clipTime = clip->Time;
+    int weightCount = 0;
+    for (int i = 0; i < model->MeshCount; i++) {
+        weightCount += model->Meshes[i]->MorphTargetCount;
+    }
+    float *weights = malloc(weightCount * sizeof(float));
+    for (int i = 0, weight = 0; i < model->MeshCount; i++) {
+        struct Mesh *mesh = model->Meshes[i];
+        for (int j = 0; j < mesh->MorphTargetCount; j++) {
+            weights[weight++] = mesh->MorphWeights[j];
+        }
+    }
+
+    clip->Time = 0;
+    for (int frame = 0; frame < frameCount; frame++) {
+        animationStep(clip, frame == 0 ? 0 : duration / frameCount);
+        textureModelFromLocal(model, modelFromLocal);
+        animationTextureWriteFrame(texture, modelFromLocal,
+                                   &texture->Texels[frame * frameTexels]);
+    }
+
+    for (int i = 0; i < model->NodeCount; i++) {
+        nodeSetLocal(model->NodeEntries[i].Node, restPose[i]);
+    }
+    for (int i = 0; i < clip->NodeCount; i++) {
+        clip->Nodes[i].Cursor = cursors[i];
+    }
+    for (int i = 0, weight = 0; i < model->MeshCount; i++) {
+        struct Mesh *mesh = model->Meshes[i];
+        for (int j = 0; j < mesh->MorphTargetCount; j++) {
+            meshSetMorphWeight(mesh, j, weights[weight++]);
+        }
+    }
+    clip->Time = clipTime;
+    free(weights);
+    free(cursors);
+    free(modelFromLocal);
+    free(restPose);
+
+    glGenTextures(1, &texture->Texture);
+    glBindTexture(GL_TEXTURE_2D, texture->Texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA,
+                 GL_FLOAT, texture->Texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture->InstanceBuffer = 0;
+
+    printf("animation texture of \"%s\": %d frames of %d %s texels, %dx%d, "
+           "%zu bytes\n",
+           clip->Name, frameCount, frameTexels,
+           mode == ANIMATIONTEXTURE_VERTICES ? "vertex" : "matrix", width,
+           height, (size_t)width * height * sizeof(vec4s));
+    return texture;
+}
+void animationTextureWriteFrame(const AnimationTexture *texture,
+                                const mat4s *modelFromLocal, vec4s *texels) {
+    Model *model = texture->Asset;
+    if (texture->Mode == ANIMATIONTEXTURE_MATRICES) {
+        for (int i = 0; i < model->NodeCount; i++) {
+            textureWriteMatrix(&texels[3 * i], modelFromLocal[i]);
+        }
+        for (int i = 0; i < model->BoneCount; i++) {
+            struct ModelBone *bone = &model->Bones[i];
+            textureWriteMatrix(
+                &texels[3 * (model->NodeCount + i)],
+                glms_mat4_mul(modelFromLocal[bone->NodeIndex],
+                              bone->BoneFromMesh));
+        }
+        return;
+    }
+
+    for (int i = 0; i < texture->DrawCount; i++) {
+        struct AnimationTextureDraw *draw = &texture->Draws[i];
+        struct Mesh *mesh = model->Meshes[draw->Mesh];
+        mat4s nodeFromMesh = modelFromLocal[draw->NodeIndex];
+        mat3s normalFromMesh =
+            glms_mat3_transpose(glms_mat3_inv(glms_mat4_pick3(nodeFromMesh)));
+        vec4s *out = &texels[2 * draw->VertexBase];
+        for (int j = 0; j < mesh->VertexCount; j++) {
+            struct Vertex *vertex = &mesh->Vertices[j];
+            vec3s position, normal;
+            if (mesh->BoneCount > 0) {
+                mat4s modelFromMesh =
+                    textureModelFromMesh(model, mesh, vertex, modelFromLocal);
+                position = glms_mat4_mulv3(modelFromMesh, vertex->Position, 1);
+                normal = glms_mat3_mulv(glms_mat4_pick3(modelFromMesh),
+                                        vertex->Normal);
+            } else {
+                position = glms_mat4_mulv3(nodeFromMesh, vertex->Position, 1);
+                normal = glms_mat3_mulv(normalFromMesh, vertex->Normal);
+            }
+            normal = glms_vec3_normalize(normal);
+            out[2 * j] = glms_vec4(position, 1);
+            out[2 * j + 1] = glms_vec4(normal, 0);
+        }
+    }
+}
+vec4s animationTextureSample(const AnimationTexture *texture, float time,
+                             int texel) {
+    // same as `vat_vert.glsl`
+    float position = 0;
+    if (texture->Duration > 0) {
+        float t = fmodf(time, texture->Duration);
+        if (t < 0)
+            t += texture->Duration;
+        position = t / texture->Duration * texture->FrameCount;
+    }
+    int frame = (int)position % texture->FrameCount;
+    int next = (frame + 1) % texture->FrameCount;
+    float blend = position - floorf(position);
+    return glms_vec4_lerp(
+        texture->Texels[frame * texture->FrameTexels + texel],
+        texture->Texels[next * texture->FrameTexels + texel], blend);
+}
+void animationTextureRender(AnimationTexture *texture,
+                            const AnimationTextureInstance *instances,
+                            int count, float time, Material *material) {
+    if (count == 0)
+        return;
+    Model *model = texture->Asset;
+    if (texture->InstanceBuffer == 0)
+        glGenBuffers(1, &texture->InstanceBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, texture->InstanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 count * sizeof(AnimationTextureInstance), instances,
+                 GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                     ANIMATION_TEXTURE_INSTANCE_BINDING,
+                     texture->InstanceBuffer);
+
+    materialApplyProperties(material);
+    uint32_t shader = material->Shader;
+    glUseProgram(shader);
+    glActiveTexture(GL_TEXTURE0 + ANIMATION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, texture->Texture);
+    glUniform1i(glGetUniformLocation(shader, "animationFrames"),
+                ANIMATION_TEXTURE_UNIT);
+    mat4s projectionFromWorld =
+        glms_mat4_mul(ProjectionFromViewMatrix, ViewFromWorldMatrix);
+    glUniformMatrix4fv(glGetUniformLocation(shader, "projectionFromWorld"), 1,
+                       GL_FALSE, projectionFromWorld.raw[0]);
+    glUniform1f(glGetUniformLocation(shader, "time"), time);
+    glUniform1f(glGetUniformLocation(shader, "duration"), texture->Duration);
+    glUniform1i(glGetUniformLocation(shader, "frameCount"),
+                texture->FrameCount);
+    glUniform1i(glGetUniformLocation(shader, "frameTexels"),
+                texture->FrameTexels);
+    glUniform1i(glGetUniformLocation(shader, "vertexFrames"),
+                texture->Mode == ANIMATIONTEXTURE_VERTICES);
+
+    for (int i = 0; i < texture->DrawCount; i++) {
+        struct AnimationTextureDraw *draw = &texture->Draws[i];
+        struct Mesh *mesh = model->Meshes[draw->Mesh];
+        glUniform1i(glGetUniformLocation(shader, "nodeIndex"),
+                    draw->NodeIndex);
+        glUniform1i(glGetUniformLocation(shader, "vertexBase"),
+                    draw->VertexBase);
+        glUniform1i(glGetUniformLocation(shader, "skinned"),
+                    mesh->BoneCount > 0);
+        glUniform1i(glGetUniformLocation(shader, "boneOffset"),
+                    model->NodeCount + mesh->BoneOffset);
+        // undo the packing done by `meshSendData`
+        glUniform3fv(glGetUniformLocation(shader, "positionOffset"), 1,
+                     mesh->PositionOffset.raw);
+        glUniform3fv(glGetUniformLocation(shader, "positionScale"), 1,
+                     mesh->PositionScale.raw);
+        glUniform1i(glGetUniformLocation(shader, "octahedralNormals"),
+                    mesh->VertexFormat == MESHFORMAT_PACKED);
+
+        glBindVertexArray(mesh->VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, mesh->IndexCount,
+                                mesh->IndexType, (void *)mesh->IndexOffset,
+                                count);
+    }
+    glBindVertexArray(0);
+}
+void animationTextureFree(AnimationTexture *texture) {
+    Model *model = texture->Asset;
+    glDeleteTextures(1, &texture->Texture);
+    glDeleteBuffers(1, &texture->InstanceBuffer);
+    arenaFree(texture->Arena);
+    if (model->Handle.Generation != 0)
+        modelFree(model);
+}
+
+int textureDrawCount(Model *model) {
+    int count = 0;
+    for (int i = 0; i < model->NodeCount; i++) {
+        count += model->NodeEntries[i].Node->MeshCount;
+    }
+    return count;
+}
+int textureFrameTexels(Model *model, enum AnimationTextureMode mode) {
+    if (mode == ANIMATIONTEXTURE_MATRICES)
+        return 3 * (model->NodeCount + model->BoneCount);
+    int frameTexels = 0;
+    for (int i = 0; i < model->NodeCount; i++) {
+        struct Node *node = model->NodeEntries[i].Node;
+        for (int j = 0; j < node->MeshCount; j++) {
+            struct Mesh *mesh = model->Meshes[node->Meshes[j]];
+            frameTexels += 2 * mesh->VertexCount;
+        }
+    }
+    return frameTexels;
+}
+size_t textureHeight(size_t texelCount) {
+    size_t height =
+        (texelCount + ANIMATION_TEXTURE_WIDTH - 1) / ANIMATION_TEXTURE_WIDTH;
+    return height > 0 ? height : 1;
+}
+// like `modelRender`, without `WorldFromModel`
+void textureModelFromLocal(Model *model, mat4s *modelFromLocal) {
+    for (int i = 0; i < model->NodeCount; i++) {
+        struct NodeEntry *nodeEntry = &model->NodeEntries[i];
+        TransformAffine parentFromLocal =
+            transformCompose(nodeEntry->Node->Local);
+        modelFromLocal[i] =
+            i == 0 ? transformToMat4(parentFromLocal)
+                   : transformApply(modelFromLocal[nodeEntry->ParentIndex],
+                                    parentFromLocal);
+    }
+}
+// the rows, the last one is always (0, 0, 0, 1)
+void textureWriteMatrix(vec4s *texels, mat4s matrix) {
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            texels[row].raw[column] = matrix.raw[column][row];
+        }
+    }
+}
+// the weights are normalized like in the vertex shader
+mat4s textureModelFromMesh(const Model *model, const struct Mesh *mesh,
+                           const struct Vertex *vertex,
+                           const mat4s *modelFromLocal) {
+    float weightSum = 0;
+    for (int i = 0; i < 4; i++) {
+        weightSum += vertex->Weights[i];
+    }
+    mat4s modelFromMesh = GLMS_MAT4_ZERO;
+    if (weightSum <= 0)
+        return modelFromMesh;
+    for (int i = 0; i < 4; i++) {
+        struct ModelBone *bone =
+            &model->Bones[mesh->BoneOffset + vertex->Joints[i]];
+        mat4s palette = glms_mat4_mul(modelFromLocal[bone->NodeIndex],
+                                      bone->BoneFromMesh);
+        float weight = vertex->Weights[i] / weightSum;
+        for (int column = 0; column < 4; column++) {
+            modelFromMesh.col[column] = glms_vec4_muladds(
+                palette.col[column], weight, modelFromMesh.col[column]);
+        }
+    }
+    return modelFromMesh;
+}
@@ -0,0 +1,49 @@
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Arena *arenaCreate(size_t size) {
+    size = ARENA_SIZE(size);
+    // the header is a multiple of the alignment, so the data after it is too
+    struct Arena *arena = malloc(ARENA_SIZE(sizeof(struct Arena)) + size);
+    if (arena == NULL) {
+        fprintf(stderr, "could not allocate arena of %zu bytes\n", size);
+        exit(EXIT_FAILURE);
+    }
+    arena->Size = size;
+    arena->Used = 0;
+    arena->Next = NULL;
+    arena->Data = (char *)arena + ARENA_SIZE(sizeof(struct Arena));
+    return arena;
+}
+void *arenaAlloc(struct Arena *arena, size_t size) {
+    size = ARENA_SIZE(size);
+    while (arena->Used + size > arena->Size) {
+        if (arena->Next == NULL) {
+            size_t blockSize = arena->Size * 2;
+            arena->Next = arenaCreate(blockSize > size ? blockSize : size);
+        }
+        arena = arena->Next;
+    }
+    void *memory = arena->Data + arena->Used;
+    arena->Used += size;
+    return memory;
+}
+void *arenaCalloc(struct Arena *arena, size_t size) {
+    return memset(arenaAlloc(arena, size), 0, size);
+}
+char *arenaCopyString(struct Arena *arena, const char *string) {
+    if (string == NULL)
+        return NULL;
+    size_t length = strlen(string) + 1;
+    return memcpy(arenaAlloc(arena, length), string, length);
+}
+void arenaFree(struct Arena *arena) {
+    while (arena != NULL) {
+        struct Arena *next = arena->Next;
+        free(arena);
+        arena = next;
+    }
+}
@@ -0,0 +1,298 @@
+#include "asset.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSET_TABLE_EMPTY -1
+#define ASSET_TABLE_REMOVED -2
+#define ASSET_INITIAL_CAPACITY 64
+
+struct AssetSlot {
+    enum AssetType Type;
+    uint32_t Generation;
+    /// 0 while the slot is free
+    int RefCount;
+    /// normalized, NULL for assets that aren't in the table
+    char *Path;
+    uint64_t Hash;
+    void *Data;
+    void (*OnRelease)(void *data);
+    /// next slot in the free list
+    int NextFree;
+};
+
+uint64_t assetHash(enum AssetType type, const char *path);
+int assetTableFind(enum AssetType type, const char *path, uint64_t hash);
+void assetTableInsert(int slot);
+void assetTableGrow();
+struct AssetSlot *assetSlot(AssetHandle handle);
+void assetFreeSlot(int index, void (**onRelease)(void *), void **data);
+
+/// slot 0 is never used, so index 0 means no slot
+struct AssetSlot *_slots = NULL;
+int _slotCount = 1, _slotCapacity = 0;
+int _freeSlot = 0;
+/// open addressing with linear probing, holds slot indices
+int *_table = NULL;
+int _tableCapacity = 0;
+/// entries plus removed markers, both make probing longer
+int _tableUsed = 0;
+pthread_mutex_t _registryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+AssetHandle assetRegister(enum AssetType type, const char *path, void *data,
+                          void (*onRelease)(void *data)) {
+    char *normalized = path != NULL ? assetNormalizePath(path) : NULL;
+
+    pthread_mutex_lock(&_registryMutex);
+    int slot = _freeSlot;
+    if (slot != 0)
+        _freeSlot = _slots[slot].NextFree;
+    else {
+        if (_slotCount >= _slotCapacity) {
+            _slotCapacity =
+                _slotCapacity ? _slotCapacity * 2 : ASSET_INITIAL_CAPACITY;
+            _slots = realloc(_slots, _slotCapacity * sizeof(struct AssetSlot));
+            if (_slots == NULL) {
+                fprintf(stderr, "could not resize asset registry\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        slot = _slotCount++;
+        _slots[slot].Generation = 0;
+    }
+
+    struct AssetSlot *assetSlot = &_slots[slot];
+    // skip 0 when wrapping around, it marks invalid handles
+    if (++assetSlot->Generation == 0)
+        assetSlot->Generation = 1;
+    assetSlot->Type = type;
+    assetSlot->RefCount = 1;
+    assetSlot->Path = normalized;
+    assetSlot->Data = data;
+    assetSlot->OnRelease = onRelease;
+    assetSlot->NextFree = 0;
+    if (normalized != NULL) {
+        assetSlot->Hash = assetHash(type, normalized);
+        assetTableInsert(slot);
+    }
+    AssetHandle handle = {slot, assetSlot->Generation};
+    pthread_mutex_unlock(&_registryMutex);
+    return handle;
+}
+AssetHandle assetFind(enum AssetType type, const char *path) {
+    char *normalized = assetNormalizePath(path);
+    uint64_t hash = assetHash(type, normalized);
+
+    pthread_mutex_lock(&_registryMutex);
+    AssetHandle handle = ASSET_HANDLE_NULL;
+    int entry = assetTableFind(type, normalized, hash);
+    if (entry != -1) {
+        struct AssetSlot *slot = &_slots[_table[entry]];
+        slot->RefCount++;
+        handle = (AssetHandle){_table[entry], slot->Generation};
+    }
+    pthread_mutex_unlock(&_registryMutex);
+
+    free(normalized);
+    return handle;
+}
+AssetHandle assetAcquire(AssetHandle handle) {
+    pthread_mutex_lock(&_registryMutex);
+    struct AssetSlot *slot = assetSlot(handle);
+    if (slot != NULL)
+        slot->RefCount++;
+    pthread_mutex_unlock(&_registryMutex);
+    return handle;
+}
+bool assetRelease(AssetHandle handle) {
+    void (*onRelease)(void *) = NULL;
+    void *data = NULL;
+
+    pthread_mutex_lock(&_registryMutex);
+    struct AssetSlot *slot = assetSlot(handle);
+    bool freed = slot != NULL && --slot->RefCount == 0;
+    if (freed)
+        assetFreeSlot(handle.Index, &onRelease, &data);
+    pthread_mutex_unlock(&_registryMutex);
+
+    // outside the lock, freeing a model releases its meshes and textures
+    if (onRelease != NULL)
+        onRelease(data);
+    return freed;
+}
+void *assetGet(AssetHandle handle, enum AssetType type) {
+    pthread_mutex_lock(&_registryMutex);
+    struct AssetSlot *slot = assetSlot(handle);
+    void *data = slot != NULL && slot->Type == type ? slot->Data : NULL;
+    pthread_mutex_unlock(&_registryMutex);
+    return data;
+}
+int assetRefCount(AssetHandle handle) {
+    pthread_mutex_lock(&_registryMutex);
+    struct AssetSlot *slot = assetSlot(handle);
+    int refCount = slot != NULL ? slot->RefCount : 0;
+    pthread_mutex_unlock(&_registryMutex);
+    return refCount;
+}
+void assetReleaseAll(enum AssetType type) {
+    for (int i = 1; i < _slotCount; i++) {
+        void (*onRelease)(void *) = NULL;
+        void *data = NULL;
+        pthread_mutex_lock(&_registryMutex);
+        if (i < _slotCount && _slots[i].RefCount > 0 && _slots[i].Type == type)
+            assetFreeSlot(i, &onRelease, &data);
+        pthread_mutex_unlock(&_registryMutex);
+        if (onRelease != NULL)
+            onRelease(data);
+    }
+}
+char *assetNormalizePath(const char *path) {
+    size_t length = strlen(path);
+    char *normalized = malloc(length + 1);
+    size_t used = 0;
+    // where the segments that `..` may remove start
+    size_t root = 0;
+    if (path[0] == '/' || path[0] == '\\')
+        normalized[used++] = '/';
+    root = used;
+
+    size_t i = 0;
+    while (i < length) {
+        size_t start = i;
+        while (i < length && path[i] != '/' && path[i] != '\\')
+            i++;
+        size_t segmentLength = i - start;
+        i++; // the separator
+
+        if (segmentLength == 0 ||
+            (segmentLength == 1 && path[start] == '.'))
+            continue;
+        if (segmentLength == 2 && path[start] == '.' &&
+            path[start + 1] == '.') {
+            // drop the last segment unless there is none or it's a `..` too
+            size_t last = used;
+            while (last > root && normalized[last - 1] != '/')
+                last--;
+            if (used > root && strncmp(normalized + last, "..", used - last)) {
+                used = last > root ? last - 1 : root;
+                continue;
+            }
+        }
+        if (used > root)
+            normalized[used++] = '/';
+        memcpy(normalized + used, path + start, segmentLength);
+        used += segmentLength;
+    }
+    normalized[used] = 0;
+    return normalized;
+}
+void assetRegistryFree() {
+    int leftover = 0;
+    for (int i = 1; i < _slotCount; i++) {
+        if (_slots[i].RefCount > 0) {
+            printf("asset \"%s\" was never released\n",
+                   _slots[i].Path != NULL ? _slots[i].Path : "(unnamed)");
+            free(_slots[i].Path);
+            leftover++;
+        }
+    }
+    if (leftover > 0)
+        printf("%d assets were never released\n", leftover);
+    free(_slots);
+    free(_table);
+    _slots = NULL;
+    _table = NULL;
+    _slotCount = 1;
+    _slotCapacity = _tableCapacity = _tableUsed = 0;
+    _freeSlot = 0;
+}
+
+// FNV-1a over the type and path
+uint64_t assetHash(enum AssetType type, const char *path) {
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ (uint64_t)type) * 1099511628211ull;
+    for (; *path; path++) {
+        hash = (hash ^ (uint8_t)*path) * 1099511628211ull;
+    }
+    return hash;
+}
+// returns the table entry holding the asset, -1 if there is none
+int assetTableFind(enum AssetType type, const char *path, uint64_t hash) {
+    if (_tableCapacity == 0)
+        return -1;
+    int mask = _tableCapacity - 1;
+    for (int i = hash & mask;; i = (i + 1) & mask) {
+        int slot = _table[i];
+        if (slot == ASSET_TABLE_EMPTY)
+            return -1;
+        if (slot != ASSET_TABLE_REMOVED && _slots[slot].Hash == hash &&
+            _slots[slot].Type == type && !strcmp(_slots[slot].Path, path))
+            return i;
+    }
+}
+void assetTableInsert(int slot) {
+    // at most half full, counting removed entries
+    if ((_tableUsed + 1) * 2 > _tableCapacity)
+        assetTableGrow();
+    int mask = _tableCapacity - 1;
+    int i = _slots[slot].Hash & mask;
+    while (_table[i] >= 0)
+        i = (i + 1) & mask;
+    if (_table[i] == ASSET_TABLE_EMPTY)
+        _tableUsed++;
+    _table[i] = slot;
+}
+void assetTableGrow() {
+    int live = 0;
+    for (int i = 0; i < _tableCapacity; i++) {
+        if (_table[i] >= 0)
+            live++;
+    }
+    // rehashing also clears the removed markers, so only grow if needed
+    int capacity = _tableCapacity ? _tableCapacity : ASSET_INITIAL_CAPACITY;
+    while ((live + 1) * 2 > capacity)
+        capacity *= 2;
+    int *oldTable = _table;
+    int oldCapacity = _tableCapacity;
+    _table = malloc(capacity * sizeof(int));
+    _tableCapacity = capacity;
+    _tableUsed = 0;
+    for (int i = 0; i < capacity; i++) {
+        _table[i] = ASSET_TABLE_EMPTY;
+    }
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldTable[i] >= 0)
+            assetTableInsert(oldTable[i]);
+    }
+    free(oldTable);
+}
+struct AssetSlot *assetSlot(AssetHandle handle) {
+    if (handle.Index == 0 || handle.Index >= _slotCount)
+        return NULL;
+    struct AssetSlot *slot = &_slots[handle.Index];
+    if (slot->Generation != handle.Generation || slot->RefCount <= 0)
+        return NULL;
+    return slot;
+}
+// takes the slot out of the table and puts it on the free list, handing
+// back what needs to be called once the lock is released
+void assetFreeSlot(int index, void (**onRelease)(void *), void **data) {
+    struct AssetSlot *slot = &_slots[index];
+    if (slot->Path != NULL) {
+        int mask = _tableCapacity - 1;
+        int i = slot->Hash & mask;
+        while (_table[i] != index)
+            i = (i + 1) & mask;
+        _table[i] = ASSET_TABLE_REMOVED;
+        free(slot->Path);
+        slot->Path = NULL;
+    }
+    *onRelease = slot->OnRelease;
+    *data = slot->Data;
+    slot->RefCount = 0;
+    slot->Data = NULL;
+    slot->NextFree = _freeSlot;
+    _freeSlot = index;
+}
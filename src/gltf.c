@@ -0,0 +1,1316 @@
+#include "gltf.h"
+
+#include "animation.h"
+#include "animation_compress.h"
+#include "json.h"
+#include "mesh.h"
+#include "mesh_optimize.h"
+#include "meshlet.h"
+#include "model_cache.h"
+#include "node.h"
+#include "texture.h"
+#include "upload_queue.h"
+
+#include "glad/glad.h"
+#include <cglm/struct/affine.h>
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/quat.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GLB_MAGIC 0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN 0x004E4942
+#define GLTF_MODE_TRIANGLES 4
+/// glTF stores keyframe times in seconds, keys are stored in milliseconds like
+/// assimp does
+#define GLTF_TICKS_PER_SEC 1000
+
+bool ModelNativeGltfEnabled = true;
+
+const char *GltfSemantics[] = {"POSITION", "NORMAL", "TEXCOORD_0", "COLOR_0"};
+
+// component types in glTF use the same values as the GL enums, so accessors
+// can be handed to `glVertexAttribPointer` as they are
+struct GltfBuffer {
+    const uint8_t *Data;
+    size_t Size;
+    /// set if the buffer was decoded from a data uri
+    uint8_t *Decoded;
+    /// set if the buffer is an external file mapped just for it
+    void *Mapping;
+};
+struct GltfFile;
+struct GltfBufferView {
+    struct GltfFile *File;
+    int Buffer;
+    size_t Offset;
+    size_t Length;
+    int Stride; // 0 if tightly packed
+    /// where this view starts in `Model::SharedBuffer`, -1 if it doesn't hold
+    /// vertex or index data
+    int64_t UploadOffset;
+};
+struct GltfAccessor {
+    int BufferView;
+    size_t Offset;
+    uint32_t ComponentType;
+    int ComponentCount;
+    bool Normalized;
+    int Count;
+    /// set for MAT2, MAT3 and MAT4, whose components are a column major matrix
+    bool Matrix;
+    /// of the first three components, zero when the file leaves them out
+    vec3s Min, Max;
+};
+struct GltfNode {
+    int Token;
+    vec3s Translation;
+    versors Rotation;
+    vec3s Scale;
+    struct Node *Node;
+};
+struct GltfFile {
+    const char *Path;
+    Json *Json;
+    void *Mapping;
+    size_t MappingSize;
+    const uint8_t *BinChunk;
+    size_t BinChunkSize;
+
+    int BufferCount;
+    struct GltfBuffer *Buffers;
+    int BufferViewCount;
+    struct GltfBufferView *BufferViews;
+    int AccessorCount;
+    struct GltfAccessor *Accessors;
+    int NodeCount;
+    struct GltfNode *Nodes;
+    int MeshCount;
+    int *MeshTokens;
+    /// index of the first primitive of each mesh in `Model::Meshes`
+    int *MeshFirstPrimitive;
+    /// set for each of `Model::Meshes` that was decoded into `Mesh::Vertices`
+    /// instead of being uploaded straight from the file
+    bool *MeshDecoded;
+    /// what each of `Model::Textures` was loaded as, for the cache. in the
+    /// model's arena
+    const char **TextureNames;
+
+    /// model whose buffers are still being uploaded
+    Model *Model;
+    /// size of the buffer views in `Model::SharedBuffer`
+    size_t UploadSize;
+};
+
+bool gltfOpen(struct GltfFile *file, const char *modelFile);
+const char *gltfLoadBuffers(struct GltfFile *file);
+const char *gltfCheckSupport(struct GltfFile *file);
+bool gltfCheckNodes(struct GltfFile *file);
+const char *gltfLoadMeshes(struct GltfFile *file, Model *model);
+bool gltfCheckIndices(struct GltfFile *file, int primitive);
+bool gltfNeedsVertices(struct GltfFile *file, int primitive);
+struct Mesh *gltfLoadUploadedPrimitive(struct GltfFile *file,
+                                       struct Arena *arena, int primitive);
+struct Mesh *gltfLoadPrimitive(struct GltfFile *file, struct Arena *arena,
+                               int primitive, const char *meshName);
+void gltfQueueUploads(struct GltfFile *file, Model *model);
+void gltfUploadBuffer(void *_file);
+void gltfUploadBufferView(void *_view);
+void gltfUploadVertexArrays(void *_file);
+void gltfSetAttribute(struct GltfFile *file, int location, int accessorIndex);
+void gltfLoadTextures(struct GltfFile *file, Model *model);
+struct Node *gltfLoadNode(struct GltfFile *file, int nodeIndex,
+                          struct Node *parent);
+struct Node *gltfLoadScene(struct GltfFile *file);
+const char **gltfAnimatedNodeNames(struct GltfFile *file, int *count);
+Animation *gltfLoadAnimation(struct GltfFile *file, struct Arena *arena,
+                             int animationToken, int animationIndex);
+void gltfClose(struct GltfFile *file);
+
+int *gltfArrayTokens(Json *json, int array);
+void gltfReadFloats(struct GltfFile *file, int accessorIndex, int element,
+                    float *out);
+uint32_t gltfReadIndex(struct GltfFile *file, int accessorIndex, int element);
+bool gltfAccessorInBounds(struct GltfFile *file, int accessorIndex);
+uint8_t *gltfDecodeBase64(const char *source, size_t length, size_t *size);
+
+bool gltfIsGltfFile(const char *modelFile) {
+    const char *extension = strrchr(modelFile, '.');
+    return extension != NULL &&
+           (!strcmp(extension, ".gltf") || !strcmp(extension, ".glb"));
+}
+
+Model *gltfLoad(const char *modelFile) {
+    struct GltfFile *file = calloc(1, sizeof(struct GltfFile));
+    if (!gltfOpen(file, modelFile)) {
+        gltfClose(file);
+        return NULL;
+    }
+    const char *unsupported = gltfLoadBuffers(file);
+    if (unsupported == NULL)
+        unsupported = gltfCheckSupport(file);
+    if (unsupported != NULL) {
+        printf("native glTF loader can't load \"%s\" (%s), using assimp\n",
+               modelFile, unsupported);
+        gltfClose(file);
+        return NULL;
+    }
+
+    Model *model = _modelCreate(MODEL_ARENA_SIZE);
+    file->Model = model;
+
+    // nothing has been handed to the GL thread yet, so the model can still
+    // be thrown away
+    unsupported = gltfLoadMeshes(file, model);
+    if (unsupported != NULL) {
+        printf("native glTF loader can't load \"%s\" (%s), using assimp\n",
+               modelFile, unsupported);
+        arenaFree(model->Arena);
+        gltfClose(file);
+        return NULL;
+    }
+    model->Materials =
+        arenaAlloc(model->Arena, model->MaterialCount * sizeof(Material *));
+
+    gltfLoadTextures(file, model);
+
+    struct Node *rootNode = gltfLoadScene(file);
+    int keepCount;
+    const char **keepNames = gltfAnimatedNodeNames(file, &keepCount);
+    _modelFlattenNodes(model->Arena, rootNode, keepNames, keepCount);
+    free(keepNames);
+    _modelSetNodes(model, rootNode);
+
+    int animations = jsonObjectGet(file->Json, 0, "animations");
+    model->AnimationCount = jsonCount(file->Json, animations);
+    model->Animations =
+        arenaAlloc(model->Arena, model->AnimationCount * sizeof(Animation *));
+    for (int i = 0; i < model->AnimationCount; i++) {
+        int animationToken = jsonArrayGet(file->Json, animations, i);
+        if (!AnimationCompressEnabled) {
+            model->Animations[i] =
+                gltfLoadAnimation(file, model->Arena, animationToken, i);
+            continue;
+        }
+        struct Arena *keyArena = arenaCreate(MODEL_ARENA_SIZE);
+        Animation *animation =
+            gltfLoadAnimation(file, keyArena, animationToken, i);
+        struct AnimationCompressStats stats;
+        model->Animations[i] = animationCompress(
+            model->Arena, animation, AnimationCompressTolerance, &stats);
+        animationCompressPrintStats(model->Animations[i], &stats);
+        arenaFree(keyArena);
+    }
+
+    if (ModelCacheEnabled)
+        modelCacheWrite(modelFile, model, file->TextureNames);
+
+    for (int i = 0; i < model->MeshCount; i++) {
+        if (file->MeshDecoded[i])
+            meshQueueSendData(model->Meshes[i]);
+    }
+    if (file->UploadSize == 0) {
+        gltfClose(file);
+        return model;
+    }
+    // the path belongs to the caller, the rest of the file is closed by the
+    // last queued upload. nothing may read it here after this point, the GL
+    // thread can already be working on it
+    file->Path = NULL;
+    gltfQueueUploads(file, model);
+
+    return model;
+}
+
+bool gltfOpen(struct GltfFile *file, const char *modelFile) {
+    file->Path = modelFile;
+    int fd = open(modelFile, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "couldn't open \"%s\"\n", modelFile);
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < 12) {
+        close(fd);
+        return false;
+    }
+    file->MappingSize = fileStat.st_size;
+    file->Mapping =
+        mmap(NULL, file->MappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file->Mapping == MAP_FAILED) {
+        file->Mapping = NULL;
+        return false;
+    }
+
+    const uint8_t *data = file->Mapping;
+    const char *jsonSource = file->Mapping;
+    size_t jsonLength = file->MappingSize;
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(uint32_t));
+    if (magic == GLB_MAGIC) {
+        // 12 byte header, then chunks of {length, type, data}. the first one
+        // is always the json and the second one, if any, the binary buffer
+        uint32_t chunkHeader[2];
+        memcpy(chunkHeader, data + 12, sizeof(chunkHeader));
+        if (chunkHeader[1] != GLB_CHUNK_JSON ||
+            20 + (size_t)chunkHeader[0] > file->MappingSize) {
+            fprintf(stderr, "\"%s\" is not a valid glb file\n", modelFile);
+            return false;
+        }
+        jsonSource = (const char *)(data + 20);
+        jsonLength = chunkHeader[0];
+
+        size_t binOffset = 20 + (size_t)chunkHeader[0];
+        if (binOffset + 8 <= file->MappingSize) {
+            memcpy(chunkHeader, data + binOffset, sizeof(chunkHeader));
+            if (chunkHeader[1] == GLB_CHUNK_BIN &&
+                binOffset + 8 + chunkHeader[0] <= file->MappingSize) {
+                file->BinChunk = data + binOffset + 8;
+                file->BinChunkSize = chunkHeader[0];
+            }
+        }
+    }
+
+    file->Json = jsonParse(jsonSource, jsonLength);
+    if (file->Json == NULL) {
+        fprintf(stderr, "\"%s\" has invalid json\n", modelFile);
+        return false;
+    }
+    return true;
+}
+
+const char *gltfLoadBuffers(struct GltfFile *file) {
+    Json *json = file->Json;
+
+    int buffers = jsonObjectGet(json, 0, "buffers");
+    file->BufferCount = jsonCount(json, buffers);
+    file->Buffers = calloc(file->BufferCount, sizeof(struct GltfBuffer));
+    int *bufferTokens = gltfArrayTokens(json, buffers);
+    for (int i = 0; i < file->BufferCount; i++) {
+        struct GltfBuffer *buffer = &file->Buffers[i];
+        int uri = jsonObjectGet(json, bufferTokens[i], "uri");
+        buffer->Size = jsonNumber(
+            json, jsonObjectGet(json, bufferTokens[i], "byteLength"), 0);
+        if (uri == -1) {
+            // glb binary chunk
+            if (i != 0 || file->BinChunk == NULL ||
+                buffer->Size > file->BinChunkSize) {
+                free(bufferTokens);
+                return "missing binary chunk";
+            }
+            buffer->Data = file->BinChunk;
+            continue;
+        }
+
+        struct JsonToken *uriToken = &json->Tokens[uri];
+        const char *uriSource = json->Source + uriToken->Start;
+        if (!strncmp(uriSource, "data:", 5)) {
+            // the source isn't null terminated, so no strstr
+            const char *base64 = NULL;
+            for (int j = 0; j + 8 <= uriToken->Length; j++) {
+                if (!strncmp(uriSource + j, ";base64,", 8)) {
+                    base64 = uriSource + j + 8;
+                    break;
+                }
+            }
+            if (base64 == NULL) {
+                free(bufferTokens);
+                return "data uri that isn't base64";
+            }
+            size_t decodedSize;
+            buffer->Decoded = gltfDecodeBase64(
+                base64, uriSource + uriToken->Length - base64, &decodedSize);
+            buffer->Data = buffer->Decoded;
+            if (decodedSize < buffer->Size) {
+                free(bufferTokens);
+                return "data uri shorter than its buffer";
+            }
+            continue;
+        }
+
+        // external file relative to the gltf file
+        char *uriString = jsonStringCopy(json, uri);
+        const char *slash = strrchr(file->Path, '/');
+        int directoryLength = slash == NULL ? 0 : slash - file->Path + 1;
+        char *bufferFile = malloc(directoryLength + strlen(uriString) + 1);
+        memcpy(bufferFile, file->Path, directoryLength);
+        strcpy(bufferFile + directoryLength, uriString);
+        free(uriString);
+        int fd = open(bufferFile, O_RDONLY);
+        free(bufferFile);
+        struct stat bufferStat;
+        if (fd == -1 || fstat(fd, &bufferStat) != 0 ||
+            bufferStat.st_size < buffer->Size || buffer->Size == 0) {
+            if (fd != -1)
+                close(fd);
+            free(bufferTokens);
+            return "missing external buffer";
+        }
+        buffer->Mapping =
+            mmap(NULL, buffer->Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (buffer->Mapping == MAP_FAILED) {
+            buffer->Mapping = NULL;
+            free(bufferTokens);
+            return "couldn't map external buffer";
+        }
+        buffer->Data = buffer->Mapping;
+    }
+    free(bufferTokens);
+
+    int bufferViews = jsonObjectGet(json, 0, "bufferViews");
+    file->BufferViewCount = jsonCount(json, bufferViews);
+    file->BufferViews =
+        malloc(file->BufferViewCount * sizeof(struct GltfBufferView));
+    int *viewTokens = gltfArrayTokens(json, bufferViews);
+    for (int i = 0; i < file->BufferViewCount; i++) {
+        struct GltfBufferView *view = &file->BufferViews[i];
+        view->Buffer =
+            jsonInt(json, jsonObjectGet(json, viewTokens[i], "buffer"), -1);
+        view->Offset = jsonNumber(
+            json, jsonObjectGet(json, viewTokens[i], "byteOffset"), 0);
+        view->Length = jsonNumber(
+            json, jsonObjectGet(json, viewTokens[i], "byteLength"), 0);
+        view->Stride =
+            jsonInt(json, jsonObjectGet(json, viewTokens[i], "byteStride"), 0);
+        view->UploadOffset = -1;
+        if (view->Buffer < 0 || view->Buffer >= file->BufferCount ||
+            view->Offset + view->Length > file->Buffers[view->Buffer].Size) {
+            free(viewTokens);
+            return "buffer view out of bounds";
+        }
+    }
+    free(viewTokens);
+
+    int accessors = jsonObjectGet(json, 0, "accessors");
+    file->AccessorCount = jsonCount(json, accessors);
+    file->Accessors = malloc(file->AccessorCount * sizeof(struct GltfAccessor));
+    int *accessorTokens = gltfArrayTokens(json, accessors);
+    for (int i = 0; i < file->AccessorCount; i++) {
+        struct GltfAccessor *accessor = &file->Accessors[i];
+        int token = accessorTokens[i];
+        if (jsonObjectGet(json, token, "sparse") != -1) {
+            free(accessorTokens);
+            return "sparse accessors";
+        }
+        accessor->BufferView =
+            jsonInt(json, jsonObjectGet(json, token, "bufferView"), -1);
+        accessor->Offset =
+            jsonNumber(json, jsonObjectGet(json, token, "byteOffset"), 0);
+        accessor->ComponentType =
+            jsonInt(json, jsonObjectGet(json, token, "componentType"), 0);
+        accessor->Normalized =
+            jsonBool(json, jsonObjectGet(json, token, "normalized"), false);
+        accessor->Count = jsonInt(json, jsonObjectGet(json, token, "count"), 0);
+        int min = jsonObjectGet(json, token, "min");
+        int max = jsonObjectGet(json, token, "max");
+        for (int j = 0; j < 3; j++) {
+            accessor->Min.raw[j] =
+                jsonNumber(json, jsonArrayGet(json, min, j), 0);
+            accessor->Max.raw[j] =
+                jsonNumber(json, jsonArrayGet(json, max, j), 0);
+        }
+        int type = jsonObjectGet(json, token, "type");
+        accessor->Matrix = jsonStringEquals(json, type, "MAT2") ||
+                           jsonStringEquals(json, type, "MAT3") ||
+                           jsonStringEquals(json, type, "MAT4");
+        if (jsonStringEquals(json, type, "SCALAR"))
+            accessor->ComponentCount = 1;
+        else if (jsonStringEquals(json, type, "VEC2"))
+            accessor->ComponentCount = 2;
+        else if (jsonStringEquals(json, type, "VEC3"))
+            accessor->ComponentCount = 3;
+        else if (jsonStringEquals(json, type, "VEC4") ||
+                 jsonStringEquals(json, type, "MAT2"))
+            accessor->ComponentCount = 4;
+        else if (jsonStringEquals(json, type, "MAT3"))
+            accessor->ComponentCount = 9;
+        else
+            accessor->ComponentCount = 16;
+        if (!gltfAccessorInBounds(file, i)) {
+            free(accessorTokens);
+            return "accessor out of bounds";
+        }
+    }
+    free(accessorTokens);
+
+    return NULL;
+}
+
+const char *gltfCheckSupport(struct GltfFile *file) {
+    Json *json = file->Json;
+    if (jsonCount(json, jsonObjectGet(json, 0, "extensionsRequired")) > 0)
+        return "required extensions";
+    if (jsonCount(json, jsonObjectGet(json, 0, "skins")) > 0)
+        return "skins";
+    if (jsonCount(json, jsonObjectGet(json, 0, "scenes")) == 0)
+        return "no scenes";
+    if (!gltfCheckNodes(file))
+        return "invalid node hierarchy";
+
+    int meshes = jsonObjectGet(json, 0, "meshes");
+    file->MeshCount = jsonCount(json, meshes);
+    file->MeshTokens = gltfArrayTokens(json, meshes);
+    for (int i = 0; i < file->MeshCount; i++) {
+        int primitives = jsonObjectGet(json, file->MeshTokens[i], "primitives");
+        for (int j = 0; j < jsonCount(json, primitives); j++) {
+            int primitive = jsonArrayGet(json, primitives, j);
+            int attributes = jsonObjectGet(json, primitive, "attributes");
+            if (jsonInt(json, jsonObjectGet(json, primitive, "mode"),
+                        GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES)
+                return "non triangle primitives";
+            if (jsonObjectGet(json, primitive, "targets") != -1)
+                return "morph targets";
+            if (jsonObjectGet(json, attributes, "NORMAL") == -1)
+                return "missing normals";
+
+            // everything that gets uploaded has to come from a buffer view,
+            // with at least as many components as `struct Vertex` takes and
+            // an element for every vertex
+            const int minComponents[] = {3, 3, 2, 3};
+            int position = jsonInt(
+                json, jsonObjectGet(json, attributes, GltfSemantics[0]), -1);
+            if (position < 0 || position >= file->AccessorCount)
+                return "missing vertex data";
+            for (int k = 0; k < 4; k++) {
+                int accessor = jsonInt(
+                    json, jsonObjectGet(json, attributes, GltfSemantics[k]),
+                    -1);
+                if (accessor == -1)
+                    continue;
+                if (accessor < 0 || accessor >= file->AccessorCount ||
+                    file->Accessors[accessor].BufferView == -1 ||
+                    file->Accessors[accessor].ComponentCount <
+                        minComponents[k] ||
+                    file->Accessors[accessor].Count <
+                        file->Accessors[position].Count)
+                    return "missing vertex data";
+            }
+            int indices =
+                jsonInt(json, jsonObjectGet(json, primitive, "indices"), -1);
+            if (indices < 0 || indices >= file->AccessorCount ||
+                file->Accessors[indices].BufferView == -1)
+                return "non indexed primitives";
+            struct GltfAccessor *indexAccessor = &file->Accessors[indices];
+            if ((indexAccessor->ComponentType != GL_UNSIGNED_BYTE &&
+                 indexAccessor->ComponentType != GL_UNSIGNED_SHORT &&
+                 indexAccessor->ComponentType != GL_UNSIGNED_INT) ||
+                indexAccessor->ComponentCount != 1 ||
+                indexAccessor->Count % 3 != 0 ||
+                file->BufferViews[indexAccessor->BufferView].Stride != 0)
+                return "invalid indices";
+        }
+    }
+    return NULL;
+}
+
+// every node index has to be in range, and every node reachable from the
+// scene at most once so loading the tree can't loop or share a node
+bool gltfCheckNodes(struct GltfFile *file) {
+    Json *json = file->Json;
+    int nodes = jsonObjectGet(json, 0, "nodes");
+    file->NodeCount = jsonCount(json, nodes);
+    file->Nodes = calloc(file->NodeCount, sizeof(struct GltfNode));
+    int *nodeTokens = gltfArrayTokens(json, nodes);
+    for (int i = 0; i < file->NodeCount; i++)
+        file->Nodes[i].Token = nodeTokens[i];
+    free(nodeTokens);
+
+    int scenes = jsonObjectGet(json, 0, "scenes");
+    int sceneIndex = jsonInt(json, jsonObjectGet(json, 0, "scene"), 0);
+    if (sceneIndex < 0 || sceneIndex >= jsonCount(json, scenes))
+        return false;
+    int rootNodes =
+        jsonObjectGet(json, jsonArrayGet(json, scenes, sceneIndex), "nodes");
+
+    // roots count as having a parent too, so they can't be children or
+    // listed twice
+    bool *hasParent = calloc(file->NodeCount, sizeof(bool));
+    bool valid = true;
+    for (int i = 0; valid && i < jsonCount(json, rootNodes); i++) {
+        int node = jsonInt(json, jsonArrayGet(json, rootNodes, i), -1);
+        valid = node >= 0 && node < file->NodeCount && !hasParent[node];
+        if (valid)
+            hasParent[node] = true;
+    }
+    for (int i = 0; valid && i < file->NodeCount; i++) {
+        int children = jsonObjectGet(json, file->Nodes[i].Token, "children");
+        for (int j = 0; valid && j < jsonCount(json, children); j++) {
+            int child = jsonInt(json, jsonArrayGet(json, children, j), -1);
+            valid = child >= 0 && child < file->NodeCount &&
+                    !hasParent[child];
+            if (valid)
+                hasParent[child] = true;
+        }
+    }
+    free(hasParent);
+    return valid;
+}
+
+const char *gltfLoadMeshes(struct GltfFile *file, Model *model) {
+    Json *json = file->Json;
+    int materialCount = jsonCount(json, jsonObjectGet(json, 0, "materials"));
+    bool needsDefaultMaterial = false;
+
+    model->MeshCount = 0;
+    file->MeshFirstPrimitive = malloc(file->MeshCount * sizeof(int));
+    for (int i = 0; i < file->MeshCount; i++) {
+        int primitives = jsonObjectGet(json, file->MeshTokens[i], "primitives");
+        file->MeshFirstPrimitive[i] = model->MeshCount;
+        model->MeshCount += jsonCount(json, primitives);
+    }
+    // find out which buffer views hold vertex and index data of primitives
+    // that aren't decoded; only those get uploaded, animation keys and images
+    // stay on the cpu
+    file->MeshDecoded = malloc(model->MeshCount * sizeof(bool));
+    bool *viewUsed = calloc(file->BufferViewCount, sizeof(bool));
+    for (int i = 0; i < file->MeshCount; i++) {
+        int primitives = jsonObjectGet(json, file->MeshTokens[i], "primitives");
+        for (int j = 0; j < jsonCount(json, primitives); j++) {
+            int primitive = jsonArrayGet(json, primitives, j);
+            if (!gltfCheckIndices(file, primitive)) {
+                free(viewUsed);
+                return "index out of range";
+            }
+            if (jsonObjectGet(json, primitive, "material") == -1)
+                needsDefaultMaterial = true;
+            bool decoded = gltfNeedsVertices(file, primitive);
+            file->MeshDecoded[file->MeshFirstPrimitive[i] + j] = decoded;
+            if (decoded)
+                continue;
+            int attributes = jsonObjectGet(json, primitive, "attributes");
+            for (int k = 0; k < 4; k++) {
+                int accessor = jsonInt(
+                    json, jsonObjectGet(json, attributes, GltfSemantics[k]),
+                    -1);
+                if (accessor != -1)
+                    viewUsed[file->Accessors[accessor].BufferView] = true;
+            }
+            int indices =
+                jsonInt(json, jsonObjectGet(json, primitive, "indices"), -1);
+            viewUsed[file->Accessors[indices].BufferView] = true;
+        }
+    }
+    file->UploadSize = 0;
+    for (int i = 0; i < file->BufferViewCount; i++) {
+        if (!viewUsed[i])
+            continue;
+        file->BufferViews[i].UploadOffset = file->UploadSize;
+        file->UploadSize += (file->BufferViews[i].Length + 15) & ~(size_t)15;
+    }
+    free(viewUsed);
+
+    model->Meshes =
+        arenaAlloc(model->Arena, model->MeshCount * sizeof(struct Mesh *));
+    for (int i = 0; i < file->MeshCount; i++) {
+        int primitives = jsonObjectGet(json, file->MeshTokens[i], "primitives");
+        char *name = jsonStringCopy(
+            json, jsonObjectGet(json, file->MeshTokens[i], "name"));
+        if (name == NULL) {
+            name = malloc(32);
+            snprintf(name, 32, "mesh_%d", i);
+        }
+        for (int j = 0; j < jsonCount(json, primitives); j++) {
+            int primitive = jsonArrayGet(json, primitives, j);
+            int meshIndex = file->MeshFirstPrimitive[i] + j;
+            struct Mesh *mesh =
+                file->MeshDecoded[meshIndex]
+                    ? gltfLoadPrimitive(file, model->Arena, primitive, name)
+                    : gltfLoadUploadedPrimitive(file, model->Arena, primitive);
+            int material = jsonObjectGet(json, primitive, "material");
+            mesh->MaterialIndex = jsonInt(json, material, materialCount);
+            model->Meshes[meshIndex] = mesh;
+        }
+        free(name);
+    }
+
+    // like assimp, primitives without a material get one added at the end
+    model->MaterialCount = materialCount + needsDefaultMaterial;
+    return NULL;
+}
+// a mesh that draws from the buffer views in `Model::SharedBuffer`
+struct Mesh *gltfLoadUploadedPrimitive(struct GltfFile *file,
+                                       struct Arena *arena, int primitive) {
+    Json *json = file->Json;
+    int attributes = jsonObjectGet(json, primitive, "attributes");
+    int position =
+        jsonInt(json, jsonObjectGet(json, attributes, GltfSemantics[0]), -1);
+    struct GltfAccessor *indices = &file->Accessors[jsonInt(
+        json, jsonObjectGet(json, primitive, "indices"), -1)];
+
+    struct Mesh *mesh = meshLoad(arena, NULL, NULL,
+                                 file->Accessors[position].Count,
+                                 indices->Count);
+    // positions are required to have their bounds
+    meshSetBounds(mesh, file->Accessors[position].Min,
+                  file->Accessors[position].Max);
+    mesh->IndexType = indices->ComponentType;
+    mesh->IndexOffset =
+        file->BufferViews[indices->BufferView].UploadOffset + indices->Offset;
+    // the buffer is owned by the model, the vertex array is made by
+    // `gltfUploadVertexArrays`
+    mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    return mesh;
+}
+// the same vertices `processMesh` makes out of what assimp imports.
+// assimp's own flip of the texcoords is undone by `aiProcess_FlipUVs`, so
+// they're used as they are. texcoords and colors the primitive leaves out are
+// one
+struct Mesh *gltfLoadPrimitive(struct GltfFile *file, struct Arena *arena,
+                               int primitive, const char *meshName) {
+    Json *json = file->Json;
+    int attributes = jsonObjectGet(json, primitive, "attributes");
+    int accessors[4];
+    for (int i = 0; i < 4; i++) {
+        accessors[i] = jsonInt(
+            json, jsonObjectGet(json, attributes, GltfSemantics[i]), -1);
+    }
+    int indexAccessor =
+        jsonInt(json, jsonObjectGet(json, primitive, "indices"), -1);
+    int vertexCount = file->Accessors[accessors[0]].Count;
+    int indexCount = file->Accessors[indexAccessor].Count;
+
+    struct Vertex *vertices =
+        arenaAlloc(arena, vertexCount * sizeof(struct Vertex));
+    uint32_t *indices = arenaAlloc(arena, indexCount * sizeof(uint32_t));
+    float value[4];
+    for (int i = 0; i < vertexCount; i++) {
+        struct Vertex vertex = {0};
+        gltfReadFloats(file, accessors[0], i, value);
+        vertex.Position = (vec3s){{value[0], value[1], value[2]}};
+        gltfReadFloats(file, accessors[1], i, value);
+        vertex.Normal = (vec3s){{value[0], value[1], value[2]}};
+        vertex.TexCoords = GLMS_VEC2_ONE;
+        if (accessors[2] != -1) {
+            gltfReadFloats(file, accessors[2], i, value);
+            vertex.TexCoords = (vec2s){{value[0], value[1]}};
+        }
+        vertex.Color = GLMS_VEC3_ONE;
+        if (accessors[3] != -1) {
+            gltfReadFloats(file, accessors[3], i, value);
+            vertex.Color = (vec3s){{value[0], value[1], value[2]}};
+        }
+        vertices[i] = vertex;
+    }
+    // `gltfCheckIndices` made sure they're all vertices
+    for (int i = 0; i < indexCount; i++) {
+        indices[i] = gltfReadIndex(file, indexAccessor, i);
+    }
+
+    // morph targets aren't loaded here, so nothing depends on the vertex
+    // order
+    if (MeshOptimizeEnabled) {
+        struct MeshOptimizeStats stats;
+        // the arena space left over past `vertexCount` is not reused
+        vertexCount =
+            meshOptimize(vertices, vertexCount, indices, indexCount, &stats);
+        meshOptimizePrintStats(meshName, &stats);
+    }
+
+    struct Mesh *mesh =
+        meshLoad(arena, vertices, indices, vertexCount, indexCount);
+    if (MeshletsEnabled)
+        meshletBuild(arena, mesh);
+    return mesh;
+}
+// whether something needs the vertices of `primitive` on the CPU, the rest
+// are uploaded as they are in the file
+bool gltfNeedsVertices(struct GltfFile *file, int primitive) {
+    if (MeshOptimizeEnabled || ModelCacheEnabled || MeshPackingEnabled)
+        return true;
+    // `meshletBuild` leaves small meshes alone
+    Json *json = file->Json;
+    int indices = jsonInt(json, jsonObjectGet(json, primitive, "indices"), -1);
+    return MeshletsEnabled &&
+           file->Accessors[indices].Count / 3 >= MESHLET_MIN_MESH_TRIANGLES;
+}
+// the GPU reads the indices as they are, so every one has to be a vertex
+bool gltfCheckIndices(struct GltfFile *file, int primitive) {
+    Json *json = file->Json;
+    int attributes = jsonObjectGet(json, primitive, "attributes");
+    int position =
+        jsonInt(json, jsonObjectGet(json, attributes, GltfSemantics[0]), -1);
+    int indices = jsonInt(json, jsonObjectGet(json, primitive, "indices"), -1);
+    uint32_t vertexCount = file->Accessors[position].Count;
+    for (int i = 0; i < file->Accessors[indices].Count; i++) {
+        if (gltfReadIndex(file, indices, i) >= vertexCount)
+            return false;
+    }
+    return true;
+}
+void gltfQueueUploads(struct GltfFile *file, Model *model) {
+    // one upload per buffer view so big files are spread over several frames
+    file->Model = model;
+    uploadQueuePush(gltfUploadBuffer, file, 0);
+    for (int i = 0; i < file->BufferViewCount; i++) {
+        struct GltfBufferView *view = &file->BufferViews[i];
+        view->File = file;
+        if (view->UploadOffset != -1)
+            uploadQueuePush(gltfUploadBufferView, view, view->Length);
+    }
+    uploadQueuePush(gltfUploadVertexArrays, file, 0);
+}
+void gltfUploadBuffer(void *_file) {
+    struct GltfFile *file = (struct GltfFile *)_file;
+    glGenBuffers(1, &file->Model->SharedBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, file->Model->SharedBuffer);
+    glBufferData(GL_ARRAY_BUFFER, file->UploadSize, NULL, GL_STATIC_DRAW);
+}
+void gltfUploadBufferView(void *_view) {
+    struct GltfBufferView *view = (struct GltfBufferView *)_view;
+    struct GltfFile *file = view->File;
+    glBindBuffer(GL_ARRAY_BUFFER, file->Model->SharedBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, view->UploadOffset, view->Length,
+                    file->Buffers[view->Buffer].Data + view->Offset);
+}
+void gltfUploadVertexArrays(void *_file) {
+    struct GltfFile *file = (struct GltfFile *)_file;
+    Json *json = file->Json;
+    Model *model = file->Model;
+
+    int meshIndex = 0;
+    for (int i = 0; i < file->MeshCount; i++) {
+        int primitives = jsonObjectGet(json, file->MeshTokens[i], "primitives");
+        for (int j = 0; j < jsonCount(json, primitives); j++) {
+            // decoded meshes make their own vertex array in `meshSendData`
+            if (file->MeshDecoded[meshIndex]) {
+                meshIndex++;
+                continue;
+            }
+            int primitive = jsonArrayGet(json, primitives, j);
+            int attributes = jsonObjectGet(json, primitive, "attributes");
+            int accessors[4];
+            for (int k = 0; k < 4; k++) {
+                accessors[k] = jsonInt(
+                    json, jsonObjectGet(json, attributes, GltfSemantics[k]),
+                    -1);
+            }
+
+            struct Mesh *mesh = model->Meshes[meshIndex++];
+            glGenVertexArrays(1, &mesh->VAO);
+            glBindVertexArray(mesh->VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, model->SharedBuffer);
+            for (int k = 0; k < 4; k++)
+                gltfSetAttribute(file, k, accessors[k]);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->SharedBuffer);
+            glBindVertexArray(0);
+        }
+    }
+
+    // everything that reads from the mapped file is done
+    gltfClose(file);
+}
+void gltfSetAttribute(struct GltfFile *file, int location, int accessorIndex) {
+    if (accessorIndex == -1) {
+        // a disabled array reads the current attribute value instead.
+        // texcoords and colors default to one like they do when importing
+        // through assimp
+        glDisableVertexAttribArray(location);
+        glVertexAttrib4f(location, 1.0f, 1.0f, 1.0f, 1.0f);
+        return;
+    }
+    struct GltfAccessor *accessor = &file->Accessors[accessorIndex];
+    struct GltfBufferView *view = &file->BufferViews[accessor->BufferView];
+    glVertexAttribPointer(location, accessor->ComponentCount,
+                          accessor->ComponentType, accessor->Normalized,
+                          view->Stride,
+                          (void *)(view->UploadOffset + accessor->Offset));
+    glEnableVertexAttribArray(location);
+}
+
+void gltfLoadTextures(struct GltfFile *file, Model *model) {
+    Json *json = file->Json;
+    int images = jsonObjectGet(json, 0, "images");
+    int *imageTokens = gltfArrayTokens(json, images);
+
+    // only embedded images count, same as `aiScene::mTextures`
+    model->TextureCount = 0;
+    model->Textures = arenaAlloc(model->Arena,
+                                 jsonCount(json, images) * sizeof(Texture *));
+    file->TextureNames = arenaAlloc(
+        model->Arena, jsonCount(json, images) * sizeof(const char *));
+    for (int i = 0; i < jsonCount(json, images); i++) {
+        int uri = jsonObjectGet(json, imageTokens[i], "uri");
+        int bufferView = jsonObjectGet(json, imageTokens[i], "bufferView");
+        bool embedded =
+            bufferView != -1 ||
+            (uri != -1 &&
+             !strncmp(json->Source + json->Tokens[uri].Start, "data:", 5));
+        if (!embedded)
+            continue;
+        char *name =
+            jsonStringCopy(json, jsonObjectGet(json, imageTokens[i], "name"));
+        const char *textureName =
+            arenaCopyString(model->Arena, name != NULL ? name : "");
+        free(name);
+        file->TextureNames[model->TextureCount] = textureName;
+        model->Textures[model->TextureCount++] = textureLoadAsync(textureName);
+    }
+    free(imageTokens);
+}
+
+struct Node *gltfLoadScene(struct GltfFile *file) {
+    Json *json = file->Json;
+    // the node indices were checked by `gltfCheckNodes`
+    int scene = jsonArrayGet(json, jsonObjectGet(json, 0, "scenes"),
+                             jsonInt(json, jsonObjectGet(json, 0, "scene"), 0));
+    int rootNodes = jsonObjectGet(json, scene, "nodes");
+    int rootNodeCount = jsonCount(json, rootNodes);
+
+    // a single root node is used as it is, otherwise they're all put under a
+    // new one (what assimp does too)
+    struct Node *rootNode;
+    if (rootNodeCount == 1) {
+        rootNode = gltfLoadNode(
+            file, jsonInt(json, jsonArrayGet(json, rootNodes, 0), 0), NULL);
+    } else {
+        rootNode = nodeCreate(file->Model->Arena, NULL, rootNodeCount);
+        rootNode->MeshCount = 0;
+        rootNode->Meshes = NULL;
+        rootNode->Name = arenaCopyString(file->Model->Arena, "ROOT");
+        for (int i = 0; i < rootNodeCount; i++) {
+            rootNode->Children[i] = gltfLoadNode(
+                file, jsonInt(json, jsonArrayGet(json, rootNodes, i), 0),
+                rootNode);
+        }
+    }
+    printf("Root node is \'%s\'\n", rootNode->Name);
+    return rootNode;
+}
+// names of the nodes the animation channels target. the animations point
+// at the nodes themselves, these only keep them from being flattened
+const char **gltfAnimatedNodeNames(struct GltfFile *file, int *count) {
+    Json *json = file->Json;
+    int animations = jsonObjectGet(json, 0, "animations");
+    int animationCount = jsonCount(json, animations);
+    int capacity = 0;
+    for (int i = 0; i < animationCount; i++) {
+        int animation = jsonArrayGet(json, animations, i);
+        capacity += jsonCount(json, jsonObjectGet(json, animation, "channels"));
+    }
+    const char **names = malloc(capacity * sizeof(char *));
+    *count = 0;
+    for (int i = 0; i < animationCount; i++) {
+        int animation = jsonArrayGet(json, animations, i);
+        int channels = jsonObjectGet(json, animation, "channels");
+        int channelCount = jsonCount(json, channels);
+        for (int j = 0; j < channelCount; j++) {
+            int target =
+                jsonObjectGet(json, jsonArrayGet(json, channels, j), "target");
+            int node = jsonInt(json, jsonObjectGet(json, target, "node"), -1);
+            // nodes outside the scene were never loaded
+            if (node >= 0 && node < file->NodeCount &&
+                file->Nodes[node].Node != NULL)
+                names[(*count)++] = file->Nodes[node].Node->Name;
+        }
+    }
+    return names;
+}
+struct Node *gltfLoadNode(struct GltfFile *file, int nodeIndex,
+                          struct Node *parent) {
+    Json *json = file->Json;
+    struct Arena *arena = file->Model->Arena;
+    struct GltfNode *gltfNode = &file->Nodes[nodeIndex];
+    int token = gltfNode->Token;
+    int children = jsonObjectGet(json, token, "children");
+
+    struct Node *node = nodeCreate(arena, parent, jsonCount(json, children));
+    gltfNode->Node = node;
+
+    gltfNode->Translation = GLMS_VEC3_ZERO;
+    gltfNode->Rotation = GLMS_QUAT_IDENTITY;
+    gltfNode->Scale = GLMS_VEC3_ONE;
+    int matrix = jsonObjectGet(json, token, "matrix");
+    if (matrix != -1) {
+        // column major, same as cglm
+        mat4s parentFromLocal;
+        for (int i = 0; i < 16; i++) {
+            parentFromLocal.raw[i / 4][i % 4] =
+                jsonNumber(json, jsonArrayGet(json, matrix, i), 0);
+        }
+        node->Local = transformDecompose(parentFromLocal);
+    } else {
+        int translation = jsonObjectGet(json, token, "translation");
+        int rotation = jsonObjectGet(json, token, "rotation");
+        int scale = jsonObjectGet(json, token, "scale");
+        for (int i = 0; i < 3; i++) {
+            gltfNode->Translation.raw[i] =
+                jsonNumber(json, jsonArrayGet(json, translation, i), 0);
+            gltfNode->Scale.raw[i] =
+                jsonNumber(json, jsonArrayGet(json, scale, i), 1);
+        }
+        for (int i = 0; i < 4; i++) {
+            gltfNode->Rotation.raw[i] = jsonNumber(
+                json, jsonArrayGet(json, rotation, i), i == 3 ? 1 : 0);
+        }
+        node->Local = (TransformLocal){
+            .Rotation = gltfNode->Rotation,
+            .Position = gltfNode->Translation,
+            .Scaling = gltfNode->Scale,
+        };
+    }
+
+    int mesh = jsonInt(json, jsonObjectGet(json, token, "mesh"), -1);
+    if (mesh >= 0 && mesh < file->MeshCount) {
+        node->MeshCount = jsonCount(
+            json, jsonObjectGet(json, file->MeshTokens[mesh], "primitives"));
+        node->Meshes = arenaAlloc(arena, node->MeshCount * sizeof(int));
+        for (int i = 0; i < node->MeshCount; i++)
+            node->Meshes[i] = file->MeshFirstPrimitive[mesh] + i;
+    } else {
+        node->MeshCount = 0;
+        node->Meshes = NULL;
+    }
+
+    char *name = jsonStringCopy(json, jsonObjectGet(json, token, "name"));
+    node->Name = arenaCopyString(arena, name);
+    free(name);
+    if (node->Name == NULL) {
+        node->Name = arenaAlloc(arena, 32);
+        snprintf(node->Name, 32, "node_%d", nodeIndex);
+    }
+
+    for (int i = 0; i < node->ChildCount; i++) {
+        int child = jsonInt(json, jsonArrayGet(json, children, i), -1);
+        node->Children[i] = gltfLoadNode(file, child, node);
+    }
+    return node;
+}
+
+Animation *gltfLoadAnimation(struct GltfFile *file, struct Arena *arena,
+                             int animationToken, int animationIndex) {
+    Json *json = file->Json;
+    int channels = jsonObjectGet(json, animationToken, "channels");
+    int samplers = jsonObjectGet(json, animationToken, "samplers");
+    int *channelTokens = gltfArrayTokens(json, channels);
+    int *samplerTokens = gltfArrayTokens(json, samplers);
+    int channelCount = jsonCount(json, channels);
+    int samplerCount = jsonCount(json, samplers);
+
+    Animation *animation = arenaAlloc(arena, sizeof(Animation));
+    animation->Bake = NULL;
+    // morph targets go through assimp
+    animation->MorphChannelCount = 0;
+    animation->MorphChannels = NULL;
+    animation->Meshes = NULL;
+    char *name =
+        jsonStringCopy(json, jsonObjectGet(json, animationToken, "name"));
+    animation->Name = arenaCopyString(arena, name);
+    free(name);
+    if (animation->Name == NULL) {
+        animation->Name = arenaAlloc(arena, 32);
+        snprintf(animation->Name, 32, "animation_%d", animationIndex);
+    }
+    animation->TicksPerSec = GLTF_TICKS_PER_SEC;
+    animation->Time = 0;
+
+    // channels are per node and path, but an `AnimationNode` holds all three
+    // paths of one node. channels of nodes outside the loaded scene have
+    // nothing to animate and are dropped
+    int *nodeToAnimNode = malloc(file->NodeCount * sizeof(int));
+    for (int i = 0; i < file->NodeCount; i++)
+        nodeToAnimNode[i] = -1;
+    animation->NodeCount = 0;
+    for (int i = 0; i < channelCount; i++) {
+        int target = jsonObjectGet(json, channelTokens[i], "target");
+        int node = jsonInt(json, jsonObjectGet(json, target, "node"), -1);
+        if (node >= 0 && node < file->NodeCount &&
+            file->Nodes[node].Node != NULL && nodeToAnimNode[node] == -1)
+            nodeToAnimNode[node] = animation->NodeCount++;
+    }
+    animation->Nodes =
+        arenaCalloc(arena, animation->NodeCount * sizeof(AnimationNode));
+
+    float maxTime = 0;
+    for (int i = 0; i < channelCount; i++) {
+        int target = jsonObjectGet(json, channelTokens[i], "target");
+        int node = jsonInt(json, jsonObjectGet(json, target, "node"), -1);
+        int sampler =
+            jsonInt(json, jsonObjectGet(json, channelTokens[i], "sampler"), -1);
+        if (node < 0 || node >= file->NodeCount ||
+            nodeToAnimNode[node] == -1 || sampler < 0 ||
+            sampler >= samplerCount)
+            continue;
+        AnimationNode *animNode = &animation->Nodes[nodeToAnimNode[node]];
+        animNode->Node = file->Nodes[node].Node;
+
+        int input = jsonInt(
+            json, jsonObjectGet(json, samplerTokens[sampler], "input"), -1);
+        int output = jsonInt(
+            json, jsonObjectGet(json, samplerTokens[sampler], "output"), -1);
+        if (input < 0 || input >= file->AccessorCount || output < 0 ||
+            output >= file->AccessorCount)
+            continue;
+        int interpolation =
+            jsonObjectGet(json, samplerTokens[sampler], "interpolation");
+        // cubic spline keys are stored as {in tangent, value, out tangent}
+        int outputStride = 1, outputOffset = 0;
+        enum AnimationInterpolation trackInterpolation;
+        if (jsonStringEquals(json, interpolation, "STEP"))
+            trackInterpolation = ANIMATIONINTERP_STEP;
+        else if (jsonStringEquals(json, interpolation, "CUBICSPLINE")) {
+            trackInterpolation = ANIMATIONINTERP_SMOOTHSTEP;
+            outputStride = 3;
+            outputOffset = 1;
+        } else
+            trackInterpolation = ANIMATIONINTERP_LINEAR;
+
+        int path = jsonObjectGet(json, target, "path");
+        // one float time per key, and a vector as long as the path's value
+        struct GltfAccessor *inputAccessor = &file->Accessors[input];
+        struct GltfAccessor *outputAccessor = &file->Accessors[output];
+        int valueComponents = jsonStringEquals(json, path, "rotation") ? 4 : 3;
+        if (inputAccessor->ComponentType != GL_FLOAT ||
+            inputAccessor->ComponentCount != 1 || inputAccessor->Matrix ||
+            outputAccessor->ComponentCount != valueComponents ||
+            outputAccessor->Matrix)
+            continue;
+        int keyCount = inputAccessor->Count;
+        if (outputAccessor->Count < keyCount * outputStride)
+            continue;
+        float value[4];
+        if (jsonStringEquals(json, path, "translation") ||
+            jsonStringEquals(json, path, "scale")) {
+            bool isTranslation = jsonStringEquals(json, path, "translation");
+            float *times = arenaAlloc(arena, keyCount * sizeof(float));
+            vec3s *values = arenaAlloc(arena, keyCount * sizeof(vec3s));
+            for (int j = 0; j < keyCount; j++) {
+                gltfReadFloats(file, input, j, value);
+                times[j] = value[0] * GLTF_TICKS_PER_SEC;
+                maxTime = fmaxf(maxTime, value[0]);
+                gltfReadFloats(file, output, j * outputStride + outputOffset,
+                               value);
+                values[j] = (vec3s){{value[0], value[1], value[2]}};
+            }
+            // a second channel for the same path replaces the first, the
+            // old keys stay in the arena
+            if (isTranslation) {
+                animNode->PositionTimes = times;
+                animNode->PositionValues = values;
+                animNode->PositionKeyCount = keyCount;
+                animNode->PositionInterpolation = trackInterpolation;
+            } else {
+                animNode->ScalingTimes = times;
+                animNode->ScalingValues = values;
+                animNode->ScalingKeyCount = keyCount;
+                animNode->ScalingInterpolation = trackInterpolation;
+            }
+        } else if (jsonStringEquals(json, path, "rotation")) {
+            float *times = arenaAlloc(arena, keyCount * sizeof(float));
+            versors *values = arenaAlloc(arena, keyCount * sizeof(versors));
+            for (int j = 0; j < keyCount; j++) {
+                gltfReadFloats(file, input, j, value);
+                times[j] = value[0] * GLTF_TICKS_PER_SEC;
+                maxTime = fmaxf(maxTime, value[0]);
+                gltfReadFloats(file, output, j * outputStride + outputOffset,
+                               value);
+                values[j] = (versors){{value[0], value[1], value[2], value[3]}};
+            }
+            animNode->RotationTimes = times;
+            animNode->RotationValues = values;
+            animNode->RotationKeyCount = keyCount;
+            animNode->RotationInterpolation = trackInterpolation;
+        }
+    }
+
+    // paths without a channel keep the node's own value, as a single key
+    for (int i = 0; i < file->NodeCount; i++) {
+        if (nodeToAnimNode[i] == -1)
+            continue;
+        AnimationNode *animNode = &animation->Nodes[nodeToAnimNode[i]];
+        struct GltfNode *gltfNode = &file->Nodes[i];
+        animNode->Node = gltfNode->Node;
+        if (animNode->PositionKeyCount == 0) {
+            animNode->PositionKeyCount = 1;
+            animNode->PositionTimes = arenaCalloc(arena, sizeof(float));
+            animNode->PositionValues = arenaAlloc(arena, sizeof(vec3s));
+            animNode->PositionValues[0] = gltfNode->Translation;
+        }
+        if (animNode->RotationKeyCount == 0) {
+            animNode->RotationKeyCount = 1;
+            animNode->RotationTimes = arenaCalloc(arena, sizeof(float));
+            animNode->RotationValues = arenaAlloc(arena, sizeof(versors));
+            animNode->RotationValues[0] = gltfNode->Rotation;
+        }
+        if (animNode->ScalingKeyCount == 0) {
+            animNode->ScalingKeyCount = 1;
+            animNode->ScalingTimes = arenaCalloc(arena, sizeof(float));
+            animNode->ScalingValues = arenaAlloc(arena, sizeof(vec3s));
+            animNode->ScalingValues[0] = gltfNode->Scale;
+        }
+    }
+
+    // at least one tick so stepping can't loop forever
+    animation->Duration = lroundf(maxTime * GLTF_TICKS_PER_SEC);
+    if (animation->Duration < 1)
+        animation->Duration = 1;
+    printf("found animation \"%s\"\n    duration: %d, ticks per sec: %d\n",
+           animation->Name, animation->Duration, animation->TicksPerSec);
+
+    free(nodeToAnimNode);
+    free(channelTokens);
+    free(samplerTokens);
+    return animation;
+}
+
+void gltfClose(struct GltfFile *file) {
+    for (int i = 0; i < file->BufferCount; i++) {
+        free(file->Buffers[i].Decoded);
+        if (file->Buffers[i].Mapping != NULL)
+            munmap(file->Buffers[i].Mapping, file->Buffers[i].Size);
+    }
+    free(file->Buffers);
+    free(file->BufferViews);
+    free(file->Accessors);
+    free(file->Nodes);
+    free(file->MeshTokens);
+    free(file->MeshFirstPrimitive);
+    free(file->MeshDecoded);
+    if (file->Json != NULL)
+        jsonFree(file->Json);
+    if (file->Mapping != NULL)
+        munmap(file->Mapping, file->MappingSize);
+    free(file);
+}
+
+int *gltfArrayTokens(Json *json, int array) {
+    int count = jsonCount(json, array);
+    int *tokens = malloc(count * sizeof(int));
+    int token = array + 1;
+    for (int i = 0; i < count; i++) {
+        tokens[i] = token;
+        token = json->Tokens[token].Next;
+    }
+    return tokens;
+}
+int gltfComponentSize(uint32_t componentType) {
+    switch (componentType) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+// writes at most the first 4 components of `element` to `out`
+void gltfReadFloats(struct GltfFile *file, int accessorIndex, int element,
+                    float *out) {
+    struct GltfAccessor *accessor = &file->Accessors[accessorIndex];
+    if (accessor->BufferView == -1) {
+        for (int i = 0; i < accessor->ComponentCount && i < 4; i++)
+            out[i] = 0;
+        return;
+    }
+    struct GltfBufferView *view = &file->BufferViews[accessor->BufferView];
+    int componentSize = gltfComponentSize(accessor->ComponentType);
+    int stride = view->Stride ? view->Stride
+                              : componentSize * accessor->ComponentCount;
+    const uint8_t *data = file->Buffers[view->Buffer].Data + view->Offset +
+                          accessor->Offset + (size_t)element * stride;
+    for (int i = 0; i < accessor->ComponentCount && i < 4; i++) {
+        const uint8_t *component = data + i * componentSize;
+        int8_t byteValue;
+        int16_t shortValue;
+        uint16_t ushortValue;
+        uint32_t uintValue;
+        switch (accessor->ComponentType) {
+        case GL_BYTE:
+            memcpy(&byteValue, component, 1);
+            out[i] = fmaxf(byteValue / 127.0f, -1.0f);
+            break;
+        case GL_UNSIGNED_BYTE:
+            out[i] = *component / 255.0f;
+            break;
+        case GL_SHORT:
+            memcpy(&shortValue, component, 2);
+            out[i] = fmaxf(shortValue / 32767.0f, -1.0f);
+            break;
+        case GL_UNSIGNED_SHORT:
+            memcpy(&ushortValue, component, 2);
+            out[i] = ushortValue / 65535.0f;
+            break;
+        case GL_UNSIGNED_INT:
+            memcpy(&uintValue, component, 4);
+            out[i] = uintValue;
+            break;
+        default:
+            memcpy(&out[i], component, 4);
+            break;
+        }
+    }
+}
+uint32_t gltfReadIndex(struct GltfFile *file, int accessorIndex, int element) {
+    struct GltfAccessor *accessor = &file->Accessors[accessorIndex];
+    struct GltfBufferView *view = &file->BufferViews[accessor->BufferView];
+    int componentSize = gltfComponentSize(accessor->ComponentType);
+    int stride = view->Stride ? view->Stride : componentSize;
+    const uint8_t *data = file->Buffers[view->Buffer].Data + view->Offset +
+                          accessor->Offset + (size_t)element * stride;
+    uint16_t shortValue;
+    uint32_t intValue;
+    switch (accessor->ComponentType) {
+    case GL_UNSIGNED_BYTE:
+        return *data;
+    case GL_UNSIGNED_SHORT:
+        memcpy(&shortValue, data, 2);
+        return shortValue;
+    default:
+        memcpy(&intValue, data, 4);
+        return intValue;
+    }
+}
+bool gltfAccessorInBounds(struct GltfFile *file, int accessorIndex) {
+    struct GltfAccessor *accessor = &file->Accessors[accessorIndex];
+    if (accessor->BufferView == -1 || accessor->Count == 0)
+        return true;
+    if (accessor->BufferView < -1 ||
+        accessor->BufferView >= file->BufferViewCount)
+        return false;
+    struct GltfBufferView *view = &file->BufferViews[accessor->BufferView];
+    size_t elementSize = (size_t)gltfComponentSize(accessor->ComponentType) *
+                         accessor->ComponentCount;
+    size_t stride = view->Stride ? view->Stride : elementSize;
+    return accessor->Offset + stride * (accessor->Count - 1) + elementSize <=
+           view->Length;
+}
+uint8_t *gltfDecodeBase64(const char *source, size_t length, size_t *size) {
+    uint8_t *data = malloc(length / 4 * 3 + 3);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    *size = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = source[i];
+        int value;
+        if (c >= 'A' && c <= 'Z')
+            value = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            value = c - '0' + 52;
+        else if (c == '+')
+            value = 62;
+        else if (c == '/')
+            value = 63;
+        else
+            break; // padding
+        bits = (bits << 6) | value;
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            data[(*size)++] = (bits >> bitCount) & 0xFF;
+        }
+    }
+    return data;
+}
@@ -0,0 +1,232 @@
+#include "json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 64
+
+int jsonPushToken(Json *json, int *capacity, enum JsonType type, int start);
+
+Json *jsonParse(const char *source, size_t length) {
+    Json *json = malloc(sizeof(Json));
+    json->Source = source;
+    json->TokenCount = 0;
+    int capacity = 256;
+    json->Tokens = malloc(capacity * sizeof(struct JsonToken));
+
+    // containers that are still open, and whether each one expects a key next
+    int stack[JSON_MAX_DEPTH];
+    bool expectingKey[JSON_MAX_DEPTH];
+    int depth = 0;
+
+    size_t i = 0;
+    while (i < length) {
+        char c = source[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' ||
+            c == ':') {
+            i++;
+            continue;
+        }
+        if (c == '}' || c == ']') {
+            if (depth == 0)
+                goto error;
+            struct JsonToken *container = &json->Tokens[stack[--depth]];
+            enum JsonType type = c == '}' ? JSONTYPE_OBJECT : JSONTYPE_ARRAY;
+            if (container->Type != type)
+                goto error;
+            container->Length = i + 1 - container->Start;
+            container->Next = json->TokenCount;
+            i++;
+            if (depth == 0)
+                break;
+            continue;
+        }
+
+        // everything else is a new value
+        if (depth > 0) {
+            struct JsonToken *parent = &json->Tokens[stack[depth - 1]];
+            if (parent->Type == JSONTYPE_ARRAY)
+                parent->ChildCount++;
+            else if (expectingKey[depth - 1]) {
+                if (c != '"')
+                    goto error;
+                parent->ChildCount++;
+                expectingKey[depth - 1] = false;
+            } else
+                expectingKey[depth - 1] = true;
+        } else if (json->TokenCount > 0)
+            goto error; // more than one value at the top level
+
+        int token;
+        switch (c) {
+        case '{':
+        case '[':
+            if (depth >= JSON_MAX_DEPTH)
+                goto error;
+            token = jsonPushToken(json, &capacity,
+                                  c == '{' ? JSONTYPE_OBJECT : JSONTYPE_ARRAY,
+                                  i);
+            expectingKey[depth] = c == '{';
+            stack[depth++] = token;
+            i++;
+            break;
+        case '"':
+            token = jsonPushToken(json, &capacity, JSONTYPE_STRING, i + 1);
+            for (i++; i < length && source[i] != '"'; i++) {
+                if (source[i] == '\\')
+                    i++;
+            }
+            if (i >= length)
+                goto error;
+            json->Tokens[token].Length = i - json->Tokens[token].Start;
+            i++;
+            break;
+        default:
+            if (c == 't' || c == 'f')
+                token = jsonPushToken(json, &capacity, JSONTYPE_BOOL, i);
+            else if (c == 'n')
+                token = jsonPushToken(json, &capacity, JSONTYPE_NULL, i);
+            else if (c == '-' || (c >= '0' && c <= '9'))
+                token = jsonPushToken(json, &capacity, JSONTYPE_NUMBER, i);
+            else
+                goto error;
+            while (i < length && source[i] != ',' && source[i] != '}' &&
+                   source[i] != ']' && source[i] != ' ' && source[i] != '\n' &&
+                   source[i] != '\r' && source[i] != '\t')
+                i++;
+            json->Tokens[token].Length = i - json->Tokens[token].Start;
+            break;
+        }
+        if (depth == 0)
+            break;
+    }
+    if (depth != 0 || json->TokenCount == 0)
+        goto error;
+
+    return json;
+
+error:
+    fprintf(stderr, "json error: invalid json near byte %zu\n", i);
+    jsonFree(json);
+    return NULL;
+}
+int jsonObjectGet(Json *json, int object, const char *key) {
+    if (object < 0 || json->Tokens[object].Type != JSONTYPE_OBJECT)
+        return -1;
+    int token = object + 1;
+    for (int i = 0; i < json->Tokens[object].ChildCount; i++) {
+        if (jsonStringEquals(json, token, key))
+            return token + 1;
+        token = json->Tokens[token + 1].Next;
+    }
+    return -1;
+}
+int jsonArrayGet(Json *json, int array, int index) {
+    if (array < 0 || json->Tokens[array].Type != JSONTYPE_ARRAY ||
+        index < 0 || index >= json->Tokens[array].ChildCount)
+        return -1;
+    int token = array + 1;
+    for (int i = 0; i < index; i++)
+        token = json->Tokens[token].Next;
+    return token;
+}
+int jsonCount(Json *json, int token) {
+    if (token < 0)
+        return 0;
+    return json->Tokens[token].ChildCount;
+}
+double jsonNumber(Json *json, int token, double fallback) {
+    if (token < 0 || json->Tokens[token].Type != JSONTYPE_NUMBER)
+        return fallback;
+    // numbers are always followed by a delimiter, so strtod stops in time
+    return strtod(json->Source + json->Tokens[token].Start, NULL);
+}
+int jsonInt(Json *json, int token, int fallback) {
+    return jsonNumber(json, token, fallback);
+}
+bool jsonBool(Json *json, int token, bool fallback) {
+    if (token < 0 || json->Tokens[token].Type != JSONTYPE_BOOL)
+        return fallback;
+    return json->Source[json->Tokens[token].Start] == 't';
+}
+bool jsonStringEquals(Json *json, int token, const char *string) {
+    if (token < 0 || json->Tokens[token].Type != JSONTYPE_STRING)
+        return false;
+    struct JsonToken *jsonToken = &json->Tokens[token];
+    return strlen(string) == jsonToken->Length &&
+           !strncmp(json->Source + jsonToken->Start, string,
+                    jsonToken->Length);
+}
+char *jsonStringCopy(Json *json, int token) {
+    if (token < 0 || json->Tokens[token].Type != JSONTYPE_STRING)
+        return NULL;
+    struct JsonToken *jsonToken = &json->Tokens[token];
+    const char *source = json->Source + jsonToken->Start;
+    char *string = malloc(jsonToken->Length + 1);
+    int length = 0;
+    for (int i = 0; i < jsonToken->Length; i++) {
+        if (source[i] != '\\') {
+            string[length++] = source[i];
+            continue;
+        }
+        switch (source[++i]) {
+        case 'n':
+            string[length++] = '\n';
+            break;
+        case 't':
+            string[length++] = '\t';
+            break;
+        case 'r':
+            string[length++] = '\r';
+            break;
+        case 'b':
+            string[length++] = '\b';
+            break;
+        case 'f':
+            string[length++] = '\f';
+            break;
+        case 'u':
+            // only ascii is decoded, which is all names in our files use
+            if (i + 4 < jsonToken->Length) {
+                char hex[5] = {0};
+                memcpy(hex, source + i + 1, 4);
+                long codepoint = strtol(hex, NULL, 16);
+                string[length++] = codepoint < 128 ? codepoint : '?';
+                i += 4;
+            }
+            break;
+        default: // '"', '\\' and '/'
+            string[length++] = source[i];
+            break;
+        }
+    }
+    string[length] = 0;
+    return string;
+}
+void jsonFree(Json *json) {
+    free(json->Tokens);
+    free(json);
+}
+
+int jsonPushToken(Json *json, int *capacity, enum JsonType type, int start) {
+    if (json->TokenCount >= *capacity) {
+        *capacity *= 2;
+        struct JsonToken *temp =
+            realloc(json->Tokens, *capacity * sizeof(struct JsonToken));
+        if (temp == NULL) {
+            fprintf(stderr, "could not resize json token array\n");
+            exit(EXIT_FAILURE);
+        }
+        json->Tokens = temp;
+    }
+    int token = json->TokenCount++;
+    json->Tokens[token] = (struct JsonToken){
+        .Type = type,
+        .Start = start,
+        .Length = 0,
+        .ChildCount = 0,
+        .Next = token + 1,
+    };
+    return token;
+}
@@ -5,11 +5,18 @@
 #include "rendering.h"
 
 #include "animation.h"
+#include "animation_lod.h"
+#include "asset.h"
 #include "error.h"
 #include "material.h"
 #include "model.h"
 #include "model_presets.h"
 #include "shader.h"
+#include "skinning.h"
+#include "thread_pool.h"
+#include "transform.h"
+#include "transform_scene.h"
+#include "upload_queue.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -17,8 +24,17 @@
 
 #define MOVE_SPEED 10.0f
 #define EVENT_COUNT 2
+// how much of a frame can go to uploading models that finished loading
+#define UPLOAD_BUDGET_BYTES (8 << 20)
+#define UPLOAD_BUDGET_MS 2.0
 
 GLFWwindow *window;
+/// NULL until it's done loading
+Model *model;
+/// one per animation of `model`
+AnimationLodState *animationStates;
+/// everything that gets rendered, so their transforms are updated together
+TransformScene *transformScene;
 
 vec2s mousePosition;
 vec2s mouseDelta;
@@ -26,6 +42,7 @@ vec2s mouseSensitivity;
 
 // just to make the main function more easily accessible
 InputEvent *getInputEventArray();
+void onModelLoaded(Model *loadedModel, void *material);
 
 int main(void) {
     window = windowCreate();
@@ -34,6 +51,8 @@ int main(void) {
     inputSetEvents(events, 2);
     inputInit(window);
     errorInit();
+    threadPoolInit(0);
+    textureInitPlaceholder();
 
     Camera camera =
         cameraCreate((vec3s){{0.0f, 1.0f, 1.0f}}, GLMS_QUAT_IDENTITY);
@@ -46,16 +65,19 @@ int main(void) {
     vec3s lightPos = (vec3s){{-2.2f, 1.2f, -0.6f}};
     vec3s lightColor = GLMS_VEC3_ONE;
     light->WorldFromModel = glms_translate(GLMS_MAT4_IDENTITY, lightPos);
+    transformScene = transformSceneCreate();
+    transformSceneAdd(transformScene, &light->Transforms,
+                      &light->WorldFromModel);
 
     uint32_t shader =
         shaderCreate("vertex_shader.glsl", "fragment_shader.glsl");
-    Model *model = modelLoad("home.glb");
-    model->Materials[0] =
+    Material *modelMaterial =
         materialCreate(shader, 2,
                        materialPropertyCreate("light_position", MATTYPE_VEC3,
                                               (void *)&lightPos),
                        materialPropertyCreate("light_color", MATTYPE_VEC3,
                                               (void *)&lightColor));
+    modelLoadAsync("home.glb", onModelLoaded, modelMaterial);
 
     glEnable(GL_CULL_FACE);
 
@@ -70,9 +92,7 @@ int main(void) {
         currentTime = glfwGetTime();
         deltaTime = currentTime - lastTime;
 
-        for (int i = 0; i < model->AnimationCount; i++) {
-            animationStep(model->Animations[i], deltaTime);
-        }
+        uploadQueueDrain(UPLOAD_BUDGET_BYTES, UPLOAD_BUDGET_MS);
 
         inputUpdate();
         if (exitEvent->State > 0)
@@ -104,6 +124,16 @@ int main(void) {
             glms_vec3_scale(positionDelta, MOVE_SPEED * deltaTime));
         cameraCalculateViewMatrix(&camera);
 
+        animationLodBeginFrame();
+        skinningResetCounters();
+        transformResetCounters();
+        if (model != NULL) {
+            for (int i = 0; i < model->AnimationCount; i++) {
+                animationLodUpdate(&animationStates[i], model->WorldFromModel,
+                                   deltaTime);
+            }
+        }
+
         lastTime = currentTime;
 
         lightPos.x = sinf(currentTime * M_PI) * 1.3f + -2.7f;
@@ -114,17 +144,28 @@ int main(void) {
         lightColor.z = (sinf(currentTime * 1.3f / 4) * 0.5 + 0.5) * 0.9f + 0.6f;
 
         light->WorldFromModel = glms_translate(GLMS_MAT4_IDENTITY, lightPos);
-        modelRender(model);
+        transformSceneUpdate(transformScene);
+        if (model != NULL)
+            modelRender(model);
         modelRender(light);
 
         windowDraw(window);
     }
 
-    materialFree(model->Materials[0]);
+    // let a load that is still running finish so it can be freed
+    threadPoolShutdown();
+    uploadQueueFlush();
+
+    materialFree(modelMaterial);
     materialFree(light->Materials[0]);
-    modelFree(model);
+    if (model != NULL)
+        modelFree(model);
+    free(animationStates);
+    transformSceneFree(transformScene);
     modelFree(light);
     shaderFreeCache();
+    textureFreePlaceholder();
+    assetRegistryFree();
 
     windowClose();
 
@@ -132,6 +173,21 @@ int main(void) {
     return 0;
 }
 
+void onModelLoaded(Model *loadedModel, void *material) {
+    loadedModel->Materials[0] = material;
+    vec3s center;
+    float radius;
+    modelBounds(loadedModel, &center, &radius);
+    animationStates =
+        malloc(loadedModel->AnimationCount * sizeof(AnimationLodState));
+    for (int i = 0; i < loadedModel->AnimationCount; i++) {
+        animationStates[i] = animationLodCreate(loadedModel->Animations[i],
+                                                NULL, NULL, center, radius);
+    }
+    transformSceneAdd(transformScene, &loadedModel->Transforms,
+                      &loadedModel->WorldFromModel);
+    model = loadedModel;
+}
 InputEvent *getInputEventArray() {
     InputEvent *events = malloc(EVENT_COUNT * sizeof(InputEvent));
 
@@ -29,6 +29,8 @@ MaterialTextureData *materialTextureDataCreate(Texture *texture, int index) {
 }
 void materialTextureDataFree(MaterialTextureData *data) { free(data); }
 
+void materialDelete(void *_material);
+
 Material *materialCreate(uint32_t shader, int propertyCount, ...) {
     Material *material = malloc(sizeof(Material));
     material->Shader = shader;
@@ -40,6 +42,8 @@ Material *materialCreate(uint32_t shader, int propertyCount, ...) {
         material->Properties[i] = va_arg(properties, MaterialProperty *);
     }
     va_end(properties);
+    material->Handle =
+        assetRegister(ASSETTYPE_MATERIAL, NULL, material, materialDelete);
     return material;
 }
 
@@ -129,7 +133,14 @@ void materialChangeProperty(Material *material, const char *propertyName,
             "\"%s\"\n",
             propertyName);
 }
-void materialFree(Material *material) {
+Material *materialAcquire(Material *material) {
+    assetAcquire(material->Handle);
+    return material;
+}
+void materialFree(Material *material) { assetRelease(material->Handle); }
+// called by the registry once the last reference is gone
+void materialDelete(void *_material) {
+    Material *material = (Material *)_material;
     for (int i = 0; i < material->PropertyCount; i++) {
         free(material->Properties[i]->Name);
         free(material->Properties[i]);
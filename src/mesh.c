@@ -1,71 +1,105 @@
 #include "mesh.h"
 
+#include "meshlet.h"
 #include "rendering.h"
+#include "skinning.h"
+#include "transform.h"
+#include "upload_queue.h"
 
 #include "glad/glad.h"
 #include <cglm/struct/mat3.h>
 #include <cglm/struct/mat4.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-struct Mesh *meshLoad(struct Vertex *vertices, uint32_t *indices,
-                      int vertexCount, int indexCount) {
-    struct Mesh *mesh = malloc(sizeof(struct Mesh));
+bool MeshPackingEnabled = true;
+
+/// what `meshSendData` puts in the buffers, prepared off the GL thread when
+/// going through `meshQueueSendData`
+struct MeshUpload {
+    struct Mesh *Mesh;
+    void *VertexData;
+    size_t VertexSize;
+    void *IndexData;
+    size_t IndexSize;
+};
+
+void meshPrepareUpload(struct Mesh *mesh, struct MeshUpload *upload);
+void meshUpload(struct MeshUpload *upload);
+void meshUploadJob(void *_upload);
+void meshPackVertices(struct Mesh *mesh, struct PackedVertex *packed);
+int16_t floatToSnorm16(float value);
+uint16_t floatToHalf(float value);
+
+struct Mesh *meshLoad(struct Arena *arena, struct Vertex *vertices,
+                      uint32_t *indices, int vertexCount, int indexCount) {
+    struct Mesh *mesh = arenaAlloc(arena, sizeof(struct Mesh));
     mesh->Vertices = vertices;
     mesh->VertexCount = vertexCount;
     mesh->Indices = indices;
     mesh->IndexCount = indexCount;
+    mesh->IndexType = GL_UNSIGNED_INT;
+    mesh->IndexOffset = 0;
+    mesh->VertexFormat = MESHFORMAT_FLOAT;
+    mesh->PositionOffset = GLMS_VEC3_ZERO;
+    mesh->PositionScale = GLMS_VEC3_ONE;
+    mesh->GpuSize = 0;
+    mesh->BoneOffset = 0;
+    mesh->BoneCount = 0;
+    mesh->MorphTargetCount = 0;
+    mesh->MorphDeltaCount = 0;
+    mesh->MorphTargetOffsets = NULL;
+    mesh->MorphDeltas = NULL;
+    mesh->MorphWeights = NULL;
+    mesh->MorphBuffer = 0;
+    mesh->SkinnedVAO = 0;
+    mesh->SkinnedVBO = 0;
+    mesh->SkinnedDirty = true;
+
+    vec3s min = GLMS_VEC3_ZERO, max = GLMS_VEC3_ZERO;
+    for (int i = 0; vertices != NULL && i < vertexCount; i++) {
+        vec3s position = vertices[i].Position;
+        min = i == 0 ? position : glms_vec3_minv(min, position);
+        max = i == 0 ? position : glms_vec3_maxv(max, position);
+    }
+    meshSetBounds(mesh, min, max);
+    mesh->Meshlets = NULL;
+    mesh->MeshletCount = 0;
+    mesh->Handle = ASSET_HANDLE_NULL;
 
     return mesh;
 }
+void meshSetBounds(struct Mesh *mesh, vec3s min, vec3s max) {
+    mesh->BoundsCenter = glms_vec3_scale(glms_vec3_add(min, max), 0.5f);
+    mesh->BoundsRadius = glms_vec3_distance(min, max) * 0.5f;
+}
 void meshSendData(struct Mesh *mesh) {
-    // generate vertex array object which contains information about all the
-    // vertices
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    // generate vertex buffer object which is the actual vertex data
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh->VertexCount * sizeof(struct Vertex),
-                 mesh->Vertices, GL_STATIC_DRAW);
-
-    int attribIdx = 0;
-    // position vertex attribute
-    glVertexAttribPointer(attribIdx, 3, GL_FLOAT, GL_FALSE,
-                          sizeof(struct Vertex),
-                          (void *)offsetof(struct Vertex, Position));
-    glEnableVertexAttribArray(attribIdx++);
-    // normals
-    glVertexAttribPointer(attribIdx, 3, GL_FLOAT, GL_FALSE,
-                          sizeof(struct Vertex),
-                          (void *)offsetof(struct Vertex, Normal));
-    glEnableVertexAttribArray(attribIdx++);
-    // texcoords
-    glVertexAttribPointer(attribIdx, 2, GL_FLOAT, GL_FALSE,
-                          sizeof(struct Vertex),
-                          (void *)offsetof(struct Vertex, TexCoords));
-    glEnableVertexAttribArray(attribIdx++);
-    // vertex colors
-    glVertexAttribPointer(attribIdx, 3, GL_FLOAT, GL_FALSE,
-                          sizeof(struct Vertex),
-                          (void *)offsetof(struct Vertex, Color));
-    glEnableVertexAttribArray(attribIdx++);
-
-    // generate element buffer object which contains information about the order
-    // of vertices to draw
-    glGenBuffers(1, &mesh->EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->IndexCount * sizeof(uint32_t),
-                 mesh->Indices, GL_STATIC_DRAW);
+    struct MeshUpload upload;
+    meshPrepareUpload(mesh, &upload);
+    meshUpload(&upload);
+}
+void meshQueueSendData(struct Mesh *mesh) {
+    struct MeshUpload *upload = malloc(sizeof(struct MeshUpload));
+    meshPrepareUpload(mesh, upload);
+    uploadQueuePush(meshUploadJob, upload,
+                    upload->VertexSize + upload->IndexSize);
 }
 void meshRender(struct Mesh *mesh, mat4s worldFromModel, uint32_t shader) {
+    // skinned by a compute pass once and drawn from there, as plain world
+    // space floats. morph targets are only applied there
+    uint32_t vao = mesh->VAO;
+    bool computeSkinned = mesh->MorphTargetCount > 0 ||
+                          (mesh->BoneCount > 0 && SkinningComputeEnabled);
+    if (computeSkinned)
+        vao = skinningUpdate(mesh);
+
     glUseProgram(shader);
 
     glUniformMatrix4fv(glGetUniformLocation(shader, "worldFromModel"), 1,
                        GL_FALSE, worldFromModel.raw[0]);
-    mat3s worldNormalFromModel = glms_mat4_pick3(worldFromModel);
-    glms_mat3_inv(worldNormalFromModel);
-    glms_mat3_transpose(worldNormalFromModel);
+    mat3s worldNormalFromModel = transformNormalMatrix(worldFromModel);
     glUniformMatrix3fv(glGetUniformLocation(shader, "worldNormalFromModel"), 1,
                        GL_FALSE, worldNormalFromModel.raw[0]);
     mat4s projectionFromModel =
@@ -73,14 +107,237 @@ void meshRender(struct Mesh *mesh, mat4s worldFromModel, uint32_t shader) {
                       glms_mat4_mul(ViewFromWorldMatrix, worldFromModel));
     glUniformMatrix4fv(glGetUniformLocation(shader, "projectionFromModel"), 1,
                        GL_FALSE, projectionFromModel.raw[0]);
+    // undo the packing done by `meshSendData`
+    bool packed = mesh->VertexFormat == MESHFORMAT_PACKED && !computeSkinned;
+    glUniform3fv(glGetUniformLocation(shader, "positionOffset"), 1,
+                 packed ? mesh->PositionOffset.raw : GLMS_VEC3_ZERO.raw);
+    glUniform3fv(glGetUniformLocation(shader, "positionScale"), 1,
+                 packed ? mesh->PositionScale.raw : GLMS_VEC3_ONE.raw);
+    glUniform1i(glGetUniformLocation(shader, "octahedralNormals"), packed);
+    glUniform1i(glGetUniformLocation(shader, "skinned"),
+                mesh->BoneCount > 0 && !computeSkinned);
+    glUniform1i(glGetUniformLocation(shader, "boneOffset"), mesh->BoneOffset);
 
-    // render triangles
-    glBindVertexArray(mesh->VAO);
-    glDrawElements(GL_TRIANGLES, mesh->IndexCount, GL_UNSIGNED_INT, 0);
+    // render triangles, only the meshlets that can be seen if there are any.
+    // the meshlet bounds are from the bind pose, so skinned and morphed
+    // meshes are drawn whole
+    glBindVertexArray(vao);
+    if (mesh->MeshletCount > 0 && MeshletCullingEnabled &&
+        mesh->BoneCount == 0 && mesh->MorphTargetCount == 0) {
+        int32_t *counts;
+        const void **offsets;
+        int rangeCount = meshletCull(mesh, worldFromModel, &counts, &offsets);
+        glMultiDrawElements(GL_TRIANGLES, counts, mesh->IndexType, offsets,
+                            rangeCount);
+    } else
+        glDrawElements(GL_TRIANGLES, mesh->IndexCount, mesh->IndexType,
+                       (void *)mesh->IndexOffset);
     glBindVertexArray(0);
 }
+void meshSetMorphWeight(struct Mesh *mesh, int target, float weight) {
+    if (target >= mesh->MorphTargetCount ||
+        mesh->MorphWeights[target] == weight)
+        return;
+    mesh->MorphWeights[target] = weight;
+    mesh->SkinnedDirty = true;
+}
 void meshFree(struct Mesh *mesh) {
-    free(mesh->Vertices);
-    free(mesh->Indices);
-    free(mesh);
+    glDeleteVertexArrays(1, &mesh->VAO);
+    glDeleteBuffers(1, &mesh->VBO);
+    glDeleteBuffers(1, &mesh->EBO);
+    glDeleteVertexArrays(1, &mesh->SkinnedVAO);
+    glDeleteBuffers(1, &mesh->SkinnedVBO);
+    glDeleteBuffers(1, &mesh->MorphBuffer);
+}
+
+// picks the formats and converts the data, doesn't touch GL
+void meshPrepareUpload(struct Mesh *mesh, struct MeshUpload *upload) {
+    upload->Mesh = mesh;
+    if (MeshPackingEnabled) {
+        mesh->VertexFormat = MESHFORMAT_PACKED;
+        upload->VertexSize = mesh->VertexCount * sizeof(struct PackedVertex);
+        upload->VertexData = malloc(upload->VertexSize);
+        meshPackVertices(mesh, upload->VertexData);
+    } else {
+        mesh->VertexFormat = MESHFORMAT_FLOAT;
+        upload->VertexSize = mesh->VertexCount * sizeof(struct Vertex);
+        upload->VertexData = mesh->Vertices;
+    }
+
+    // every index fits in 16 bits
+    if (mesh->VertexCount <= UINT16_MAX + 1) {
+        mesh->IndexType = GL_UNSIGNED_SHORT;
+        upload->IndexSize = mesh->IndexCount * sizeof(uint16_t);
+        uint16_t *indices = malloc(upload->IndexSize);
+        for (int i = 0; i < mesh->IndexCount; i++) {
+            indices[i] = mesh->Indices[i];
+        }
+        upload->IndexData = indices;
+    } else {
+        mesh->IndexType = GL_UNSIGNED_INT;
+        upload->IndexSize = mesh->IndexCount * sizeof(uint32_t);
+        upload->IndexData = mesh->Indices;
+    }
+    mesh->GpuSize = upload->VertexSize + upload->IndexSize;
+}
+void meshUpload(struct MeshUpload *upload) {
+    struct Mesh *mesh = upload->Mesh;
+    // generate vertex array object which contains information about all the
+    // vertices
+    glGenVertexArrays(1, &mesh->VAO);
+    glBindVertexArray(mesh->VAO);
+
+    // generate vertex buffer object which is the actual vertex data
+    glGenBuffers(1, &mesh->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, upload->VertexSize, upload->VertexData,
+                 GL_STATIC_DRAW);
+
+    if (mesh->VertexFormat == MESHFORMAT_PACKED) {
+        size_t stride = sizeof(struct PackedVertex);
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride,
+                              (void *)offsetof(struct PackedVertex, Position));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride,
+                              (void *)offsetof(struct PackedVertex, Normal));
+        glVertexAttribPointer(
+            2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+            (void *)offsetof(struct PackedVertex, TexCoords));
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              (void *)offsetof(struct PackedVertex, Color));
+        glVertexAttribIPointer(4, 4, GL_UNSIGNED_BYTE, stride,
+                               (void *)offsetof(struct PackedVertex, Joints));
+        glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              (void *)offsetof(struct PackedVertex, Weights));
+    } else {
+        size_t stride = sizeof(struct Vertex);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, Position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, Normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, TexCoords));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, Color));
+        glVertexAttribIPointer(4, 4, GL_UNSIGNED_BYTE, stride,
+                               (void *)offsetof(struct Vertex, Joints));
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, Weights));
+    }
+    // position, normals, texcoords, vertex colors, joints, weights
+    for (int i = 0; i < 6; i++) {
+        glEnableVertexAttribArray(i);
+    }
+
+    // generate element buffer object which contains information about the order
+    // of vertices to draw
+    glGenBuffers(1, &mesh->EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, upload->IndexSize, upload->IndexData,
+                 GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    if (upload->VertexData != mesh->Vertices)
+        free(upload->VertexData);
+    if (upload->IndexData != mesh->Indices)
+        free(upload->IndexData);
+}
+void meshUploadJob(void *_upload) {
+    meshUpload(_upload);
+    free(_upload);
+}
+void meshPackVertices(struct Mesh *mesh, struct PackedVertex *packed) {
+    // positions are stored relative to the bounds, so the full 16 bits cover
+    // just the mesh
+    vec3s min = GLMS_VEC3_ZERO, max = GLMS_VEC3_ZERO;
+    for (int i = 0; i < mesh->VertexCount; i++) {
+        for (int k = 0; k < 3; k++) {
+            float value = mesh->Vertices[i].Position.raw[k];
+            if (i == 0 || value < min.raw[k])
+                min.raw[k] = value;
+            if (i == 0 || value > max.raw[k])
+                max.raw[k] = value;
+        }
+    }
+    for (int k = 0; k < 3; k++) {
+        mesh->PositionOffset.raw[k] = (min.raw[k] + max.raw[k]) * 0.5f;
+        float extent = (max.raw[k] - min.raw[k]) * 0.5f;
+        mesh->PositionScale.raw[k] = extent > 0 ? extent : 1.0f;
+    }
+
+    for (int i = 0; i < mesh->VertexCount; i++) {
+        struct Vertex *vertex = &mesh->Vertices[i];
+        struct PackedVertex *out = &packed[i];
+        for (int k = 0; k < 3; k++) {
+            out->Position[k] = floatToSnorm16(
+                (vertex->Position.raw[k] - mesh->PositionOffset.raw[k]) /
+                mesh->PositionScale.raw[k]);
+        }
+        out->Position[3] = 0;
+
+        // octahedral: project onto |x|+|y|+|z|=1 and fold the lower half
+        // over the upper one
+        vec3s normal = vertex->Normal;
+        float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+        float x = length > 0 ? normal.x / length : 0;
+        float y = length > 0 ? normal.y / length : 0;
+        if (normal.z < 0) {
+            float foldedX = (1.0f - fabsf(y)) * (x >= 0 ? 1.0f : -1.0f);
+            y = (1.0f - fabsf(x)) * (y >= 0 ? 1.0f : -1.0f);
+            x = foldedX;
+        }
+        out->Normal[0] = floatToSnorm16(x);
+        out->Normal[1] = floatToSnorm16(y);
+
+        out->TexCoords[0] = floatToHalf(vertex->TexCoords.x);
+        out->TexCoords[1] = floatToHalf(vertex->TexCoords.y);
+
+        for (int k = 0; k < 3; k++) {
+            float value = glm_clamp(vertex->Color.raw[k], 0.0f, 1.0f);
+            out->Color[k] = roundf(value * 255.0f);
+        }
+        out->Color[3] = 255;
+
+        // rounded separately, the shader divides by their sum
+        for (int k = 0; k < 4; k++) {
+            out->Joints[k] = vertex->Joints[k];
+            float weight = glm_clamp(vertex->Weights[k], 0.0f, 1.0f);
+            out->Weights[k] = roundf(weight * 255.0f);
+        }
+    }
+}
+int16_t floatToSnorm16(float value) {
+    return roundf(glm_clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+// round to nearest, overflow becomes infinity
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff) // inf and nan
+        return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+    if (exponent >= 31)
+        return sign | 0x7c00;
+    if (exponent <= 0) {
+        // too small for a normal half, becomes subnormal or zero
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint16_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return sign | half;
+    }
+    uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+    // rounds to nearest even, a carry out of the mantissa correctly bumps the
+    // exponent
+    uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return half;
 }
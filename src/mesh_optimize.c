@@ -0,0 +1,407 @@
+#include "mesh_optimize.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+bool MeshOptimizeEnabled = true;
+
+struct OverdrawCluster {
+    int Start, End; // in triangles
+    float Key;
+};
+
+int meshOptimizeFifoMisses(const uint32_t *indices, int indexCount,
+                           int vertexCount, int cacheSize,
+                           bool *triangleMissedAll);
+float forsythVertexScore(int cachePosition, int remainingTriangles);
+uint64_t weldHash(const struct Vertex *vertex);
+int compareClusters(const void *a, const void *b);
+
+int meshOptimize(struct Vertex *vertices, int vertexCount, uint32_t *indices,
+                 int indexCount, struct MeshOptimizeStats *stats) {
+    stats->VertexCountBefore = vertexCount;
+    stats->AcmrBefore = meshOptimizeAcmr(indices, indexCount, vertexCount,
+                                         MESH_OPTIMIZE_FIFO_SIZE);
+    stats->AtvrBefore = meshOptimizeAtvr(indices, indexCount, vertexCount,
+                                         MESH_OPTIMIZE_FIFO_SIZE);
+
+    vertexCount = meshOptimizeWeld(vertices, vertexCount, indices, indexCount);
+    meshOptimizeVertexCache(indices, indexCount, vertexCount);
+    meshOptimizeOverdraw(vertices, vertexCount, indices, indexCount,
+                         MESH_OPTIMIZE_OVERDRAW_THRESHOLD);
+    vertexCount =
+        meshOptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+    stats->VertexCountAfter = vertexCount;
+    stats->AcmrAfter = meshOptimizeAcmr(indices, indexCount, vertexCount,
+                                        MESH_OPTIMIZE_FIFO_SIZE);
+    stats->AtvrAfter = meshOptimizeAtvr(indices, indexCount, vertexCount,
+                                        MESH_OPTIMIZE_FIFO_SIZE);
+    return vertexCount;
+}
+void meshOptimizePrintStats(const char *meshName,
+                            const struct MeshOptimizeStats *stats) {
+    printf("optimized mesh \"%s\": %d -> %d vertices, ACMR %.3f -> %.3f, "
+           "ATVR %.3f -> %.3f\n",
+           meshName, stats->VertexCountBefore, stats->VertexCountAfter,
+           stats->AcmrBefore, stats->AcmrAfter, stats->AtvrBefore,
+           stats->AtvrAfter);
+}
+int meshOptimizeWeld(struct Vertex *vertices, int vertexCount,
+                     uint32_t *indices, int indexCount) {
+    if (vertexCount == 0)
+        return 0;
+    size_t tableSize = 1;
+    while (tableSize < (size_t)vertexCount * 2)
+        tableSize *= 2;
+    // holds new vertex index + 1, 0 is empty
+    uint32_t *table = calloc(tableSize, sizeof(uint32_t));
+    uint32_t *remap = malloc(vertexCount * sizeof(uint32_t));
+
+    int uniqueCount = 0;
+    for (int i = 0; i < vertexCount; i++) {
+        size_t slot = weldHash(&vertices[i]) & (tableSize - 1);
+        while (table[slot] != 0 &&
+               memcmp(&vertices[table[slot] - 1], &vertices[i],
+                      sizeof(struct Vertex)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == 0) {
+            // unique vertices only ever move towards the front, so this can
+            // be done in place
+            vertices[uniqueCount] = vertices[i];
+            table[slot] = ++uniqueCount;
+        }
+        remap[i] = table[slot] - 1;
+    }
+    for (int i = 0; i < indexCount; i++) {
+        indices[i] = remap[indices[i]];
+    }
+
+    free(remap);
+    free(table);
+    return uniqueCount;
+}
+void meshOptimizeVertexCache(uint32_t *indices, int indexCount,
+                             int vertexCount) {
+    int triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // triangles using each vertex; the ones that are already drawn get
+    // swapped out of the front `remaining` entries
+    int *triangleCounts = calloc(vertexCount, sizeof(int));
+    int *adjacencyOffsets = malloc((vertexCount + 1) * sizeof(int));
+    int *adjacency = malloc(triangleCount * 3 * sizeof(int));
+    for (int i = 0; i < triangleCount * 3; i++) {
+        triangleCounts[indices[i]]++;
+    }
+    adjacencyOffsets[0] = 0;
+    for (int i = 0; i < vertexCount; i++) {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + triangleCounts[i];
+        triangleCounts[i] = 0;
+    }
+    for (int i = 0; i < triangleCount * 3; i++) {
+        uint32_t vertex = indices[i];
+        adjacency[adjacencyOffsets[vertex] + triangleCounts[vertex]++] = i / 3;
+    }
+
+    int *cachePositions = malloc(vertexCount * sizeof(int));
+    float *vertexScores = malloc(vertexCount * sizeof(float));
+    for (int i = 0; i < vertexCount; i++) {
+        cachePositions[i] = -1;
+        vertexScores[i] = forsythVertexScore(-1, triangleCounts[i]);
+    }
+    float *triangleScores = malloc(triangleCount * sizeof(float));
+    bool *emitted = calloc(triangleCount, sizeof(bool));
+    int bestTriangle = 0;
+    for (int i = 0; i < triangleCount; i++) {
+        triangleScores[i] = vertexScores[indices[i * 3]] +
+                            vertexScores[indices[i * 3 + 1]] +
+                            vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+            bestTriangle = i;
+    }
+
+    uint32_t *output = malloc(triangleCount * 3 * sizeof(uint32_t));
+    // the 3 extra entries hold vertices that were just pushed out, so their
+    // scores get updated one last time
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    int searchCursor = 0;
+    for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (bestTriangle == -1) {
+            // nothing in the cache has triangles left, start somewhere new
+            while (emitted[searchCursor])
+                searchCursor++;
+            bestTriangle = searchCursor;
+        }
+        const uint32_t *triangle = &indices[bestTriangle * 3];
+        memcpy(&output[emittedCount * 3], triangle, 3 * sizeof(uint32_t));
+        emitted[bestTriangle] = true;
+
+        int newCacheCount = 0;
+        for (int i = 0; i < 3; i++) {
+            uint32_t vertex = triangle[i];
+            int *vertexAdjacency = &adjacency[adjacencyOffsets[vertex]];
+            for (int j = 0; j < triangleCounts[vertex]; j++) {
+                if (vertexAdjacency[j] == bestTriangle) {
+                    vertexAdjacency[j] =
+                        vertexAdjacency[--triangleCounts[vertex]];
+                    break;
+                }
+            }
+            newCache[newCacheCount++] = vertex;
+        }
+        for (int i = 0; i < cacheCount; i++) {
+            uint32_t vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] &&
+                vertex != triangle[2] && newCacheCount < FORSYTH_CACHE_SIZE + 3)
+                newCache[newCacheCount++] = vertex;
+        }
+        memcpy(cache, newCache, newCacheCount * sizeof(uint32_t));
+        cacheCount = newCacheCount;
+
+        for (int i = 0; i < cacheCount; i++) {
+            uint32_t vertex = cache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? i : -1;
+            vertexScores[vertex] = forsythVertexScore(cachePositions[vertex],
+                                                      triangleCounts[vertex]);
+        }
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; i++) {
+            uint32_t vertex = cache[i];
+            int *vertexAdjacency = &adjacency[adjacencyOffsets[vertex]];
+            for (int j = 0; j < triangleCounts[vertex]; j++) {
+                int t = vertexAdjacency[j];
+                triangleScores[t] = vertexScores[indices[t * 3]] +
+                                    vertexScores[indices[t * 3 + 1]] +
+                                    vertexScores[indices[t * 3 + 2]];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+        // vertices that fell out of the cache are done being tracked
+        if (cacheCount > FORSYTH_CACHE_SIZE)
+            cacheCount = FORSYTH_CACHE_SIZE;
+    }
+    memcpy(indices, output, triangleCount * 3 * sizeof(uint32_t));
+
+    free(output);
+    free(emitted);
+    free(triangleScores);
+    free(vertexScores);
+    free(cachePositions);
+    free(adjacency);
+    free(adjacencyOffsets);
+    free(triangleCounts);
+}
+void meshOptimizeOverdraw(const struct Vertex *vertices, int vertexCount,
+                          uint32_t *indices, int indexCount, float threshold) {
+    int triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // a cluster starts wherever a triangle misses the cache with all three
+    // vertices, so moving clusters around barely changes cache behaviour
+    bool *missedAll = malloc(triangleCount * sizeof(bool));
+    meshOptimizeFifoMisses(indices, indexCount, vertexCount,
+                           MESH_OPTIMIZE_FIFO_SIZE, missedAll);
+    missedAll[0] = true;
+    int clusterCount = 0;
+    for (int i = 0; i < triangleCount; i++) {
+        clusterCount += missedAll[i];
+    }
+    if (clusterCount < 2) {
+        free(missedAll);
+        return;
+    }
+    struct OverdrawCluster *clusters =
+        malloc(clusterCount * sizeof(struct OverdrawCluster));
+    for (int i = 0, cluster = -1; i < triangleCount; i++) {
+        if (missedAll[i]) {
+            if (cluster >= 0)
+                clusters[cluster].End = i;
+            clusters[++cluster].Start = i;
+        }
+    }
+    clusters[clusterCount - 1].End = triangleCount;
+    free(missedAll);
+
+    float meshCenter[3] = {0};
+    for (int i = 0; i < indexCount; i++) {
+        for (int k = 0; k < 3; k++) {
+            meshCenter[k] += vertices[indices[i]].Position.raw[k] / indexCount;
+        }
+    }
+    // clusters that sit far out along their own normal are likely to cover
+    // the rest of the mesh, so they go first
+    for (int c = 0; c < clusterCount; c++) {
+        struct OverdrawCluster *cluster = &clusters[c];
+        float center[3] = {0}, normal[3] = {0};
+        for (int t = cluster->Start; t < cluster->End; t++) {
+            const float *p0 = vertices[indices[t * 3]].Position.raw;
+            const float *p1 = vertices[indices[t * 3 + 1]].Position.raw;
+            const float *p2 = vertices[indices[t * 3 + 2]].Position.raw;
+            float e1[3], e2[3];
+            for (int k = 0; k < 3; k++) {
+                center[k] += p0[k] + p1[k] + p2[k];
+                e1[k] = p1[k] - p0[k];
+                e2[k] = p2[k] - p0[k];
+            }
+            // not normalized, so bigger triangles weigh more
+            normal[0] += e1[1] * e2[2] - e1[2] * e2[1];
+            normal[1] += e1[2] * e2[0] - e1[0] * e2[2];
+            normal[2] += e1[0] * e2[1] - e1[1] * e2[0];
+        }
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+                             normal[2] * normal[2]);
+        int cornerCount = (cluster->End - cluster->Start) * 3;
+        cluster->Key = 0;
+        for (int k = 0; k < 3; k++) {
+            float offset = center[k] / cornerCount - meshCenter[k];
+            cluster->Key += length > 0 ? offset * normal[k] / length : 0;
+        }
+    }
+    qsort(clusters, clusterCount, sizeof(struct OverdrawCluster),
+          compareClusters);
+
+    uint32_t *sorted = malloc(indexCount * sizeof(uint32_t));
+    int written = 0;
+    for (int c = 0; c < clusterCount; c++) {
+        int count = (clusters[c].End - clusters[c].Start) * 3;
+        memcpy(&sorted[written], &indices[clusters[c].Start * 3],
+               count * sizeof(uint32_t));
+        written += count;
+    }
+    // any trailing indices that aren't a whole triangle stay where they are
+    memcpy(&sorted[written], &indices[written],
+           (indexCount - written) * sizeof(uint32_t));
+
+    float acmrBefore = meshOptimizeAcmr(indices, indexCount, vertexCount,
+                                        MESH_OPTIMIZE_FIFO_SIZE);
+    float acmrAfter = meshOptimizeAcmr(sorted, indexCount, vertexCount,
+                                       MESH_OPTIMIZE_FIFO_SIZE);
+    if (acmrAfter <= acmrBefore * threshold)
+        memcpy(indices, sorted, indexCount * sizeof(uint32_t));
+
+    free(sorted);
+    free(clusters);
+}
+int meshOptimizeVertexFetch(struct Vertex *vertices, int vertexCount,
+                            uint32_t *indices, int indexCount) {
+    uint32_t *remap = malloc(vertexCount * sizeof(uint32_t));
+    memset(remap, 0xff, vertexCount * sizeof(uint32_t));
+    struct Vertex *reordered = malloc(vertexCount * sizeof(struct Vertex));
+    uint32_t usedCount = 0;
+    for (int i = 0; i < indexCount; i++) {
+        uint32_t vertex = indices[i];
+        if (remap[vertex] == UINT32_MAX) {
+            remap[vertex] = usedCount;
+            reordered[usedCount++] = vertices[vertex];
+        }
+        indices[i] = remap[vertex];
+    }
+    memcpy(vertices, reordered, usedCount * sizeof(struct Vertex));
+    free(reordered);
+    free(remap);
+    return usedCount;
+}
+float meshOptimizeAcmr(const uint32_t *indices, int indexCount,
+                       int vertexCount, int cacheSize) {
+    if (indexCount < 3)
+        return 0;
+    return (float)meshOptimizeFifoMisses(indices, indexCount, vertexCount,
+                                         cacheSize, NULL) /
+           (indexCount / 3);
+}
+float meshOptimizeAtvr(const uint32_t *indices, int indexCount,
+                       int vertexCount, int cacheSize) {
+    bool *used = calloc(vertexCount, sizeof(bool));
+    int usedCount = 0;
+    for (int i = 0; i < indexCount; i++) {
+        usedCount += !used[indices[i]];
+        used[indices[i]] = true;
+    }
+    free(used);
+    if (usedCount == 0)
+        return 0;
+    return (float)meshOptimizeFifoMisses(indices, indexCount, vertexCount,
+                                         cacheSize, NULL) /
+           usedCount;
+}
+
+// returns the number of cache misses. if `triangleMissedAll` is set, it
+// gets whether each triangle missed with all three of its vertices
+int meshOptimizeFifoMisses(const uint32_t *indices, int indexCount,
+                           int vertexCount, int cacheSize,
+                           bool *triangleMissedAll) {
+    // a vertex is in the cache if fewer than `cacheSize` misses happened
+    // since it was put in
+    int *insertedAt = malloc(vertexCount * sizeof(int));
+    for (int i = 0; i < vertexCount; i++) {
+        insertedAt[i] = -cacheSize - 1;
+    }
+    int misses = 0;
+    for (int t = 0; t < indexCount / 3; t++) {
+        int triangleMisses = 0;
+        for (int i = 0; i < 3; i++) {
+            uint32_t vertex = indices[t * 3 + i];
+            if (misses - insertedAt[vertex] > cacheSize) {
+                insertedAt[vertex] = misses++;
+                triangleMisses++;
+            }
+        }
+        if (triangleMissedAll != NULL)
+            triangleMissedAll[t] = triangleMisses == 3;
+    }
+    free(insertedAt);
+    return misses;
+}
+float forsythVertexScore(int cachePosition, int remainingTriangles) {
+    if (remainingTriangles == 0)
+        return -1.0f;
+    float score = 0;
+    if (cachePosition >= 0) {
+        // the last triangle's vertices get a fixed score so the next one
+        // doesn't just reuse them in a strip-like order
+        if (cachePosition < 3)
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) /
+                                    (FORSYTH_CACHE_SIZE - 3),
+                         FORSYTH_CACHE_DECAY_POWER);
+    }
+    // vertices with few triangles left are worth finishing off
+    return score + FORSYTH_VALENCE_BOOST_SCALE *
+                       powf(remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+// FNV-1a over the raw bytes, matching the `memcmp` used for equality
+uint64_t weldHash(const struct Vertex *vertex) {
+    const uint8_t *bytes = (const uint8_t *)vertex;
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < sizeof(struct Vertex); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+int compareClusters(const void *a, const void *b) {
+    const struct OverdrawCluster *clusterA = a, *clusterB = b;
+    if (clusterA->Key != clusterB->Key)
+        return clusterA->Key > clusterB->Key ? -1 : 1;
+    // keep the cache order for ties
+    return clusterA->Start - clusterB->Start;
+}
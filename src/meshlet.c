@@ -0,0 +1,209 @@
+#include "meshlet.h"
+
+#include "rendering.h"
+#include "transform_batch.h"
+
+#include "glad/glad.h"
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/vec3.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool MeshletsEnabled = true;
+bool MeshletCullingEnabled = true;
+
+/// scratch ranges handed out by `meshletCull`
+int32_t *_drawCounts = NULL;
+const void **_drawOffsets = NULL;
+bool *_drawVisible = NULL;
+int _drawCapacity = 0;
+
+// the bounds are read as a center and radius straight from the meshlets
+_Static_assert(offsetof(struct Meshlet, Radius) ==
+                   offsetof(struct Meshlet, Center) + sizeof(vec3s),
+               "meshlet radius has to follow its center");
+
+void meshletBounds(struct Mesh *mesh, struct Meshlet *meshlet);
+
+void meshletBuild(struct Arena *arena, struct Mesh *mesh) {
+    int triangleCount = mesh->IndexCount / 3;
+    if (triangleCount < MESHLET_MIN_MESH_TRIANGLES)
+        return;
+
+    // index of the meshlet that last used each vertex, so a vertex is only
+    // counted once per meshlet
+    int *lastMeshlet = malloc(mesh->VertexCount * sizeof(int));
+    for (int i = 0; i < mesh->VertexCount; i++) {
+        lastMeshlet[i] = -1;
+    }
+    // the worst case is one meshlet per `MESHLET_MAX_TRIANGLES` triangles
+    // until the vertex limit kicks in, so grow as needed
+    int capacity = triangleCount / MESHLET_MAX_TRIANGLES + 1;
+    struct Meshlet *meshlets = malloc(capacity * sizeof(struct Meshlet));
+    int meshletCount = 0;
+
+    struct Meshlet *meshlet = NULL;
+    for (int triangle = 0; triangle < triangleCount; triangle++) {
+        const uint32_t *indices = &mesh->Indices[triangle * 3];
+        int newVertices = 0;
+        if (meshlet != NULL) {
+            for (int k = 0; k < 3; k++) {
+                if (lastMeshlet[indices[k]] != meshletCount - 1)
+                    newVertices++;
+            }
+        }
+        if (meshlet == NULL ||
+            meshlet->VertexCount + newVertices > MESHLET_MAX_VERTICES ||
+            meshlet->TriangleCount == MESHLET_MAX_TRIANGLES) {
+            if (meshletCount == capacity) {
+                capacity *= 2;
+                meshlets = realloc(meshlets, capacity * sizeof(struct Meshlet));
+            }
+            meshlet = &meshlets[meshletCount++];
+            meshlet->FirstIndex = triangle * 3;
+            meshlet->TriangleCount = 0;
+            meshlet->VertexCount = 0;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (lastMeshlet[indices[k]] != meshletCount - 1) {
+                lastMeshlet[indices[k]] = meshletCount - 1;
+                meshlet->VertexCount++;
+            }
+        }
+        meshlet->TriangleCount++;
+    }
+    free(lastMeshlet);
+
+    for (int i = 0; i < meshletCount; i++) {
+        meshletBounds(mesh, &meshlets[i]);
+    }
+    mesh->Meshlets = arenaAlloc(arena, meshletCount * sizeof(struct Meshlet));
+    memcpy(mesh->Meshlets, meshlets, meshletCount * sizeof(struct Meshlet));
+    mesh->MeshletCount = meshletCount;
+    free(meshlets);
+}
+int meshletCull(struct Mesh *mesh, mat4s worldFromModel, int32_t **counts,
+                const void ***offsets) {
+    if (_drawCapacity < mesh->MeshletCount) {
+        _drawCapacity = mesh->MeshletCount;
+        _drawCounts = realloc(_drawCounts, _drawCapacity * sizeof(int32_t));
+        _drawOffsets =
+            realloc(_drawOffsets, _drawCapacity * sizeof(const void *));
+        _drawVisible = realloc(_drawVisible, _drawCapacity * sizeof(bool));
+    }
+    *counts = _drawCounts;
+    *offsets = _drawOffsets;
+
+    mat4s viewFromModel = glms_mat4_mul(ViewFromWorldMatrix, worldFromModel);
+    mat4s projectionFromModel =
+        glms_mat4_mul(ProjectionFromViewMatrix, viewFromModel);
+    vec3s camera = glms_vec3(glms_mat4_inv(viewFromModel).col[3]);
+
+    // frustum planes in model space, taken from the rows of the projection
+    // (Gribb & Hartmann). a point is inside when `dot(xyz, p) + w >= 0`
+    vec4s planes[6];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            float row = projectionFromModel.raw[j][i];
+            float w = projectionFromModel.raw[j][3];
+            planes[i * 2].raw[j] = w + row;
+            planes[i * 2 + 1].raw[j] = w - row;
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        float length = glms_vec3_norm(glms_vec3(planes[i]));
+        for (int j = 0; j < 4; j++) {
+            planes[i].raw[j] /= length;
+        }
+    }
+
+    transformBatchCullSpheres(planes, mesh->Meshlets[0].Center.raw,
+                              sizeof(struct Meshlet), mesh->MeshletCount,
+                              _drawVisible);
+
+    size_t indexSize =
+        mesh->IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                             : sizeof(uint32_t);
+    int rangeCount = 0;
+    uint32_t rangeEnd = UINT32_MAX;
+    for (int i = 0; i < mesh->MeshletCount; i++) {
+        struct Meshlet *meshlet = &mesh->Meshlets[i];
+        if (!_drawVisible[i])
+            continue;
+        vec3s toCenter = glms_vec3_sub(meshlet->Center, camera);
+        if (glms_vec3_dot(toCenter, meshlet->ConeAxis) >=
+            meshlet->ConeCutoff * glms_vec3_norm(toCenter) + meshlet->Radius)
+            continue;
+
+        int32_t count = meshlet->TriangleCount * 3;
+        if (meshlet->FirstIndex == rangeEnd) {
+            _drawCounts[rangeCount - 1] += count;
+        } else {
+            _drawCounts[rangeCount] = count;
+            _drawOffsets[rangeCount] =
+                (const void *)(mesh->IndexOffset +
+                               meshlet->FirstIndex * indexSize);
+            rangeCount++;
+        }
+        rangeEnd = meshlet->FirstIndex + count;
+    }
+    return rangeCount;
+}
+
+void meshletBounds(struct Mesh *mesh, struct Meshlet *meshlet) {
+    const uint32_t *indices = &mesh->Indices[meshlet->FirstIndex];
+    int indexCount = meshlet->TriangleCount * 3;
+
+    // the sphere is centered on the bounding box, which is close enough for
+    // clusters this small
+    vec3s min = mesh->Vertices[indices[0]].Position, max = min;
+    for (int i = 1; i < indexCount; i++) {
+        vec3s position = mesh->Vertices[indices[i]].Position;
+        min = glms_vec3_minv(min, position);
+        max = glms_vec3_maxv(max, position);
+    }
+    meshlet->Center = glms_vec3_scale(glms_vec3_add(min, max), 0.5f);
+    meshlet->Radius = 0.0f;
+    for (int i = 0; i < indexCount; i++) {
+        float distance = glms_vec3_distance(
+            meshlet->Center, mesh->Vertices[indices[i]].Position);
+        meshlet->Radius = fmaxf(meshlet->Radius, distance);
+    }
+
+    // the cone uses face normals, vertex normals can point anywhere
+    vec3s normals[MESHLET_MAX_TRIANGLES];
+    vec3s axis = GLMS_VEC3_ZERO;
+    int normalCount = 0;
+    for (int i = 0; i < indexCount; i += 3) {
+        vec3s a = mesh->Vertices[indices[i]].Position;
+        vec3s b = mesh->Vertices[indices[i + 1]].Position;
+        vec3s c = mesh->Vertices[indices[i + 2]].Position;
+        vec3s normal =
+            glms_vec3_cross(glms_vec3_sub(b, a), glms_vec3_sub(c, a));
+        float length = glms_vec3_norm(normal);
+        if (length == 0.0f)
+            continue; // degenerate triangles face nowhere
+        normal = glms_vec3_scale(normal, 1.0f / length);
+        normals[normalCount++] = normal;
+        axis = glms_vec3_add(axis, normal);
+    }
+    meshlet->ConeAxis = GLMS_VEC3_ZERO;
+    meshlet->ConeCutoff = 1.0f;
+    float axisLength = glms_vec3_norm(axis);
+    if (normalCount == 0 || axisLength == 0.0f)
+        return;
+    meshlet->ConeAxis = glms_vec3_scale(axis, 1.0f / axisLength);
+
+    float minDot = 1.0f;
+    for (int i = 0; i < normalCount; i++) {
+        minDot = fminf(minDot, glms_vec3_dot(normals[i], meshlet->ConeAxis));
+    }
+    // wider than ~84 degrees is never fully back facing in practice
+    if (minDot <= 0.1f)
+        return;
+    // the cone of normals is back facing when the view direction is more
+    // than 90 degrees away from every normal, i.e. within `90 - angle` of
+    // the axis
+    meshlet->ConeCutoff = sqrtf(1.0f - minDot * minDot);
+}
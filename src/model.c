@@ -1,82 +1,297 @@
 #include "model.h"
 
+#include "animation_bake.h"
+#include "animation_compress.h"
 #include "assimp/matrix4x4.h"
+#include "gltf.h"
 #include "material.h"
 #include "mesh.h"
+#include "mesh_optimize.h"
+#include "meshlet.h"
+#include "model_cache.h"
 #include "node.h"
 #include "texture.h"
+#include "thread_pool.h"
+#include "transform_batch.h"
+#include "upload_queue.h"
 
 #include "glad/glad.h"
 #include <GL/gl.h>
 #include <assimp/postprocess.h>
 #include <cglm/struct/mat4.h>
 #include <cglm/struct/vec2.h>
+#include <cglm/struct/vec3.h>
+#include <cglm/struct/vec4.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-struct Mesh *processMesh(struct aiMesh *mesh, const struct aiScene *scene);
-struct Node *processNode(struct aiNode *node, struct Node *parentNode);
+/// bone matrices worked out together by `_modelUploadBones`
+#define MODEL_BONE_BLOCK 64
+
+bool ModelFlattenEnabled = true;
+
+/// everything `modelLoadAsync` needs to hand the model back
+struct ModelLoadRequest {
+    char *ModelFilename;
+    Model *Model;
+    void (*OnLoaded)(Model *model, void *data);
+    void *Data;
+    /// requests for the same file made while this one was importing, handed
+    /// the model this one imports
+    struct ModelLoadRequest *Waiting;
+    /// next in `_pendingLoads`, or in the `Waiting` list of the request this
+    /// one waits on
+    struct ModelLoadRequest *Next;
+};
+
+/// requests whose model is being imported, one per file
+struct ModelLoadRequest *_pendingLoads = NULL;
+pthread_mutex_t _pendingLoadsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+Model *modelImport(const char *_modelPath);
+Model *modelImportFile(const char *_modelPath);
+Model *modelFindLoaded(const char *modelFilename);
+void modelRegister(Model *model, const char *modelFilename);
+void modelDeleteAsset(void *_model);
+void modelLoadJob(void *_request);
+void modelLoadFinish(void *_request);
+size_t modelArenaSize(const struct aiScene *scene);
+size_t nodeArenaSize(const struct aiNode *node, int *nodeCount);
+struct Mesh *processMesh(struct Arena *arena, struct aiMesh *mesh,
+                         const struct aiScene *scene);
+mat4s aiMatrixToGLMS(struct aiMatrix4x4 aiMat);
+int processBoneCount(const struct aiMesh *mesh);
+int processMorphDeltaCount(const struct aiMesh *mesh);
+void processMorphTargets(struct Arena *arena, struct Mesh *newMesh,
+                         const struct aiMesh *mesh);
+bool processMorphDelta(const struct aiMesh *mesh,
+                       const struct aiAnimMesh *target, int vertex,
+                       struct MorphDelta *delta);
+void processBones(Model *model, const struct aiScene *scene);
+struct Node *processNode(struct Arena *arena, struct aiNode *node,
+                         struct Node *parentNode);
+const char **processKeptNodeNames(const struct aiScene *scene, int *count);
+struct Node *searchForNode(char *name, struct Node *rootNode);
+void flattenNodeChildren(struct Node *node, struct Node **children,
+                         int *childCount, const char *const *keepNames,
+                         int keepCount);
+void flattenNodeInto(struct Node *parent, struct Node *node,
+                     struct Node **children, int *childCount,
+                     const char *const *keepNames, int keepCount);
+bool flattenNodeFoldable(struct Node *node, const char *const *keepNames,
+                         int keepCount);
+bool flattenNodeKept(struct Node *node, const char *const *keepNames,
+                     int keepCount);
 void processNodeArray(struct NodeEntry *nodeArray, struct Node *rootNode,
                       int *index, int parentIndex);
 
-Model *modelLoad(const char *_modelPath) {
+Model *modelLoad(const char *modelFilename) {
+    Model *model = modelFindLoaded(modelFilename);
+    if (model != NULL)
+        return model;
+    model = modelImport(modelFilename);
+    uploadQueueFlush();
+    // an async load of the same file may have finished during the flush
+    Model *loaded = modelFindLoaded(modelFilename);
+    if (loaded != NULL) {
+        model->OnDelete(model);
+        return loaded;
+    }
+    modelRegister(model, modelFilename);
+    return model;
+}
+void modelLoadAsync(const char *modelFilename,
+                    void (*onLoaded)(Model *model, void *data), void *data) {
+    struct ModelLoadRequest *request = malloc(sizeof(struct ModelLoadRequest));
+    request->ModelFilename = malloc(strlen(modelFilename) + 1);
+    strcpy(request->ModelFilename, modelFilename);
+    request->OnLoaded = onLoaded;
+    request->Data = data;
+    request->Waiting = NULL;
+
+    // a file that is already being imported isn't imported again, the
+    // request waits for that one instead. `modelLoadFinish` registers under
+    // the same lock, so the file is always either loaded or pending here
+    pthread_mutex_lock(&_pendingLoadsMutex);
+    request->Model = modelFindLoaded(modelFilename);
+    struct ModelLoadRequest *pending = NULL;
+    if (request->Model == NULL) {
+        pending = _pendingLoads;
+        while (pending != NULL &&
+               strcmp(pending->ModelFilename, modelFilename) != 0)
+            pending = pending->Next;
+        if (pending != NULL) {
+            request->Next = pending->Waiting;
+            pending->Waiting = request;
+        } else {
+            request->Next = _pendingLoads;
+            _pendingLoads = request;
+        }
+    }
+    pthread_mutex_unlock(&_pendingLoadsMutex);
+
+    // still handed back from `uploadQueueDrain` when it's already loaded
+    if (request->Model != NULL)
+        uploadQueuePush(modelLoadFinish, request, 0);
+    else if (pending == NULL)
+        threadPoolSubmit(modelLoadJob, request);
+}
+// does all the cpu work of loading a model and leaves the GL calls to the
+// upload queue, so it can run on any thread
+Model *modelImport(const char *_modelPath) {
+    Model *model = modelImportFile(_modelPath);
+    if (AnimationBakeEnabled) {
+        for (int i = 0; i < model->AnimationCount; i++) {
+            animationBake(model->Arena, model->Animations[i],
+                          AnimationBakeFrameRate, AnimationBakeBudget,
+                          AnimationBakeBlend);
+        }
+    }
+    return model;
+}
+Model *modelImportFile(const char *_modelPath) {
     char *modelFile = malloc(strlen(_modelPath) + sizeof(MODELS_PATH));
     strcpy(modelFile, MODELS_PATH);
     strcat(modelFile, _modelPath);
 
+    if (ModelCacheEnabled) {
+        Model *cachedModel = modelCacheLoad(modelFile);
+        if (cachedModel != NULL) {
+            free(modelFile);
+            return cachedModel;
+        }
+    }
+    if (ModelNativeGltfEnabled && gltfIsGltfFile(modelFile)) {
+        Model *gltfModel = gltfLoad(modelFile);
+        if (gltfModel != NULL) {
+            free(modelFile);
+            return gltfModel;
+        }
+    }
+
     const struct aiScene *scene = aiImportFile(
         modelFile, aiProcess_Triangulate | aiProcess_FlipUVs |
                        aiProcess_GenNormals | aiProcess_SplitLargeMeshes |
-                       aiProcess_PopulateArmatureData);
+                       aiProcess_PopulateArmatureData |
+                       aiProcess_LimitBoneWeights);
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
         !scene->mRootNode) {
         printf("assimp error: %s", aiGetErrorString());
     }
 
-    Model *model = malloc(sizeof(Model));
-
-    model->WorldFromModel = GLMS_MAT4_IDENTITY;
+    // everything below comes out of one allocation, sized by walking the
+    // scene first
+    Model *model = _modelCreate(modelArenaSize(scene));
+    struct Arena *arena = model->Arena;
 
     model->MeshCount = scene->mNumMeshes;
-    model->Meshes = malloc(model->MeshCount * sizeof(struct Mesh *));
+    model->Meshes = arenaAlloc(arena, model->MeshCount * sizeof(struct Mesh *));
     for (int i = 0; i < scene->mNumMeshes; i++) {
-        model->Meshes[i] = processMesh(scene->mMeshes[i], scene);
-        meshSendData(model->Meshes[i]);
+        model->Meshes[i] = processMesh(arena, scene->mMeshes[i], scene);
+        meshQueueSendData(model->Meshes[i]);
     }
 
     model->MaterialCount = scene->mNumMaterials;
-    model->Materials = malloc(model->MaterialCount * sizeof(Material *));
+    model->Materials =
+        arenaAlloc(arena, model->MaterialCount * sizeof(Material *));
 
     model->TextureCount = scene->mNumTextures;
-    model->Textures = malloc(model->TextureCount * sizeof(Texture *));
+    model->Textures =
+        arenaAlloc(arena, model->TextureCount * sizeof(Texture *));
     for (int i = 0; i < model->TextureCount; i++) {
-        model->Textures[i] = textureCreate(scene->mTextures[i]->mFilename.data,
-                                           TEXTURETYPE_RGB, true);
+        model->Textures[i] =
+            textureLoadAsync(scene->mTextures[i]->mFilename.data);
     }
 
-    struct Node *rootNode = processNode(scene->mRootNode, NULL);
-    model->NodeCount = nodeChildCount(rootNode) + 1; // +1 for root node
-    model->NodeEntries = malloc(model->NodeCount * sizeof(struct NodeEntry));
-    int index = 0;
-    processNodeArray(model->NodeEntries, rootNode, &index, -1);
+    struct Node *rootNode = processNode(arena, scene->mRootNode, NULL);
+    int keepCount;
+    const char **keepNames = processKeptNodeNames(scene, &keepCount);
+    _modelFlattenNodes(arena, rootNode, keepNames, keepCount);
+    free(keepNames);
+    _modelSetNodes(model, rootNode);
+    processBones(model, scene);
 
     model->AnimationCount = scene->mNumAnimations;
-    model->Animations = malloc(model->AnimationCount * sizeof(Animation *));
+    model->Animations =
+        arenaAlloc(arena, model->AnimationCount * sizeof(Animation *));
     for (int i = 0; i < model->AnimationCount; i++) {
-        model->Animations[i] =
-            animationCreate(scene, scene->mAnimations[i]->mName.data,
-                            model->NodeEntries[0].Node);
+        char *name = scene->mAnimations[i]->mName.data;
+        if (!AnimationCompressEnabled) {
+            model->Animations[i] =
+                animationCreate(arena, scene, name, rootNode, model->Meshes);
+            continue;
+        }
+        // the full keys are only needed until they're compressed
+        struct Arena *keyArena = arenaCreate(MODEL_ARENA_SIZE);
+        Animation *animation =
+            animationCreate(keyArena, scene, name, rootNode, model->Meshes);
+        struct AnimationCompressStats stats;
+        model->Animations[i] = animationCompress(
+            arena, animation, AnimationCompressTolerance, &stats);
+        animationCompressPrintStats(model->Animations[i], &stats);
+        arenaFree(keyArena);
     }
 
-    model->OnDelete = &_modelDelete;
+    if (ModelCacheEnabled) {
+        const char **textureNames =
+            malloc(model->TextureCount * sizeof(const char *));
+        for (int i = 0; i < model->TextureCount; i++)
+            textureNames[i] = scene->mTextures[i]->mFilename.data;
+        modelCacheWrite(modelFile, model, textureNames);
+        free(textureNames);
+    }
 
     free(modelFile);
     aiReleaseImport(scene);
 
     return model;
 }
+void modelLoadJob(void *_request) {
+    struct ModelLoadRequest *request = (struct ModelLoadRequest *)_request;
+    request->Model = modelImport(request->ModelFilename);
+    // queued after all of the model's uploads, so it runs once they're done
+    uploadQueuePush(modelLoadFinish, request, 0);
+}
+void modelLoadFinish(void *_request) {
+    struct ModelLoadRequest *request = (struct ModelLoadRequest *)_request;
+    if (request->Model->Handle.Generation == 0) {
+        pthread_mutex_lock(&_pendingLoadsMutex);
+        struct ModelLoadRequest **link = &_pendingLoads;
+        while (*link != request)
+            link = &(*link)->Next;
+        *link = request->Next;
+        // `modelLoad` may have loaded the same file in the meantime
+        Model *duplicate = NULL;
+        Model *loaded = modelFindLoaded(request->ModelFilename);
+        if (loaded != NULL) {
+            duplicate = request->Model;
+            request->Model = loaded;
+        } else
+            modelRegister(request->Model, request->ModelFilename);
+        pthread_mutex_unlock(&_pendingLoadsMutex);
+        if (duplicate != NULL)
+            duplicate->OnDelete(duplicate);
+
+        // each waiting request gets its own reference before any callback
+        // can release the first one
+        for (struct ModelLoadRequest *waiting = request->Waiting;
+             waiting != NULL; waiting = waiting->Next)
+            waiting->Model = modelFindLoaded(waiting->ModelFilename);
+        struct ModelLoadRequest *waiting = request->Waiting;
+        while (waiting != NULL) {
+            struct ModelLoadRequest *next = waiting->Next;
+            modelLoadFinish(waiting);
+            waiting = next;
+        }
+    }
+    request->OnLoaded(request->Model, request->Data);
+    free(request->ModelFilename);
+    free(request);
+}
 void modelSetMaterials(Model *model, int materialCount, ...) {
     va_list materials;
     va_start(materials, materialCount);
@@ -91,40 +306,82 @@ void modelSetDefaultMaterial(Model *model, Material *material) {
     }
 }
 void modelRender(Model *model) {
+    // every bone has to be in place before a skinned mesh is drawn
+    transformUpdate(&model->Transforms, model->WorldFromModel);
+    _modelUploadBones(model, model->Transforms.WorldFromLocal, sizeof(mat4s));
+
+    for (int i = 0; i < model->NodeCount; i++) {
+        nodeRenderAt(model->Transforms.WorldFromLocal[i],
+                     model->NodeEntries[i].Node, model->Meshes,
+                     model->Materials);
+    }
+}
+void modelBounds(Model *model, vec3s *center, float *radius) {
+    // a sphere per mesh, then the box around those and the sphere around that
+    int meshCount = 0;
+    for (int i = 0; i < model->NodeCount; i++) {
+        meshCount += model->NodeEntries[i].Node->MeshCount;
+    }
+    mat4s *modelFromLocal = malloc(model->NodeCount * sizeof(mat4s));
+    vec4s *spheres = malloc(meshCount * sizeof(vec4s));
+    int sphereCount = 0;
+    vec3s min = GLMS_VEC3_ZERO, max = GLMS_VEC3_ZERO;
     for (int i = 0; i < model->NodeCount; i++) {
         struct NodeEntry *nodeEntry = &model->NodeEntries[i];
-        mat4s worldFromParent;
-        if (i == 0)
-            worldFromParent = model->WorldFromModel;
-        else
-            worldFromParent =
-                model->NodeEntries[nodeEntry->ParentIndex].WorldFromLocal;
+        struct Node *node = nodeEntry->Node;
+        TransformAffine parentFromLocal = transformCompose(node->Local);
+        modelFromLocal[i] =
+            i == 0 ? transformToMat4(parentFromLocal)
+                   : transformApply(modelFromLocal[nodeEntry->ParentIndex],
+                                    parentFromLocal);
+        float scale = 0;
+        for (int j = 0; j < 3; j++) {
+            scale = fmaxf(scale,
+                          glms_vec3_norm(glms_vec3(modelFromLocal[i].col[j])));
+        }
+
+        for (int j = 0; j < node->MeshCount; j++) {
+            struct Mesh *mesh = model->Meshes[node->Meshes[j]];
+            vec3s sphereCenter =
+                glms_mat4_mulv3(modelFromLocal[i], mesh->BoundsCenter, 1);
+            float sphereRadius = mesh->BoundsRadius * scale;
+            vec3s sphereMin = glms_vec3_subs(sphereCenter, sphereRadius);
+            vec3s sphereMax = glms_vec3_adds(sphereCenter, sphereRadius);
+            min = sphereCount == 0 ? sphereMin : glms_vec3_minv(min, sphereMin);
+            max = sphereCount == 0 ? sphereMax : glms_vec3_maxv(max, sphereMax);
+            spheres[sphereCount++] = glms_vec4(sphereCenter, sphereRadius);
+        }
+    }
 
-        nodeRender(worldFromParent, nodeEntry->Node, model->Meshes,
-                   model->Materials);
-        nodeEntry->WorldFromLocal =
-            glms_mat4_mul(worldFromParent, nodeEntry->Node->ParentFromLocal);
+    *center = glms_vec3_scale(glms_vec3_add(min, max), 0.5f);
+    *radius = 0;
+    for (int i = 0; i < sphereCount; i++) {
+        float distance = glms_vec3_distance(*center, glms_vec3(spheres[i]));
+        *radius = fmaxf(*radius, distance + spheres[i].w);
     }
+    free(spheres);
+    free(modelFromLocal);
+}
+void modelFree(Model *model) {
+    // models made by a loader directly aren't registered
+    if (model->Handle.Generation == 0)
+        (model->OnDelete)(model);
+    else
+        assetRelease(model->Handle);
 }
-void modelFree(Model *model) { (model->OnDelete)(model); }
 void _modelDelete(void *_model) {
     Model *model = (Model *)_model;
-    nodeFree(model->NodeEntries[0].Node);
-    free(model->NodeEntries);
-    free(model->Materials);
+    // only the GL objects and textures live outside of the arena
     for (int i = 0; i < model->MeshCount; i++) {
+        assetRelease(model->Meshes[i]->Handle);
         meshFree(model->Meshes[i]);
     }
-    free(model->Meshes);
     for (int i = 0; i < model->TextureCount; i++) {
         textureFree(model->Textures[i]);
     }
-    free(model->Textures);
-    for (int i = 0; i < model->AnimationCount; i++) {
-        animationFree(model->Animations[i]);
-    }
-    free(model->Animations);
-    free(model);
+    glDeleteBuffers(1, &model->SharedBuffer);
+    glDeleteBuffers(1, &model->BoneBuffer);
+    arenaFree(model->Arena);
 }
 void _modelFreeMaterials(void *_model) {
     Model *model = (Model *)_model;
@@ -132,11 +389,199 @@ void _modelFreeMaterials(void *_model) {
         materialFree(model->Materials[i]);
     }
 }
+Model *modelFindLoaded(const char *modelFilename) {
+    return assetGet(assetFind(ASSETTYPE_MODEL, modelFilename),
+                    ASSETTYPE_MODEL);
+}
+void modelRegister(Model *model, const char *modelFilename) {
+    model->Handle =
+        assetRegister(ASSETTYPE_MODEL, modelFilename, model, modelDeleteAsset);
+    size_t length = strlen(modelFilename) + 16;
+    char *meshName = malloc(length);
+    for (int i = 0; i < model->MeshCount; i++) {
+        snprintf(meshName, length, "%s#%d", modelFilename, i);
+        model->Meshes[i]->Handle =
+            assetRegister(ASSETTYPE_MESH, meshName, model->Meshes[i], NULL);
+    }
+    free(meshName);
+}
+// called by the registry once the last reference is gone
+void modelDeleteAsset(void *_model) {
+    Model *model = (Model *)_model;
+    (model->OnDelete)(model);
+}
+Model *_modelCreate(size_t arenaSize) {
+    struct Arena *arena = arenaCreate(arenaSize);
+    Model *model = arenaCalloc(arena, sizeof(Model));
+    model->Arena = arena;
+    model->WorldFromModel = GLMS_MAT4_IDENTITY;
+    model->SharedBuffer = 0;
+    model->OnDelete = &_modelDelete;
+    return model;
+}
+void _modelFlattenNodes(struct Arena *arena, struct Node *rootNode,
+                        const char *const *keepNames, int keepCount) {
+    if (!ModelFlattenEnabled)
+        return;
+    int countBefore = nodeChildCount(rootNode) + 1;
+    // every node that is left is in exactly one list of children, so the
+    // lists fit one after another in one array
+    struct Node **children =
+        arenaAlloc(arena, countBefore * sizeof(struct Node *));
+    int childCount = 0;
+    flattenNodeChildren(rootNode, children, &childCount, keepNames,
+                        keepCount);
+    printf("flattened nodes below \'%s\': %d -> %d\n", rootNode->Name,
+           countBefore, childCount + 1);
+}
+void _modelSetNodes(Model *model, struct Node *rootNode) {
+    model->NodeCount = nodeChildCount(rootNode) + 1; // +1 for root node
+    model->NodeEntries =
+        arenaAlloc(model->Arena, model->NodeCount * sizeof(struct NodeEntry));
+    int index = 0;
+    processNodeArray(model->NodeEntries, rootNode, &index, -1);
+    _modelSetTransforms(model);
+}
+void _modelSetTransforms(Model *model) {
+    int *parents = arenaAlloc(model->Arena, model->NodeCount * sizeof(int));
+    for (int i = 0; i < model->NodeCount; i++) {
+        parents[i] = model->NodeEntries[i].ParentIndex;
+    }
+    transformCreate(model->Arena, &model->Transforms, model->NodeCount,
+                    parents);
+    for (int i = 0; i < model->NodeCount; i++) {
+        struct Node *node = model->NodeEntries[i].Node;
+        transformSetLocal(&model->Transforms, i, node->Local);
+        node->Transforms = &model->Transforms;
+    }
+}
+void _modelUploadBones(Model *model, const mat4s *worldFromLocal,
+                       size_t stride) {
+    if (model->BoneCount == 0)
+        return;
+    // the range of bones that moved, meshes using none of them keep what
+    // `skinningUpdate` made last time
+    int firstChanged = model->BoneCount, lastChanged = -1;
+    const mat4s *nodeWorldFromLocal[MODEL_BONE_BLOCK];
+    const mat4s *boneFromMesh[MODEL_BONE_BLOCK];
+    mat4s worldFromMesh[MODEL_BONE_BLOCK];
+    for (int first = 0; first < model->BoneCount; first += MODEL_BONE_BLOCK) {
+        int blockCount = model->BoneCount - first < MODEL_BONE_BLOCK
+                             ? model->BoneCount - first
+                             : MODEL_BONE_BLOCK;
+        for (int j = 0; j < blockCount; j++) {
+            struct ModelBone *bone = &model->Bones[first + j];
+            nodeWorldFromLocal[j] =
+                (const mat4s *)((const char *)worldFromLocal +
+                                bone->NodeIndex * stride);
+            boneFromMesh[j] = &bone->BoneFromMesh;
+        }
+        transformBatchMul(nodeWorldFromLocal, boneFromMesh, worldFromMesh,
+                          blockCount);
+        for (int j = 0; j < blockCount; j++) {
+            int i = first + j;
+            if (model->BoneBuffer != 0 &&
+                memcmp(&worldFromMesh[j], &model->BonePalette[i],
+                       sizeof(mat4s)) == 0)
+                continue;
+            model->BonePalette[i] = worldFromMesh[j];
+            if (i < firstChanged)
+                firstChanged = i;
+            lastChanged = i;
+        }
+    }
+
+    if (model->BoneBuffer == 0)
+        glGenBuffers(1, &model->BoneBuffer);
+    if (lastChanged >= 0) {
+        for (int i = 0; i < model->MeshCount; i++) {
+            struct Mesh *mesh = model->Meshes[i];
+            if (mesh->BoneCount > 0 && mesh->BoneOffset <= lastChanged &&
+                mesh->BoneOffset + mesh->BoneCount > firstChanged)
+                mesh->SkinnedDirty = true;
+        }
+        // a new store every time, so the upload doesn't wait on draws that
+        // still read the last one
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, model->BoneBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER,
+                     model->BoneCount * sizeof(mat4s), model->BonePalette,
+                     GL_STREAM_DRAW);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_BONE_BINDING,
+                     model->BoneBuffer);
+}
+
+// has to add up to what `processMesh`, `processNode`, `processBones`,
+// `animationCreate`, `_modelFlattenNodes` and `_modelSetNodes` take from the
+// arena. compressed animations take less than this
+size_t modelArenaSize(const struct aiScene *scene) {
+    size_t size = ARENA_SIZE(sizeof(Model));
+
+    size += ARENA_SIZE(scene->mNumMeshes * sizeof(struct Mesh *));
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        const struct aiMesh *mesh = scene->mMeshes[i];
+        size += ARENA_SIZE(sizeof(struct Mesh));
+        size += ARENA_SIZE(mesh->mNumVertices * sizeof(struct Vertex));
+        size += ARENA_SIZE(mesh->mNumFaces * 3 * sizeof(uint32_t));
+        if (MeshletsEnabled && mesh->mNumFaces >= MESHLET_MIN_MESH_TRIANGLES)
+            size += ARENA_SIZE(MESHLET_MAX_COUNT(mesh->mNumFaces) *
+                               sizeof(struct Meshlet));
+        if (mesh->mNumAnimMeshes > 0) {
+            size += ARENA_SIZE((mesh->mNumAnimMeshes + 1) * sizeof(int));
+            size += ARENA_SIZE(processMorphDeltaCount(mesh) *
+                               sizeof(struct MorphDelta));
+            size += ARENA_SIZE(mesh->mNumAnimMeshes * sizeof(float));
+        }
+    }
+    int boneCount = 0;
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        boneCount += processBoneCount(scene->mMeshes[i]);
+    }
+    size += ARENA_SIZE(boneCount * sizeof(struct ModelBone));
+    size += ARENA_SIZE(boneCount * sizeof(mat4s));
+    size += ARENA_SIZE(scene->mNumMaterials * sizeof(Material *));
+    size += ARENA_SIZE(scene->mNumTextures * sizeof(Texture *));
 
-struct Mesh *processMesh(struct aiMesh *mesh, const struct aiScene *scene) {
+    int nodeCount = 0;
+    size += nodeArenaSize(scene->mRootNode, &nodeCount);
+    size += ARENA_SIZE(nodeCount * sizeof(struct Node *));
+    size += ARENA_SIZE(nodeCount * sizeof(struct NodeEntry));
+    size += ARENA_SIZE(nodeCount * sizeof(int));
+    size += transformArenaSize(nodeCount);
+
+    size += ARENA_SIZE(scene->mNumAnimations * sizeof(Animation *));
+    for (int i = 0; i < scene->mNumAnimations; i++) {
+        const struct aiAnimation *animation = scene->mAnimations[i];
+        size += ARENA_SIZE(sizeof(Animation));
+        size += ARENA_SIZE(animation->mName.length + 1);
+        size += ARENA_SIZE(animation->mNumChannels * sizeof(AnimationNode));
+        for (int j = 0; j < animation->mNumChannels; j++) {
+            const struct aiNodeAnim *channel = animation->mChannels[j];
+            size += animationNodeArenaSize(channel->mNumPositionKeys,
+                                           channel->mNumRotationKeys,
+                                           channel->mNumScalingKeys);
+        }
+        size += animationMorphArenaSize(animation);
+    }
+    return size;
+}
+size_t nodeArenaSize(const struct aiNode *node, int *nodeCount) {
+    (*nodeCount)++;
+    size_t size = ARENA_SIZE(sizeof(struct Node));
+    size += ARENA_SIZE(node->mNumChildren * sizeof(struct Node *));
+    size += ARENA_SIZE(node->mNumMeshes * sizeof(int));
+    size += ARENA_SIZE(node->mName.length + 1);
+    for (int i = 0; i < node->mNumChildren; i++) {
+        size += nodeArenaSize(node->mChildren[i], nodeCount);
+    }
+    return size;
+}
+struct Mesh *processMesh(struct Arena *arena, struct aiMesh *mesh,
+                         const struct aiScene *scene) {
     struct Vertex *vertices =
-        malloc(mesh->mNumVertices * sizeof(struct Vertex));
-    uint32_t *indices = malloc(mesh->mNumFaces * 3 * sizeof(uint32_t));
+        arenaAlloc(arena, mesh->mNumVertices * sizeof(struct Vertex));
+    uint32_t *indices =
+        arenaAlloc(arena, mesh->mNumFaces * 3 * sizeof(uint32_t));
     for (int i = 0; i < mesh->mNumVertices; i++) {
         struct Vertex v = {0};
 
@@ -159,6 +604,35 @@ struct Mesh *processMesh(struct aiMesh *mesh, const struct aiScene *scene) {
             v.Color = GLMS_VEC3_ONE;
         vertices[i] = v;
     }
+    // each vertex keeps its heaviest four, `aiProcess_LimitBoneWeights`
+    // has mostly done that already
+    int boneCount = processBoneCount(mesh);
+    if (boneCount < mesh->mNumBones)
+        printf("mesh \"%s\" has %d bones, only the first %d are used\n",
+               mesh->mName.data, mesh->mNumBones, boneCount);
+    for (int i = 0; i < boneCount; i++) {
+        struct aiBone *bone = mesh->mBones[i];
+        for (int j = 0; j < bone->mNumWeights; j++) {
+            struct Vertex *vertex = &vertices[bone->mWeights[j].mVertexId];
+            float weight = bone->mWeights[j].mWeight;
+            int lightest = 0;
+            for (int k = 1; k < 4; k++) {
+                if (vertex->Weights[k] < vertex->Weights[lightest])
+                    lightest = k;
+            }
+            if (weight > vertex->Weights[lightest]) {
+                vertex->Joints[lightest] = i;
+                vertex->Weights[lightest] = weight;
+            }
+        }
+    }
+    for (int i = 0; boneCount > 0 && i < mesh->mNumVertices; i++) {
+        float *weights = vertices[i].Weights;
+        float sum = weights[0] + weights[1] + weights[2] + weights[3];
+        for (int k = 0; sum > 0 && k < 4; k++) {
+            weights[k] /= sum;
+        }
+    }
     for (int i = 0; i < mesh->mNumFaces; i++) {
         struct aiFace face = mesh->mFaces[i];
         for (int j = 0; j < 3; j++) {
@@ -166,12 +640,130 @@ struct Mesh *processMesh(struct aiMesh *mesh, const struct aiScene *scene) {
         }
     }
 
+    int vertexCount = mesh->mNumVertices;
+    // morph targets are stored by vertex index, so they stay in order
+    if (MeshOptimizeEnabled && mesh->mNumAnimMeshes == 0) {
+        struct MeshOptimizeStats stats;
+        // the arena space left over past `vertexCount` is not reused
+        vertexCount = meshOptimize(vertices, vertexCount, indices,
+                                   mesh->mNumFaces * 3, &stats);
+        meshOptimizePrintStats(mesh->mName.data, &stats);
+    }
+
     struct Mesh *newMesh =
-        meshLoad(vertices, indices, mesh->mNumVertices, mesh->mNumFaces * 3);
+        meshLoad(arena, vertices, indices, vertexCount, mesh->mNumFaces * 3);
     newMesh->MaterialIndex = mesh->mMaterialIndex;
+    if (mesh->mNumAnimMeshes > 0)
+        processMorphTargets(arena, newMesh, mesh);
+    if (MeshletsEnabled)
+        meshletBuild(arena, newMesh);
     return newMesh;
 }
+// vertices moved by each of the mesh's morph targets, added up
+int processMorphDeltaCount(const struct aiMesh *mesh) {
+    int count = 0;
+    for (int i = 0; i < mesh->mNumAnimMeshes; i++) {
+        for (int j = 0; j < mesh->mNumVertices; j++) {
+            struct MorphDelta delta;
+            count += processMorphDelta(mesh, mesh->mAnimMeshes[i], j, &delta);
+        }
+    }
+    return count;
+}
+// assimp gives the targets as whole meshes, only the difference of the
+// vertices that move is kept
+void processMorphTargets(struct Arena *arena, struct Mesh *newMesh,
+                         const struct aiMesh *mesh) {
+    newMesh->MorphTargetCount = mesh->mNumAnimMeshes;
+    newMesh->MorphDeltaCount = processMorphDeltaCount(mesh);
+    newMesh->MorphTargetOffsets =
+        arenaAlloc(arena, (mesh->mNumAnimMeshes + 1) * sizeof(int));
+    newMesh->MorphDeltas = arenaAlloc(
+        arena, newMesh->MorphDeltaCount * sizeof(struct MorphDelta));
+    newMesh->MorphWeights =
+        arenaAlloc(arena, mesh->mNumAnimMeshes * sizeof(float));
+
+    int deltaCount = 0;
+    for (int i = 0; i < mesh->mNumAnimMeshes; i++) {
+        const struct aiAnimMesh *target = mesh->mAnimMeshes[i];
+        newMesh->MorphTargetOffsets[i] = deltaCount;
+        newMesh->MorphWeights[i] = target->mWeight;
+        for (int j = 0; j < mesh->mNumVertices; j++) {
+            struct MorphDelta delta;
+            if (processMorphDelta(mesh, target, j, &delta))
+                newMesh->MorphDeltas[deltaCount++] = delta;
+        }
+    }
+    newMesh->MorphTargetOffsets[mesh->mNumAnimMeshes] = deltaCount;
 
+    size_t dense = (size_t)mesh->mNumAnimMeshes * mesh->mNumVertices *
+                   2 * sizeof(vec3s);
+    printf("morph targets of mesh \"%s\": %d targets, %d of %d vertices "
+           "move, %zu bytes (%zu with every vertex)\n",
+           mesh->mName.data, mesh->mNumAnimMeshes, deltaCount,
+           mesh->mNumAnimMeshes * mesh->mNumVertices,
+           deltaCount * sizeof(struct MorphDelta), dense);
+}
+// fills `delta` with how far `target` moves the vertex, returns whether it
+// moves it at all
+bool processMorphDelta(const struct aiMesh *mesh,
+                       const struct aiAnimMesh *target, int vertex,
+                       struct MorphDelta *delta) {
+    *delta = (struct MorphDelta){.Vertex = vertex};
+    if (target->mVertices != NULL) {
+        struct aiVector3D from = mesh->mVertices[vertex];
+        struct aiVector3D to = target->mVertices[vertex];
+        delta->Position =
+            (vec3s){{to.x - from.x, to.y - from.y, to.z - from.z}};
+    }
+    if (target->mNormals != NULL && mesh->mNormals != NULL) {
+        struct aiVector3D from = mesh->mNormals[vertex];
+        struct aiVector3D to = target->mNormals[vertex];
+        delta->Normal =
+            (vec3s){{to.x - from.x, to.y - from.y, to.z - from.z}};
+    }
+    for (int i = 0; i < 3; i++) {
+        if (fabsf(delta->Position.raw[i]) > MESH_MORPH_EPSILON ||
+            fabsf(delta->Normal.raw[i]) > MESH_MORPH_EPSILON)
+            return true;
+    }
+    return false;
+}
+
+int processBoneCount(const struct aiMesh *mesh) {
+    return mesh->mNumBones < MESH_MAX_BONES ? mesh->mNumBones
+                                            : MESH_MAX_BONES;
+}
+// after the nodes, which the bones point at
+void processBones(Model *model, const struct aiScene *scene) {
+    model->BoneCount = 0;
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        model->BoneCount += processBoneCount(scene->mMeshes[i]);
+    }
+    model->Bones =
+        arenaAlloc(model->Arena, model->BoneCount * sizeof(struct ModelBone));
+    model->BonePalette =
+        arenaAlloc(model->Arena, model->BoneCount * sizeof(mat4s));
+
+    struct Node *rootNode = model->NodeEntries[0].Node;
+    int boneIndex = 0;
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        const struct aiMesh *aiMesh = scene->mMeshes[i];
+        struct Mesh *mesh = model->Meshes[i];
+        mesh->BoneOffset = boneIndex;
+        mesh->BoneCount = processBoneCount(aiMesh);
+        for (int j = 0; j < mesh->BoneCount; j++) {
+            struct aiBone *aiBone = aiMesh->mBones[j];
+            struct ModelBone *bone = &model->Bones[boneIndex++];
+            struct Node *node = searchForNode(aiBone->mName.data, rootNode);
+            if (node == NULL)
+                printf("bone \"%s\" has no node, it stays at the root\n",
+                       aiBone->mName.data);
+            bone->NodeIndex = node != NULL ? node->Index : 0;
+            bone->BoneFromMesh = aiMatrixToGLMS(aiBone->mOffsetMatrix);
+        }
+    }
+}
 mat4s aiMatrixToGLMS(struct aiMatrix4x4 aiMat) {
     mat4s mat;
     mat.raw[0][0] = aiMat.a1;
@@ -192,33 +784,114 @@ mat4s aiMatrixToGLMS(struct aiMatrix4x4 aiMat) {
     mat.raw[3][3] = aiMat.d4;
     return mat;
 }
-struct Node *processNode(struct aiNode *node, struct Node *parentNode) {
+struct Node *processNode(struct Arena *arena, struct aiNode *node,
+                         struct Node *parentNode) {
     if (parentNode == NULL) {
         printf("Root node is \'%s\'\n", node->mName.data);
     }
-    struct Node *newNode = nodeCreate(parentNode, node->mNumChildren);
-    newNode->ParentFromLocal = aiMatrixToGLMS(node->mTransformation);
+    struct Node *newNode = nodeCreate(arena, parentNode, node->mNumChildren);
+    newNode->Local = transformDecompose(aiMatrixToGLMS(node->mTransformation));
     newNode->MeshCount = node->mNumMeshes;
-    newNode->Meshes = malloc(node->mNumMeshes * sizeof(uint32_t));
-    memcpy(newNode->Meshes, node->mMeshes, node->mNumMeshes * sizeof(uint32_t));
-    newNode->Name = malloc(node->mName.length * sizeof(char) + 1);
-    strcpy(newNode->Name, node->mName.data);
+    newNode->Meshes = arenaAlloc(arena, node->mNumMeshes * sizeof(int));
+    memcpy(newNode->Meshes, node->mMeshes, node->mNumMeshes * sizeof(int));
+    newNode->Name = arenaCopyString(arena, node->mName.data);
     for (int i = 0; i < node->mNumChildren; i++) {
-        newNode->Children[i] = processNode(node->mChildren[i], newNode);
+        newNode->Children[i] = processNode(arena, node->mChildren[i], newNode);
     }
     return newNode;
 }
+// names of the nodes bones and animation channels are matched to
+const char **processKeptNodeNames(const struct aiScene *scene, int *count) {
+    int capacity = 0;
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        capacity += scene->mMeshes[i]->mNumBones;
+    }
+    for (int i = 0; i < scene->mNumAnimations; i++) {
+        capacity += scene->mAnimations[i]->mNumChannels +
+                    scene->mAnimations[i]->mNumMorphMeshChannels;
+    }
+    const char **names = malloc(capacity * sizeof(char *));
+    *count = 0;
+    for (int i = 0; i < scene->mNumMeshes; i++) {
+        const struct aiMesh *mesh = scene->mMeshes[i];
+        for (int j = 0; j < mesh->mNumBones; j++) {
+            names[(*count)++] = mesh->mBones[j]->mName.data;
+        }
+    }
+    for (int i = 0; i < scene->mNumAnimations; i++) {
+        const struct aiAnimation *animation = scene->mAnimations[i];
+        for (int j = 0; j < animation->mNumChannels; j++) {
+            names[(*count)++] = animation->mChannels[j]->mNodeName.data;
+        }
+        for (int j = 0; j < animation->mNumMorphMeshChannels; j++) {
+            names[(*count)++] = animation->mMorphMeshChannels[j]->mName.data;
+        }
+    }
+    return names;
+}
+// replaces the children of `node` with what's left of them once the ones
+// that can be are folded away, then does the same below each of those
+void flattenNodeChildren(struct Node *node, struct Node **children,
+                         int *childCount, const char *const *keepNames,
+                         int keepCount) {
+    struct Node **nodeChildren = &children[*childCount];
+    for (int i = 0; i < node->ChildCount; i++) {
+        flattenNodeInto(node, node->Children[i], children, childCount,
+                        keepNames, keepCount);
+    }
+    node->ChildCount = &children[*childCount] - nodeChildren;
+    node->Children = nodeChildren;
+    for (int i = 0; i < node->ChildCount; i++) {
+        flattenNodeChildren(node->Children[i], children, childCount,
+                            keepNames, keepCount);
+    }
+}
+// adds `node` to the children of `parent`, or its own children in its place
+// when it's folded into them. whole chains of static nodes go at once
+void flattenNodeInto(struct Node *parent, struct Node *node,
+                     struct Node **children, int *childCount,
+                     const char *const *keepNames, int keepCount) {
+    if (!flattenNodeFoldable(node, keepNames, keepCount)) {
+        node->Parent = parent;
+        children[(*childCount)++] = node;
+        return;
+    }
+    for (int i = 0; i < node->ChildCount; i++) {
+        struct Node *child = node->Children[i];
+        child->Local = transformCombine(node->Local, child->Local);
+        flattenNodeInto(parent, child, children, childCount, keepNames,
+                        keepCount);
+    }
+}
+bool flattenNodeFoldable(struct Node *node, const char *const *keepNames,
+                         int keepCount) {
+    if (node->MeshCount > 0 || node->ChildCount == 0 ||
+        flattenNodeKept(node, keepNames, keepCount))
+        return false;
+    for (int i = 0; i < node->ChildCount; i++) {
+        struct Node *child = node->Children[i];
+        // an animation would write over the folded local transform with one
+        // that is relative to this node again
+        if (flattenNodeKept(child, keepNames, keepCount) ||
+            !transformCanCombine(node->Local, child->Local))
+            return false;
+    }
+    return true;
+}
+bool flattenNodeKept(struct Node *node, const char *const *keepNames,
+                     int keepCount) {
+    for (int i = 0; i < keepCount; i++) {
+        if (!strcmp(node->Name, keepNames[i]))
+            return true;
+    }
+    return false;
+}
 void processNodeArray(struct NodeEntry *nodeArray, struct Node *rootNode,
                       int *indexPtr, int parentIndex) {
     int index = (*indexPtr)++;
     nodeArray[index].Node = rootNode;
     nodeArray[index].ParentIndex = parentIndex;
-
-    if (parentIndex == -1)
-        nodeArray[index].WorldFromLocal = GLMS_MAT4_IDENTITY;
-    else
-        nodeArray[index].WorldFromLocal = glms_mat4_mul(
-            nodeArray[parentIndex].WorldFromLocal, rootNode->ParentFromLocal);
+    rootNode->Index = index;
 
     for (int i = 0; i < rootNode->ChildCount; i++) {
         processNodeArray(nodeArray, rootNode->Children[i], indexPtr, index);
@@ -0,0 +1,910 @@
+#include "model_cache.h"
+
+#include "animation.h"
+#include "animation_compress.h"
+#include "mesh.h"
+#include "mesh_optimize.h"
+#include "meshlet.h"
+#include "node.h"
+#include "texture.h"
+#include "upload_queue.h"
+
+#include <cglm/struct/mat4.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "MDLCOOK"
+/// bump whenever the layout of the file or of `struct Vertex` changes, or
+/// when import produces different data
+#define CACHE_VERSION 10
+
+bool ModelCacheEnabled = true;
+
+// all offsets are in bytes from the start of the file
+struct CacheHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t VertexSize;
+    uint64_t SourceHash;
+    int64_t SourceModifiedTime; // in nanoseconds
+    uint64_t SourceSize;
+    uint32_t MeshCount;
+    uint32_t MaterialCount;
+    uint32_t TextureCount;
+    uint32_t NodeCount;
+    uint32_t AnimationCount;
+    /// `AnimationCompressTolerance` the animations were compressed with, 0
+    /// when they weren't
+    float AnimationTolerance;
+    uint32_t BoneCount;
+    /// `ModelFlattenEnabled` the nodes were imported with
+    uint32_t NodesFlattened;
+    /// `MeshOptimizeEnabled` and `MeshletsEnabled` the meshes were imported
+    /// with
+    uint32_t MeshesOptimized;
+    uint32_t MeshletsBuilt;
+    uint64_t MeshTableOffset;
+    uint64_t TextureTableOffset;
+    uint64_t NodeTableOffset;
+    uint64_t AnimationTableOffset;
+    uint64_t BoneTableOffset;
+};
+struct CacheMesh {
+    uint32_t VertexCount;
+    uint32_t IndexCount;
+    int32_t MaterialIndex;
+    uint32_t BoneOffset;
+    uint32_t BoneCount;
+    uint32_t _padding;
+    uint64_t VertexOffset;
+    uint64_t IndexOffset;
+};
+struct CacheBone {
+    mat4s BoneFromMesh;
+    int32_t NodeIndex;
+    uint32_t _padding[3];
+};
+struct CacheTexture {
+    uint64_t NameOffset;
+};
+/// nodes are stored in the same order as `Model::NodeEntries`, so parents
+/// always come before their children
+struct CacheNode {
+    TransformLocal Local;
+    int32_t ParentIndex;
+    uint32_t ChildCount;
+    uint32_t MeshCount;
+    uint32_t _padding;
+    uint64_t MeshesOffset;
+    uint64_t NameOffset;
+};
+struct CacheAnimation {
+    uint64_t NameOffset;
+    int32_t Duration;
+    int32_t TicksPerSec;
+    uint32_t ChannelCount;
+    uint32_t _padding;
+    uint64_t ChannelsOffset;
+};
+enum CacheInterpolation {
+    CACHEINTERP_STEP,
+    CACHEINTERP_LINEAR,
+    CACHEINTERP_SMOOTHSTEP,
+};
+enum CachePacked {
+    CACHEPACKED_POSITIONS = 1 << 0,
+    CACHEPACKED_ROTATIONS = 1 << 1,
+    CACHEPACKED_SCALINGS = 1 << 2,
+};
+struct CacheChannel {
+    int32_t NodeIndex;
+    /// `CACHEINTERP_*` of each track
+    int32_t PositionInterpolation, RotationInterpolation, ScalingInterpolation;
+    uint32_t PositionKeyCount;
+    uint32_t RotationKeyCount;
+    uint32_t ScalingKeyCount;
+    /// `CACHEPACKED_*` bits of the tracks whose values are the `Keys` of an
+    /// `AnimationPackedTrack` instead of floats
+    uint32_t Packed;
+    /// key times and values are stored separately, like in `AnimationNode`
+    uint64_t PositionTimesOffset, PositionValuesOffset;
+    uint64_t RotationTimesOffset, RotationValuesOffset;
+    uint64_t ScalingTimesOffset, ScalingValuesOffset;
+    /// `Min` and `Extent` of packed tracks
+    vec3s PositionRange[2], ScalingRange[2];
+};
+
+/// the mapping has to outlive the mesh uploads that read from it
+struct CacheMapping {
+    uint8_t *Data;
+    size_t Size;
+    Model *Model;
+};
+
+struct CacheWriter {
+    uint8_t *Data;
+    size_t Size;
+    size_t Capacity;
+};
+uint64_t cacheWriterPush(struct CacheWriter *writer, const void *data,
+                         size_t size, size_t alignment);
+uint64_t cacheWriterPushString(struct CacheWriter *writer, const char *string);
+
+char *cacheGetPath(const char *modelFile);
+uint64_t cacheHashFile(const char *path, size_t size);
+int64_t cacheModifiedTime(struct stat *fileStat);
+bool cacheInBounds(size_t fileSize, uint64_t offset, uint64_t size);
+bool cacheArrayInBounds(size_t fileSize, uint64_t offset, uint64_t count,
+                        size_t elementSize, size_t alignment);
+bool cacheStringInBounds(const uint8_t *data, size_t fileSize,
+                         uint64_t offset);
+float cacheAnimationTolerance(void);
+int32_t cacheInterpolationWrite(enum AnimationInterpolation interpolation);
+enum AnimationInterpolation cacheInterpolationRead(int32_t interpolation);
+bool cacheCheckModel(const uint8_t *data, size_t size);
+bool cacheCheckChannel(const struct CacheChannel *channel, size_t size,
+                       uint32_t nodeCount);
+Model *cacheBuildModel(const uint8_t *data, size_t size);
+void cacheReadChannel(struct Arena *arena, AnimationNode *animNode,
+                      const struct CacheChannel *channel, const uint8_t *data);
+void *cacheReadTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                     bool isPacked, const uint8_t *values, int keyCount,
+                     size_t valueSize);
+void cacheRelease(void *_mapping);
+
+Model *modelCacheLoad(const char *modelFile) {
+    struct stat sourceStat;
+    if (stat(modelFile, &sourceStat) != 0)
+        return NULL;
+
+    char *cacheFile = cacheGetPath(modelFile);
+    int fd = open(cacheFile, O_RDONLY);
+    if (fd == -1) {
+        free(cacheFile);
+        return NULL;
+    }
+    struct stat cacheStat;
+    if (fstat(fd, &cacheStat) != 0 ||
+        cacheStat.st_size < sizeof(struct CacheHeader)) {
+        close(fd);
+        free(cacheFile);
+        return NULL;
+    }
+    size_t cacheSize = cacheStat.st_size;
+    uint8_t *data = mmap(NULL, cacheSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        free(cacheFile);
+        return NULL;
+    }
+
+    const struct CacheHeader *header = (const struct CacheHeader *)data;
+    if (memcmp(header->Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header->Version != CACHE_VERSION ||
+        header->VertexSize != sizeof(struct Vertex)) {
+        printf("cooked model \"%s\" is from another version, recooking\n",
+               cacheFile);
+        munmap(data, cacheSize);
+        free(cacheFile);
+        return NULL;
+    }
+    if (header->AnimationTolerance != cacheAnimationTolerance()) {
+        printf("cooked model \"%s\" has other animation compression, "
+               "recooking\n",
+               cacheFile);
+        munmap(data, cacheSize);
+        free(cacheFile);
+        return NULL;
+    }
+    if (header->NodesFlattened != ModelFlattenEnabled) {
+        printf("cooked model \"%s\" has other node flattening, recooking\n",
+               cacheFile);
+        munmap(data, cacheSize);
+        free(cacheFile);
+        return NULL;
+    }
+    if (header->MeshesOptimized != MeshOptimizeEnabled ||
+        header->MeshletsBuilt != MeshletsEnabled) {
+        printf("cooked model \"%s\" has other mesh processing, recooking\n",
+               cacheFile);
+        munmap(data, cacheSize);
+        free(cacheFile);
+        return NULL;
+    }
+
+    // mtime and size are only a quick check, if they don't match the source
+    // may still be the same (e.g. after a fresh checkout) so compare contents
+    int64_t sourceModifiedTime = cacheModifiedTime(&sourceStat);
+    if (header->SourceModifiedTime != sourceModifiedTime ||
+        header->SourceSize != sourceStat.st_size) {
+        if (header->SourceSize != sourceStat.st_size ||
+            header->SourceHash !=
+                cacheHashFile(modelFile, sourceStat.st_size)) {
+            munmap(data, cacheSize);
+            free(cacheFile);
+            return NULL;
+        }
+        // same contents, store the new mtime so the next load skips hashing
+        FILE *file = fopen(cacheFile, "r+b");
+        if (file != NULL) {
+            fseek(file, offsetof(struct CacheHeader, SourceModifiedTime),
+                  SEEK_SET);
+            fwrite(&sourceModifiedTime, sizeof(int64_t), 1, file);
+            fclose(file);
+        }
+    }
+
+    Model *model = cacheBuildModel(data, cacheSize);
+    if (model == NULL) {
+        fprintf(stderr, "cooked model \"%s\" is corrupt, recooking\n",
+                cacheFile);
+        munmap(data, cacheSize);
+    } else {
+        printf("loaded cooked model \"%s\"\n", cacheFile);
+        struct CacheMapping *mapping = malloc(sizeof(struct CacheMapping));
+        *mapping = (struct CacheMapping){
+            .Data = data,
+            .Size = cacheSize,
+            .Model = model,
+        };
+        uploadQueuePush(cacheRelease, mapping, 0);
+    }
+
+    free(cacheFile);
+    return model;
+}
+
+void modelCacheWrite(const char *modelFile, Model *model,
+                     const char *const *textureNames) {
+    struct stat sourceStat;
+    if (stat(modelFile, &sourceStat) != 0)
+        return;
+    for (int i = 0; i < model->MeshCount; i++) {
+        if (model->Meshes[i]->MorphTargetCount > 0) {
+            printf("not caching `%s`, morph targets aren't stored\n",
+                   modelFile);
+            return;
+        }
+    }
+
+    struct CacheWriter writer = {0};
+    struct CacheHeader header = {
+        .Version = CACHE_VERSION,
+        .VertexSize = sizeof(struct Vertex),
+        .SourceHash = cacheHashFile(modelFile, sourceStat.st_size),
+        .SourceModifiedTime = cacheModifiedTime(&sourceStat),
+        .SourceSize = sourceStat.st_size,
+        .MeshCount = model->MeshCount,
+        .MaterialCount = model->MaterialCount,
+        .TextureCount = model->TextureCount,
+        .NodeCount = model->NodeCount,
+        .AnimationCount = model->AnimationCount,
+        .AnimationTolerance = cacheAnimationTolerance(),
+        .BoneCount = model->BoneCount,
+        .NodesFlattened = ModelFlattenEnabled,
+        .MeshesOptimized = MeshOptimizeEnabled,
+        .MeshletsBuilt = MeshletsEnabled,
+    };
+    memcpy(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    cacheWriterPush(&writer, NULL, sizeof(header), 16);
+
+    uint64_t meshTable = cacheWriterPush(
+        &writer, NULL, model->MeshCount * sizeof(struct CacheMesh), 16);
+    uint64_t textureTable = cacheWriterPush(
+        &writer, NULL, model->TextureCount * sizeof(struct CacheTexture), 16);
+    uint64_t nodeTable = cacheWriterPush(
+        &writer, NULL, model->NodeCount * sizeof(struct CacheNode),
+        _Alignof(struct CacheNode));
+    uint64_t animationTable = cacheWriterPush(
+        &writer, NULL, model->AnimationCount * sizeof(struct CacheAnimation),
+        16);
+    header.MeshTableOffset = meshTable;
+    header.TextureTableOffset = textureTable;
+    header.NodeTableOffset = nodeTable;
+    uint64_t boneTable = cacheWriterPush(
+        &writer, NULL, model->BoneCount * sizeof(struct CacheBone),
+        _Alignof(struct CacheBone));
+    header.AnimationTableOffset = animationTable;
+    header.BoneTableOffset = boneTable;
+    memcpy(writer.Data, &header, sizeof(header));
+
+    for (int i = 0; i < model->MeshCount; i++) {
+        struct Mesh *mesh = model->Meshes[i];
+        struct CacheMesh cacheMesh = {
+            .VertexCount = mesh->VertexCount,
+            .IndexCount = mesh->IndexCount,
+            .MaterialIndex = mesh->MaterialIndex,
+            .BoneOffset = mesh->BoneOffset,
+            .BoneCount = mesh->BoneCount,
+        };
+        cacheMesh.VertexOffset =
+            cacheWriterPush(&writer, mesh->Vertices,
+                            mesh->VertexCount * sizeof(struct Vertex), 16);
+        cacheMesh.IndexOffset = cacheWriterPush(
+            &writer, mesh->Indices, mesh->IndexCount * sizeof(uint32_t), 16);
+        memcpy(writer.Data + meshTable + i * sizeof(struct CacheMesh),
+               &cacheMesh, sizeof(cacheMesh));
+    }
+    for (int i = 0; i < model->TextureCount; i++) {
+        struct CacheTexture cacheTexture = {
+            .NameOffset = cacheWriterPushString(&writer, textureNames[i]),
+        };
+        memcpy(writer.Data + textureTable + i * sizeof(struct CacheTexture),
+               &cacheTexture, sizeof(cacheTexture));
+    }
+    for (int i = 0; i < model->NodeCount; i++) {
+        struct NodeEntry *nodeEntry = &model->NodeEntries[i];
+        struct Node *node = nodeEntry->Node;
+        struct CacheNode cacheNode = {
+            .Local = node->Local,
+            .ParentIndex = nodeEntry->ParentIndex,
+            .ChildCount = node->ChildCount,
+            .MeshCount = node->MeshCount,
+        };
+        cacheNode.MeshesOffset = cacheWriterPush(
+            &writer, node->Meshes, node->MeshCount * sizeof(int), 4);
+        cacheNode.NameOffset = cacheWriterPushString(&writer, node->Name);
+        memcpy(writer.Data + nodeTable + i * sizeof(struct CacheNode),
+               &cacheNode, sizeof(cacheNode));
+    }
+    for (int i = 0; i < model->BoneCount; i++) {
+        struct CacheBone cacheBone = {
+            .BoneFromMesh = model->Bones[i].BoneFromMesh,
+            .NodeIndex = model->Bones[i].NodeIndex,
+        };
+        memcpy(writer.Data + boneTable + i * sizeof(struct CacheBone),
+               &cacheBone, sizeof(cacheBone));
+    }
+    for (int i = 0; i < model->AnimationCount; i++) {
+        Animation *animation = model->Animations[i];
+        struct CacheAnimation cacheAnimation = {
+            .Duration = animation->Duration,
+            .TicksPerSec = animation->TicksPerSec,
+            .ChannelCount = animation->NodeCount,
+        };
+        cacheAnimation.NameOffset =
+            cacheWriterPushString(&writer, animation->Name);
+        cacheAnimation.ChannelsOffset = cacheWriterPush(
+            &writer, NULL, animation->NodeCount * sizeof(struct CacheChannel),
+            16);
+        for (int j = 0; j < animation->NodeCount; j++) {
+            AnimationNode *animNode = &animation->Nodes[j];
+            struct CacheChannel channel = {
+                .NodeIndex = -1,
+                .PositionInterpolation =
+                    cacheInterpolationWrite(animNode->PositionInterpolation),
+                .RotationInterpolation =
+                    cacheInterpolationWrite(animNode->RotationInterpolation),
+                .ScalingInterpolation =
+                    cacheInterpolationWrite(animNode->ScalingInterpolation),
+                .PositionKeyCount = animNode->PositionKeyCount,
+                .RotationKeyCount = animNode->RotationKeyCount,
+                .ScalingKeyCount = animNode->ScalingKeyCount,
+            };
+            for (int k = 0; k < model->NodeCount; k++) {
+                if (model->NodeEntries[k].Node == animNode->Node) {
+                    channel.NodeIndex = k;
+                    break;
+                }
+            }
+            channel.PositionTimesOffset = cacheWriterPush(
+                &writer, animNode->PositionTimes,
+                animNode->PositionKeyCount * sizeof(float), 16);
+            channel.RotationTimesOffset = cacheWriterPush(
+                &writer, animNode->RotationTimes,
+                animNode->RotationKeyCount * sizeof(float), 16);
+            channel.ScalingTimesOffset = cacheWriterPush(
+                &writer, animNode->ScalingTimes,
+                animNode->ScalingKeyCount * sizeof(float), 16);
+            if (animNode->PositionValues == NULL) {
+                channel.Packed |= CACHEPACKED_POSITIONS;
+                channel.PositionValuesOffset = cacheWriterPush(
+                    &writer, animNode->PackedPositions.Keys,
+                    animNode->PositionKeyCount * sizeof(uint16_t[3]), 16);
+                channel.PositionRange[0] = animNode->PackedPositions.Min;
+                channel.PositionRange[1] = animNode->PackedPositions.Extent;
+            } else
+                channel.PositionValuesOffset = cacheWriterPush(
+                    &writer, animNode->PositionValues,
+                    animNode->PositionKeyCount * sizeof(vec3s), 16);
+            if (animNode->RotationValues == NULL) {
+                channel.Packed |= CACHEPACKED_ROTATIONS;
+                channel.RotationValuesOffset = cacheWriterPush(
+                    &writer, animNode->PackedRotations.Keys,
+                    animNode->RotationKeyCount * sizeof(uint16_t[3]), 16);
+            } else
+                channel.RotationValuesOffset = cacheWriterPush(
+                    &writer, animNode->RotationValues,
+                    animNode->RotationKeyCount * sizeof(versors), 16);
+            if (animNode->ScalingValues == NULL) {
+                channel.Packed |= CACHEPACKED_SCALINGS;
+                channel.ScalingValuesOffset = cacheWriterPush(
+                    &writer, animNode->PackedScalings.Keys,
+                    animNode->ScalingKeyCount * sizeof(uint16_t[3]), 16);
+                channel.ScalingRange[0] = animNode->PackedScalings.Min;
+                channel.ScalingRange[1] = animNode->PackedScalings.Extent;
+            } else
+                channel.ScalingValuesOffset = cacheWriterPush(
+                    &writer, animNode->ScalingValues,
+                    animNode->ScalingKeyCount * sizeof(vec3s), 16);
+            memcpy(writer.Data + cacheAnimation.ChannelsOffset +
+                       j * sizeof(struct CacheChannel),
+                   &channel, sizeof(channel));
+        }
+        memcpy(writer.Data + animationTable +
+                   i * sizeof(struct CacheAnimation),
+               &cacheAnimation, sizeof(cacheAnimation));
+    }
+
+    // write to a temporary file first so a crash never leaves a half written
+    // cache behind
+    char *cacheFile = cacheGetPath(modelFile);
+    // models can be imported on several threads at once, so each one gets its
+    // own temporary file
+    char *tempFile = malloc(strlen(cacheFile) + 32);
+    sprintf(tempFile, "%s.%lx.tmp", cacheFile, (unsigned long)pthread_self());
+    FILE *file = fopen(tempFile, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "couldn't write cooked model \"%s\"\n", cacheFile);
+    } else {
+        size_t written = fwrite(writer.Data, 1, writer.Size, file);
+        fclose(file);
+        if (written != writer.Size || rename(tempFile, cacheFile) != 0) {
+            fprintf(stderr, "couldn't write cooked model \"%s\"\n", cacheFile);
+            remove(tempFile);
+        }
+    }
+
+    free(tempFile);
+    free(cacheFile);
+    free(writer.Data);
+}
+
+// every offset, count and index in the file is checked before anything is
+// built from it, so a truncated or corrupt cache is recooked instead of read
+// out of bounds
+bool cacheCheckModel(const uint8_t *data, size_t size) {
+    const struct CacheHeader *header = (const struct CacheHeader *)data;
+    if (header->NodeCount == 0 ||
+        !cacheArrayInBounds(size, header->MeshTableOffset, header->MeshCount,
+                            sizeof(struct CacheMesh),
+                            _Alignof(struct CacheMesh)) ||
+        !cacheArrayInBounds(size, header->TextureTableOffset,
+                            header->TextureCount, sizeof(struct CacheTexture),
+                            _Alignof(struct CacheTexture)) ||
+        !cacheArrayInBounds(size, header->NodeTableOffset, header->NodeCount,
+                            sizeof(struct CacheNode),
+                            _Alignof(struct CacheNode)) ||
+        !cacheArrayInBounds(size, header->AnimationTableOffset,
+                            header->AnimationCount,
+                            sizeof(struct CacheAnimation),
+                            _Alignof(struct CacheAnimation)) ||
+        !cacheArrayInBounds(size, header->BoneTableOffset, header->BoneCount,
+                            sizeof(struct CacheBone),
+                            _Alignof(struct CacheBone)))
+        return false;
+    const struct CacheMesh *cacheMeshes =
+        (const struct CacheMesh *)(data + header->MeshTableOffset);
+    const struct CacheTexture *cacheTextures =
+        (const struct CacheTexture *)(data + header->TextureTableOffset);
+    const struct CacheNode *cacheNodes =
+        (const struct CacheNode *)(data + header->NodeTableOffset);
+    const struct CacheAnimation *cacheAnimations =
+        (const struct CacheAnimation *)(data + header->AnimationTableOffset);
+    const struct CacheBone *cacheBones =
+        (const struct CacheBone *)(data + header->BoneTableOffset);
+
+    for (int i = 0; i < header->MeshCount; i++) {
+        const struct CacheMesh *cacheMesh = &cacheMeshes[i];
+        if (!cacheArrayInBounds(size, cacheMesh->VertexOffset,
+                                cacheMesh->VertexCount, sizeof(struct Vertex),
+                                _Alignof(struct Vertex)) ||
+            !cacheArrayInBounds(size, cacheMesh->IndexOffset,
+                                cacheMesh->IndexCount, sizeof(uint32_t),
+                                _Alignof(uint32_t)) ||
+            cacheMesh->MaterialIndex < 0 ||
+            cacheMesh->MaterialIndex >= header->MaterialCount ||
+            cacheMesh->BoneCount > MESH_MAX_BONES ||
+            (uint64_t)cacheMesh->BoneOffset + cacheMesh->BoneCount >
+                header->BoneCount)
+            return false;
+        // meshlets are built from the indices before anything draws them
+        const uint32_t *indices =
+            (const uint32_t *)(data + cacheMesh->IndexOffset);
+        for (uint32_t j = 0; j < cacheMesh->IndexCount; j++) {
+            if (indices[j] >= cacheMesh->VertexCount)
+                return false;
+        }
+    }
+    for (int i = 0; i < header->BoneCount; i++) {
+        if (cacheBones[i].NodeIndex < 0 ||
+            cacheBones[i].NodeIndex >= header->NodeCount)
+            return false;
+    }
+    for (int i = 0; i < header->TextureCount; i++) {
+        if (!cacheStringInBounds(data, size, cacheTextures[i].NameOffset))
+            return false;
+    }
+
+    // the root comes first and every other node after its parent, and each
+    // node has as many children as point back at it
+    uint32_t *childCounts = calloc(header->NodeCount, sizeof(uint32_t));
+    bool valid = true;
+    for (int i = 0; i < header->NodeCount && valid; i++) {
+        const struct CacheNode *cacheNode = &cacheNodes[i];
+        int parent = cacheNode->ParentIndex;
+        valid = (i == 0 ? parent == -1 : parent >= 0 && parent < i) &&
+                cacheArrayInBounds(size, cacheNode->MeshesOffset,
+                                   cacheNode->MeshCount, sizeof(int32_t),
+                                   _Alignof(int32_t)) &&
+                cacheStringInBounds(data, size, cacheNode->NameOffset);
+        if (!valid)
+            break;
+        if (parent >= 0)
+            childCounts[parent]++;
+        const int32_t *meshes =
+            (const int32_t *)(data + cacheNode->MeshesOffset);
+        for (uint32_t j = 0; j < cacheNode->MeshCount && valid; j++) {
+            valid = meshes[j] >= 0 && meshes[j] < header->MeshCount;
+        }
+    }
+    for (int i = 0; i < header->NodeCount && valid; i++) {
+        valid = childCounts[i] == cacheNodes[i].ChildCount;
+    }
+    free(childCounts);
+    if (!valid)
+        return false;
+
+    for (int i = 0; i < header->AnimationCount; i++) {
+        const struct CacheAnimation *cacheAnimation = &cacheAnimations[i];
+        if (!cacheStringInBounds(data, size, cacheAnimation->NameOffset) ||
+            !cacheArrayInBounds(size, cacheAnimation->ChannelsOffset,
+                                cacheAnimation->ChannelCount,
+                                sizeof(struct CacheChannel),
+                                _Alignof(struct CacheChannel)))
+            return false;
+        const struct CacheChannel *channels =
+            (const struct CacheChannel *)(data +
+                                          cacheAnimation->ChannelsOffset);
+        for (int j = 0; j < cacheAnimation->ChannelCount; j++) {
+            if (!cacheCheckChannel(&channels[j], size, header->NodeCount))
+                return false;
+        }
+    }
+    return true;
+}
+// the node and every key array `cacheReadChannel` reads
+bool cacheCheckChannel(const struct CacheChannel *channel, size_t size,
+                       uint32_t nodeCount) {
+    // channels whose node wasn't found are kept and skipped while animating
+    if (channel->NodeIndex < -1 || channel->NodeIndex >= (int64_t)nodeCount)
+        return false;
+    size_t packedSize = sizeof(uint16_t[3]);
+    return cacheArrayInBounds(size, channel->PositionTimesOffset,
+                              channel->PositionKeyCount, sizeof(float), 1) &&
+           cacheArrayInBounds(size, channel->RotationTimesOffset,
+                              channel->RotationKeyCount, sizeof(float), 1) &&
+           cacheArrayInBounds(size, channel->ScalingTimesOffset,
+                              channel->ScalingKeyCount, sizeof(float), 1) &&
+           cacheArrayInBounds(size, channel->PositionValuesOffset,
+                              channel->PositionKeyCount,
+                              channel->Packed & CACHEPACKED_POSITIONS
+                                  ? packedSize
+                                  : sizeof(vec3s),
+                              1) &&
+           cacheArrayInBounds(size, channel->RotationValuesOffset,
+                              channel->RotationKeyCount,
+                              channel->Packed & CACHEPACKED_ROTATIONS
+                                  ? packedSize
+                                  : sizeof(versors),
+                              1) &&
+           cacheArrayInBounds(size, channel->ScalingValuesOffset,
+                              channel->ScalingKeyCount,
+                              channel->Packed & CACHEPACKED_SCALINGS
+                                  ? packedSize
+                                  : sizeof(vec3s),
+                              1);
+}
+Model *cacheBuildModel(const uint8_t *data, size_t size) {
+    if (!cacheCheckModel(data, size))
+        return NULL;
+    const struct CacheHeader *header = (const struct CacheHeader *)data;
+    const struct CacheMesh *cacheMeshes =
+        (const struct CacheMesh *)(data + header->MeshTableOffset);
+    const struct CacheTexture *cacheTextures =
+        (const struct CacheTexture *)(data + header->TextureTableOffset);
+    const struct CacheNode *cacheNodes =
+        (const struct CacheNode *)(data + header->NodeTableOffset);
+    const struct CacheAnimation *cacheAnimations =
+        (const struct CacheAnimation *)(data + header->AnimationTableOffset);
+    const struct CacheBone *cacheBones =
+        (const struct CacheBone *)(data + header->BoneTableOffset);
+
+    Model *model = _modelCreate(MODEL_ARENA_SIZE);
+    struct Arena *arena = model->Arena;
+
+    // the mapped ranges go straight to the GPU and aren't needed afterwards,
+    // `cacheRelease` unmaps them once the queued uploads are done
+    model->MeshCount = header->MeshCount;
+    model->Meshes = arenaAlloc(arena, model->MeshCount * sizeof(struct Mesh *));
+    for (int i = 0; i < model->MeshCount; i++) {
+        const struct CacheMesh *cacheMesh = &cacheMeshes[i];
+        struct Mesh *mesh =
+            meshLoad(arena, (struct Vertex *)(data + cacheMesh->VertexOffset),
+                     (uint32_t *)(data + cacheMesh->IndexOffset),
+                     cacheMesh->VertexCount, cacheMesh->IndexCount);
+        mesh->MaterialIndex = cacheMesh->MaterialIndex;
+        mesh->BoneOffset = cacheMesh->BoneOffset;
+        mesh->BoneCount = cacheMesh->BoneCount;
+        if (MeshletsEnabled)
+            meshletBuild(arena, mesh);
+        meshQueueSendData(mesh);
+        model->Meshes[i] = mesh;
+    }
+
+    model->MaterialCount = header->MaterialCount;
+    model->Materials =
+        arenaAlloc(arena, model->MaterialCount * sizeof(Material *));
+
+    model->TextureCount = header->TextureCount;
+    model->Textures =
+        arenaAlloc(arena, model->TextureCount * sizeof(Texture *));
+    for (int i = 0; i < model->TextureCount; i++) {
+        const char *name = (const char *)(data + cacheTextures[i].NameOffset);
+        model->Textures[i] = textureLoadAsync(name);
+    }
+
+    model->NodeCount = header->NodeCount;
+    model->NodeEntries =
+        arenaAlloc(arena, model->NodeCount * sizeof(struct NodeEntry));
+    // how many children each node has gotten so far
+    int *childrenFilled = calloc(model->NodeCount, sizeof(int));
+    for (int i = 0; i < model->NodeCount; i++) {
+        const struct CacheNode *cacheNode = &cacheNodes[i];
+        struct NodeEntry *nodeEntry = &model->NodeEntries[i];
+        struct Node *parent = NULL;
+        if (cacheNode->ParentIndex != -1)
+            parent = model->NodeEntries[cacheNode->ParentIndex].Node;
+
+        struct Node *node = nodeCreate(arena, parent, cacheNode->ChildCount);
+        node->Local = cacheNode->Local;
+        node->MeshCount = cacheNode->MeshCount;
+        node->Meshes = arenaAlloc(arena, node->MeshCount * sizeof(int));
+        memcpy(node->Meshes, data + cacheNode->MeshesOffset,
+               node->MeshCount * sizeof(int));
+        node->Name = arenaCopyString(
+            arena, (const char *)(data + cacheNode->NameOffset));
+        if (parent != NULL)
+            parent->Children[childrenFilled[cacheNode->ParentIndex]++] = node;
+
+        nodeEntry->Node = node;
+        node->Index = i;
+        nodeEntry->ParentIndex = cacheNode->ParentIndex;
+    }
+    free(childrenFilled);
+    _modelSetTransforms(model);
+
+    model->BoneCount = header->BoneCount;
+    model->Bones =
+        arenaAlloc(arena, model->BoneCount * sizeof(struct ModelBone));
+    model->BonePalette = arenaAlloc(arena, model->BoneCount * sizeof(mat4s));
+    for (int i = 0; i < model->BoneCount; i++) {
+        model->Bones[i].NodeIndex = cacheBones[i].NodeIndex;
+        model->Bones[i].BoneFromMesh = cacheBones[i].BoneFromMesh;
+    }
+
+    model->AnimationCount = header->AnimationCount;
+    model->Animations =
+        arenaAlloc(arena, model->AnimationCount * sizeof(Animation *));
+    for (int i = 0; i < model->AnimationCount; i++) {
+        const struct CacheAnimation *cacheAnimation = &cacheAnimations[i];
+        const struct CacheChannel *channels =
+            (const struct CacheChannel *)(data +
+                                          cacheAnimation->ChannelsOffset);
+        const char *name = (const char *)(data + cacheAnimation->NameOffset);
+
+        Animation *animation = arenaAlloc(arena, sizeof(Animation));
+        animation->Name = arenaCopyString(arena, name);
+        animation->Duration = cacheAnimation->Duration;
+        animation->TicksPerSec = cacheAnimation->TicksPerSec;
+        animation->Time = 0;
+        animation->Bake = NULL;
+        // models with morph targets aren't cached
+        animation->MorphChannelCount = 0;
+        animation->MorphChannels = NULL;
+        animation->Meshes = model->Meshes;
+        animation->NodeCount = cacheAnimation->ChannelCount;
+        animation->Nodes =
+            arenaAlloc(arena, animation->NodeCount * sizeof(AnimationNode));
+        for (int j = 0; j < animation->NodeCount; j++) {
+            const struct CacheChannel *channel = &channels[j];
+            AnimationNode *animNode = &animation->Nodes[j];
+            animNode->Node = channel->NodeIndex == -1
+                                 ? NULL
+                                 : model->NodeEntries[channel->NodeIndex].Node;
+            animNode->PositionInterpolation =
+                cacheInterpolationRead(channel->PositionInterpolation);
+            animNode->RotationInterpolation =
+                cacheInterpolationRead(channel->RotationInterpolation);
+            animNode->ScalingInterpolation =
+                cacheInterpolationRead(channel->ScalingInterpolation);
+            animNode->Cursor = (AnimationCursor){0};
+            cacheReadChannel(arena, animNode, channel, data);
+        }
+        model->Animations[i] = animation;
+    }
+
+    return model;
+}
+
+// allocates the keys of `animNode` and copies them
+void cacheReadChannel(struct Arena *arena, AnimationNode *animNode,
+                      const struct CacheChannel *channel, const uint8_t *data) {
+    int positionCount = channel->PositionKeyCount;
+    int rotationCount = channel->RotationKeyCount;
+    int scalingCount = channel->ScalingKeyCount;
+    animNode->PositionKeyCount = positionCount;
+    animNode->RotationKeyCount = rotationCount;
+    animNode->ScalingKeyCount = scalingCount;
+    animNode->PositionTimes = arenaAlloc(arena, positionCount * sizeof(float));
+    animNode->RotationTimes = arenaAlloc(arena, rotationCount * sizeof(float));
+    animNode->ScalingTimes = arenaAlloc(arena, scalingCount * sizeof(float));
+    memcpy(animNode->PositionTimes, data + channel->PositionTimesOffset,
+           positionCount * sizeof(float));
+    memcpy(animNode->RotationTimes, data + channel->RotationTimesOffset,
+           rotationCount * sizeof(float));
+    memcpy(animNode->ScalingTimes, data + channel->ScalingTimesOffset,
+           scalingCount * sizeof(float));
+
+    animNode->PositionValues = cacheReadTrack(
+        arena, &animNode->PackedPositions,
+        channel->Packed & CACHEPACKED_POSITIONS,
+        data + channel->PositionValuesOffset, positionCount, sizeof(vec3s));
+    animNode->RotationValues = cacheReadTrack(
+        arena, &animNode->PackedRotations,
+        channel->Packed & CACHEPACKED_ROTATIONS,
+        data + channel->RotationValuesOffset, rotationCount, sizeof(versors));
+    animNode->ScalingValues = cacheReadTrack(
+        arena, &animNode->PackedScalings,
+        channel->Packed & CACHEPACKED_SCALINGS,
+        data + channel->ScalingValuesOffset, scalingCount, sizeof(vec3s));
+    animNode->PackedPositions.Min = channel->PositionRange[0];
+    animNode->PackedPositions.Extent = channel->PositionRange[1];
+    animNode->PackedScalings.Min = channel->ScalingRange[0];
+    animNode->PackedScalings.Extent = channel->ScalingRange[1];
+}
+// copies the values of a track, returns them or NULL when they're packed into
+// `packed` instead
+void *cacheReadTrack(struct Arena *arena, AnimationPackedTrack *packed,
+                     bool isPacked, const uint8_t *values, int keyCount,
+                     size_t valueSize) {
+    *packed = (AnimationPackedTrack){0};
+    if (isPacked) {
+        packed->Keys = arenaAlloc(arena, keyCount * sizeof(uint16_t[3]));
+        memcpy(packed->Keys, values, keyCount * sizeof(uint16_t[3]));
+        return NULL;
+    }
+    void *result = arenaAlloc(arena, keyCount * valueSize);
+    memcpy(result, values, keyCount * valueSize);
+    return result;
+}
+
+void cacheRelease(void *_mapping) {
+    struct CacheMapping *mapping = (struct CacheMapping *)_mapping;
+    for (int i = 0; i < mapping->Model->MeshCount; i++) {
+        mapping->Model->Meshes[i]->Vertices = NULL;
+        mapping->Model->Meshes[i]->Indices = NULL;
+    }
+    munmap(mapping->Data, mapping->Size);
+    free(mapping);
+}
+
+uint64_t cacheWriterPush(struct CacheWriter *writer, const void *data,
+                         size_t size, size_t alignment) {
+    size_t offset = (writer->Size + alignment - 1) & ~(alignment - 1);
+    if (offset + size > writer->Capacity) {
+        size_t capacity = writer->Capacity ? writer->Capacity : 4096;
+        while (offset + size > capacity)
+            capacity *= 2;
+        uint8_t *temp = realloc(writer->Data, capacity);
+        if (temp == NULL) {
+            fprintf(stderr, "could not resize model cache buffer\n");
+            exit(EXIT_FAILURE);
+        }
+        writer->Data = temp;
+        writer->Capacity = capacity;
+    }
+    // zero the padding (and the whole range if there's no data yet) so the
+    // output is deterministic
+    memset(writer->Data + writer->Size, 0, offset - writer->Size);
+    if (data != NULL)
+        memcpy(writer->Data + offset, data, size);
+    else
+        memset(writer->Data + offset, 0, size);
+    writer->Size = offset + size;
+    return offset;
+}
+uint64_t cacheWriterPushString(struct CacheWriter *writer, const char *string) {
+    return cacheWriterPush(writer, string, strlen(string) + 1, 1);
+}
+
+char *cacheGetPath(const char *modelFile) {
+    char *cacheFile =
+        malloc(strlen(modelFile) + sizeof(MODEL_CACHE_EXTENSION));
+    strcpy(cacheFile, modelFile);
+    strcat(cacheFile, MODEL_CACHE_EXTENSION);
+    return cacheFile;
+}
+// 64 bit FNV-1a over the whole file
+uint64_t cacheHashFile(const char *path, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 0;
+    if (size == 0) {
+        close(fd);
+        return hash;
+    }
+    uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3;
+    }
+    munmap(data, size);
+    return hash;
+}
+int64_t cacheModifiedTime(struct stat *fileStat) {
+    return (int64_t)fileStat->st_mtim.tv_sec * 1000000000 +
+           fileStat->st_mtim.tv_nsec;
+}
+bool cacheInBounds(size_t fileSize, uint64_t offset, uint64_t size) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+// `count` is at most 32 bits and the elements are small, so the product
+// can't overflow
+bool cacheArrayInBounds(size_t fileSize, uint64_t offset, uint64_t count,
+                        size_t elementSize, size_t alignment) {
+    return offset % alignment == 0 &&
+           cacheInBounds(fileSize, offset, count * elementSize);
+}
+// the string has to end before the file does
+bool cacheStringInBounds(const uint8_t *data, size_t fileSize,
+                         uint64_t offset) {
+    return offset < fileSize &&
+           memchr(data + offset, '\0', fileSize - offset) != NULL;
+}
+float cacheAnimationTolerance(void) {
+    return AnimationCompressEnabled ? AnimationCompressTolerance : 0;
+}
+// the file keeps its own values, so reordering the enum doesn't break it
+int32_t cacheInterpolationWrite(enum AnimationInterpolation interpolation) {
+    switch (interpolation) {
+    case ANIMATIONINTERP_STEP:
+        return CACHEINTERP_STEP;
+    case ANIMATIONINTERP_SMOOTHSTEP:
+        return CACHEINTERP_SMOOTHSTEP;
+    default:
+        return CACHEINTERP_LINEAR;
+    }
+}
+enum AnimationInterpolation cacheInterpolationRead(int32_t interpolation) {
+    switch (interpolation) {
+    case CACHEINTERP_STEP:
+        return ANIMATIONINTERP_STEP;
+    case CACHEINTERP_SMOOTHSTEP:
+        return ANIMATIONINTERP_SMOOTHSTEP;
+    default:
+        return ANIMATIONINTERP_LINEAR;
+    }
+}
@@ -0,0 +1,89 @@
+#include "model_instance.h"
+
+#include "animation.h"
+#include "asset.h"
+#include "node.h"
+
+#include <cglm/struct/mat4.h>
+#include <stdlib.h>
+
+/// `Asset->Materials` with the overrides applied, grown as needed
+Material **_materials = NULL;
+int _materialsSize = 0;
+
+ModelInstance *modelInstanceCreate(Model *model) {
+    struct Arena *arena = arenaCreate(modelInstanceSize(model));
+    ModelInstance *instance = arenaAlloc(arena, sizeof(ModelInstance));
+    instance->Arena = arena;
+    instance->Asset = model;
+    if (model->Handle.Generation != 0)
+        assetAcquire(model->Handle);
+    instance->WorldFromModel = GLMS_MAT4_IDENTITY;
+
+    transformCreate(arena, &instance->Transforms, model->NodeCount,
+                    model->Transforms.Parents);
+    for (int i = 0; i < model->NodeCount; i++) {
+        transformSetLocal(&instance->Transforms, i,
+                          model->NodeEntries[i].Node->Local);
+    }
+
+    instance->MaterialOverrides =
+        arenaCalloc(arena, model->MaterialCount * sizeof(Material *));
+
+    instance->AnimationTimes =
+        arenaCalloc(arena, model->AnimationCount * sizeof(float));
+    instance->AnimationCursors =
+        arenaAlloc(arena, model->AnimationCount * sizeof(AnimationCursor *));
+    for (int i = 0; i < model->AnimationCount; i++) {
+        instance->AnimationCursors[i] = arenaCalloc(
+            arena, model->Animations[i]->NodeCount * sizeof(AnimationCursor));
+    }
+    return instance;
+}
+size_t modelInstanceSize(Model *model) {
+    size_t size = ARENA_SIZE(sizeof(ModelInstance)) +
+                  transformArenaSize(model->NodeCount) +
+                  ARENA_SIZE(model->MaterialCount * sizeof(Material *)) +
+                  ARENA_SIZE(model->AnimationCount * sizeof(float)) +
+                  ARENA_SIZE(model->AnimationCount * sizeof(AnimationCursor *));
+    for (int i = 0; i < model->AnimationCount; i++) {
+        size += ARENA_SIZE(model->Animations[i]->NodeCount *
+                           sizeof(AnimationCursor));
+    }
+    return size;
+}
+void modelInstanceAnimate(ModelInstance *instance, int animation,
+                          float deltaTime) {
+    Animation *clip = instance->Asset->Animations[animation];
+    float *time = &instance->AnimationTimes[animation];
+    *time = animationAdvance(clip, *time, deltaTime);
+    animationSampleTransforms(clip, *time, &instance->Transforms,
+                              instance->AnimationCursors[animation]);
+}
+void modelInstanceRender(ModelInstance *instance) {
+    Model *model = instance->Asset;
+    if (model->MaterialCount > _materialsSize) {
+        _materialsSize = model->MaterialCount;
+        _materials = realloc(_materials, _materialsSize * sizeof(Material *));
+    }
+    for (int i = 0; i < model->MaterialCount; i++) {
+        Material *override = instance->MaterialOverrides[i];
+        _materials[i] = override != NULL ? override : model->Materials[i];
+    }
+
+    transformUpdate(&instance->Transforms, instance->WorldFromModel);
+    // the model's bone buffer holds this instance's pose until the next one
+    // is drawn
+    mat4s *worldFromLocal = instance->Transforms.WorldFromLocal;
+    _modelUploadBones(model, worldFromLocal, sizeof(mat4s));
+    for (int i = 0; i < model->NodeCount; i++) {
+        nodeRenderAt(worldFromLocal[i], model->NodeEntries[i].Node,
+                     model->Meshes, _materials);
+    }
+}
+void modelInstanceFree(ModelInstance *instance) {
+    Model *model = instance->Asset;
+    arenaFree(instance->Arena);
+    if (model->Handle.Generation != 0)
+        modelFree(model);
+}
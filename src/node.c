@@ -9,31 +9,50 @@
 void printParents(struct Node *node);
 void printMat(mat4s *matrix);
 
-struct Node *nodeCreate(struct Node *parent, int childCount) {
-    struct Node *node = malloc(sizeof(struct Node));
-    node->ParentFromLocal = GLMS_MAT4_IDENTITY;
+struct Node *nodeCreate(struct Arena *arena, struct Node *parent,
+                        int childCount) {
+    struct Node *node = arenaAlloc(arena, sizeof(struct Node));
+    node->Local = transformIdentity();
     node->Parent = parent;
     node->ChildCount = childCount;
-    node->Children = malloc(childCount * sizeof(struct Node *));
+    node->Children = arenaAlloc(arena, childCount * sizeof(struct Node *));
+    node->Index = -1;
+    node->Transforms = NULL;
     return node;
 }
 void nodeRender(mat4s worldFromParent, struct Node *node,
                 struct Mesh **meshArray, Material **materialArray) {
-    mat4s worldFromLocal =
-        glms_mat4_mul(worldFromParent, node->ParentFromLocal);
+    nodeRenderAt(transformApply(worldFromParent, transformCompose(node->Local)),
+                 node, meshArray, materialArray);
+}
+void nodeRenderAt(mat4s worldFromLocal, struct Node *node,
+                  struct Mesh **meshArray, Material **materialArray) {
     for (int i = 0; i < node->MeshCount; i++) {
         struct Mesh *mesh = meshArray[node->Meshes[i]];
         int index = mesh->MaterialIndex;
         Material *material = materialArray[index];
         materialApplyProperties(material);
-        meshRender(mesh, worldFromLocal, material->Shader);
+        // skinned meshes get to world space through their bones instead
+        mat4s worldFromMesh =
+            mesh->BoneCount > 0 ? GLMS_MAT4_IDENTITY : worldFromLocal;
+        meshRender(mesh, worldFromMesh, material->Shader);
     }
 }
+void nodeSetLocal(struct Node *node, TransformLocal local) {
+    node->Local = local;
+    if (node->Transforms != NULL)
+        transformSetLocal(node->Transforms, node->Index, local);
+}
+mat4s nodeGetParentFromLocal(struct Node *node) {
+    return transformToMat4(transformCompose(node->Local));
+}
 mat4s nodeGetWorldFromLocal(struct Node *node) {
     if (node == NULL)
         return GLMS_MAT4_IDENTITY;
-    return glms_mat4_mul(nodeGetWorldFromLocal(node->Parent),
-                         node->ParentFromLocal);
+    if (node->Transforms != NULL)
+        return node->Transforms->WorldFromLocal[node->Index];
+    return transformApply(nodeGetWorldFromLocal(node->Parent),
+                          transformCompose(node->Local));
 }
 int nodeChildCount(struct Node *node) {
     int result = node->ChildCount;
@@ -42,19 +61,18 @@ int nodeChildCount(struct Node *node) {
     }
     return result;
 }
+int nodeDepth(struct Node *node) {
+    int result = 0;
+    for (struct Node *parent = node->Parent; parent != NULL;
+         parent = parent->Parent) {
+        result++;
+    }
+    return result;
+}
 void nodePrintInfo(struct Node *node) {
     printParents(node);
     printf("Node's Name = %s\n", node->Name);
 }
-void nodeFree(struct Node *node) {
-    for (int i = 0; i < node->ChildCount; i++) {
-        nodeFree(node->Children[i]);
-    }
-    free(node->Children);
-    free(node->Name);
-    free(node->Meshes);
-    free(node);
-}
 
 void printParents(struct Node *node) {
     if (node->Parent == NULL) {
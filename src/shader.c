@@ -1,5 +1,7 @@
 #include "shader.h"
 
+#include "asset.h"
+
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include <stdio.h>
@@ -7,155 +9,124 @@
 #include <string.h>
 
 char *readFile(const char *fileName);
-uint64_t hash(char *str);
-
-struct shaderCache {
-    size_t used;
-    size_t size;
-    uint64_t *array;
-};
-struct shaderCache *shaderCacheCreate();
-uint32_t shaderCacheValue(struct shaderCache *cache, int index);
-void shaderCacheAppend(struct shaderCache *cache, uint32_t key, uint32_t value);
-void shaderCacheRemove(struct shaderCache *cache, int index);
-int shaderCacheSearch(struct shaderCache *cache, uint32_t key);
-void shaderCacheFree(struct shaderCache *cache);
-
-struct shaderCache *_cache;
+uint32_t shaderCompile(const char *path, uint32_t type, const char *kind);
+void shaderLink(uint32_t program);
+void shaderRegister(uint32_t shaderProgram, const char *key);
+char *shaderKey(const char *vertexShaderPath, const char *fragmentShaderPath);
+void shaderDelete(void *program);
+
+/// registry handle of every program, indexed by program id
+AssetHandle *_programHandles = NULL;
+uint32_t _programHandleCount = 0;
 
 uint32_t shaderCreate(const char *_vertexShaderPath,
                       const char *_fragmentShaderPath) {
-    if (_cache == NULL)
-        _cache = shaderCacheCreate();
-
-    char *hashSource =
-        malloc(strlen(_vertexShaderPath) + strlen(_fragmentShaderPath) + 1);
-    strcpy(hashSource, _vertexShaderPath);
-    strcat(hashSource, _fragmentShaderPath);
-    uint64_t hashSourceHash = hash(hashSource);
-    int shaderCacheIndex = shaderCacheSearch(_cache, hashSourceHash);
-    if (shaderCacheIndex != -1) {
-        free(hashSource);
-        return _cache->array[shaderCacheIndex] & 0xFFFF;
+    char *key = shaderKey(_vertexShaderPath, _fragmentShaderPath);
+    AssetHandle handle = assetFind(ASSETTYPE_SHADER, key);
+    if (handle.Generation != 0) {
+        free(key);
+        return (uintptr_t)assetGet(handle, ASSETTYPE_SHADER);
     }
 
-    char *vertexShaderPath =
-        malloc(strlen(_vertexShaderPath) + sizeof(SHADERS_PATH));
-    strcpy(vertexShaderPath, SHADERS_PATH);
-    strcat(vertexShaderPath, _vertexShaderPath);
-    char *fragmentShaderPath =
-        malloc(strlen(_fragmentShaderPath) + sizeof(SHADERS_PATH));
-    strcpy(fragmentShaderPath, SHADERS_PATH);
-    strcat(fragmentShaderPath, _fragmentShaderPath);
-
-    char *vertexShaderContents = readFile(vertexShaderPath);
-    const char *vertexShaderSource = vertexShaderContents;
-    uint32_t vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // error checking
-    int success = 0;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, sizeof(infoLog), NULL, infoLog);
-        fprintf(stderr, "vertex shader could not compile: %s", infoLog);
-        exit(EXIT_FAILURE);
-    }
-
-    char *fragmentShaderContents = readFile(fragmentShaderPath);
-    const char *fragmentShaderSource = fragmentShaderContents;
-    uint32_t fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, sizeof(infoLog), NULL, infoLog);
-        fprintf(stderr, "fragment shader could not compile: %s", infoLog);
-        exit(EXIT_FAILURE);
-    }
+    uint32_t vertexShader =
+        shaderCompile(_vertexShaderPath, GL_VERTEX_SHADER, "vertex");
+    uint32_t fragmentShader =
+        shaderCompile(_fragmentShaderPath, GL_FRAGMENT_SHADER, "fragment");
 
     uint32_t shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    int shaderSuccess;
-    glGetProgramiv(shaderProgram, GL_VALIDATE_STATUS, &shaderSuccess);
-    if (success != GL_TRUE) {
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), NULL, infoLog);
-        fprintf(stderr, "shader program could not be linked: %s", infoLog);
-        exit(EXIT_FAILURE);
-    }
+    shaderLink(shaderProgram);
     glUseProgram(shaderProgram);
     glDeleteShader(fragmentShader);
     glDeleteShader(vertexShader);
 
-    free(vertexShaderContents);
-    free(fragmentShaderContents);
-    free(vertexShaderPath);
-    free(fragmentShaderPath);
-
-    shaderCacheAppend(_cache, hashSourceHash, shaderProgram);
-    free(hashSource);
+    shaderRegister(shaderProgram, key);
+    free(key);
 
     return shaderProgram;
 }
-void shaderFree(uint32_t shader) {
-    int index = shaderCacheSearch(_cache, shader);
-    if (index != -1) {
-        shaderCacheRemove(_cache, index);
-        glDeleteProgram(shader);
+uint32_t shaderCreateCompute(const char *computeShaderPath) {
+    char *key = assetNormalizePath(computeShaderPath);
+    AssetHandle handle = assetFind(ASSETTYPE_SHADER, key);
+    if (handle.Generation != 0) {
+        free(key);
+        return (uintptr_t)assetGet(handle, ASSETTYPE_SHADER);
     }
+
+    uint32_t computeShader =
+        shaderCompile(computeShaderPath, GL_COMPUTE_SHADER, "compute");
+    uint32_t shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, computeShader);
+    shaderLink(shaderProgram);
+    glDeleteShader(computeShader);
+
+    shaderRegister(shaderProgram, key);
+    free(key);
+
+    return shaderProgram;
 }
-void shaderFreeCache() { shaderCacheFree(_cache); }
-
-void shaderCacheFitSize(struct shaderCache *cache) {
-    uint64_t *temp = realloc(cache->array, cache->size);
-    if (temp != NULL)
-        cache->array = temp;
-    else {
-        fprintf(stderr, "could not resize shader cache\n");
-        exit(EXIT_FAILURE);
-    }
-}
-struct shaderCache *shaderCacheCreate() {
-    struct shaderCache *cache = malloc(sizeof(struct shaderCache));
-    cache->array = NULL;
-    cache->used = 0;
-    cache->size = 4;
-    shaderCacheFitSize(cache);
-    return cache;
-}
-uint32_t shaderCacheValue(struct shaderCache *cache, int index) {
-    return cache->array[index] & 0xFFFF;
+void shaderFree(uint32_t shader) {
+    if (shader < _programHandleCount)
+        assetRelease(_programHandles[shader]);
 }
-void shaderCacheAppend(struct shaderCache *cache, uint32_t key,
-                       uint32_t value) {
-    if (cache->used > cache->size) {
-        cache->size *= 2;
-        shaderCacheFitSize(cache);
-    }
-    cache->array[cache->used++] = ((uint64_t)key << 32) | value;
+void shaderFreeCache() {
+    assetReleaseAll(ASSETTYPE_SHADER);
+    free(_programHandles);
+    _programHandles = NULL;
+    _programHandleCount = 0;
 }
-void shaderCacheRemove(struct shaderCache *cache, int index) {
-    for (int i = index + 1; i < cache->used; i++) {
-        cache[i - 1] = cache[i];
+
+// `path` is relative to `SHADERS_PATH`, `kind` is for the error message
+uint32_t shaderCompile(const char *_path, uint32_t type, const char *kind) {
+    char *path = malloc(strlen(_path) + sizeof(SHADERS_PATH));
+    strcpy(path, SHADERS_PATH);
+    strcat(path, _path);
+
+    char *contents = readFile(path);
+    const char *source = contents;
+    uint32_t shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    // error checking
+    int success = 0;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        fprintf(stderr, "%s shader could not compile: %s", kind, infoLog);
+        exit(EXIT_FAILURE);
     }
-    cache->size--;
+
+    free(contents);
+    free(path);
+    return shader;
 }
-int shaderCacheSearch(struct shaderCache *cache, uint32_t key) {
-    for (int i = 0; i < cache->used; i++) {
-        if ((cache->array[i] >> 32) == key)
-            return i;
+void shaderLink(uint32_t program) {
+    glLinkProgram(program);
+    int success = 0;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success != GL_TRUE) {
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        fprintf(stderr, "shader program could not be linked: %s", infoLog);
+        exit(EXIT_FAILURE);
     }
-    return -1;
 }
-void shaderCacheFree(struct shaderCache *cache) {
-    for (int i = 0; i < cache->used; i++) {
-        shaderFree(shaderCacheValue(cache, i));
+// so `shaderFree` can find the program's handle from its id
+void shaderRegister(uint32_t shaderProgram, const char *key) {
+    if (shaderProgram >= _programHandleCount) {
+        uint32_t count = _programHandleCount ? _programHandleCount : 16;
+        while (shaderProgram >= count)
+            count *= 2;
+        _programHandles = realloc(_programHandles, count * sizeof(AssetHandle));
+        for (uint32_t i = _programHandleCount; i < count; i++) {
+            _programHandles[i] = ASSET_HANDLE_NULL;
+        }
+        _programHandleCount = count;
     }
-    free(cache->array);
-    free(cache);
+    _programHandles[shaderProgram] = assetRegister(
+        ASSETTYPE_SHADER, key, (void *)(uintptr_t)shaderProgram, shaderDelete);
 }
 
 char *readFile(const char *fileName) {
@@ -178,12 +149,17 @@ char *readFile(const char *fileName) {
     string[fsize] = 0;
     return string;
 }
-uint64_t hash(char *str) {
-    uint64_t hash = 5381;
-    int c;
-
-    while ((c = (uint8_t)*str++))
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-
-    return hash;
+// both paths normalized, so the same pair always gives the same key
+char *shaderKey(const char *vertexShaderPath, const char *fragmentShaderPath) {
+    char *vertex = assetNormalizePath(vertexShaderPath);
+    char *fragment = assetNormalizePath(fragmentShaderPath);
+    char *key = malloc(strlen(vertex) + strlen(fragment) + 2);
+    strcpy(key, vertex);
+    strcat(key, "|");
+    strcat(key, fragment);
+    free(vertex);
+    free(fragment);
+    return key;
 }
+// called by the registry once the last reference is gone
+void shaderDelete(void *program) { glDeleteProgram((uintptr_t)program); }
@@ -0,0 +1,172 @@
+#include "skinning.h"
+
+#include "shader.h"
+
+#include "glad/glad.h"
+#include <stddef.h>
+
+/// floats `skinning_comp.glsl` writes per vertex, position then normal
+#define SKINNED_VERTEX_FLOATS 6
+/// storage bindings of the compute shader, the bones are at
+/// `MODEL_BONE_BINDING`
+#define SKINNING_VERTEX_BINDING 1
+#define SKINNING_OUTPUT_BINDING 2
+#define SKINNING_MORPH_BINDING 3
+
+bool SkinningComputeEnabled = true;
+int SkinningVerticesSkinned = 0;
+int SkinningDrawsReused = 0;
+int SkinningMorphTargetsApplied = 0;
+int SkinningMorphTargetsSkipped = 0;
+
+/// made the first time a mesh is skinned or morphed
+uint32_t _skinningShader = 0;
+uint32_t _morphShader = 0;
+
+void skinningCreateOutput(struct Mesh *mesh);
+void skinningMorph(struct Mesh *mesh);
+void skinningSetVertexUniforms(uint32_t shader, struct Mesh *mesh);
+
+uint32_t skinningUpdate(struct Mesh *mesh) {
+    if (mesh->SkinnedVAO == 0)
+        skinningCreateOutput(mesh);
+    if (!mesh->SkinnedDirty) {
+        SkinningDrawsReused++;
+        return mesh->SkinnedVAO;
+    }
+
+    // the morphed vertices are skinned in place
+    if (mesh->MorphTargetCount > 0)
+        skinningMorph(mesh);
+    if (mesh->BoneCount > 0) {
+        if (_skinningShader == 0)
+            _skinningShader = shaderCreateCompute("skinning_comp.glsl");
+        glUseProgram(_skinningShader);
+        skinningSetVertexUniforms(_skinningShader, mesh);
+        glUniform1i(glGetUniformLocation(_skinningShader, "boneOffset"),
+                    mesh->BoneOffset);
+        glUniform1i(glGetUniformLocation(_skinningShader, "morphed"),
+                    mesh->MorphTargetCount > 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_VERTEX_BINDING,
+                         mesh->VBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_OUTPUT_BINDING,
+                         mesh->SkinnedVBO);
+        glDispatchCompute((mesh->VertexCount + SKINNING_GROUP_SIZE - 1) /
+                              SKINNING_GROUP_SIZE,
+                          1, 1);
+    }
+    // the draws read the output as vertex attributes
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    mesh->SkinnedDirty = false;
+    SkinningVerticesSkinned += mesh->VertexCount;
+    return mesh->SkinnedVAO;
+}
+void skinningResetCounters(void) {
+    SkinningVerticesSkinned = 0;
+    SkinningDrawsReused = 0;
+    SkinningMorphTargetsApplied = 0;
+    SkinningMorphTargetsSkipped = 0;
+}
+
+// copies the mesh's vertices to the output, then adds each target with a
+// weight to them. the vertices of one target are all different, so each of
+// them is a single dispatch over just the vertices it moves
+void skinningMorph(struct Mesh *mesh) {
+    if (mesh->MorphBuffer == 0 && mesh->MorphDeltaCount > 0) {
+        glGenBuffers(1, &mesh->MorphBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, mesh->MorphBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER,
+                     mesh->MorphDeltaCount * sizeof(struct MorphDelta),
+                     mesh->MorphDeltas, GL_STATIC_DRAW);
+    }
+    if (_morphShader == 0)
+        _morphShader = shaderCreateCompute("morph_comp.glsl");
+    glUseProgram(_morphShader);
+    skinningSetVertexUniforms(_morphShader, mesh);
+    glUniform1i(glGetUniformLocation(_morphShader, "addDeltas"), false);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_VERTEX_BINDING,
+                     mesh->VBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_OUTPUT_BINDING,
+                     mesh->SkinnedVBO);
+    if (mesh->MorphBuffer != 0)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SKINNING_MORPH_BINDING,
+                         mesh->MorphBuffer);
+    glDispatchCompute(
+        (mesh->VertexCount + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE, 1,
+        1);
+
+    glUniform1i(glGetUniformLocation(_morphShader, "addDeltas"), true);
+    for (int i = 0; i < mesh->MorphTargetCount; i++) {
+        int first = mesh->MorphTargetOffsets[i];
+        int count = mesh->MorphTargetOffsets[i + 1] - first;
+        if (mesh->MorphWeights[i] == 0 || count == 0) {
+            SkinningMorphTargetsSkipped++;
+            continue;
+        }
+        // each target adds to what the one before it wrote
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUniform1i(glGetUniformLocation(_morphShader, "firstDelta"), first);
+        glUniform1ui(glGetUniformLocation(_morphShader, "deltaCount"), count);
+        glUniform1f(glGetUniformLocation(_morphShader, "weight"),
+                    mesh->MorphWeights[i]);
+        glDispatchCompute((count + SKINNING_GROUP_SIZE - 1) /
+                              SKINNING_GROUP_SIZE,
+                          1, 1);
+        SkinningMorphTargetsApplied++;
+    }
+    if (mesh->BoneCount > 0)
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+// how the mesh's own vertex buffer is read
+void skinningSetVertexUniforms(uint32_t shader, struct Mesh *mesh) {
+    glUniform1ui(glGetUniformLocation(shader, "vertexCount"),
+                 mesh->VertexCount);
+    glUniform1i(glGetUniformLocation(shader, "packedVertices"),
+                mesh->VertexFormat == MESHFORMAT_PACKED);
+    glUniform3fv(glGetUniformLocation(shader, "positionOffset"), 1,
+                 mesh->PositionOffset.raw);
+    glUniform3fv(glGetUniformLocation(shader, "positionScale"), 1,
+                 mesh->PositionScale.raw);
+}
+
+// positions and normals come from the output buffer, everything skinning
+// doesn't change from the mesh's own
+void skinningCreateOutput(struct Mesh *mesh) {
+    glGenVertexArrays(1, &mesh->SkinnedVAO);
+    glBindVertexArray(mesh->SkinnedVAO);
+
+    glGenBuffers(1, &mesh->SkinnedVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->SkinnedVBO);
+    glBufferData(GL_ARRAY_BUFFER,
+                 mesh->VertexCount * SKINNED_VERTEX_FLOATS * sizeof(float),
+                 NULL, GL_DYNAMIC_COPY);
+    size_t skinnedStride = SKINNED_VERTEX_FLOATS * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, skinnedStride, (void *)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, skinnedStride,
+                          (void *)(3 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    if (mesh->VertexFormat == MESHFORMAT_PACKED) {
+        size_t stride = sizeof(struct PackedVertex);
+        glVertexAttribPointer(
+            2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+            (void *)offsetof(struct PackedVertex, TexCoords));
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              (void *)offsetof(struct PackedVertex, Color));
+    } else {
+        size_t stride = sizeof(struct Vertex);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, TexCoords));
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void *)offsetof(struct Vertex, Color));
+    }
+    // position, normals, texcoords, vertex colors
+    for (int i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(i);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glBindVertexArray(0);
+    mesh->SkinnedDirty = true;
+}
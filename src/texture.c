@@ -1,36 +1,65 @@
 #include "texture.h"
 
+#include "thread_pool.h"
+#include "upload_queue.h"
+
 #include "glad/glad.h"
 #include "stb/stb_image.h"
 #include <GLFW/glfw3.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define TEXTURE_MAX_LEVELS 16
+
+/// a texture being loaded by `textureLoadAsync`. decoded and mipmapped on a
+/// worker, then uploaded one level per upload queue job
+struct TextureUpload {
+    /// NULL if the texture was freed before it finished loading
+    Texture *Texture;
+    char *TextureFile;
+    int Width, Height;
+    int LevelCount;
+    int NextLevel;
+    /// every level back to back, RGBA8. NULL if decoding failed
+    uint8_t *Pixels;
+    size_t LevelOffsets[TEXTURE_MAX_LEVELS];
+    uint32_t Id;
+};
+
+unsigned char *textureDecode(const char *_texturePath, bool optional,
+                             int *width, int *height, int *numColorChannels);
+void textureDecodeJob(void *_upload);
+void textureUploadLevel(void *_upload);
+void textureFinishUpload(struct TextureUpload *upload);
+Texture *textureFind(const char *texturePath);
+void textureRegister(Texture *texture, const char *texturePath);
+void textureDelete(void *_texture);
+void textureBuildMips(struct TextureUpload *upload, uint8_t *level0);
+void textureDownsample(const uint8_t *source, int sourceWidth,
+                       int sourceHeight, uint8_t *destination);
+int textureLevelWidth(struct TextureUpload *upload, int level);
+int textureLevelHeight(struct TextureUpload *upload, int level);
+
+Texture *_placeholder;
 
 Texture *textureCreate(const char *_texturePath, enum TEXTURETYPE type,
                        bool optional) {
-    char *textureFile = malloc(strlen(_texturePath) + sizeof(TEXTURES_PATH));
-    strcpy(textureFile, TEXTURES_PATH);
-    strcat(textureFile, _texturePath);
-
-    uint32_t textureId;
+    Texture *loaded = textureFind(_texturePath);
+    if (loaded != NULL)
+        return loaded;
 
     int width, height, numColorChannels;
-    unsigned char *data;
-    // load default texture (white)
-    if (strcmp(textureFile, "") == 0)
-        data = stbi_load("textures/default.jpg", &width, &height,
-                         &numColorChannels, 0);
-    else
-        data = stbi_load(textureFile, &width, &height, &numColorChannels, 0);
-    if (!data) {
-        printf("failed to load texture \"%s\"\n", textureFile);
-        stbi_image_free(data);
-        if (optional)
-            return NULL;
-        else
-            exit(EXIT_FAILURE);
-    }
+    unsigned char *data = textureDecode(_texturePath, optional, &width,
+                                        &height, &numColorChannels);
+    if (!data)
+        return NULL;
+
+    uint32_t textureId;
     glGenTextures(1, &textureId);
     glBindTexture(GL_TEXTURE_2D, textureId);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -44,13 +73,231 @@ Texture *textureCreate(const char *_texturePath, enum TEXTURETYPE type,
     glGenerateMipmap(GL_TEXTURE_2D);
     stbi_image_free(data);
 
-    free(textureFile);
-
     Texture *texture = malloc(sizeof(Texture));
     texture->id = textureId;
+    texture->Pending = NULL;
+    textureRegister(texture, _texturePath);
     return texture;
 }
-void textureFree(Texture *texture) {
-    glDeleteTextures(1, &texture->id);
+Texture *textureLoadAsync(const char *_texturePath) {
+    Texture *loaded = textureFind(_texturePath);
+    if (loaded != NULL)
+        return loaded;
+
+    Texture *texture = malloc(sizeof(Texture));
+    texture->id = _placeholder != NULL ? _placeholder->id : 0;
+
+    struct TextureUpload *upload = calloc(1, sizeof(struct TextureUpload));
+    upload->Texture = texture;
+    upload->TextureFile =
+        malloc(strlen(_texturePath) + sizeof(TEXTURES_PATH));
+    strcpy(upload->TextureFile, TEXTURES_PATH);
+    strcat(upload->TextureFile, _texturePath);
+    texture->Pending = upload;
+    textureRegister(texture, _texturePath);
+
+    threadPoolSubmit(textureDecodeJob, upload);
+    return texture;
+}
+void textureInitPlaceholder() {
+    if (_placeholder == NULL)
+        _placeholder = textureCreate("default.jpg", TEXTURETYPE_RGB, false);
+}
+void textureFreePlaceholder() {
+    if (_placeholder == NULL)
+        return;
+    textureFree(_placeholder);
+    _placeholder = NULL;
+}
+void textureFree(Texture *texture) { assetRelease(texture->Handle); }
+
+// embedded textures without a name aren't shared
+Texture *textureFind(const char *texturePath) {
+    if (texturePath[0] == 0)
+        return NULL;
+    return assetGet(assetFind(ASSETTYPE_TEXTURE, texturePath),
+                    ASSETTYPE_TEXTURE);
+}
+void textureRegister(Texture *texture, const char *texturePath) {
+    texture->Handle =
+        assetRegister(ASSETTYPE_TEXTURE, texturePath[0] ? texturePath : NULL,
+                      texture, textureDelete);
+}
+// called by the registry once the last reference is gone
+void textureDelete(void *_texture) {
+    Texture *texture = (Texture *)_texture;
+    if (texture->Pending != NULL)
+        // the upload cleans up after itself when it sees this
+        texture->Pending->Texture = NULL;
+    else if (texture == _placeholder || _placeholder == NULL ||
+             texture->id != _placeholder->id)
+        glDeleteTextures(1, &texture->id);
     free(texture);
 }
+
+unsigned char *textureDecode(const char *_texturePath, bool optional,
+                             int *width, int *height, int *numColorChannels) {
+    char *textureFile = malloc(strlen(_texturePath) + sizeof(TEXTURES_PATH));
+    strcpy(textureFile, TEXTURES_PATH);
+    strcat(textureFile, _texturePath);
+
+    unsigned char *data;
+    // load default texture (white)
+    if (strcmp(textureFile, "") == 0)
+        data = stbi_load("textures/default.jpg", width, height,
+                         numColorChannels, 0);
+    else
+        data = stbi_load(textureFile, width, height, numColorChannels, 0);
+    if (!data) {
+        printf("failed to load texture \"%s\"\n", textureFile);
+        stbi_image_free(data);
+        if (!optional)
+            exit(EXIT_FAILURE);
+    }
+    free(textureFile);
+    return data;
+}
+// runs on a worker thread
+void textureDecodeJob(void *_upload) {
+    struct TextureUpload *upload = (struct TextureUpload *)_upload;
+    int numColorChannels;
+    // always 4 channels so every level has the same layout and rows are
+    // aligned for the upload
+    uint8_t *level0 = stbi_load(upload->TextureFile, &upload->Width,
+                                &upload->Height, &numColorChannels, 4);
+    if (level0 == NULL) {
+        printf("failed to load texture \"%s\", keeping the placeholder\n",
+               upload->TextureFile);
+        uploadQueuePush(textureUploadLevel, upload, 0);
+        return;
+    }
+    textureBuildMips(upload, level0);
+    stbi_image_free(level0);
+
+    uploadQueuePush(textureUploadLevel, upload,
+                    (size_t)upload->Width * upload->Height * 4);
+}
+// runs on the GL thread, once per level
+void textureUploadLevel(void *_upload) {
+    struct TextureUpload *upload = (struct TextureUpload *)_upload;
+    if (upload->Texture == NULL || upload->Pixels == NULL) {
+        textureFinishUpload(upload);
+        return;
+    }
+
+    if (upload->NextLevel == 0) {
+        glGenTextures(1, &upload->Id);
+        glBindTexture(GL_TEXTURE_2D, upload->Id);
+        glTexStorage2D(GL_TEXTURE_2D, upload->LevelCount, GL_RGBA8,
+                       upload->Width, upload->Height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else
+        glBindTexture(GL_TEXTURE_2D, upload->Id);
+
+    int level = upload->NextLevel++;
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0,
+                    textureLevelWidth(upload, level),
+                    textureLevelHeight(upload, level), GL_RGBA,
+                    GL_UNSIGNED_BYTE,
+                    upload->Pixels + upload->LevelOffsets[level]);
+
+    if (upload->NextLevel < upload->LevelCount) {
+        level = upload->NextLevel;
+        uploadQueuePush(textureUploadLevel, upload,
+                        (size_t)textureLevelWidth(upload, level) *
+                            textureLevelHeight(upload, level) * 4);
+        return;
+    }
+    // swap the placeholder for the real thing
+    upload->Texture->id = upload->Id;
+    upload->Id = 0;
+    textureFinishUpload(upload);
+}
+void textureFinishUpload(struct TextureUpload *upload) {
+    if (upload->Texture != NULL)
+        upload->Texture->Pending = NULL;
+    if (upload->Id != 0)
+        glDeleteTextures(1, &upload->Id);
+    free(upload->Pixels);
+    free(upload->TextureFile);
+    free(upload);
+}
+
+void textureBuildMips(struct TextureUpload *upload, uint8_t *level0) {
+    int largestSide =
+        upload->Width > upload->Height ? upload->Width : upload->Height;
+    upload->LevelCount = 1;
+    while (largestSide >> upload->LevelCount &&
+           upload->LevelCount < TEXTURE_MAX_LEVELS)
+        upload->LevelCount++;
+
+    size_t size = 0;
+    for (int i = 0; i < upload->LevelCount; i++) {
+        upload->LevelOffsets[i] = size;
+        size += (size_t)textureLevelWidth(upload, i) *
+                textureLevelHeight(upload, i) * 4;
+    }
+    upload->Pixels = malloc(size);
+    memcpy(upload->Pixels, level0, (size_t)upload->Width * upload->Height * 4);
+    for (int i = 1; i < upload->LevelCount; i++) {
+        textureDownsample(upload->Pixels + upload->LevelOffsets[i - 1],
+                          textureLevelWidth(upload, i - 1),
+                          textureLevelHeight(upload, i - 1),
+                          upload->Pixels + upload->LevelOffsets[i]);
+    }
+}
+// 2x2 box filter over RGBA8. odd sizes drop the last row/column, and a side
+// that is already 1 pixel wide is only filtered along the other one
+void textureDownsample(const uint8_t *source, int sourceWidth,
+                       int sourceHeight, uint8_t *destination) {
+    int width = sourceWidth > 1 ? sourceWidth / 2 : 1;
+    int height = sourceHeight > 1 ? sourceHeight / 2 : 1;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *row0 = source + (size_t)(2 * y) * sourceWidth * 4;
+        const uint8_t *row1 =
+            sourceHeight > 1 ? row0 + (size_t)sourceWidth * 4 : row0;
+        uint8_t *out = destination + (size_t)y * width * 4;
+        int x = 0;
+#ifdef __SSE2__
+        // two output pixels from four input pixels of each row at a time
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(2);
+        for (; sourceWidth > 1 && x + 2 <= width; x += 2) {
+            __m128i top = _mm_loadu_si128((const __m128i *)(row0 + x * 8));
+            __m128i bottom = _mm_loadu_si128((const __m128i *)(row1 + x * 8));
+            // pixels 0 and 1, and 2 and 3, summed vertically as 16 bit
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero),
+                                        _mm_unpacklo_epi8(bottom, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero),
+                                         _mm_unpackhi_epi8(bottom, zero));
+            low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+            high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+            __m128i sum = _mm_unpacklo_epi64(low, high);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+            _mm_storel_epi64((__m128i *)(out + x * 4),
+                             _mm_packus_epi16(sum, sum));
+        }
+#endif
+        for (; x < width; x++) {
+            int x0 = 2 * x;
+            int x1 = sourceWidth > 1 ? x0 + 1 : x0;
+            for (int c = 0; c < 4; c++) {
+                out[x * 4 + c] = (row0[x0 * 4 + c] + row0[x1 * 4 + c] +
+                                  row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) >>
+                                 2;
+            }
+        }
+    }
+}
+int textureLevelWidth(struct TextureUpload *upload, int level) {
+    int width = upload->Width >> level;
+    return width > 0 ? width : 1;
+}
+int textureLevelHeight(struct TextureUpload *upload, int level) {
+    int height = upload->Height >> level;
+    return height > 0 ? height : 1;
+}
@@ -0,0 +1,208 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct ThreadPoolJob {
+    void (*Function)(void *data);
+    void *Data;
+    struct ThreadPoolJob *Next;
+};
+/// one call to `threadPoolFor`, shared by the caller and the jobs helping it
+struct ThreadPoolFor {
+    void (*Function)(void *data, int start, int end);
+    void *Data;
+    int Count, ChunkSize;
+    /// start of the next range nobody has taken
+    atomic_int Next;
+    /// how much of `Count` has been run
+    atomic_int Done;
+    /// the caller and the helper jobs that haven't returned, the last one out
+    /// frees it
+    atomic_int References;
+};
+struct ThreadPool {
+    int ThreadCount;
+    pthread_t *Threads;
+
+    pthread_mutex_t Mutex;
+    pthread_cond_t JobAvailable;
+    pthread_cond_t JobsDone;
+    pthread_cond_t ForDone;
+    struct ThreadPoolJob *First, *Last;
+    /// queued and running jobs
+    int PendingJobs;
+    bool Stopping;
+};
+
+void *threadPoolWorker(void *_pool);
+void threadPoolForRun(struct ThreadPoolFor *work);
+void threadPoolForJob(void *_work);
+void threadPoolForRelease(struct ThreadPoolFor *work);
+
+struct ThreadPool _pool = {
+    .Mutex = PTHREAD_MUTEX_INITIALIZER,
+    .JobAvailable = PTHREAD_COND_INITIALIZER,
+    .JobsDone = PTHREAD_COND_INITIALIZER,
+    .ForDone = PTHREAD_COND_INITIALIZER,
+};
+
+void threadPoolInit(int threadCount) {
+    if (_pool.ThreadCount > 0)
+        return;
+    if (threadCount <= 0) {
+        threadCount = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+        if (threadCount < 1)
+            threadCount = 1;
+    }
+    _pool.Stopping = false;
+    _pool.Threads = malloc(threadCount * sizeof(pthread_t));
+    for (int i = 0; i < threadCount; i++) {
+        if (pthread_create(&_pool.Threads[i], NULL, threadPoolWorker,
+                           &_pool) != 0) {
+            fprintf(stderr, "could not create worker thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    _pool.ThreadCount = threadCount;
+}
+int threadPoolThreadCount() { return _pool.ThreadCount; }
+void threadPoolSubmit(void (*function)(void *data), void *data) {
+    if (_pool.ThreadCount == 0) {
+        function(data);
+        return;
+    }
+    struct ThreadPoolJob *job = malloc(sizeof(struct ThreadPoolJob));
+    job->Function = function;
+    job->Data = data;
+    job->Next = NULL;
+
+    pthread_mutex_lock(&_pool.Mutex);
+    if (_pool.Last == NULL)
+        _pool.First = job;
+    else
+        _pool.Last->Next = job;
+    _pool.Last = job;
+    _pool.PendingJobs++;
+    pthread_cond_signal(&_pool.JobAvailable);
+    pthread_mutex_unlock(&_pool.Mutex);
+}
+void threadPoolWait() {
+    pthread_mutex_lock(&_pool.Mutex);
+    while (_pool.PendingJobs > 0)
+        pthread_cond_wait(&_pool.JobsDone, &_pool.Mutex);
+    pthread_mutex_unlock(&_pool.Mutex);
+}
+void threadPoolFor(int count, int chunkSize,
+                   void (*function)(void *data, int start, int end),
+                   void *data) {
+    if (count <= 0)
+        return;
+    if (chunkSize < 1)
+        chunkSize = 1;
+    int helperCount = (count - 1) / chunkSize;
+    if (helperCount > _pool.ThreadCount)
+        helperCount = _pool.ThreadCount;
+    if (helperCount == 0) {
+        for (int start = 0; start < count; start += chunkSize) {
+            function(data, start,
+                     start + chunkSize < count ? start + chunkSize : count);
+        }
+        return;
+    }
+
+    struct ThreadPoolFor *work = malloc(sizeof(struct ThreadPoolFor));
+    work->Function = function;
+    work->Data = data;
+    work->Count = count;
+    work->ChunkSize = chunkSize;
+    atomic_init(&work->Next, 0);
+    atomic_init(&work->Done, 0);
+    atomic_init(&work->References, helperCount + 1);
+    for (int i = 0; i < helperCount; i++) {
+        threadPoolSubmit(threadPoolForJob, work);
+    }
+    threadPoolForRun(work);
+
+    // helpers that are queued behind other jobs don't hold this up, they find
+    // nothing left when they start
+    pthread_mutex_lock(&_pool.Mutex);
+    while (atomic_load(&work->Done) < count)
+        pthread_cond_wait(&_pool.ForDone, &_pool.Mutex);
+    pthread_mutex_unlock(&_pool.Mutex);
+    threadPoolForRelease(work);
+}
+void threadPoolShutdown() {
+    if (_pool.ThreadCount == 0)
+        return;
+    threadPoolWait();
+
+    pthread_mutex_lock(&_pool.Mutex);
+    _pool.Stopping = true;
+    pthread_cond_broadcast(&_pool.JobAvailable);
+    pthread_mutex_unlock(&_pool.Mutex);
+    for (int i = 0; i < _pool.ThreadCount; i++) {
+        pthread_join(_pool.Threads[i], NULL);
+    }
+    free(_pool.Threads);
+    _pool.Threads = NULL;
+    _pool.ThreadCount = 0;
+}
+
+void *threadPoolWorker(void *_pool) {
+    struct ThreadPool *pool = (struct ThreadPool *)_pool;
+    pthread_mutex_lock(&pool->Mutex);
+    while (true) {
+        while (pool->First == NULL && !pool->Stopping)
+            pthread_cond_wait(&pool->JobAvailable, &pool->Mutex);
+        if (pool->First == NULL)
+            break; // stopping and nothing left to do
+
+        struct ThreadPoolJob *job = pool->First;
+        pool->First = job->Next;
+        if (pool->First == NULL)
+            pool->Last = NULL;
+        pthread_mutex_unlock(&pool->Mutex);
+
+        job->Function(job->Data);
+        free(job);
+
+        pthread_mutex_lock(&pool->Mutex);
+        if (--pool->PendingJobs == 0)
+            pthread_cond_broadcast(&pool->JobsDone);
+    }
+    pthread_mutex_unlock(&pool->Mutex);
+    return NULL;
+}
+
+// takes ranges until there are none left
+void threadPoolForRun(struct ThreadPoolFor *work) {
+    while (true) {
+        int start = atomic_fetch_add(&work->Next, work->ChunkSize);
+        if (start >= work->Count)
+            return;
+        int end = start + work->ChunkSize < work->Count
+                      ? start + work->ChunkSize
+                      : work->Count;
+        work->Function(work->Data, start, end);
+        if (atomic_fetch_add(&work->Done, end - start) + end - start ==
+            work->Count) {
+            pthread_mutex_lock(&_pool.Mutex);
+            pthread_cond_broadcast(&_pool.ForDone);
+            pthread_mutex_unlock(&_pool.Mutex);
+        }
+    }
+}
+void threadPoolForJob(void *_work) {
+    struct ThreadPoolFor *work = (struct ThreadPoolFor *)_work;
+    threadPoolForRun(work);
+    threadPoolForRelease(work);
+}
+void threadPoolForRelease(struct ThreadPoolFor *work) {
+    if (atomic_fetch_sub(&work->References, 1) == 1)
+        free(work);
+}
@@ -0,0 +1,252 @@
+#include "transform.h"
+
+#include "transform_batch.h"
+
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/quat.h>
+#include <cglm/struct/vec3.h>
+#include <cglm/struct/vec4.h>
+#include <math.h>
+#include <string.h>
+
+/// how far the axes of a matrix can be from the same length and square to
+/// each other, relative to their length squared, for it to count as only
+/// rotating and scaling evenly
+#define TRANSFORM_SIMILAR_TOLERANCE 1e-4f
+/// nodes `transformUpdateNodes` composes and applies at a time
+#define TRANSFORM_UPDATE_BLOCK 64
+
+int TransformNodesUpdated = 0;
+
+TransformLocal transformIdentity(void) {
+    return (TransformLocal){
+        .Rotation = GLMS_QUAT_IDENTITY,
+        .Position = GLMS_VEC3_ZERO,
+        .Scaling = GLMS_VEC3_ONE,
+    };
+}
+TransformAffine transformCompose(TransformLocal local) {
+    versors q = local.Rotation;
+    float lengthSquared = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+    float s = lengthSquared > 0 ? 2 / lengthSquared : 0;
+    float xx = s * q.x * q.x, yy = s * q.y * q.y, zz = s * q.z * q.z;
+    float xy = s * q.x * q.y, xz = s * q.x * q.z, yz = s * q.y * q.z;
+    float wx = s * q.w * q.x, wy = s * q.w * q.y, wz = s * q.w * q.z;
+    vec3s scale = local.Scaling;
+    vec3s position = local.Position;
+    return (TransformAffine){{
+        {{(1 - yy - zz) * scale.x, (xy - wz) * scale.y, (xz + wy) * scale.z,
+          position.x}},
+        {{(xy + wz) * scale.x, (1 - xx - zz) * scale.y, (yz - wx) * scale.z,
+          position.y}},
+        {{(xz - wy) * scale.x, (yz + wx) * scale.y, (1 - xx - yy) * scale.z,
+          position.z}},
+    }};
+}
+mat4s transformApply(mat4s worldFromParent, TransformAffine parentFromLocal) {
+    // the bottom row of `parentFromLocal` is left out, it only adds the
+    // translation of `worldFromParent` to the last column
+    mat4s result;
+    for (int column = 0; column < 4; column++) {
+        vec4s value = glms_vec4_scale(worldFromParent.col[0],
+                                      parentFromLocal.Rows[0].raw[column]);
+        value = glms_vec4_muladds(worldFromParent.col[1],
+                                  parentFromLocal.Rows[1].raw[column], value);
+        value = glms_vec4_muladds(worldFromParent.col[2],
+                                  parentFromLocal.Rows[2].raw[column], value);
+        result.col[column] = value;
+    }
+    result.col[3] = glms_vec4_add(result.col[3], worldFromParent.col[3]);
+    return result;
+}
+mat4s transformToMat4(TransformAffine affine) {
+    mat4s result;
+    for (int column = 0; column < 4; column++) {
+        result.col[column] = (vec4s){{
+            affine.Rows[0].raw[column],
+            affine.Rows[1].raw[column],
+            affine.Rows[2].raw[column],
+            column == 3 ? 1 : 0,
+        }};
+    }
+    return result;
+}
+TransformLocal transformDecompose(mat4s parentFromLocal) {
+    TransformLocal local;
+    local.Position = glms_vec3(parentFromLocal.col[3]);
+    vec3s axes[3];
+    for (int i = 0; i < 3; i++) {
+        axes[i] = glms_vec3(parentFromLocal.col[i]);
+        local.Scaling.raw[i] = glms_vec3_norm(axes[i]);
+    }
+    // mirrored, put it on x
+    if (glms_vec3_dot(glms_vec3_cross(axes[0], axes[1]), axes[2]) < 0)
+        local.Scaling.x = -local.Scaling.x;
+
+    mat4s rotationMatrix = GLMS_MAT4_IDENTITY;
+    for (int i = 0; i < 3; i++) {
+        vec3s axis = local.Scaling.raw[i] != 0
+                         ? glms_vec3_scale(axes[i], 1 / local.Scaling.raw[i])
+                         : GLMS_VEC3_ZERO;
+        rotationMatrix.col[i] = (vec4s){{axis.x, axis.y, axis.z, 0}};
+    }
+    local.Rotation = glms_mat4_quat(rotationMatrix);
+    return local;
+}
+bool transformCanCombine(TransformLocal parentFromMiddle,
+                         TransformLocal middleFromLocal) {
+    vec3s scaling = parentFromMiddle.Scaling;
+    float tolerance = TRANSFORM_SIMILAR_TOLERANCE * fabsf(scaling.x);
+    if (fabsf(scaling.y - scaling.x) <= tolerance &&
+        fabsf(scaling.z - scaling.x) <= tolerance)
+        return true;
+    versors rotation = middleFromLocal.Rotation;
+    float axis = rotation.x * rotation.x + rotation.y * rotation.y +
+                 rotation.z * rotation.z;
+    return axis <= TRANSFORM_SIMILAR_TOLERANCE *
+                       glms_quat_dot(rotation, rotation);
+}
+TransformLocal transformCombine(TransformLocal parentFromMiddle,
+                                TransformLocal middleFromLocal) {
+    TransformAffine affine = transformCompose(parentFromMiddle);
+    vec4s position = glms_vec4(middleFromLocal.Position, 1);
+    TransformLocal result;
+    for (int i = 0; i < 3; i++) {
+        result.Position.raw[i] = glms_vec4_dot(affine.Rows[i], position);
+    }
+    result.Rotation = glms_quat_normalize(
+        glms_quat_mul(parentFromMiddle.Rotation, middleFromLocal.Rotation));
+    result.Scaling =
+        glms_vec3_mul(parentFromMiddle.Scaling, middleFromLocal.Scaling);
+    return result;
+}
+mat3s transformNormalMatrix(mat4s worldFromLocal) {
+    vec3s axes[3];
+    for (int i = 0; i < 3; i++) {
+        axes[i] = glms_vec3(worldFromLocal.col[i]);
+    }
+    float length = glms_vec3_dot(axes[0], axes[0]);
+    float tolerance = TRANSFORM_SIMILAR_TOLERANCE * length;
+    mat3s result;
+    if (fabsf(glms_vec3_dot(axes[1], axes[1]) - length) <= tolerance &&
+        fabsf(glms_vec3_dot(axes[2], axes[2]) - length) <= tolerance &&
+        fabsf(glms_vec3_dot(axes[0], axes[1])) <= tolerance &&
+        fabsf(glms_vec3_dot(axes[0], axes[2])) <= tolerance &&
+        fabsf(glms_vec3_dot(axes[1], axes[2])) <= tolerance) {
+        for (int i = 0; i < 3; i++) {
+            result.col[i] = axes[i];
+        }
+        return result;
+    }
+
+    // the inverse transpose times the determinant
+    result.col[0] = glms_vec3_cross(axes[1], axes[2]);
+    result.col[1] = glms_vec3_cross(axes[2], axes[0]);
+    result.col[2] = glms_vec3_cross(axes[0], axes[1]);
+    // which is negative for mirrored ones, and would turn normals inwards
+    if (glms_vec3_dot(axes[0], result.col[0]) < 0) {
+        for (int i = 0; i < 3; i++) {
+            result.col[i] = glms_vec3_negate(result.col[i]);
+        }
+    }
+    return result;
+}
+
+size_t transformArenaSize(int count) {
+    return 2 * ARENA_SIZE(count * sizeof(vec3s)) +
+           ARENA_SIZE(count * sizeof(versors)) +
+           ARENA_SIZE(count * sizeof(mat4s)) +
+           ARENA_SIZE(count * sizeof(bool));
+}
+void transformCreate(struct Arena *arena, TransformHierarchy *hierarchy,
+                     int count, const int *parents) {
+    hierarchy->Count = count;
+    hierarchy->Parents = parents;
+    hierarchy->Positions = arenaAlloc(arena, count * sizeof(vec3s));
+    hierarchy->Rotations = arenaAlloc(arena, count * sizeof(versors));
+    hierarchy->Scalings = arenaAlloc(arena, count * sizeof(vec3s));
+    hierarchy->WorldFromLocal = arenaAlloc(arena, count * sizeof(mat4s));
+    hierarchy->Dirty = arenaAlloc(arena, count * sizeof(bool));
+    hierarchy->FirstDirty = 0;
+    for (int i = 0; i < count; i++) {
+        transformSetLocal(hierarchy, i, transformIdentity());
+        hierarchy->WorldFromLocal[i] = GLMS_MAT4_IDENTITY;
+    }
+    hierarchy->WorldFromRoot = GLMS_MAT4_IDENTITY;
+}
+TransformLocal transformGetLocal(const TransformHierarchy *hierarchy,
+                                 int node) {
+    return (TransformLocal){
+        .Rotation = hierarchy->Rotations[node],
+        .Position = hierarchy->Positions[node],
+        .Scaling = hierarchy->Scalings[node],
+    };
+}
+void transformSetLocal(TransformHierarchy *hierarchy, int node,
+                       TransformLocal local) {
+    hierarchy->Positions[node] = local.Position;
+    hierarchy->Rotations[node] = local.Rotation;
+    hierarchy->Scalings[node] = local.Scaling;
+    transformMarkDirty(hierarchy, node);
+}
+void transformMarkDirty(TransformHierarchy *hierarchy, int node) {
+    hierarchy->Dirty[node] = true;
+    if (node < hierarchy->FirstDirty)
+        hierarchy->FirstDirty = node;
+}
+int transformUpdate(TransformHierarchy *hierarchy, mat4s worldFromRoot) {
+    if (hierarchy->Count == 0)
+        return 0;
+    if (memcmp(&worldFromRoot, &hierarchy->WorldFromRoot, sizeof(mat4s)) !=
+        0) {
+        hierarchy->WorldFromRoot = worldFromRoot;
+        transformMarkDirty(hierarchy, 0);
+    }
+    if (hierarchy->FirstDirty == hierarchy->Count)
+        return 0;
+
+    // parents come first, so by the time a node is reached its parent's flag
+    // already says whether anything above it moved, and its world transform
+    // is worked out by the time the node's block is
+    int updated = 0;
+    int nodes[TRANSFORM_UPDATE_BLOCK];
+    int nodeCount = 0;
+    for (int i = hierarchy->FirstDirty; i < hierarchy->Count; i++) {
+        int parent = hierarchy->Parents[i];
+        if (parent >= 0 && hierarchy->Dirty[parent])
+            hierarchy->Dirty[i] = true;
+        if (!hierarchy->Dirty[i])
+            continue;
+        nodes[nodeCount++] = i;
+        if (nodeCount == TRANSFORM_UPDATE_BLOCK) {
+            transformUpdateNodes(hierarchy, nodes, nodeCount);
+            updated += nodeCount;
+            nodeCount = 0;
+        }
+    }
+    transformUpdateNodes(hierarchy, nodes, nodeCount);
+    updated += nodeCount;
+    memset(&hierarchy->Dirty[hierarchy->FirstDirty], false,
+           (hierarchy->Count - hierarchy->FirstDirty) * sizeof(bool));
+    hierarchy->FirstDirty = hierarchy->Count;
+
+    TransformNodesUpdated += updated;
+    return updated;
+}
+void transformUpdateNodes(TransformHierarchy *hierarchy, const int *nodes,
+                          int count) {
+    TransformAffine parentFromLocals[TRANSFORM_UPDATE_BLOCK];
+    for (int first = 0; first < count; first += TRANSFORM_UPDATE_BLOCK) {
+        int blockCount = count - first < TRANSFORM_UPDATE_BLOCK
+                             ? count - first
+                             : TRANSFORM_UPDATE_BLOCK;
+        transformBatchCompose(hierarchy->Positions, hierarchy->Rotations,
+                              hierarchy->Scalings, &nodes[first], blockCount,
+                              parentFromLocals);
+        transformBatchApply(hierarchy, &nodes[first], parentFromLocals,
+                            blockCount);
+    }
+}
+void transformResetCounters(void) {
+    TransformNodesUpdated = 0;
+}
@@ -0,0 +1,599 @@
+#include "transform_batch.h"
+
+#include <cglm/struct/mat4.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSFORM_BATCH_X86
+#endif
+
+/// transforms or spheres worked on together by the compose and cull kernels,
+/// one AVX-512 register, two AVX2 or four SSE ones
+#define TRANSFORM_BATCH_LANES 16
+
+typedef float TransformBatchFloats
+    __attribute__((vector_size(TRANSFORM_BATCH_LANES * sizeof(float))));
+
+/// one value per lane in each
+struct TransformBatchLanes {
+    TransformBatchFloats Position[3];
+    TransformBatchFloats Rotation[4];
+    TransformBatchFloats Scale[3];
+    /// the three rows of the results, one after another
+    TransformBatchFloats Matrix[12];
+};
+struct TransformBatchSpheres {
+    TransformBatchFloats Center[3];
+    TransformBatchFloats Radius;
+    /// a bit per lane, set for the visible ones
+    uint32_t Visible;
+};
+
+enum TransformBatchPath TransformBatchPath = TRANSFORMBATCH_AUTO;
+
+/// the widest path the CPU can run, found the first time it's needed
+enum TransformBatchPath _supportedPath = TRANSFORMBATCH_SCALAR;
+pthread_once_t _supportedOnce = PTHREAD_ONCE_INIT;
+
+const char *_pathNames[TRANSFORMBATCH_PATH_COUNT] = {"scalar", "sse4.1",
+                                                     "avx2", "avx-512"};
+
+void transformBatchDetect(void);
+void transformBatchMulScalar(const mat4s *const *left,
+                             const mat4s *const *right, mat4s *results,
+                             int count);
+void transformBatchApplyScalar(TransformHierarchy *hierarchy, const int *nodes,
+                               const TransformAffine *parentFromLocals,
+                               int count);
+bool transformBatchCullSphere(const vec4s *planes, const float *sphere);
+#ifdef TRANSFORM_BATCH_X86
+__m128 transformBatchLoadVec3(const vec3s *vector);
+void transformBatchGather(struct TransformBatchLanes *lanes, int lane,
+                          const vec3s *positions, const versors *rotations,
+                          const vec3s *scalings, const int *nodes, int first);
+void transformBatchScatter(const struct TransformBatchLanes *lanes, int lane,
+                           TransformAffine *results);
+void transformBatchMulSse4(const mat4s *const *left, const mat4s *const *right,
+                           mat4s *results, int count);
+void transformBatchMulAvx2(const mat4s *const *left, const mat4s *const *right,
+                           mat4s *results, int count);
+void transformBatchMulAvx512(const mat4s *const *left,
+                             const mat4s *const *right, mat4s *results,
+                             int count);
+void transformBatchApplySse4(TransformHierarchy *hierarchy, const int *nodes,
+                             const TransformAffine *parentFromLocals,
+                             int count);
+void transformBatchApplyAvx2(TransformHierarchy *hierarchy, const int *nodes,
+                             const TransformAffine *parentFromLocals,
+                             int count);
+void transformBatchApplyAvx512(TransformHierarchy *hierarchy, const int *nodes,
+                               const TransformAffine *parentFromLocals,
+                               int count);
+void transformBatchComposeSse4(struct TransformBatchLanes *lanes);
+void transformBatchComposeAvx2(struct TransformBatchLanes *lanes);
+void transformBatchComposeAvx512(struct TransformBatchLanes *lanes);
+void transformBatchCullSse4(struct TransformBatchSpheres *spheres,
+                            const vec4s *planes);
+void transformBatchCullAvx2(struct TransformBatchSpheres *spheres,
+                            const vec4s *planes);
+void transformBatchCullAvx512(struct TransformBatchSpheres *spheres,
+                              const vec4s *planes);
+#endif
+
+enum TransformBatchPath transformBatchGetPath(void) {
+    pthread_once(&_supportedOnce, transformBatchDetect);
+    if (TransformBatchPath == TRANSFORMBATCH_AUTO ||
+        TransformBatchPath > _supportedPath)
+        return _supportedPath;
+    return TransformBatchPath;
+}
+const char *transformBatchPathName(enum TransformBatchPath path) {
+    if (path < 0 || path >= TRANSFORMBATCH_PATH_COUNT)
+        return "auto";
+    return _pathNames[path];
+}
+
+void transformBatchMul(const mat4s *const *left, const mat4s *const *right,
+                       mat4s *results, int count) {
+    switch (transformBatchGetPath()) {
+#ifdef TRANSFORM_BATCH_X86
+    case TRANSFORMBATCH_AVX512:
+        transformBatchMulAvx512(left, right, results, count);
+        return;
+    case TRANSFORMBATCH_AVX2:
+        transformBatchMulAvx2(left, right, results, count);
+        return;
+    case TRANSFORMBATCH_SSE4:
+        transformBatchMulSse4(left, right, results, count);
+        return;
+#endif
+    default:
+        transformBatchMulScalar(left, right, results, count);
+        return;
+    }
+}
+void transformBatchCompose(const vec3s *positions, const versors *rotations,
+                           const vec3s *scalings, const int *nodes, int count,
+                           TransformAffine *results) {
+    enum TransformBatchPath path = transformBatchGetPath();
+    int first = 0;
+#ifdef TRANSFORM_BATCH_X86
+    struct TransformBatchLanes lanes;
+    for (; path != TRANSFORMBATCH_SCALAR &&
+           first + TRANSFORM_BATCH_LANES <= count;
+         first += TRANSFORM_BATCH_LANES) {
+        for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane += 4) {
+            transformBatchGather(&lanes, lane, positions, rotations, scalings,
+                                 nodes, first + lane);
+        }
+        switch (path) {
+        case TRANSFORMBATCH_AVX512:
+            transformBatchComposeAvx512(&lanes);
+            break;
+        case TRANSFORMBATCH_AVX2:
+            transformBatchComposeAvx2(&lanes);
+            break;
+        default:
+            transformBatchComposeSse4(&lanes);
+            break;
+        }
+        for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane += 4) {
+            transformBatchScatter(&lanes, lane, &results[first + lane]);
+        }
+    }
+#endif
+    // the rest one at a time
+    for (; first < count; first++) {
+        int node = nodes != NULL ? nodes[first] : first;
+        results[first] = transformCompose(
+            (TransformLocal){rotations[node], positions[node], scalings[node]});
+    }
+}
+void transformBatchApply(TransformHierarchy *hierarchy, const int *nodes,
+                         const TransformAffine *parentFromLocals, int count) {
+    switch (transformBatchGetPath()) {
+#ifdef TRANSFORM_BATCH_X86
+    case TRANSFORMBATCH_AVX512:
+        transformBatchApplyAvx512(hierarchy, nodes, parentFromLocals, count);
+        return;
+    case TRANSFORMBATCH_AVX2:
+        transformBatchApplyAvx2(hierarchy, nodes, parentFromLocals, count);
+        return;
+    case TRANSFORMBATCH_SSE4:
+        transformBatchApplySse4(hierarchy, nodes, parentFromLocals, count);
+        return;
+#endif
+    default:
+        transformBatchApplyScalar(hierarchy, nodes, parentFromLocals, count);
+        return;
+    }
+}
+int transformBatchCullSpheres(const vec4s *planes, const float *spheres,
+                              size_t stride, int count, bool *visible) {
+    enum TransformBatchPath path = transformBatchGetPath();
+    int visibleCount = 0;
+    int first = 0;
+#ifdef TRANSFORM_BATCH_X86
+    struct TransformBatchSpheres lanes;
+    for (; path != TRANSFORMBATCH_SCALAR &&
+           first + TRANSFORM_BATCH_LANES <= count;
+         first += TRANSFORM_BATCH_LANES) {
+        for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane += 4) {
+            __m128 sphere[4];
+            for (int i = 0; i < 4; i++) {
+                sphere[i] = _mm_loadu_ps(
+                    (const float *)((const char *)spheres +
+                                    (first + lane + i) * stride));
+            }
+            _MM_TRANSPOSE4_PS(sphere[0], sphere[1], sphere[2], sphere[3]);
+            for (int j = 0; j < 3; j++) {
+                _mm_storeu_ps((float *)&lanes.Center[j] + lane, sphere[j]);
+            }
+            _mm_storeu_ps((float *)&lanes.Radius + lane, sphere[3]);
+        }
+        switch (path) {
+        case TRANSFORMBATCH_AVX512:
+            transformBatchCullAvx512(&lanes, planes);
+            break;
+        case TRANSFORMBATCH_AVX2:
+            transformBatchCullAvx2(&lanes, planes);
+            break;
+        default:
+            transformBatchCullSse4(&lanes, planes);
+            break;
+        }
+        for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane++) {
+            visible[first + lane] = (lanes.Visible >> lane) & 1;
+            visibleCount += visible[first + lane];
+        }
+    }
+#endif
+    for (; first < count; first++) {
+        visible[first] = transformBatchCullSphere(
+            planes, (const float *)((const char *)spheres + first * stride));
+        visibleCount += visible[first];
+    }
+    return visibleCount;
+}
+
+void transformBatchDetect(void) {
+#ifdef TRANSFORM_BATCH_X86
+    // also checks the OS saves the wider registers
+    if (__builtin_cpu_supports("avx512f"))
+        _supportedPath = TRANSFORMBATCH_AVX512;
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        _supportedPath = TRANSFORMBATCH_AVX2;
+    else if (__builtin_cpu_supports("sse4.1"))
+        _supportedPath = TRANSFORMBATCH_SSE4;
+#endif
+}
+
+// the lane math is written once with vector extensions and inlined into a
+// function per instruction set, which the compiler splits into registers of
+// that width
+__attribute__((always_inline)) static inline void
+transformBatchComposeLanes(struct TransformBatchLanes *lanes) {
+    TransformBatchFloats x = lanes->Rotation[0], y = lanes->Rotation[1],
+                         z = lanes->Rotation[2], w = lanes->Rotation[3];
+    // `transformBatchGather` made zero quaternions the identity
+    TransformBatchFloats s = 2 / (x * x + y * y + z * z + w * w);
+    TransformBatchFloats xx = s * x * x, yy = s * y * y, zz = s * z * z;
+    TransformBatchFloats xy = s * x * y, xz = s * x * z, yz = s * y * z;
+    TransformBatchFloats wx = s * w * x, wy = s * w * y, wz = s * w * z;
+    TransformBatchFloats *scale = lanes->Scale, *m = lanes->Matrix;
+    m[0] = (1 - yy - zz) * scale[0];
+    m[1] = (xy - wz) * scale[1];
+    m[2] = (xz + wy) * scale[2];
+    m[3] = lanes->Position[0];
+    m[4] = (xy + wz) * scale[0];
+    m[5] = (1 - xx - zz) * scale[1];
+    m[6] = (yz - wx) * scale[2];
+    m[7] = lanes->Position[1];
+    m[8] = (xz - wy) * scale[0];
+    m[9] = (yz + wx) * scale[1];
+    m[10] = (1 - xx - yy) * scale[2];
+    m[11] = lanes->Position[2];
+}
+void transformBatchMulScalar(const mat4s *const *left,
+                             const mat4s *const *right, mat4s *results,
+                             int count) {
+    for (int i = 0; i < count; i++) {
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                float value = 0;
+                for (int k = 0; k < 4; k++) {
+                    value += left[i]->raw[k][row] * right[i]->raw[column][k];
+                }
+                results[i].raw[column][row] = value;
+            }
+        }
+    }
+}
+void transformBatchApplyScalar(TransformHierarchy *hierarchy, const int *nodes,
+                               const TransformAffine *parentFromLocals,
+                               int count) {
+    for (int i = 0; i < count; i++) {
+        int parent = hierarchy->Parents[nodes[i]];
+        hierarchy->WorldFromLocal[nodes[i]] = transformApply(
+            parent >= 0 ? hierarchy->WorldFromLocal[parent]
+                        : hierarchy->WorldFromRoot,
+            parentFromLocals[i]);
+    }
+}
+bool transformBatchCullSphere(const vec4s *planes, const float *sphere) {
+    for (int i = 0; i < 6; i++) {
+        if (planes[i].x * sphere[0] + planes[i].y * sphere[1] +
+                planes[i].z * sphere[2] + planes[i].w <
+            -sphere[3])
+            return false;
+    }
+    return true;
+}
+
+#ifdef TRANSFORM_BATCH_X86
+// the 4th float could be past the end of the array. vec3s is only 4 byte
+// aligned, so the first two go in through an unaligned 64 bit load
+__m128 transformBatchLoadVec3(const vec3s *vector) {
+    return _mm_movelh_ps(
+        _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)vector->raw)),
+        _mm_load_ss(&vector->raw[2]));
+}
+// 4 transforms into the lanes from `lane` on, loaded whole and transposed
+void transformBatchGather(struct TransformBatchLanes *lanes, int lane,
+                          const vec3s *positions, const versors *rotations,
+                          const vec3s *scalings, const int *nodes, int first) {
+    __m128 position[4], rotation[4], scaling[4];
+    for (int i = 0; i < 4; i++) {
+        int node = nodes != NULL ? nodes[first + i] : first + i;
+        position[i] = transformBatchLoadVec3(&positions[node]);
+        rotation[i] = _mm_loadu_ps(rotations[node].raw);
+        scaling[i] = transformBatchLoadVec3(&scalings[node]);
+    }
+    _MM_TRANSPOSE4_PS(position[0], position[1], position[2], position[3]);
+    _MM_TRANSPOSE4_PS(rotation[0], rotation[1], rotation[2], rotation[3]);
+    _MM_TRANSPOSE4_PS(scaling[0], scaling[1], scaling[2], scaling[3]);
+    // `transformCompose` leaves out the rotation of a zero quaternion, which
+    // is the same as an identity one
+    __m128 lengthSquared = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(rotation[0], rotation[0]),
+                   _mm_mul_ps(rotation[1], rotation[1])),
+        _mm_add_ps(_mm_mul_ps(rotation[2], rotation[2]),
+                   _mm_mul_ps(rotation[3], rotation[3])));
+    __m128 zero = _mm_cmpeq_ps(lengthSquared, _mm_setzero_ps());
+    for (int j = 0; j < 3; j++) {
+        rotation[j] = _mm_andnot_ps(zero, rotation[j]);
+    }
+    rotation[3] = _mm_or_ps(_mm_andnot_ps(zero, rotation[3]),
+                            _mm_and_ps(zero, _mm_set1_ps(1)));
+    for (int j = 0; j < 3; j++) {
+        _mm_storeu_ps((float *)&lanes->Position[j] + lane, position[j]);
+        _mm_storeu_ps((float *)&lanes->Scale[j] + lane, scaling[j]);
+    }
+    for (int j = 0; j < 4; j++) {
+        _mm_storeu_ps((float *)&lanes->Rotation[j] + lane, rotation[j]);
+    }
+}
+// and the other way round, a row of 4 results at a time
+void transformBatchScatter(const struct TransformBatchLanes *lanes, int lane,
+                           TransformAffine *results) {
+    for (int row = 0; row < 3; row++) {
+        __m128 column[4];
+        for (int j = 0; j < 4; j++) {
+            column[j] =
+                _mm_loadu_ps((const float *)&lanes->Matrix[row * 4 + j] + lane);
+        }
+        _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+        for (int i = 0; i < 4; i++) {
+            _mm_storeu_ps(results[i].Rows[row].raw, column[i]);
+        }
+    }
+}
+
+// a column of the result at a time, each the columns of the left matrix
+// scaled by the right one's
+__attribute__((target("sse4.1"))) void
+transformBatchMulSse4(const mat4s *const *left, const mat4s *const *right,
+                      mat4s *results, int count) {
+    for (int i = 0; i < count; i++) {
+        __m128 l0 = _mm_loadu_ps(left[i]->raw[0]);
+        __m128 l1 = _mm_loadu_ps(left[i]->raw[1]);
+        __m128 l2 = _mm_loadu_ps(left[i]->raw[2]);
+        __m128 l3 = _mm_loadu_ps(left[i]->raw[3]);
+        for (int column = 0; column < 4; column++) {
+            const float *r = right[i]->raw[column];
+            __m128 value = _mm_mul_ps(l0, _mm_set1_ps(r[0]));
+            value = _mm_add_ps(value, _mm_mul_ps(l1, _mm_set1_ps(r[1])));
+            value = _mm_add_ps(value, _mm_mul_ps(l2, _mm_set1_ps(r[2])));
+            value = _mm_add_ps(value, _mm_mul_ps(l3, _mm_set1_ps(r[3])));
+            _mm_storeu_ps(results[i].raw[column], value);
+        }
+    }
+}
+// two columns at a time, the left columns are in both halves and each half
+// of the right pair is spread across its own
+__attribute__((target("avx2,fma"))) void
+transformBatchMulAvx2(const mat4s *const *left, const mat4s *const *right,
+                      mat4s *results, int count) {
+    for (int i = 0; i < count; i++) {
+        __m256 l0 = _mm256_broadcast_ps((const __m128 *)left[i]->raw[0]);
+        __m256 l1 = _mm256_broadcast_ps((const __m128 *)left[i]->raw[1]);
+        __m256 l2 = _mm256_broadcast_ps((const __m128 *)left[i]->raw[2]);
+        __m256 l3 = _mm256_broadcast_ps((const __m128 *)left[i]->raw[3]);
+        for (int column = 0; column < 4; column += 2) {
+            __m256 r = _mm256_loadu_ps(right[i]->raw[column]);
+            __m256 value = _mm256_mul_ps(l0, _mm256_permute_ps(r, 0x00));
+            value = _mm256_fmadd_ps(l1, _mm256_permute_ps(r, 0x55), value);
+            value = _mm256_fmadd_ps(l2, _mm256_permute_ps(r, 0xaa), value);
+            value = _mm256_fmadd_ps(l3, _mm256_permute_ps(r, 0xff), value);
+            _mm256_storeu_ps(results[i].raw[column], value);
+        }
+    }
+}
+// the whole matrix at once, the same way as with AVX2
+__attribute__((target("avx512f"))) void
+transformBatchMulAvx512(const mat4s *const *left, const mat4s *const *right,
+                        mat4s *results, int count) {
+    for (int i = 0; i < count; i++) {
+        __m512 l0 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[i]->raw[0]));
+        __m512 l1 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[i]->raw[1]));
+        __m512 l2 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[i]->raw[2]));
+        __m512 l3 = _mm512_broadcast_f32x4(_mm_loadu_ps(left[i]->raw[3]));
+        __m512 r = _mm512_loadu_ps(right[i]->raw[0]);
+        __m512 value = _mm512_mul_ps(l0, _mm512_permute_ps(r, 0x00));
+        value = _mm512_fmadd_ps(l1, _mm512_permute_ps(r, 0x55), value);
+        value = _mm512_fmadd_ps(l2, _mm512_permute_ps(r, 0xaa), value);
+        value = _mm512_fmadd_ps(l3, _mm512_permute_ps(r, 0xff), value);
+        _mm512_storeu_ps(results[i].raw[0], value);
+    }
+}
+
+// like the multiplies, with the right matrix's columns read down its rows and
+// its bottom row only adding the parent's translation
+__attribute__((target("sse4.1"))) void
+transformBatchApplySse4(TransformHierarchy *hierarchy, const int *nodes,
+                        const TransformAffine *parentFromLocals, int count) {
+    for (int i = 0; i < count; i++) {
+        int parent = hierarchy->Parents[nodes[i]];
+        const mat4s *worldFromParent = parent >= 0
+                                           ? &hierarchy->WorldFromLocal[parent]
+                                           : &hierarchy->WorldFromRoot;
+        __m128 p0 = _mm_loadu_ps(worldFromParent->raw[0]);
+        __m128 p1 = _mm_loadu_ps(worldFromParent->raw[1]);
+        __m128 p2 = _mm_loadu_ps(worldFromParent->raw[2]);
+        __m128 p3 = _mm_loadu_ps(worldFromParent->raw[3]);
+        const TransformAffine *affine = &parentFromLocals[i];
+        mat4s *result = &hierarchy->WorldFromLocal[nodes[i]];
+        for (int column = 0; column < 4; column++) {
+            __m128 value =
+                _mm_mul_ps(p0, _mm_set1_ps(affine->Rows[0].raw[column]));
+            value = _mm_add_ps(
+                value,
+                _mm_mul_ps(p1, _mm_set1_ps(affine->Rows[1].raw[column])));
+            value = _mm_add_ps(
+                value,
+                _mm_mul_ps(p2, _mm_set1_ps(affine->Rows[2].raw[column])));
+            if (column == 3)
+                value = _mm_add_ps(value, p3);
+            _mm_storeu_ps(result->raw[column], value);
+        }
+    }
+}
+__attribute__((target("avx2,fma"))) void
+transformBatchApplyAvx2(TransformHierarchy *hierarchy, const int *nodes,
+                        const TransformAffine *parentFromLocals, int count) {
+    __m256i columns01 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    __m256i columns23 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+    for (int i = 0; i < count; i++) {
+        int parent = hierarchy->Parents[nodes[i]];
+        const mat4s *worldFromParent = parent >= 0
+                                           ? &hierarchy->WorldFromLocal[parent]
+                                           : &hierarchy->WorldFromRoot;
+        __m256 p0 =
+            _mm256_broadcast_ps((const __m128 *)worldFromParent->raw[0]);
+        __m256 p1 =
+            _mm256_broadcast_ps((const __m128 *)worldFromParent->raw[1]);
+        __m256 p2 =
+            _mm256_broadcast_ps((const __m128 *)worldFromParent->raw[2]);
+        __m256 translation = _mm256_insertf128_ps(
+            _mm256_setzero_ps(), _mm_loadu_ps(worldFromParent->raw[3]), 1);
+        const TransformAffine *affine = &parentFromLocals[i];
+        __m256 row0 = _mm256_broadcast_ps((const __m128 *)&affine->Rows[0]);
+        __m256 row1 = _mm256_broadcast_ps((const __m128 *)&affine->Rows[1]);
+        __m256 row2 = _mm256_broadcast_ps((const __m128 *)&affine->Rows[2]);
+        mat4s *result = &hierarchy->WorldFromLocal[nodes[i]];
+
+        __m256 value =
+            _mm256_mul_ps(p0, _mm256_permutevar_ps(row0, columns01));
+        value = _mm256_fmadd_ps(p1, _mm256_permutevar_ps(row1, columns01),
+                                value);
+        value = _mm256_fmadd_ps(p2, _mm256_permutevar_ps(row2, columns01),
+                                value);
+        _mm256_storeu_ps(result->raw[0], value);
+        value = _mm256_fmadd_ps(p0, _mm256_permutevar_ps(row0, columns23),
+                                translation);
+        value = _mm256_fmadd_ps(p1, _mm256_permutevar_ps(row1, columns23),
+                                value);
+        value = _mm256_fmadd_ps(p2, _mm256_permutevar_ps(row2, columns23),
+                                value);
+        _mm256_storeu_ps(result->raw[2], value);
+    }
+}
+__attribute__((target("avx512f"))) void
+transformBatchApplyAvx512(TransformHierarchy *hierarchy, const int *nodes,
+                          const TransformAffine *parentFromLocals, int count) {
+    __m512i columns = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                        3, 3, 3, 3);
+    for (int i = 0; i < count; i++) {
+        int parent = hierarchy->Parents[nodes[i]];
+        const mat4s *worldFromParent = parent >= 0
+                                           ? &hierarchy->WorldFromLocal[parent]
+                                           : &hierarchy->WorldFromRoot;
+        __m512 p0 =
+            _mm512_broadcast_f32x4(_mm_loadu_ps(worldFromParent->raw[0]));
+        __m512 p1 =
+            _mm512_broadcast_f32x4(_mm_loadu_ps(worldFromParent->raw[1]));
+        __m512 p2 =
+            _mm512_broadcast_f32x4(_mm_loadu_ps(worldFromParent->raw[2]));
+        __m512 translation = _mm512_insertf32x4(
+            _mm512_setzero_ps(), _mm_loadu_ps(worldFromParent->raw[3]), 3);
+        const TransformAffine *affine = &parentFromLocals[i];
+        __m512 row0 = _mm512_broadcast_f32x4(_mm_loadu_ps(affine->Rows[0].raw));
+        __m512 row1 = _mm512_broadcast_f32x4(_mm_loadu_ps(affine->Rows[1].raw));
+        __m512 row2 = _mm512_broadcast_f32x4(_mm_loadu_ps(affine->Rows[2].raw));
+
+        __m512 value = _mm512_fmadd_ps(
+            p0, _mm512_permutevar_ps(row0, columns), translation);
+        value =
+            _mm512_fmadd_ps(p1, _mm512_permutevar_ps(row1, columns), value);
+        value =
+            _mm512_fmadd_ps(p2, _mm512_permutevar_ps(row2, columns), value);
+        _mm512_storeu_ps(hierarchy->WorldFromLocal[nodes[i]].raw[0], value);
+    }
+}
+
+__attribute__((target("sse4.1"))) void
+transformBatchComposeSse4(struct TransformBatchLanes *lanes) {
+    transformBatchComposeLanes(lanes);
+}
+__attribute__((target("avx2,fma"))) void
+transformBatchComposeAvx2(struct TransformBatchLanes *lanes) {
+    transformBatchComposeLanes(lanes);
+}
+__attribute__((target("avx512f"))) void
+transformBatchComposeAvx512(struct TransformBatchLanes *lanes) {
+    transformBatchComposeLanes(lanes);
+}
+// the same sums as `transformBatchCullSphere`, so they agree exactly
+__attribute__((target("sse4.1"))) void
+transformBatchCullSse4(struct TransformBatchSpheres *spheres,
+                       const vec4s *planes) {
+    spheres->Visible = 0;
+    for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane += 4) {
+        __m128 x = _mm_loadu_ps((const float *)&spheres->Center[0] + lane);
+        __m128 y = _mm_loadu_ps((const float *)&spheres->Center[1] + lane);
+        __m128 z = _mm_loadu_ps((const float *)&spheres->Center[2] + lane);
+        __m128 radius = _mm_sub_ps(
+            _mm_setzero_ps(),
+            _mm_loadu_ps((const float *)&spheres->Radius + lane));
+        __m128 visible = _mm_cmpeq_ps(x, x);
+        for (int i = 0; i < 6; i++) {
+            __m128 distance = _mm_mul_ps(_mm_set1_ps(planes[i].x), x);
+            distance = _mm_add_ps(distance,
+                                  _mm_mul_ps(_mm_set1_ps(planes[i].y), y));
+            distance = _mm_add_ps(distance,
+                                  _mm_mul_ps(_mm_set1_ps(planes[i].z), z));
+            distance = _mm_add_ps(distance, _mm_set1_ps(planes[i].w));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, radius));
+        }
+        spheres->Visible |= (uint32_t)_mm_movemask_ps(visible) << lane;
+    }
+}
+__attribute__((target("avx2,fma"))) void
+transformBatchCullAvx2(struct TransformBatchSpheres *spheres,
+                       const vec4s *planes) {
+    spheres->Visible = 0;
+    for (int lane = 0; lane < TRANSFORM_BATCH_LANES; lane += 8) {
+        __m256 x = _mm256_loadu_ps((const float *)&spheres->Center[0] + lane);
+        __m256 y = _mm256_loadu_ps((const float *)&spheres->Center[1] + lane);
+        __m256 z = _mm256_loadu_ps((const float *)&spheres->Center[2] + lane);
+        __m256 radius = _mm256_sub_ps(
+            _mm256_setzero_ps(),
+            _mm256_loadu_ps((const float *)&spheres->Radius + lane));
+        __m256 visible = _mm256_cmp_ps(x, x, _CMP_EQ_OQ);
+        for (int i = 0; i < 6; i++) {
+            __m256 distance = _mm256_mul_ps(_mm256_set1_ps(planes[i].x), x);
+            distance = _mm256_add_ps(
+                distance, _mm256_mul_ps(_mm256_set1_ps(planes[i].y), y));
+            distance = _mm256_add_ps(
+                distance, _mm256_mul_ps(_mm256_set1_ps(planes[i].z), z));
+            distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[i].w));
+            visible = _mm256_and_ps(
+                visible, _mm256_cmp_ps(distance, radius, _CMP_GE_OQ));
+        }
+        spheres->Visible |= (uint32_t)_mm256_movemask_ps(visible) << lane;
+    }
+}
+__attribute__((target("avx512f"))) void
+transformBatchCullAvx512(struct TransformBatchSpheres *spheres,
+                         const vec4s *planes) {
+    __m512 x = _mm512_loadu_ps(&spheres->Center[0]);
+    __m512 y = _mm512_loadu_ps(&spheres->Center[1]);
+    __m512 z = _mm512_loadu_ps(&spheres->Center[2]);
+    __m512 radius =
+        _mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(&spheres->Radius));
+    __mmask16 visible = 0xffff;
+    for (int i = 0; i < 6; i++) {
+        __m512 distance = _mm512_mul_ps(_mm512_set1_ps(planes[i].x), x);
+        distance = _mm512_add_ps(
+            distance, _mm512_mul_ps(_mm512_set1_ps(planes[i].y), y));
+        distance = _mm512_add_ps(
+            distance, _mm512_mul_ps(_mm512_set1_ps(planes[i].z), z));
+        distance = _mm512_add_ps(distance, _mm512_set1_ps(planes[i].w));
+        visible =
+            _mm512_mask_cmp_ps_mask(visible, distance, radius, _CMP_GE_OQ);
+    }
+    spheres->Visible = visible;
+}
+#endif
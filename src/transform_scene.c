@@ -0,0 +1,201 @@
+#include "transform_scene.h"
+
+#include "thread_pool.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// what the jobs of one depth share
+struct TransformSceneLevel {
+    TransformScene *Scene;
+    /// index in `Nodes` the ranges are counted from
+    int First;
+    atomic_int Updated;
+};
+
+/// nodes of one hierarchy gathered before they're worked out together
+#define TRANSFORM_SCENE_BLOCK 64
+
+int TransformSceneChunkSize = 1024;
+
+void transformSceneBuildLevels(TransformScene *scene);
+void transformSceneUpdateNodes(void *_level, int start, int end);
+
+TransformScene *transformSceneCreate(void) {
+    TransformScene *scene = calloc(1, sizeof(TransformScene));
+    return scene;
+}
+void transformSceneAdd(TransformScene *scene, TransformHierarchy *hierarchy,
+                       const mat4s *worldFromRoot) {
+    if (scene->HierarchyCount == scene->HierarchyCapacity) {
+        scene->HierarchyCapacity =
+            scene->HierarchyCapacity > 0 ? scene->HierarchyCapacity * 2 : 16;
+        scene->Hierarchies =
+            realloc(scene->Hierarchies,
+                    scene->HierarchyCapacity * sizeof(TransformHierarchy *));
+        scene->WorldFromRoots = realloc(
+            scene->WorldFromRoots, scene->HierarchyCapacity * sizeof(mat4s *));
+    }
+    scene->Hierarchies[scene->HierarchyCount] = hierarchy;
+    scene->WorldFromRoots[scene->HierarchyCount] = worldFromRoot;
+    scene->HierarchyCount++;
+    scene->LevelsStale = true;
+}
+void transformSceneRemove(TransformScene *scene,
+                          TransformHierarchy *hierarchy) {
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        if (scene->Hierarchies[i] != hierarchy)
+            continue;
+        scene->HierarchyCount--;
+        scene->Hierarchies[i] = scene->Hierarchies[scene->HierarchyCount];
+        scene->WorldFromRoots[i] = scene->WorldFromRoots[scene->HierarchyCount];
+        scene->LevelsStale = true;
+        return;
+    }
+}
+int transformSceneUpdate(TransformScene *scene) {
+    if (scene->LevelsStale)
+        transformSceneBuildLevels(scene);
+
+    // roots that were moved dirty their whole hierarchy, the same as
+    // `transformUpdate`
+    bool anyDirty = false;
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        TransformHierarchy *hierarchy = scene->Hierarchies[i];
+        if (hierarchy->Count == 0)
+            continue;
+        const mat4s *worldFromRoot = scene->WorldFromRoots[i];
+        if (memcmp(worldFromRoot, &hierarchy->WorldFromRoot, sizeof(mat4s)) !=
+            0) {
+            hierarchy->WorldFromRoot = *worldFromRoot;
+            transformMarkDirty(hierarchy, 0);
+        }
+        if (hierarchy->FirstDirty < hierarchy->Count)
+            anyDirty = true;
+    }
+    if (!anyDirty)
+        return 0;
+
+    // returning from `threadPoolFor` is the barrier, every parent of the next
+    // depth is done by then
+    int updated = 0;
+    for (int level = 0; level < scene->LevelCount; level++) {
+        struct TransformSceneLevel work = {
+            .Scene = scene,
+            .First = scene->LevelStarts[level],
+        };
+        atomic_init(&work.Updated, 0);
+        threadPoolFor(scene->LevelStarts[level + 1] - work.First,
+                      TransformSceneChunkSize, transformSceneUpdateNodes,
+                      &work);
+        updated += atomic_load(&work.Updated);
+    }
+
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        TransformHierarchy *hierarchy = scene->Hierarchies[i];
+        if (hierarchy->FirstDirty >= hierarchy->Count)
+            continue;
+        memset(&hierarchy->Dirty[hierarchy->FirstDirty], false,
+               (hierarchy->Count - hierarchy->FirstDirty) * sizeof(bool));
+        hierarchy->FirstDirty = hierarchy->Count;
+    }
+    TransformNodesUpdated += updated;
+    return updated;
+}
+void transformSceneFree(TransformScene *scene) {
+    free(scene->Hierarchies);
+    free(scene->WorldFromRoots);
+    free(scene->Nodes);
+    free(scene->LevelStarts);
+    free(scene);
+}
+
+// `transformUpdate`'s loop body for a range of one depth. every node only
+// writes its own flag and matrix and reads its parent's, which the depth
+// before finished
+void transformSceneUpdateNodes(void *_level, int start, int end) {
+    struct TransformSceneLevel *level = (struct TransformSceneLevel *)_level;
+    TransformScene *scene = level->Scene;
+    TransformSceneNode *nodes = &scene->Nodes[level->First];
+    int updated = 0;
+    // the nodes of a hierarchy are next to each other within a depth
+    TransformHierarchy *blockHierarchy = NULL;
+    int block[TRANSFORM_SCENE_BLOCK];
+    int blockCount = 0;
+    for (int i = start; i < end; i++) {
+        TransformHierarchy *hierarchy = scene->Hierarchies[nodes[i].Hierarchy];
+        if (hierarchy != blockHierarchy ||
+            blockCount == TRANSFORM_SCENE_BLOCK) {
+            transformUpdateNodes(blockHierarchy, block, blockCount);
+            updated += blockCount;
+            blockHierarchy = hierarchy;
+            blockCount = 0;
+        }
+        int node = nodes[i].Node;
+        // neither it nor anything above it changed
+        if (node < hierarchy->FirstDirty)
+            continue;
+        int parent = hierarchy->Parents[node];
+        if (parent >= 0 && hierarchy->Dirty[parent])
+            hierarchy->Dirty[node] = true;
+        if (hierarchy->Dirty[node])
+            block[blockCount++] = node;
+    }
+    transformUpdateNodes(blockHierarchy, block, blockCount);
+    updated += blockCount;
+    atomic_fetch_add(&level->Updated, updated);
+}
+
+// sorts the nodes by depth, counting them first. parents come before their
+// children, so one pass over each hierarchy finds every depth
+void transformSceneBuildLevels(TransformScene *scene) {
+    scene->NodeCount = 0;
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        scene->NodeCount += scene->Hierarchies[i]->Count;
+    }
+    int *depths = malloc(scene->NodeCount * sizeof(int));
+    int levelCount = 0;
+    int offset = 0;
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        TransformHierarchy *hierarchy = scene->Hierarchies[i];
+        int *hierarchyDepths = &depths[offset];
+        for (int node = 0; node < hierarchy->Count; node++) {
+            int parent = hierarchy->Parents[node];
+            hierarchyDepths[node] =
+                parent >= 0 ? hierarchyDepths[parent] + 1 : 0;
+            if (hierarchyDepths[node] >= levelCount)
+                levelCount = hierarchyDepths[node] + 1;
+        }
+        offset += hierarchy->Count;
+    }
+
+    scene->LevelCount = levelCount;
+    scene->LevelStarts =
+        realloc(scene->LevelStarts, (levelCount + 1) * sizeof(int));
+    memset(scene->LevelStarts, 0, (levelCount + 1) * sizeof(int));
+    for (int i = 0; i < scene->NodeCount; i++) {
+        scene->LevelStarts[depths[i] + 1]++;
+    }
+    for (int level = 0; level < levelCount; level++) {
+        scene->LevelStarts[level + 1] += scene->LevelStarts[level];
+    }
+
+    // going through the hierarchies in order keeps each one's nodes next to
+    // each other within a depth
+    scene->Nodes =
+        realloc(scene->Nodes, scene->NodeCount * sizeof(TransformSceneNode));
+    int *next = malloc((levelCount + 1) * sizeof(int));
+    memcpy(next, scene->LevelStarts, (levelCount + 1) * sizeof(int));
+    offset = 0;
+    for (int i = 0; i < scene->HierarchyCount; i++) {
+        for (int node = 0; node < scene->Hierarchies[i]->Count; node++) {
+            scene->Nodes[next[depths[offset + node]]++] =
+                (TransformSceneNode){.Hierarchy = i, .Node = node};
+        }
+        offset += scene->Hierarchies[i]->Count;
+    }
+    free(next);
+    free(depths);
+    scene->LevelsStale = false;
+}
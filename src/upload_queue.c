@@ -0,0 +1,94 @@
+#include "upload_queue.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// intrusive multi producer single consumer queue: producers only swap the
+/// head, the GL thread is the only one that touches the tail
+struct UploadJob {
+    void (*Upload)(void *data);
+    void *Data;
+    size_t Bytes;
+    _Atomic(struct UploadJob *) Next;
+};
+
+void uploadQueueAppend(struct UploadJob *job);
+struct UploadJob *uploadQueuePop();
+
+// the queue always holds at least the stub, so it's never really empty
+struct UploadJob _stub;
+_Atomic(struct UploadJob *) _head = &_stub;
+struct UploadJob *_tail = &_stub;
+/// popped but over the budget, runs first next frame
+struct UploadJob *_pending;
+
+void uploadQueuePush(void (*upload)(void *data), void *data, size_t bytes) {
+    struct UploadJob *job = malloc(sizeof(struct UploadJob));
+    job->Upload = upload;
+    job->Data = data;
+    job->Bytes = bytes;
+    uploadQueueAppend(job);
+}
+size_t uploadQueueDrain(size_t byteBudget, double msBudget) {
+    double startTime = glfwGetTime();
+    size_t uploadedBytes = 0;
+    int uploadCount = 0;
+    while (true) {
+        if (_pending == NULL)
+            _pending = uploadQueuePop();
+        if (_pending == NULL)
+            break;
+        if (uploadCount > 0 && uploadedBytes + _pending->Bytes > byteBudget)
+            break;
+
+        struct UploadJob *job = _pending;
+        _pending = NULL;
+        job->Upload(job->Data);
+        uploadedBytes += job->Bytes;
+        uploadCount++;
+        free(job);
+
+        if ((glfwGetTime() - startTime) * 1000.0 >= msBudget)
+            break;
+    }
+    return uploadedBytes;
+}
+void uploadQueueFlush() { uploadQueueDrain(SIZE_MAX, INFINITY); }
+
+void uploadQueueAppend(struct UploadJob *job) {
+    atomic_store_explicit(&job->Next, NULL, memory_order_relaxed);
+    struct UploadJob *previous =
+        atomic_exchange_explicit(&_head, job, memory_order_acq_rel);
+    // between the exchange and this store the consumer can't see `job` yet,
+    // `uploadQueuePop` treats that as empty and picks it up next time
+    atomic_store_explicit(&previous->Next, job, memory_order_release);
+}
+struct UploadJob *uploadQueuePop() {
+    struct UploadJob *tail = _tail;
+    struct UploadJob *next =
+        atomic_load_explicit(&tail->Next, memory_order_acquire);
+    if (tail == &_stub) {
+        if (next == NULL)
+            return NULL;
+        _tail = tail = next;
+        next = atomic_load_explicit(&tail->Next, memory_order_acquire);
+    }
+    if (next != NULL) {
+        _tail = next;
+        return tail;
+    }
+    // `tail` is the last job, put the stub behind it so it can be taken out
+    if (tail != atomic_load_explicit(&_head, memory_order_acquire))
+        return NULL;
+    uploadQueueAppend(&_stub);
+    next = atomic_load_explicit(&tail->Next, memory_order_acquire);
+    if (next != NULL) {
+        _tail = next;
+        return tail;
+    }
+    return NULL;
+}